@@ -506,6 +506,14 @@ typedef int (*curl_prereq_callback)(void *clientp,
    request */
 #define CURL_PREREQFUNC_ABORT 1
 
+/* This is the CURLOPT_RECVBUFFERFUNCTION callback prototype. It sets
+   *bufferp to a buffer of at most 'size' bytes that libcurl receives response
+   body data into and returns its length, or returns 0 to have libcurl use
+   its own buffer. */
+typedef size_t (*curl_recvbuffer_callback)(char **bufferp,
+                                           size_t size,
+                                           void *userdata);
+
 /* All possible error codes from all sorts of curl functions. Future versions
    may return other values, stay prepared.
 
@@ -2224,6 +2232,21 @@ typedef enum {
   /* maximum number of keepalive probes (Linux, *BSD, macOS, etc.) */
   CURLOPT(CURLOPT_TCP_KEEPCNT, CURLOPTTYPE_LONG, 326),
 
+  /* congestion control algorithm for QUIC connections, CURL_QUIC_CC_* */
+  CURLOPT(CURLOPT_QUIC_CC_ALGO, CURLOPTTYPE_VALUES, 327),
+
+  /* callback that hands out application buffers to receive body data into,
+     and the pointer to pass to it */
+  CURLOPT(CURLOPT_RECVBUFFERFUNCTION, CURLOPTTYPE_FUNCTIONPOINT, 328),
+  CURLOPT(CURLOPT_RECVBUFFERDATA, CURLOPTTYPE_CBPOINT, 329),
+
+  /* seconds an expired DNS cache entry is still used while it is resolved
+     again in the background */
+  CURLOPT(CURLOPT_DNS_CACHE_STALE, CURLOPTTYPE_LONG, 330),
+
+  /* file to keep resolved addresses in between processes */
+  CURLOPT(CURLOPT_DNS_CACHE_FILE, CURLOPTTYPE_STRINGPOINT, 331),
+
   CURLOPT_LASTENTRY /* the last unused */
 } CURLoption;
 
@@ -2298,6 +2321,12 @@ enum {
    still planned to be 2.0 and we stick to it for compatibility. */
 #define CURL_HTTP_VERSION_2 CURL_HTTP_VERSION_2_0
 
+/* These enums are for use with the CURLOPT_QUIC_CC_ALGO option. */
+#define CURL_QUIC_CC_DEFAULT 0L /* what the QUIC library prefers */
+#define CURL_QUIC_CC_RENO    1L
+#define CURL_QUIC_CC_CUBIC   2L
+#define CURL_QUIC_CC_BBR     3L
+
 /*
  * Public API enums for RTSP requests
  */
@@ -3037,6 +3066,12 @@ typedef enum {
   CURLSHOPT_UNLOCKFUNC, /* pass in a 'curl_unlock_function' pointer */
   CURLSHOPT_USERDATA,   /* pass in a user data pointer used in the lock/unlock
                            callback functions */
+  CURLSHOPT_CONNECT_SHARDS, /* number of independently locked parts of the
+                               shared connection pool */
+  CURLSHOPT_SSL_SESSION_SHARDS, /* number of independently locked parts of
+                                   the shared SSL session cache */
+  CURLSHOPT_BUILTIN_LOCKS, /* use libcurl's reader/writer locks instead of
+                              the lock callbacks */
   CURLSHOPT_LAST  /* never use */
 } CURLSHoption;
 
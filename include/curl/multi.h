@@ -399,6 +399,18 @@ typedef enum {
   /* maximum number of concurrent streams to support on a connection */
   CURLOPT(CURLMOPT_MAX_CONCURRENT_STREAMS, CURLOPTTYPE_LONG, 16),
 
+  /* maximum number of threads resolving names at the same time */
+  CURLOPT(CURLMOPT_RESOLVER_THREADS, CURLOPTTYPE_LONG, 17),
+
+  /* maximum number of name lookups waiting for a resolver thread */
+  CURLOPT(CURLMOPT_RESOLVER_QUEUE, CURLOPTTYPE_LONG, 18),
+
+  /* maximum number of bytes of spare buffers kept for connections */
+  CURLOPT(CURLMOPT_MAX_BUFFER_POOL, CURLOPTTYPE_LONG, 19),
+
+  /* maximum size an HTTP/2 stream's receive window grows to */
+  CURLOPT(CURLMOPT_MAX_STREAM_WINDOW, CURLOPTTYPE_LONG, 20),
+
   CURLMOPT_LASTENTRY /* the last unused */
 } CURLMoption;
 
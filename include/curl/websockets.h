@@ -56,6 +56,33 @@ CURL_EXTERN CURLcode curl_ws_recv(CURL *curl, void *buffer, size_t buflen,
                                   size_t *recv,
                                   const struct curl_ws_frame **metap);
 
+/* flags for curl_ws_recv_lease() */
+#define CURLWS_LEASE_MESSAGE (1<<0)
+
+/*
+ * NAME curl_ws_recv_lease()
+ *
+ * DESCRIPTION
+ *
+ * Receives data from the websocket connection without copying it. Sets
+ * *bufp to the data inside libcurl's receive buffer, valid until
+ * curl_ws_recv_release() is called. Use after successful
+ * curl_easy_perform() with CURLOPT_CONNECT_ONLY option.
+ */
+CURL_EXTERN CURLcode curl_ws_recv_lease(CURL *curl, const void **bufp,
+                                        size_t *recv,
+                                        const struct curl_ws_frame **metap,
+                                        unsigned int flags);
+
+/*
+ * NAME curl_ws_recv_release()
+ *
+ * DESCRIPTION
+ *
+ * Gives back the data from the last curl_ws_recv_lease() call.
+ */
+CURL_EXTERN CURLcode curl_ws_recv_release(CURL *curl);
+
 /* flags for curl_ws_send() */
 #define CURLWS_PONG       (1<<6)
 
@@ -31,6 +31,7 @@
 #include <curl/curl.h>
 #include "urldata.h"
 #include "altsvc.h"
+#include "hash.h"
 #include "curl_get_line.h"
 #include "strcase.h"
 #include "parsedate.h"
@@ -53,6 +54,9 @@
 #define MAX_ALTSVC_HOSTLEN 512
 #define MAX_ALTSVC_ALPNLENSTR "10"
 #define MAX_ALTSVC_ALPNLEN 10
+/* source ALPN id, port and hostname */
+#define MAX_ALTSVC_IDLEN (MAX_ALTSVC_HOSTLEN + 16)
+#define ALTSVC_HASH_SIZE 64
 
 #define H3VERSION "h3"
 
@@ -85,6 +89,23 @@ const char *Curl_alpnid2str(enum alpnid id)
 }
 
 
+#ifdef DEBUGBUILD
+/* to play well with debug builds, we can *set* a fixed time this will
+   return */
+static time_t altsvc_debugtime(void *unused)
+{
+  char *timestr = getenv("CURL_TIME");
+  (void)unused;
+  if(timestr) {
+    long val = strtol(timestr, NULL, 10);
+    return (time_t)val;
+  }
+  return time(NULL);
+}
+#undef time
+#define time(x) altsvc_debugtime(x)
+#endif
+
 static void altsvc_free(struct altsvc *as)
 {
   free(as->src.host);
@@ -92,6 +113,74 @@ static void altsvc_free(struct altsvc *as)
   free(as);
 }
 
+/* Creates the key of the source origin in the hash, returns its length or
+   zero if the hostname is too long. A trailing dot is ignored. */
+static size_t altsvc_id(char *buf, enum alpnid alpnid, const char *host,
+                        unsigned int port)
+{
+  size_t hlen = strlen(host);
+  size_t len;
+  if(hlen && (host[hlen - 1] == '.'))
+    hlen--;
+  if(hlen > MAX_ALTSVC_HOSTLEN)
+    return 0;
+  len = msnprintf(buf, MAX_ALTSVC_IDLEN - MAX_ALTSVC_HOSTLEN, "%u:%u:",
+                  (unsigned int)alpnid, port);
+  Curl_strntolower(&buf[len], host, hlen);
+  return len + hlen;
+}
+
+static void altsvc_origin_dtor(void *p)
+{
+  /* the entries are owned by the main list */
+  free(p);
+}
+
+/* Adds the entry to the cache. Frees it on failure. */
+static CURLcode altsvc_append(struct altsvcinfo *asi, struct altsvc *as)
+{
+  char id[MAX_ALTSVC_IDLEN];
+  size_t idlen = altsvc_id(id, as->src.alpnid, as->src.host, as->src.port);
+  struct Curl_llist *origin;
+
+  if(!idlen) {
+    /* never looked up */
+    altsvc_free(as);
+    return CURLE_OK;
+  }
+  origin = Curl_hash_pick(&asi->origins, id, idlen);
+  if(!origin) {
+    origin = malloc(sizeof(*origin));
+    if(!origin) {
+      altsvc_free(as);
+      return CURLE_OUT_OF_MEMORY;
+    }
+    Curl_llist_init(origin, NULL);
+    if(!Curl_hash_add(&asi->origins, id, idlen, origin)) {
+      free(origin);
+      altsvc_free(as);
+      return CURLE_OUT_OF_MEMORY;
+    }
+  }
+  Curl_llist_append(origin, as, &as->onode);
+  Curl_llist_append(&asi->list, as, &as->node);
+  return CURLE_OK;
+}
+
+/* Removes the entry from the cache and frees it */
+static void altsvc_remove(struct altsvcinfo *asi, struct altsvc *as)
+{
+  struct Curl_llist *origin = Curl_node_llist(&as->onode);
+  Curl_node_remove(&as->node);
+  Curl_node_remove(&as->onode);
+  if(!Curl_llist_count(origin)) {
+    char id[MAX_ALTSVC_IDLEN];
+    size_t idlen = altsvc_id(id, as->src.alpnid, as->src.host, as->src.port);
+    Curl_hash_delete(&asi->origins, id, idlen);
+  }
+  altsvc_free(as);
+}
+
 static struct altsvc *altsvc_createid(const char *srchost,
                                       const char *dsthost,
                                       enum alpnid srcalpnid,
@@ -193,7 +282,7 @@ static CURLcode altsvc_add(struct altsvcinfo *asi, char *line)
       as->expires = expires;
       as->prio = prio;
       as->persist = persist ? 1 : 0;
-      Curl_llist_append(&asi->list, as, &as->node);
+      return altsvc_append(asi, as);
     }
   }
 
@@ -299,6 +388,8 @@ struct altsvcinfo *Curl_altsvc_init(void)
   if(!asi)
     return NULL;
   Curl_llist_init(&asi->list, NULL);
+  Curl_hash_init(&asi->origins, ALTSVC_HASH_SIZE, Curl_hash_str,
+                 Curl_str_key_compare, altsvc_origin_dtor);
 
   /* set default behavior */
   asi->flags = CURLALTSVC_H1
@@ -346,6 +437,7 @@ void Curl_altsvc_cleanup(struct altsvcinfo **altsvcp)
       n = Curl_node_next(e);
       altsvc_free(as);
     }
+    Curl_hash_destroy(&altsvc->origins);
     free(altsvc->filename);
     free(altsvc);
     *altsvcp = NULL; /* clear the pointer */
@@ -361,11 +453,23 @@ CURLcode Curl_altsvc_save(struct Curl_easy *data,
   CURLcode result = CURLE_OK;
   FILE *out;
   char *tempstore = NULL;
+  struct Curl_llist_node *e;
+  struct Curl_llist_node *n;
+  time_t now;
 
   if(!altsvc)
     /* no cache activated */
     return CURLE_OK;
 
+  /* drop the expired entries first */
+  now = time(NULL);
+  for(e = Curl_llist_head(&altsvc->list); e; e = n) {
+    struct altsvc *as = Curl_node_elem(e);
+    n = Curl_node_next(e);
+    if(as->expires < now)
+      altsvc_remove(altsvc, as);
+  }
+
   /* if not new name is given, use the one we stored from the load */
   if(!file && altsvc->filename)
     file = altsvc->filename;
@@ -376,8 +480,6 @@ CURLcode Curl_altsvc_save(struct Curl_easy *data,
 
   result = Curl_fopen(data, file, &out, &tempstore);
   if(!result) {
-    struct Curl_llist_node *e;
-    struct Curl_llist_node *n;
     fputs("# Your alt-svc cache. https://curl.se/docs/alt-svc.html\n"
           "# This file was generated by libcurl! Edit at your own risk.\n",
           out);
@@ -419,57 +521,37 @@ static CURLcode getalnum(const char **ptr, char *alpnbuf, size_t buflen)
   return CURLE_OK;
 }
 
-/* hostcompare() returns true if 'host' matches 'check'. The first host
- * argument may have a trailing dot present that will be ignored.
- */
-static bool hostcompare(const char *host, const char *check)
+/* altsvc_origin() returns the list of entries for this source origin, if
+   any. The hostname may have a trailing dot present that will be ignored. */
+static struct Curl_llist *altsvc_origin(struct altsvcinfo *asi,
+                                        enum alpnid srcalpnid,
+                                        const char *srchost,
+                                        unsigned int srcport)
 {
-  size_t hlen = strlen(host);
-  size_t clen = strlen(check);
-
-  if(hlen && (host[hlen - 1] == '.'))
-    hlen--;
-  if(hlen != clen)
-    /* they cannot match if they have different lengths */
-    return FALSE;
-  return strncasecompare(host, check, hlen);
+  char id[MAX_ALTSVC_IDLEN];
+  size_t idlen = altsvc_id(id, srcalpnid, srchost, srcport);
+  if(!idlen)
+    return NULL;
+  return Curl_hash_pick(&asi->origins, id, idlen);
 }
 
 /* altsvc_flush() removes all alternatives for this source origin from the
-   list */
+   cache */
 static void altsvc_flush(struct altsvcinfo *asi, enum alpnid srcalpnid,
                          const char *srchost, unsigned short srcport)
 {
+  struct Curl_llist *origin = altsvc_origin(asi, srcalpnid, srchost, srcport);
   struct Curl_llist_node *e;
   struct Curl_llist_node *n;
-  for(e = Curl_llist_head(&asi->list); e; e = n) {
+  if(!origin)
+    return;
+  /* the list is gone with its last entry, when `n` is NULL */
+  for(e = Curl_llist_head(origin); e; e = n) {
     struct altsvc *as = Curl_node_elem(e);
     n = Curl_node_next(e);
-    if((srcalpnid == as->src.alpnid) &&
-       (srcport == as->src.port) &&
-       hostcompare(srchost, as->src.host)) {
-      Curl_node_remove(e);
-      altsvc_free(as);
-    }
-  }
-}
-
-#ifdef DEBUGBUILD
-/* to play well with debug builds, we can *set* a fixed time this will
-   return */
-static time_t altsvc_debugtime(void *unused)
-{
-  char *timestr = getenv("CURL_TIME");
-  (void)unused;
-  if(timestr) {
-    long val = strtol(timestr, NULL, 10);
-    return (time_t)val;
+    altsvc_remove(asi, as);
   }
-  return time(NULL);
 }
-#undef time
-#define time(x) altsvc_debugtime(x)
-#endif
 
 #define ISNEWLINE(x) (((x) == '\n') || (x) == '\r')
 
@@ -643,9 +725,9 @@ CURLcode Curl_altsvc_parse(struct Curl_easy *data,
                account. [See RFC 7838 section 3.1] */
             as->expires = maxage + time(NULL);
             as->persist = persist;
-            Curl_llist_append(&asi->list, as, &as->node);
-            infof(data, "Added alt-svc: %s:%d over %s", dsthost, dstport,
-                  Curl_alpnid2str(dstalpnid));
+            if(!altsvc_append(asi, as))
+              infof(data, "Added alt-svc: %s:%d over %s", dsthost, dstport,
+                    Curl_alpnid2str(dstalpnid));
           }
         }
       }
@@ -677,6 +759,7 @@ bool Curl_altsvc_lookup(struct altsvcinfo *asi,
                         struct altsvc **dstentry,
                         const int versions) /* one or more bits */
 {
+  struct Curl_llist *origin;
   struct Curl_llist_node *e;
   struct Curl_llist_node *n;
   time_t now = time(NULL);
@@ -684,19 +767,18 @@ bool Curl_altsvc_lookup(struct altsvcinfo *asi,
   DEBUGASSERT(srchost);
   DEBUGASSERT(dstentry);
 
-  for(e = Curl_llist_head(&asi->list); e; e = n) {
+  origin = altsvc_origin(asi, srcalpnid, srchost, (unsigned int)srcport);
+  if(!origin)
+    return FALSE;
+  for(e = Curl_llist_head(origin); e; e = n) {
     struct altsvc *as = Curl_node_elem(e);
     n = Curl_node_next(e);
     if(as->expires < now) {
       /* an expired entry, remove */
-      Curl_node_remove(e);
-      altsvc_free(as);
+      altsvc_remove(asi, as);
       continue;
     }
-    if((as->src.alpnid == srcalpnid) &&
-       hostcompare(srchost, as->src.host) &&
-       (as->src.port == srcport) &&
-       (versions & (int)as->dst.alpnid)) {
+    if(versions & (int)as->dst.alpnid) {
       /* match */
       *dstentry = as;
       return TRUE;
@@ -28,6 +28,7 @@
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_ALTSVC)
 #include <curl/curl.h>
 #include "llist.h"
+#include "hash.h"
 
 enum alpnid {
   ALPN_none = 0,
@@ -49,11 +50,13 @@ struct altsvc {
   bool persist;
   unsigned int prio;
   struct Curl_llist_node node;
+  struct Curl_llist_node onode; /* in the list of its source origin */
 };
 
 struct altsvcinfo {
   char *filename;
   struct Curl_llist list; /* list of entries */
+  struct Curl_hash origins; /* lists of entries per source origin */
   long flags; /* the publicly set bitmask */
 };
 
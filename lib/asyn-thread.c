@@ -64,6 +64,8 @@
 #include "inet_ntop.h"
 #include "curl_threads.h"
 #include "connect.h"
+#include "select.h"
+#include "multihandle.h"
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
 #include "curl_memory.h"
@@ -144,146 +146,185 @@ static bool init_resolve_thread(struct Curl_easy *data,
                                 const char *hostname, int port,
                                 const struct addrinfo *hints);
 
+/*
+ * Names are resolved by a pool of threads owned by the multi handle. A
+ * transfer's lookup is put into the pool's queue and picked up by the next
+ * free thread. Threads are started on demand, up to CURLMOPT_RESOLVER_THREADS,
+ * and keep taking queued lookups until the queue is empty.
+ *
+ * Lookups of the same name, port and hints that are in flight at the same
+ * time share one query. All transfers waiting on it get a copy of its result.
+ */
+struct resolv_pool {
+  curl_mutex_t mtx;
+  struct Curl_llist queue;   /* struct resolv_query waiting for a thread */
+  struct Curl_llist workers; /* struct resolv_worker */
+  struct Curl_hash inflight; /* key -> struct resolv_query, queued or
+                                being resolved */
+  unsigned int max_threads;
+  unsigned int max_queue;    /* 0 for no limit */
+  unsigned int nrunning;     /* threads not yet done with the queue */
+  int refcount;              /* owner, queries and detached workers */
+  BIT(shutdown);             /* owner is gone, do not take more queries */
+};
 
-/* Data for synchronization between resolver thread and its parent */
-struct thread_sync_data {
-  curl_mutex_t *mtx;
-  int done;
+struct resolv_query {
+  struct Curl_llist_node node; /* entry in pool->queue while queued */
+  struct resolv_pool *pool;
+  struct Curl_llist waiters;   /* struct thread_data waiting for this */
+  char *key;                   /* key in pool->inflight */
+  size_t keylen;
+  char *hostname;
   int port;
-  char *hostname;        /* hostname to resolve, Curl_async.hostname
-                            duplicate */
-#ifndef CURL_DISABLE_SOCKETPAIR
-  struct Curl_easy *data;
-  curl_socket_t sock_pair[2]; /* eventfd/pipes/socket pair */
-#endif
+  int refcount;  /* waiters plus one while queued or being resolved */
   int sock_error;
   struct Curl_addrinfo *res;
 #ifdef HAVE_GETADDRINFO
   struct addrinfo hints;
 #endif
-  struct thread_data *td; /* for thread-self cleanup */
+  BIT(done);
 };
 
-struct thread_data {
+struct resolv_worker {
+  struct Curl_llist_node node; /* entry in pool->workers */
+  struct resolv_pool *pool;
   curl_thread_t thread_hnd;
+  BIT(running);  /* thread has not left its loop yet */
+  BIT(detached); /* thread removes and frees itself */
+};
+
+/* A transfer's part in a lookup */
+struct thread_data {
+  struct Curl_llist_node node; /* entry in query->waiters */
+  struct resolv_query *query;
   unsigned int poll_interval;
   timediff_t interval_end;
-  struct thread_sync_data tsd;
+#ifndef CURL_DISABLE_SOCKETPAIR
+  struct Curl_easy *data;
+  curl_socket_t sock_pair[2]; /* eventfd/pipes/socket pair */
+#endif
+  int sock_error; /* failure to signal this waiter */
 };
 
-static struct thread_sync_data *conn_thread_sync_data(struct Curl_easy *data)
+static void pool_free(struct resolv_pool *pool)
 {
-  return &(data->state.async.tdata->tsd);
+  DEBUGASSERT(!pool->refcount);
+  Curl_hash_destroy(&pool->inflight);
+  Curl_mutex_destroy(&pool->mtx);
+  free(pool);
 }
 
-/* Destroy resolver thread synchronization data */
-static
-void destroy_thread_sync_data(struct thread_sync_data *tsd)
+/* Drop a reference to `pool` with its mutex held. Returns TRUE when this
+ * was the last one and the caller needs to pool_free() it once the mutex is
+ * released. */
+static bool pool_unref(struct resolv_pool *pool)
 {
-  if(tsd->mtx) {
-    Curl_mutex_destroy(tsd->mtx);
-    free(tsd->mtx);
-  }
-
-  free(tsd->hostname);
+  DEBUGASSERT(pool->refcount > 0);
+  return --pool->refcount == 0;
+}
 
-  if(tsd->res)
-    Curl_freeaddrinfo(tsd->res);
+/* Drop a reference to `q` with the pool mutex held, freeing it when it was
+ * the last one. Returns what pool_unref() says. */
+static bool query_unref(struct resolv_query *q)
+{
+  struct resolv_pool *pool = q->pool;
+
+  DEBUGASSERT(q->refcount > 0);
+  if(--q->refcount)
+    return FALSE;
+
+  DEBUGASSERT(!Curl_llist_count(&q->waiters));
+  DEBUGASSERT(!Curl_node_llist(&q->node));
+  if(q->res)
+    Curl_freeaddrinfo(q->res);
+  free(q->hostname);
+  free(q->key);
+  free(q);
+  return pool_unref(pool);
+}
 
-#ifndef CURL_DISABLE_SOCKETPAIR
-  /*
-   * close one end of the socket pair (may be done in resolver thread);
-   * the other end (for reading) is always closed in the parent thread.
-   */
-  if(tsd->sock_pair[1] != CURL_SOCKET_BAD) {
-    wakeup_close(tsd->sock_pair[1]);
+/* Leave `q` without waiting for it anymore, pool mutex held. Returns what
+ * query_unref() says. */
+static bool query_leave(struct resolv_query *q)
+{
+  if((q->refcount == 2) && Curl_node_llist(&q->node)) {
+    /* nobody else wants the lookup and it has not started, drop it */
+    Curl_node_remove(&q->node);
+    Curl_hash_delete(&q->pool->inflight, q->key, q->keylen);
+    (void)query_unref(q);
   }
-#endif
-  memset(tsd, 0, sizeof(*tsd));
+  return query_unref(q);
 }
 
-/* Initialize resolver thread synchronization data */
-static
-int init_thread_sync_data(struct thread_data *td,
-                           const char *hostname,
-                           int port,
-                           const struct addrinfo *hints)
+/* Mark `q` as done and wake up everyone waiting for it, pool mutex held. */
+static void query_done(struct resolv_query *q)
 {
-  struct thread_sync_data *tsd = &td->tsd;
-
-  memset(tsd, 0, sizeof(*tsd));
-
-  tsd->td = td;
-  tsd->port = port;
-  /* Treat the request as done until the thread actually starts so any early
-   * cleanup gets done properly.
-   */
-  tsd->done = 1;
-#ifdef HAVE_GETADDRINFO
-  DEBUGASSERT(hints);
-  tsd->hints = *hints;
+#ifndef CURL_DISABLE_SOCKETPAIR
+  struct Curl_llist_node *e;
+#ifdef USE_EVENTFD
+  const uint64_t val = 1;
+  const void *buf = &val;
 #else
-  (void) hints;
+  char buf[1] = { 1 };
+#endif
 #endif
 
-  tsd->mtx = malloc(sizeof(curl_mutex_t));
-  if(!tsd->mtx)
-    goto err_exit;
-
-  Curl_mutex_init(tsd->mtx);
+  q->done = TRUE;
+  Curl_hash_delete(&q->pool->inflight, q->key, q->keylen);
 
 #ifndef CURL_DISABLE_SOCKETPAIR
-  /* create socket pair or pipe */
-  if(wakeup_create(tsd->sock_pair, FALSE) < 0) {
-    tsd->sock_pair[0] = CURL_SOCKET_BAD;
-    tsd->sock_pair[1] = CURL_SOCKET_BAD;
-    goto err_exit;
+  for(e = Curl_llist_head(&q->waiters); e; e = Curl_node_next(e)) {
+    struct thread_data *td = Curl_node_elem(e);
+    if(td->sock_pair[1] != CURL_SOCKET_BAD) {
+      /* DNS has been resolved, signal client task */
+      if(wakeup_write(td->sock_pair[1], buf, sizeof(buf)) < 0)
+        td->sock_error = SOCKERRNO;
+    }
   }
 #endif
-  tsd->sock_error = CURL_ASYNC_SUCCESS;
+}
 
-  /* Copying hostname string because original can be destroyed by parent
-   * thread during gethostbyname execution.
-   */
-  tsd->hostname = strdup(hostname);
-  if(!tsd->hostname)
-    goto err_exit;
+#ifdef HAVE_GETADDRINFO
 
-  return 1;
+/* Resolve the name of `q` with getaddrinfo() */
+static void query_resolve(struct resolv_query *q)
+{
+  char service[12];
+  int rc;
 
-err_exit:
-#ifndef CURL_DISABLE_SOCKETPAIR
-  if(tsd->sock_pair[0] != CURL_SOCKET_BAD) {
-    wakeup_close(tsd->sock_pair[0]);
-    tsd->sock_pair[0] = CURL_SOCKET_BAD;
+  msnprintf(service, sizeof(service), "%d", q->port);
+
+  rc = Curl_getaddrinfo_ex(q->hostname, service, &q->hints, &q->res);
+
+  if(rc) {
+    q->sock_error = SOCKERRNO ? SOCKERRNO : rc;
+    if(q->sock_error == 0)
+      q->sock_error = RESOLVER_ENOMEM;
+  }
+  else {
+    Curl_addrinfo_set_port(q->res, q->port);
   }
-#endif
-  destroy_thread_sync_data(tsd);
-  return 0;
 }
 
-static CURLcode getaddrinfo_complete(struct Curl_easy *data)
-{
-  struct thread_sync_data *tsd = conn_thread_sync_data(data);
-  CURLcode result;
+#else /* HAVE_GETADDRINFO */
 
-  result = Curl_addrinfo_callback(data, tsd->sock_error, tsd->res);
-  /* The tsd->res structure has been copied to async.dns and perhaps the DNS
-     cache. Set our copy to NULL so destroy_thread_sync_data does not free it.
-  */
-  tsd->res = NULL;
+/* Resolve the name of `q` with gethostbyname() */
+static void query_resolve(struct resolv_query *q)
+{
+  q->res = Curl_ipv4_resolve_r(q->hostname, q->port);
 
-  return result;
+  if(!q->res) {
+    q->sock_error = SOCKERRNO;
+    if(q->sock_error == 0)
+      q->sock_error = RESOLVER_ENOMEM;
+  }
 }
 
-
-#ifdef HAVE_GETADDRINFO
+#endif /* HAVE_GETADDRINFO */
 
 /*
- * getaddrinfo_thread() resolves a name and then exits.
- *
- * For builds without ARES, but with USE_IPV6, create a resolver thread
- * and wait on it.
+ * resolv_worker_thread() resolves queued queries until there are no more
+ * and then exits.
  */
 static
 #if defined(_WIN32_WCE) || defined(CURL_WINDOWS_UWP)
@@ -291,145 +332,245 @@ DWORD
 #else
 unsigned int
 #endif
-CURL_STDCALL getaddrinfo_thread(void *arg)
+CURL_STDCALL resolv_worker_thread(void *arg)
 {
-  struct thread_sync_data *tsd = (struct thread_sync_data *)arg;
-  struct thread_data *td = tsd->td;
-  char service[12];
-  int rc;
-#ifndef CURL_DISABLE_SOCKETPAIR
-#ifdef USE_EVENTFD
-  const void *buf;
-  const uint64_t val = 1;
-#else
-  char buf[1];
-#endif
-#endif
+  struct resolv_worker *w = (struct resolv_worker *)arg;
+  struct resolv_pool *pool = w->pool;
+  bool last = FALSE;
+
+  Curl_mutex_acquire(&pool->mtx);
+  for(;;) {
+    struct Curl_llist_node *e = Curl_llist_head(&pool->queue);
+    struct resolv_query *q;
+
+    if(!e || pool->shutdown)
+      break;
+    q = Curl_node_elem(e);
+    Curl_node_remove(e);
+    Curl_mutex_release(&pool->mtx);
+
+    query_resolve(q);
+
+    Curl_mutex_acquire(&pool->mtx);
+    query_done(q);
+    /* the owner or this detached worker still holds the pool */
+    (void)query_unref(q);
+  }
 
-  msnprintf(service, sizeof(service), "%d", tsd->port);
+  w->running = FALSE;
+  pool->nrunning--;
+  if(w->detached) {
+    Curl_node_remove(&w->node);
+    free(w);
+    last = pool_unref(pool);
+  }
+  Curl_mutex_release(&pool->mtx);
 
-  rc = Curl_getaddrinfo_ex(tsd->hostname, service, &tsd->hints, &tsd->res);
+  if(last)
+    pool_free(pool);
+  return 0;
+}
 
-  if(rc) {
-    tsd->sock_error = SOCKERRNO ? SOCKERRNO : rc;
-    if(tsd->sock_error == 0)
-      tsd->sock_error = RESOLVER_ENOMEM;
-  }
-  else {
-    Curl_addrinfo_set_port(tsd->res, tsd->port);
+/* Join and free workers that have left their loop, pool mutex held. Such a
+ * thread does not touch the pool anymore and is about to return. */
+static void pool_reap(struct resolv_pool *pool)
+{
+  struct Curl_llist_node *e, *n;
+
+  for(e = Curl_llist_head(&pool->workers); e; e = n) {
+    struct resolv_worker *w = Curl_node_elem(e);
+    n = Curl_node_next(e);
+    if(!w->running) {
+      Curl_node_remove(e);
+      if(w->thread_hnd != curl_thread_t_null)
+        Curl_thread_join(&w->thread_hnd);
+      free(w);
+    }
   }
+}
 
-  Curl_mutex_acquire(tsd->mtx);
-  if(tsd->done) {
-    /* too late, gotta clean up the mess */
-    Curl_mutex_release(tsd->mtx);
-    destroy_thread_sync_data(tsd);
-    free(td);
+/* Queue `q` for resolving and start another thread for it if we may, pool
+ * mutex held. Returns FALSE if the query could not be queued. */
+static bool pool_add(struct resolv_pool *pool, struct resolv_query *q)
+{
+  struct resolv_worker *w;
+
+  if(pool->max_queue &&
+     (Curl_llist_count(&pool->queue) >= pool->max_queue)) {
+    errno = EAGAIN;
+    return FALSE;
   }
-  else {
-#ifndef CURL_DISABLE_SOCKETPAIR
-    if(tsd->sock_pair[1] != CURL_SOCKET_BAD) {
-#ifdef USE_EVENTFD
-      buf = &val;
-#else
-      buf[0] = 1;
-#endif
-      /* DNS has been resolved, signal client task */
-      if(wakeup_write(tsd->sock_pair[1], buf, sizeof(buf)) < 0) {
-        /* update sock_erro to errno */
-        tsd->sock_error = SOCKERRNO;
-      }
+
+  Curl_llist_append(&pool->queue, q, &q->node);
+  if(pool->nrunning >= pool->max_threads)
+    return TRUE; /* a running thread picks it up */
+
+  pool_reap(pool);
+  w = calloc(1, sizeof(*w));
+  if(w) {
+    w->pool = pool;
+    w->running = TRUE;
+    Curl_llist_append(&pool->workers, w, &w->node);
+    w->thread_hnd = Curl_thread_create(resolv_worker_thread, w);
+    if(w->thread_hnd != curl_thread_t_null) {
+      pool->nrunning++;
+      return TRUE;
     }
-#endif
-    tsd->done = 1;
-    Curl_mutex_release(tsd->mtx);
+    Curl_node_remove(&w->node);
+    free(w);
   }
 
-  return 0;
+  if(pool->nrunning)
+    return TRUE; /* no new thread, but a running one picks it up */
+  Curl_node_remove(&q->node);
+  return FALSE;
 }
 
-#else /* HAVE_GETADDRINFO */
-
-/*
- * gethostbyname_thread() resolves a name and then exits.
- */
-static
-#if defined(_WIN32_WCE) || defined(CURL_WINDOWS_UWP)
-DWORD
-#else
-unsigned int
-#endif
-CURL_STDCALL gethostbyname_thread(void *arg)
+static void query_hash_dtor(void *p)
 {
-  struct thread_sync_data *tsd = (struct thread_sync_data *)arg;
-  struct thread_data *td = tsd->td;
+  /* queries are freed by query_unref() */
+  (void)p;
+}
 
-  tsd->res = Curl_ipv4_resolve_r(tsd->hostname, tsd->port);
+/* Get the resolver pool of the transfer's multi handle, create it on first
+ * use. */
+static struct resolv_pool *pool_get(struct Curl_easy *data)
+{
+  struct Curl_multi *multi = data->multi;
 
-  if(!tsd->res) {
-    tsd->sock_error = SOCKERRNO;
-    if(tsd->sock_error == 0)
-      tsd->sock_error = RESOLVER_ENOMEM;
+  DEBUGASSERT(multi);
+  if(!multi)
+    return NULL;
+  if(!multi->resolv_pool) {
+    struct resolv_pool *pool = calloc(1, sizeof(*pool));
+    if(!pool)
+      return NULL;
+    Curl_mutex_init(&pool->mtx);
+    Curl_llist_init(&pool->queue, NULL);
+    Curl_llist_init(&pool->workers, NULL);
+    Curl_hash_init(&pool->inflight, 63, Curl_hash_str, Curl_str_key_compare,
+                   query_hash_dtor);
+    pool->refcount = 1;
+    multi->resolv_pool = pool;
   }
+  return multi->resolv_pool;
+}
 
-  Curl_mutex_acquire(tsd->mtx);
-  if(tsd->done) {
-    /* too late, gotta clean up the mess */
-    Curl_mutex_release(tsd->mtx);
-    destroy_thread_sync_data(tsd);
-    free(td);
+void Curl_resolver_multi_cleanup(struct Curl_multi *multi)
+{
+  struct resolv_pool *pool = multi->resolv_pool;
+  struct Curl_llist_node *e, *n;
+  bool last;
+
+  if(!pool)
+    return;
+  multi->resolv_pool = NULL;
+
+  Curl_mutex_acquire(&pool->mtx);
+  pool->shutdown = TRUE;
+  /* lookups not started yet are never started */
+  for(e = Curl_llist_head(&pool->queue); e; e = n) {
+    struct resolv_query *q = Curl_node_elem(e);
+    n = Curl_node_next(e);
+    Curl_node_remove(e);
+    q->sock_error = RESOLVER_ENOMEM;
+    query_done(q);
+    (void)query_unref(q);
   }
-  else {
-    tsd->done = 1;
-    Curl_mutex_release(tsd->mtx);
+  /* threads still busy with a lookup are left to finish on their own */
+  for(e = Curl_llist_head(&pool->workers); e; e = n) {
+    struct resolv_worker *w = Curl_node_elem(e);
+    n = Curl_node_next(e);
+    if(w->running) {
+      w->detached = TRUE;
+      Curl_thread_destroy(w->thread_hnd);
+      w->thread_hnd = curl_thread_t_null;
+      pool->refcount++;
+    }
   }
+  pool_reap(pool);
+  last = pool_unref(pool);
+  Curl_mutex_release(&pool->mtx);
 
-  return 0;
+  if(last)
+    pool_free(pool);
 }
 
-#endif /* HAVE_GETADDRINFO */
+/* Check if the query of `td` is done */
+static bool thread_query_done(struct thread_data *td)
+{
+  struct resolv_pool *pool = td->query->pool;
+  bool done;
+
+  Curl_mutex_acquire(&pool->mtx);
+  done = td->query->done;
+  Curl_mutex_release(&pool->mtx);
+  return done;
+}
+
+static CURLcode getaddrinfo_complete(struct Curl_easy *data)
+{
+  struct thread_data *td = data->state.async.tdata;
+  struct resolv_query *q = td->query;
+  struct Curl_addrinfo *res = NULL;
+  int sock_error;
+
+  Curl_mutex_acquire(&q->pool->mtx);
+  DEBUGASSERT(q->done);
+  sock_error = td->sock_error ? td->sock_error : q->sock_error;
+  if(q->res) {
+    if(q->refcount == 1) {
+      /* nobody else wants it, take it */
+      res = q->res;
+      q->res = NULL;
+    }
+    else
+      res = Curl_addrinfo_dup(q->res);
+  }
+  Curl_mutex_release(&q->pool->mtx);
+
+  /* `res` has been copied to async.dns and perhaps the DNS cache. */
+  return Curl_addrinfo_callback(data, sock_error, res);
+}
 
 /*
- * destroy_async_data() cleans up async resolver data and thread handle.
+ * destroy_async_data() cleans up async resolver data and leaves the query.
  */
 static void destroy_async_data(struct Curl_async *async)
 {
   if(async->tdata) {
     struct thread_data *td = async->tdata;
-    int done;
 #ifndef CURL_DISABLE_SOCKETPAIR
-    curl_socket_t sock_rd = td->tsd.sock_pair[0];
-    struct Curl_easy *data = td->tsd.data;
+    curl_socket_t sock_rd = td->sock_pair[0];
+    struct Curl_easy *data = td->data;
 #endif
 
-    /*
-     * if the thread is still blocking in the resolve syscall, detach it and
-     * let the thread do the cleanup...
-     */
-    Curl_mutex_acquire(td->tsd.mtx);
-    done = td->tsd.done;
-    td->tsd.done = 1;
-    Curl_mutex_release(td->tsd.mtx);
-
-    if(!done) {
-      Curl_thread_destroy(td->thread_hnd);
+    if(td->query) {
+      struct resolv_query *q = td->query;
+      struct resolv_pool *pool = q->pool;
+      bool last;
+
+      Curl_mutex_acquire(&pool->mtx);
+      Curl_node_remove(&td->node);
+      last = query_leave(q);
+      Curl_mutex_release(&pool->mtx);
+      if(last)
+        pool_free(pool);
     }
-    else {
-      if(td->thread_hnd != curl_thread_t_null)
-        Curl_thread_join(&td->thread_hnd);
-
-      destroy_thread_sync_data(&td->tsd);
 
-      free(async->tdata);
-    }
 #ifndef CURL_DISABLE_SOCKETPAIR
-    /*
-     * ensure CURLMOPT_SOCKETFUNCTION fires CURL_POLL_REMOVE
-     * before the FD is invalidated to avoid EBADF on EPOLL_CTL_DEL
-     */
-    Curl_multi_closed(data, sock_rd);
-    wakeup_close(sock_rd);
+    if(sock_rd != CURL_SOCKET_BAD) {
+      /*
+       * ensure CURLMOPT_SOCKETFUNCTION fires CURL_POLL_REMOVE
+       * before the FD is invalidated to avoid EBADF on EPOLL_CTL_DEL
+       */
+      Curl_multi_closed(data, sock_rd);
+      wakeup_close(sock_rd);
+    }
+    if((td->sock_pair[1] != CURL_SOCKET_BAD) && (td->sock_pair[1] != sock_rd))
+      wakeup_close(td->sock_pair[1]);
 #endif
+    free(td);
   }
   async->tdata = NULL;
 
@@ -438,8 +579,87 @@ static void destroy_async_data(struct Curl_async *async)
 }
 
 /*
- * init_resolve_thread() starts a new thread that performs the actual
- * resolve. This function returns before the resolve is done.
+ * pool_query() gets the query for a lookup of the name with the given port
+ * and hints, joining one already in flight or queueing a new one. Called
+ * with the pool mutex held. The returned query has a reference taken for
+ * the caller. Returns NULL and sets errno in case of failure.
+ */
+static struct resolv_query *pool_query(struct Curl_easy *data,
+                                       struct resolv_pool *pool,
+                                       const char *hostname, int port,
+                                       const struct addrinfo *hints)
+{
+  struct resolv_query *q;
+  char *key;
+  size_t keylen;
+
+#ifdef HAVE_GETADDRINFO
+  DEBUGASSERT(hints);
+  key = aprintf("%s:%d:%d:%d", hostname, port,
+                hints->ai_family, hints->ai_socktype);
+#else
+  (void)hints;
+  key = aprintf("%s:%d", hostname, port);
+#endif
+  if(!key) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  keylen = strlen(key) + 1;
+
+  pool->max_threads = data->multi->resolver_threads;
+  pool->max_queue = data->multi->resolver_queue;
+
+  q = Curl_hash_pick(&pool->inflight, key, keylen);
+  if(q) {
+    free(key);
+    infof(data, "Joining resolve of %s already in progress", hostname);
+  }
+  else {
+    q = calloc(1, sizeof(*q));
+    if(q)
+      q->hostname = strdup(hostname);
+    if(!q || !q->hostname ||
+       !Curl_hash_add(&pool->inflight, key, keylen, q)) {
+      if(q)
+        free(q->hostname);
+      free(q);
+      free(key);
+      errno = ENOMEM;
+      return NULL;
+    }
+    q->pool = pool;
+    q->key = key;
+    q->keylen = keylen;
+    q->port = port;
+    q->sock_error = CURL_ASYNC_SUCCESS;
+#ifdef HAVE_GETADDRINFO
+    q->hints = *hints;
+#endif
+    Curl_llist_init(&q->waiters, NULL);
+    if(!pool_add(pool, q)) {
+      int err = errno;
+      if(err == EAGAIN)
+        failf(data, "Resolver queue is full (%u lookups waiting)",
+              pool->max_queue);
+      Curl_hash_delete(&pool->inflight, key, keylen);
+      free(q->hostname);
+      free(q);
+      free(key);
+      errno = err;
+      return NULL;
+    }
+    q->refcount = 1; /* for being queued and resolved */
+    pool->refcount++;
+  }
+  q->refcount++;
+  return q;
+}
+
+/*
+ * init_resolve_thread() has the name resolved by the resolver thread pool,
+ * joining a lookup of the same name already in flight if there is one. This
+ * function returns before the resolve is done.
  *
  * Returns FALSE in case of failure, otherwise TRUE.
  */
@@ -448,8 +668,10 @@ static bool init_resolve_thread(struct Curl_easy *data,
                                 const struct addrinfo *hints)
 {
   struct thread_data *td = calloc(1, sizeof(struct thread_data));
-  int err = ENOMEM;
   struct Curl_async *asp = &data->state.async;
+  struct resolv_pool *pool;
+  struct resolv_query *q;
+  int err = ENOMEM;
 
   data->state.async.tdata = td;
   if(!td)
@@ -459,34 +681,35 @@ static bool init_resolve_thread(struct Curl_easy *data,
   asp->done = FALSE;
   asp->status = 0;
   asp->dns = NULL;
-  td->thread_hnd = curl_thread_t_null;
 
-  if(!init_thread_sync_data(td, hostname, port, hints)) {
-    asp->tdata = NULL;
-    free(td);
-    goto errno_exit;
+#ifndef CURL_DISABLE_SOCKETPAIR
+  /* create socket pair or pipe */
+  if(wakeup_create(td->sock_pair, FALSE) < 0) {
+    td->sock_pair[0] = CURL_SOCKET_BAD;
+    td->sock_pair[1] = CURL_SOCKET_BAD;
+    goto err_exit;
   }
+#endif
 
   free(asp->hostname);
   asp->hostname = strdup(hostname);
   if(!asp->hostname)
     goto err_exit;
 
-  /* The thread will set this to 1 when complete. */
-  td->tsd.done = 0;
-
-#ifdef HAVE_GETADDRINFO
-  td->thread_hnd = Curl_thread_create(getaddrinfo_thread, &td->tsd);
-#else
-  td->thread_hnd = Curl_thread_create(gethostbyname_thread, &td->tsd);
-#endif
+  pool = pool_get(data);
+  if(!pool)
+    goto err_exit;
 
-  if(td->thread_hnd == curl_thread_t_null) {
-    /* The thread never started, so mark it as done here for proper cleanup. */
-    td->tsd.done = 1;
+  Curl_mutex_acquire(&pool->mtx);
+  q = pool_query(data, pool, hostname, port, hints);
+  if(!q) {
     err = errno;
+    Curl_mutex_release(&pool->mtx);
     goto err_exit;
   }
+  Curl_llist_append(&q->waiters, td, &td->node);
+  td->query = q;
+  Curl_mutex_release(&pool->mtx);
 
   return TRUE;
 
@@ -511,15 +734,20 @@ static CURLcode thread_wait_resolv(struct Curl_easy *data,
   DEBUGASSERT(data);
   td = data->state.async.tdata;
   DEBUGASSERT(td);
-  DEBUGASSERT(td->thread_hnd != curl_thread_t_null);
+  DEBUGASSERT(td->query);
 
-  /* wait for the thread to resolve the name */
-  if(Curl_thread_join(&td->thread_hnd)) {
-    if(entry)
-      result = getaddrinfo_complete(data);
+  /* wait for the pool to resolve the name */
+  while(!thread_query_done(td)) {
+#ifndef CURL_DISABLE_SOCKETPAIR
+    if(td->sock_pair[0] != CURL_SOCKET_BAD) {
+      (void)SOCKET_READABLE(td->sock_pair[0], 1000);
+      continue;
+    }
+#endif
+    (void)Curl_wait_ms(10);
   }
-  else
-    DEBUGASSERT(0);
+  if(entry)
+    result = getaddrinfo_complete(data);
 
   data->state.async.done = TRUE;
 
@@ -547,11 +775,10 @@ void Curl_resolver_kill(struct Curl_easy *data)
 {
   struct thread_data *td = data->state.async.tdata;
 
-  /* If we are still resolving, we must wait for the threads to fully clean up,
+  /* If we are still resolving, we must wait for the lookup to finish,
      unfortunately. Otherwise, we can simply cancel to clean up any resolver
      data. */
-  if(td && td->thread_hnd != curl_thread_t_null
-     && (data->set.quick_exit != 1L))
+  if(td && td->query && (data->set.quick_exit != 1L))
     (void)thread_wait_resolv(data, NULL, FALSE);
   else
     Curl_resolver_cancel(data);
@@ -585,21 +812,16 @@ CURLcode Curl_resolver_is_resolved(struct Curl_easy *data,
                                    struct Curl_dns_entry **entry)
 {
   struct thread_data *td = data->state.async.tdata;
-  int done = 0;
 
   DEBUGASSERT(entry);
   *entry = NULL;
 
-  if(!td) {
+  if(!td || !td->query) {
     DEBUGASSERT(td);
     return CURLE_COULDNT_RESOLVE_HOST;
   }
 
-  Curl_mutex_acquire(td->tsd.mtx);
-  done = td->tsd.done;
-  Curl_mutex_release(td->tsd.mtx);
-
-  if(done) {
+  if(thread_query_done(td)) {
     getaddrinfo_complete(data);
 
     if(!data->state.async.dns) {
@@ -650,8 +872,8 @@ int Curl_resolver_getsock(struct Curl_easy *data, curl_socket_t *socks)
 #ifndef CURL_DISABLE_SOCKETPAIR
   if(td) {
     /* return read fd to client for polling the DNS resolution status */
-    socks[0] = td->tsd.sock_pair[0];
-    td->tsd.data = data;
+    socks[0] = td->sock_pair[0];
+    td->data = data;
     ret_val = GETSOCK_READSOCK(0);
   }
   else {
@@ -702,19 +924,10 @@ struct Curl_addrinfo *Curl_resolver_getaddrinfo(struct Curl_easy *data,
 
 #else /* !HAVE_GETADDRINFO */
 
-/*
- * Curl_resolver_getaddrinfo() - for getaddrinfo
- */
-struct Curl_addrinfo *Curl_resolver_getaddrinfo(struct Curl_easy *data,
-                                                const char *hostname,
-                                                int port,
-                                                int *waitp)
+/* The hints for resolving a name for the transfer's connection */
+static void resolv_hints(struct Curl_easy *data, struct addrinfo *hints)
 {
-  struct addrinfo hints;
   int pf = PF_INET;
-  struct resdata *reslv = (struct resdata *)data->state.async.resolver;
-
-  *waitp = 0; /* default to synchronous response */
 
 #ifdef CURLRES_IPV6
   if((data->conn->ip_version != CURL_IPRESOLVE_V4) && Curl_ipv6works(data)) {
@@ -726,10 +939,26 @@ struct Curl_addrinfo *Curl_resolver_getaddrinfo(struct Curl_easy *data,
   }
 #endif /* CURLRES_IPV6 */
 
-  memset(&hints, 0, sizeof(hints));
-  hints.ai_family = pf;
-  hints.ai_socktype = (data->conn->transport == TRNSPRT_TCP) ?
+  memset(hints, 0, sizeof(*hints));
+  hints->ai_family = pf;
+  hints->ai_socktype = (data->conn->transport == TRNSPRT_TCP) ?
     SOCK_STREAM : SOCK_DGRAM;
+}
+
+/*
+ * Curl_resolver_getaddrinfo() - for getaddrinfo
+ */
+struct Curl_addrinfo *Curl_resolver_getaddrinfo(struct Curl_easy *data,
+                                                const char *hostname,
+                                                int port,
+                                                int *waitp)
+{
+  struct addrinfo hints;
+  struct resdata *reslv = (struct resdata *)data->state.async.resolver;
+
+  *waitp = 0; /* default to synchronous response */
+
+  resolv_hints(data, &hints);
 
   reslv->start = Curl_now();
   /* fire up a new resolver thread! */
@@ -745,6 +974,54 @@ struct Curl_addrinfo *Curl_resolver_getaddrinfo(struct Curl_easy *data,
 
 #endif /* !HAVE_GETADDRINFO */
 
+struct resolv_query *Curl_resolver_refresh(struct Curl_easy *data,
+                                           const char *hostname, int port)
+{
+  struct resolv_pool *pool = pool_get(data);
+  struct resolv_query *q;
+#ifdef HAVE_GETADDRINFO
+  struct addrinfo hints;
+  struct addrinfo *hintsp = &hints;
+
+  resolv_hints(data, &hints);
+#else
+  struct addrinfo *hintsp = NULL;
+#endif
+
+  if(!pool)
+    return NULL;
+  Curl_mutex_acquire(&pool->mtx);
+  q = pool_query(data, pool, hostname, port, hintsp);
+  Curl_mutex_release(&pool->mtx);
+  return q;
+}
+
+bool Curl_resolver_refresh_done(struct resolv_query *q,
+                                struct Curl_addrinfo **res)
+{
+  bool done;
+
+  *res = NULL;
+  Curl_mutex_acquire(&q->pool->mtx);
+  done = q->done;
+  if(done && q->res)
+    *res = Curl_addrinfo_dup(q->res);
+  Curl_mutex_release(&q->pool->mtx);
+  return done;
+}
+
+void Curl_resolver_refresh_free(struct resolv_query *q)
+{
+  struct resolv_pool *pool = q->pool;
+  bool last;
+
+  Curl_mutex_acquire(&pool->mtx);
+  last = query_leave(q);
+  Curl_mutex_release(&pool->mtx);
+  if(last)
+    pool_free(pool);
+}
+
 CURLcode Curl_set_dns_servers(struct Curl_easy *data,
                               char *servers)
 {
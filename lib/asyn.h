@@ -30,6 +30,7 @@
 struct addrinfo;
 struct hostent;
 struct Curl_easy;
+struct Curl_multi;
 struct connectdata;
 struct Curl_dns_entry;
 
@@ -160,6 +161,48 @@ struct Curl_addrinfo *Curl_resolver_getaddrinfo(struct Curl_easy *data,
                                                 int port,
                                                 int *waitp);
 
+#ifdef CURLRES_THREADED
+/*
+ * Curl_resolver_multi_cleanup()
+ *
+ * Called from curl_multi_cleanup() to release the resolver thread pool the
+ * multi handle owns. Threads still blocked in a name lookup are detached and
+ * clean up after themselves when it returns.
+ */
+void Curl_resolver_multi_cleanup(struct Curl_multi *multi);
+
+struct resolv_query;
+
+/*
+ * Curl_resolver_refresh()
+ *
+ * Starts a lookup of the hostname and port in the background, not tied to
+ * the transfer, to get a new result for a stale DNS cache entry. A lookup
+ * of the same name already in flight is joined. Returns NULL on failure.
+ */
+struct resolv_query *Curl_resolver_refresh(struct Curl_easy *data,
+                                           const char *hostname, int port);
+
+/*
+ * Curl_resolver_refresh_done()
+ *
+ * Returns TRUE when the background lookup is done and then sets '*res' to
+ * a copy of the addresses it got, NULL if it failed. The caller owns them.
+ */
+bool Curl_resolver_refresh_done(struct resolv_query *q,
+                                struct Curl_addrinfo **res);
+
+/*
+ * Curl_resolver_refresh_free()
+ *
+ * Leaves the background lookup, which is dropped if nobody else waits for
+ * it and it has not started yet.
+ */
+void Curl_resolver_refresh_free(struct resolv_query *q);
+#else
+#define Curl_resolver_multi_cleanup(x) Curl_nop_stmt
+#endif
+
 #ifndef CURLRES_ASYNCH
 /* convert these functions if an asynch resolver is not used */
 #define Curl_resolver_cancel(x) Curl_nop_stmt
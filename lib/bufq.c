@@ -183,12 +183,84 @@ void Curl_bufcp_init(struct bufc_pool *pool,
   pool->spare_max = spare_max;
 }
 
+void Curl_bufcs_init(struct bufc_share *share, size_t spare_max)
+{
+  memset(share, 0, sizeof(*share));
+  share->spare_max = spare_max;
+}
+
+/* free spares until no more than `keep` bytes are left */
+static void bufcs_trim(struct bufc_share *share, size_t keep)
+{
+  size_t i;
+  for(i = 0; (i < BUFC_SHARE_CLASSES) && (share->spare_bytes > keep); ++i) {
+    struct bufc_class *c = &share->classes[i];
+    while(c->spare && (share->spare_bytes > keep)) {
+      struct buf_chunk *chunk = c->spare;
+      c->spare = chunk->next;
+      share->spare_bytes -= c->chunk_size;
+      share->trimmed++;
+      free(chunk);
+    }
+  }
+}
+
+void Curl_bufcs_set_max(struct bufc_share *share, size_t spare_max)
+{
+  share->spare_max = spare_max;
+  if(share->spare_bytes > spare_max)
+    bufcs_trim(share, spare_max / 2);
+}
+
+void Curl_bufcs_free(struct bufc_share *share)
+{
+  bufcs_trim(share, 0);
+}
+
+/* the class for chunks of `chunk_size`, NULL if all are used for others */
+static struct bufc_class *bufcs_class(struct bufc_share *share,
+                                      size_t chunk_size)
+{
+  size_t i;
+  for(i = 0; i < BUFC_SHARE_CLASSES; ++i) {
+    struct bufc_class *c = &share->classes[i];
+    if(!c->chunk_size)
+      c->chunk_size = chunk_size;
+    if(c->chunk_size == chunk_size)
+      return c;
+  }
+  return NULL;
+}
+
+void Curl_bufcp_use_share(struct bufc_pool *pool, struct bufc_share *share)
+{
+  struct bufc_class *c = share ? bufcs_class(share, pool->chunk_size) : NULL;
+  if(c) {
+    DEBUGASSERT(!pool->spare);
+    pool->share = share;
+    pool->sclass = c;
+  }
+}
+
 static CURLcode bufcp_take(struct bufc_pool *pool,
                            struct buf_chunk **pchunk)
 {
   struct buf_chunk *chunk = NULL;
 
-  if(pool->spare) {
+  if(pool->share) {
+    struct bufc_class *c = pool->sclass;
+    if(c->spare) {
+      chunk = c->spare;
+      c->spare = chunk->next;
+      pool->share->spare_bytes -= pool->chunk_size;
+      pool->share->hits++;
+      chunk_reset(chunk);
+      *pchunk = chunk;
+      return CURLE_OK;
+    }
+    pool->share->misses++;
+  }
+  else if(pool->spare) {
     chunk = pool->spare;
     pool->spare = chunk->next;
     --pool->spare_count;
@@ -210,7 +282,17 @@ static CURLcode bufcp_take(struct bufc_pool *pool,
 static void bufcp_put(struct bufc_pool *pool,
                       struct buf_chunk *chunk)
 {
-  if(pool->spare_count >= pool->spare_max) {
+  if(pool->share) {
+    struct bufc_share *share = pool->share;
+    struct bufc_class *c = pool->sclass;
+    chunk_reset(chunk);
+    chunk->next = c->spare;
+    c->spare = chunk;
+    share->spare_bytes += pool->chunk_size;
+    if(share->spare_bytes > share->spare_max)
+      bufcs_trim(share, share->spare_max / 2);
+  }
+  else if(pool->spare_count >= pool->spare_max) {
     free(chunk);
   }
   else {
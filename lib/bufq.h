@@ -43,6 +43,40 @@ struct buf_chunk {
   } x;
 };
 
+#define BUFC_SHARE_CLASSES 4
+
+/**
+ * Spare chunks kept for the pools of many connections, in classes by
+ * chunk size. A pool using it keeps no spares of its own, so chunks one
+ * connection no longer needs can be used by all others.
+ *
+ * When a chunk given back makes the spares use more than `spare_max`
+ * bytes, spares are freed until at most half of that is left.
+ *
+ * Not thread safe, all pools using it are supposed to operate in the
+ * same thread.
+ */
+struct bufc_share {
+  struct bufc_class {
+    struct buf_chunk *spare;  /* list of available spare chunks */
+    size_t chunk_size;        /* 0 for a class not used yet */
+  } classes[BUFC_SHARE_CLASSES];
+  size_t spare_bytes;         /* memory in all `spare` lists */
+  size_t spare_max;           /* the high watermark for `spare_bytes` */
+  size_t hits;                /* chunks taken from a `spare` list */
+  size_t misses;              /* chunks allocated as there was no spare */
+  size_t trimmed;             /* spares freed over the high watermark */
+};
+
+void Curl_bufcs_init(struct bufc_share *share, size_t spare_max);
+
+/**
+ * Change the high watermark, freeing spares if it is now exceeded.
+ */
+void Curl_bufcs_set_max(struct bufc_share *share, size_t spare_max);
+
+void Curl_bufcs_free(struct bufc_share *share);
+
 /**
  * A pool for providing/keeping a number of chunks of the same size
  *
@@ -52,6 +86,8 @@ struct buf_chunk {
  */
 struct bufc_pool {
   struct buf_chunk *spare;  /* list of available spare chunks */
+  struct bufc_share *share; /* where to keep spares instead, or NULL */
+  struct bufc_class *sclass; /* the class in `share` for `chunk_size` */
   size_t chunk_size;        /* the size of chunks in this pool */
   size_t spare_count;       /* current number of spare chunks in list */
   size_t spare_max;         /* max number of spares to keep */
@@ -60,6 +96,12 @@ struct bufc_pool {
 void Curl_bufcp_init(struct bufc_pool *pool,
                      size_t chunk_size, size_t spare_max);
 
+/**
+ * Have the pool take and keep its spare chunks in `share`, which must
+ * outlive it. Does nothing when `share` is NULL.
+ */
+void Curl_bufcp_use_share(struct bufc_pool *pool, struct bufc_share *share);
+
 void Curl_bufcp_free(struct bufc_pool *pool);
 
 /**
@@ -48,11 +48,19 @@
 #include "memdebug.h"
 
 
+#ifdef CPOOL_SHARDING
+#define CPOOL_SHARDED(c)      ((c)->sharded)
+#else
+#define CPOOL_SHARDED(c)      FALSE
+#endif
+
+/* A sharded pool does not use the share lock. Its shards are locked
+ * individually, see cpool_shard_lock(). */
 #define CPOOL_IS_LOCKED(c)    ((c) && (c)->locked)
 
 #define CPOOL_LOCK(c)                                                   \
   do {                                                                  \
-    if((c)) {                                                           \
+    if((c) && !CPOOL_SHARDED(c)) {                                      \
       if(CURL_SHARE_KEEP_CONNECT((c)->share))                           \
         Curl_share_lock(((c)->idata), CURL_LOCK_DATA_CONNECT,           \
                         CURL_LOCK_ACCESS_SINGLE);                       \
@@ -63,7 +71,7 @@
 
 #define CPOOL_UNLOCK(c)                                                 \
   do {                                                                  \
-    if((c)) {                                                           \
+    if((c) && !CPOOL_SHARDED(c)) {                                      \
       DEBUGASSERT((c)->locked);                                         \
       (c)->locked = FALSE;                                              \
       if(CURL_SHARE_KEEP_CONNECT((c)->share))                           \
@@ -71,15 +79,116 @@
     }                                                                   \
   } while(0)
 
+/* Counters and idle hints of a sharded pool are guarded by the pool's
+ * own mutex. It is always the last lock taken. */
+#define CPOOL_COUNT_LOCK(c)                                             \
+  do {                                                                  \
+    if(CPOOL_SHARDED(c))                                                \
+      cpool_mutex_acquire(&(c)->mutex);                                 \
+  } while(0)
+
+#define CPOOL_COUNT_UNLOCK(c)                                           \
+  do {                                                                  \
+    if(CPOOL_SHARDED(c))                                                \
+      cpool_mutex_release(&(c)->mutex);                                 \
+  } while(0)
+
 
 /* A list of connections to the same destinationn. */
 struct cpool_bundle {
   struct Curl_llist conns; /* connections in the bundle */
+  struct Curl_llist idle; /* idle connections, least recently used first.
+                             May hold some that are in use again. */
   size_t dest_len; /* total length of destination, including NUL */
   char *dest[1]; /* destination of bundle, allocated to keep dest_len bytes */
 };
 
+#ifdef CPOOL_SHARDING
+#define cpool_mutex_acquire(m)  Curl_mutex_acquire(m)
+#define cpool_mutex_release(m)  Curl_mutex_release(m)
+
+/* Shard locks are recursive, as user callbacks invoked under the lock
+ * may discard connections from the same shard. */
+static int cpool_mutex_init(curl_mutex_t *mutex)
+{
+#ifdef USE_THREADS_POSIX
+  pthread_mutexattr_t attr;
+  int rc;
+
+  if(pthread_mutexattr_init(&attr))
+    return 1;
+  rc = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) ||
+       pthread_mutex_init(mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+  return rc ? 1 : 0;
+#else
+  /* critical sections are recursive */
+  Curl_mutex_init(mutex);
+  return 0;
+#endif
+}
+#else
+#define cpool_mutex_acquire(m)  Curl_nop_stmt
+#define cpool_mutex_release(m)  Curl_nop_stmt
+#endif /* CPOOL_SHARDING */
+
+/* Lock a shard of a sharded pool, does nothing otherwise. */
+static void cpool_shard_lock(struct cpool *cpool, struct cpool_shard *shard)
+{
+#ifdef CPOOL_SHARDING
+  if(cpool && cpool->sharded)
+    Curl_mutex_acquire(&shard->mutex);
+#else
+  (void)cpool;
+  (void)shard;
+#endif
+}
+
+static void cpool_shard_unlock(struct cpool *cpool,
+                               struct cpool_shard *shard)
+{
+#ifdef CPOOL_SHARDING
+  if(cpool && cpool->sharded)
+    Curl_mutex_release(&shard->mutex);
+#else
+  (void)cpool;
+  (void)shard;
+#endif
+}
+
+/* Lock a shard only if that is possible right away. Used while another
+ * shard is already locked, as waiting could deadlock. */
+static bool cpool_shard_trylock(struct cpool *cpool,
+                                struct cpool_shard *shard)
+{
+#ifdef CPOOL_SHARDING
+  if(cpool && cpool->sharded)
+    return Curl_mutex_try_acquire(&shard->mutex);
+#else
+  (void)cpool;
+  (void)shard;
+#endif
+  return TRUE;
+}
 
+static struct cpool_shard *cpool_shard_get(struct cpool *cpool,
+                                           const char *dest, size_t dest_len)
+{
+  if(cpool->num_shards > 1)
+    return &cpool->shards[Curl_hash_str((void *)dest, dest_len,
+                                        cpool->num_shards)];
+  return &cpool->shards[0];
+}
+
+static struct cpool_shard *cpool_conn_shard(struct cpool *cpool,
+                                            struct connectdata *conn)
+{
+  return cpool_shard_get(cpool, conn->destination, conn->destination_len);
+}
+
+
+UNITTEST void cpool_remove_conn(struct cpool *cpool,
+                                struct connectdata *conn);
 static void cpool_discard_conn(struct cpool *cpool,
                                struct Curl_easy *data,
                                struct connectdata *conn,
@@ -99,7 +208,9 @@ static CURLMcode cpool_update_shutdown_ev(struct Curl_multi *multi,
 static void cpool_shutdown_all(struct cpool *cpool,
                                struct Curl_easy *data, int timeout_ms);
 static void cpool_close_and_destroy_all(struct cpool *cpool);
-static struct connectdata *cpool_get_oldest_idle(struct cpool *cpool);
+UNITTEST struct connectdata *cpool_get_oldest_idle(struct cpool *cpool,
+                                                  struct cpool_shard *locked,
+                                                  struct cpool_shard **pshard);
 
 static struct cpool_bundle *cpool_bundle_create(const char *dest,
                                                 size_t dest_len)
@@ -109,6 +220,7 @@ static struct cpool_bundle *cpool_bundle_create(const char *dest,
   if(!bundle)
     return NULL;
   Curl_llist_init(&bundle->conns, NULL);
+  Curl_llist_init(&bundle->idle, NULL);
   bundle->dest_len = dest_len;
   memcpy(bundle->dest, dest, dest_len);
   return bundle;
@@ -136,33 +248,124 @@ static void cpool_bundle_remove(struct cpool_bundle *bundle,
   (void)bundle;
   DEBUGASSERT(Curl_node_llist(&conn->cpool_node) == &bundle->conns);
   Curl_node_remove(&conn->cpool_node);
+  if(Curl_node_llist(&conn->bundle_idle_node))
+    Curl_node_remove(&conn->bundle_idle_node);
+  if(Curl_node_llist(&conn->cpool_idle_node))
+    Curl_node_remove(&conn->cpool_idle_node);
   conn->bits.in_cpool = FALSE;
 }
 
+/* Set the shard's idle hint from the head of its idle list. */
+static void cpool_shard_update_hint(struct cpool *cpool,
+                                    struct cpool_shard *shard)
+{
+  struct Curl_llist_node *e = Curl_llist_head(&shard->idle);
+
+  CPOOL_COUNT_LOCK(cpool);
+  shard->has_idle_hint = !!e;
+  if(e)
+    shard->idle_hint = ((struct connectdata *)Curl_node_elem(e))->lastused;
+  CPOOL_COUNT_UNLOCK(cpool);
+}
+
+/* The connection in the bundle has become idle and is now the most
+ * recently used one. The shard is locked. */
+static void cpool_conn_idle(struct cpool *cpool,
+                            struct cpool_shard *shard,
+                            struct cpool_bundle *bundle,
+                            struct connectdata *conn)
+{
+  if(Curl_node_llist(&conn->bundle_idle_node))
+    Curl_node_remove(&conn->bundle_idle_node);
+  if(Curl_node_llist(&conn->cpool_idle_node))
+    Curl_node_remove(&conn->cpool_idle_node);
+  Curl_llist_append(&bundle->idle, conn, &conn->bundle_idle_node);
+  Curl_llist_append(&shard->idle, conn, &conn->cpool_idle_node);
+  if(Curl_llist_count(&shard->idle) == 1)
+    cpool_shard_update_hint(cpool, shard);
+}
+
 static void cpool_bundle_free_entry(void *freethis)
 {
   cpool_bundle_destroy((struct cpool_bundle *)freethis);
 }
 
+static void cpool_free_shards(struct cpool *cpool)
+{
+  size_t i;
+
+  for(i = 0; cpool->shards && (i < cpool->num_shards); ++i) {
+    Curl_hash_destroy(&cpool->shards[i].dest2bundle);
+#ifdef CPOOL_SHARDING
+    if(cpool->sharded)
+      Curl_mutex_destroy(&cpool->shards[i].mutex);
+#endif
+  }
+#ifdef CPOOL_SHARDING
+  if(cpool->sharded) {
+    Curl_mutex_destroy(&cpool->mutex);
+    cpool->sharded = FALSE;
+  }
+#endif
+  Curl_safefree(cpool->shards);
+  cpool->num_shards = 0;
+}
+
 int Curl_cpool_init(struct cpool *cpool,
                         Curl_cpool_disconnect_cb *disconnect_cb,
                         struct Curl_multi *multi,
                         struct Curl_share *share,
-                        size_t size)
+                        size_t size,
+                        size_t shards)
 {
+  size_t i;
+
   DEBUGASSERT(!!multi != !!share); /* either one */
-  Curl_hash_init(&cpool->dest2bundle, size, Curl_hash_str,
-                 Curl_str_key_compare, cpool_bundle_free_entry);
+  DEBUGASSERT(!multi || shards <= 1); /* only shared pools are sharded */
+  if(!shards)
+    shards = 1;
+  if(shards > CPOOL_MAX_SHARDS)
+    return 1;
+#ifndef CPOOL_SHARDING
+  if(shards > 1)
+    return 1;
+#endif
+
+  cpool->shards = calloc(shards, sizeof(*cpool->shards));
+  if(!cpool->shards)
+    return 1;
+  cpool->num_shards = shards;
+  for(i = 0; i < shards; ++i) {
+    Curl_hash_init(&cpool->shards[i].dest2bundle, size, Curl_hash_str,
+                   Curl_str_key_compare, cpool_bundle_free_entry);
+    Curl_llist_init(&cpool->shards[i].idle, NULL);
+  }
   Curl_llist_init(&cpool->shutdowns, NULL);
 
+#ifdef CPOOL_SHARDING
+  if(shards > 1) {
+    if(cpool_mutex_init(&cpool->mutex))
+      goto error;
+    for(i = 0; i < shards; ++i) {
+      if(cpool_mutex_init(&cpool->shards[i].mutex)) {
+        while(i)
+          Curl_mutex_destroy(&cpool->shards[--i].mutex);
+        Curl_mutex_destroy(&cpool->mutex);
+        goto error;
+      }
+    }
+    cpool->sharded = TRUE;
+  }
+#endif
+
   DEBUGASSERT(disconnect_cb);
   if(!disconnect_cb)
-    return 1;
+    goto error;
 
   /* allocate a new easy handle to use when closing cached connections */
   cpool->idata = curl_easy_init();
   if(!cpool->idata)
-    return 1; /* bad */
+    goto error;
   cpool->idata->state.internal = TRUE;
   /* TODO: this is quirky. We need an internal handle for certain
    * operations, but we do not add it to the multi (if there is one).
@@ -180,6 +383,10 @@ int Curl_cpool_init(struct cpool *cpool,
   cpool->idata->share = cpool->share = share;
 
   return 0; /* good */
+
+error:
+  cpool_free_shards(cpool);
+  return 1; /* bad */
 }
 
 void Curl_cpool_destroy(struct cpool *cpool)
@@ -193,7 +400,7 @@ void Curl_cpool_destroy(struct cpool *cpool)
       cpool->idata->share = NULL;
       Curl_close(&cpool->idata);
     }
-    Curl_hash_destroy(&cpool->dest2bundle);
+    cpool_free_shards(cpool);
     cpool->multi = NULL;
   }
 }
@@ -218,6 +425,7 @@ void Curl_cpool_xfer_init(struct Curl_easy *data)
   DEBUGASSERT(cpool);
   if(cpool) {
     CPOOL_LOCK(cpool);
+    CPOOL_COUNT_LOCK(cpool);
     /* the identifier inside the connection cache */
     data->id = cpool->next_easy_id++;
     if(cpool->next_easy_id <= 0)
@@ -233,6 +441,7 @@ void Curl_cpool_xfer_init(struct Curl_easy *data)
       data->set.server_response_timeout;
     cpool->idata->set.no_signal = data->set.no_signal;
 
+    CPOOL_COUNT_UNLOCK(cpool);
     CPOOL_UNLOCK(cpool);
   }
   else {
@@ -242,15 +451,15 @@ void Curl_cpool_xfer_init(struct Curl_easy *data)
   }
 }
 
-static struct cpool_bundle *cpool_find_bundle(struct cpool *cpool,
+static struct cpool_bundle *cpool_find_bundle(struct cpool_shard *shard,
                                               struct connectdata *conn)
 {
-  return Curl_hash_pick(&cpool->dest2bundle,
+  return Curl_hash_pick(&shard->dest2bundle,
                         conn->destination, conn->destination_len);
 }
 
 static struct cpool_bundle *
-cpool_add_bundle(struct cpool *cpool, struct connectdata *conn)
+cpool_add_bundle(struct cpool_shard *shard, struct connectdata *conn)
 {
   struct cpool_bundle *bundle;
 
@@ -258,7 +467,7 @@ cpool_add_bundle(struct cpool *cpool, struct connectdata *conn)
   if(!bundle)
     return NULL;
 
-  if(!Curl_hash_add(&cpool->dest2bundle,
+  if(!Curl_hash_add(&shard->dest2bundle,
                     bundle->dest, bundle->dest_len, bundle)) {
     cpool_bundle_destroy(bundle);
     return NULL;
@@ -266,28 +475,14 @@ cpool_add_bundle(struct cpool *cpool, struct connectdata *conn)
   return bundle;
 }
 
-static void cpool_remove_bundle(struct cpool *cpool,
+static void cpool_remove_bundle(struct cpool_shard *shard,
                                 struct cpool_bundle *bundle)
 {
-  struct Curl_hash_iterator iter;
-  struct Curl_hash_element *he;
-
-  if(!cpool)
+  if(!shard)
     return;
-
-  Curl_hash_start_iterate(&cpool->dest2bundle, &iter);
-
-  he = Curl_hash_next_element(&iter);
-  while(he) {
-    if(he->ptr == bundle) {
-      /* The bundle is destroyed by the hash destructor function,
-         free_bundle_hash_entry() */
-      Curl_hash_delete(&cpool->dest2bundle, he->key, he->key_len);
-      return;
-    }
-
-    he = Curl_hash_next_element(&iter);
-  }
+  /* The bundle is destroyed by the hash destructor function,
+     cpool_bundle_free_entry() */
+  Curl_hash_delete(&shard->dest2bundle, bundle->dest, bundle->dest_len);
 }
 
 static struct connectdata *
@@ -297,6 +492,7 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
                             struct connectdata *conn)
 {
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
   struct cpool_bundle *bundle;
   size_t dest_limit = 0;
   size_t total_limit = 0;
@@ -315,7 +511,9 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
 
   CPOOL_LOCK(cpool);
   if(dest_limit) {
-    bundle = cpool_find_bundle(cpool, conn);
+    shard = cpool_conn_shard(cpool, conn);
+    cpool_shard_lock(cpool, shard);
+    bundle = cpool_find_bundle(shard, conn);
     while(bundle && (Curl_llist_count(&bundle->conns) >= dest_limit)) {
       struct connectdata *oldest_idle = NULL;
       /* The bundle is full. Extract the oldest connection that may
@@ -329,28 +527,41 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
                    "limit of %zu", oldest_idle->connection_id,
                    Curl_llist_count(&bundle->conns), dest_limit));
       Curl_cpool_disconnect(data, oldest_idle, FALSE);
+      /* the bundle is gone when its last connection was removed */
+      bundle = cpool_find_bundle(shard, conn);
     }
-    if(bundle && (Curl_llist_count(&bundle->conns) >= dest_limit)) {
+    if(bundle && (Curl_llist_count(&bundle->conns) >= dest_limit))
       result = CPOOL_LIMIT_DEST;
+    cpool_shard_unlock(cpool, shard);
+    if(result)
       goto out;
-    }
   }
 
   if(total_limit) {
-    while(cpool->num_conn >= total_limit) {
-      struct connectdata *oldest_idle = cpool_get_oldest_idle(cpool);
-      if(!oldest_idle)
+    size_t num_conn;
+
+    for(;;) {
+      struct connectdata *oldest_idle;
+
+      CPOOL_COUNT_LOCK(cpool);
+      num_conn = cpool->num_conn;
+      CPOOL_COUNT_UNLOCK(cpool);
+      if(num_conn < total_limit)
         break;
+
+      /* returns with the connection's shard locked */
+      oldest_idle = cpool_get_oldest_idle(cpool, NULL, &shard);
+      if(!oldest_idle) {
+        result = CPOOL_LIMIT_TOTAL;
+        break;
+      }
       /* disconnect the old conn and continue */
       DEBUGF(infof(data, "Discarding connection #%"
                    FMT_OFF_T " from %zu to reach total "
                    "limit of %zu",
-                   oldest_idle->connection_id, cpool->num_conn, total_limit));
+                   oldest_idle->connection_id, num_conn, total_limit));
       Curl_cpool_disconnect(data, oldest_idle, FALSE);
-    }
-    if(cpool->num_conn >= total_limit) {
-      result = CPOOL_LIMIT_TOTAL;
-      goto out;
+      cpool_shard_unlock(cpool, shard);
     }
   }
 
@@ -365,6 +576,8 @@ CURLcode Curl_cpool_add_conn(struct Curl_easy *data,
   CURLcode result = CURLE_OK;
   struct cpool_bundle *bundle = NULL;
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
+  size_t num_conn;
   DEBUGASSERT(conn);
 
   DEBUGASSERT(cpool);
@@ -372,9 +585,11 @@ CURLcode Curl_cpool_add_conn(struct Curl_easy *data,
     return CURLE_FAILED_INIT;
 
   CPOOL_LOCK(cpool);
-  bundle = cpool_find_bundle(cpool, conn);
+  shard = cpool_conn_shard(cpool, conn);
+  cpool_shard_lock(cpool, shard);
+  bundle = cpool_find_bundle(shard, conn);
   if(!bundle) {
-    bundle = cpool_add_bundle(cpool, conn);
+    bundle = cpool_add_bundle(shard, conn);
     if(!bundle) {
       result = CURLE_OUT_OF_MEMORY;
       goto out;
@@ -382,31 +597,44 @@ CURLcode Curl_cpool_add_conn(struct Curl_easy *data,
   }
 
   cpool_bundle_add(bundle, conn);
+  CPOOL_COUNT_LOCK(cpool);
   conn->connection_id = cpool->next_connection_id++;
-  cpool->num_conn++;
+  num_conn = ++cpool->num_conn;
+  CPOOL_COUNT_UNLOCK(cpool);
   DEBUGF(infof(data, "Added connection %" FMT_OFF_T ". "
                "The cache now contains %zu members",
-               conn->connection_id, cpool->num_conn));
+               conn->connection_id, num_conn));
+  (void)num_conn;
 out:
+  cpool_shard_unlock(cpool, shard);
   CPOOL_UNLOCK(cpool);
 
   return result;
 }
 
-static void cpool_remove_conn(struct cpool *cpool,
-                              struct connectdata *conn)
+/* Remove the connection from the pool. The caller holds the lock
+ * of the connection's shard. */
+UNITTEST void cpool_remove_conn(struct cpool *cpool,
+                                struct connectdata *conn)
 {
   struct Curl_llist *list = Curl_node_llist(&conn->cpool_node);
   DEBUGASSERT(cpool);
   if(list) {
     /* The connection is certainly in the pool, but where? */
-    struct cpool_bundle *bundle = cpool_find_bundle(cpool, conn);
+    struct cpool_shard *shard = cpool_conn_shard(cpool, conn);
+    struct cpool_bundle *bundle = cpool_find_bundle(shard, conn);
     if(bundle && (list == &bundle->conns)) {
+      bool was_oldest = (Curl_llist_head(&shard->idle) ==
+                         &conn->cpool_idle_node);
       cpool_bundle_remove(bundle, conn);
       if(!Curl_llist_count(&bundle->conns))
-        cpool_remove_bundle(cpool, bundle);
+        cpool_remove_bundle(shard, bundle);
       conn->bits.in_cpool = FALSE;
+      if(was_oldest)
+        cpool_shard_update_hint(cpool, shard);
+      CPOOL_COUNT_LOCK(cpool);
       cpool->num_conn--;
+      CPOOL_COUNT_UNLOCK(cpool);
     }
     else {
       /* Not in  a bundle, already in the shutdown list? */
@@ -421,7 +649,8 @@ static void cpool_remove_conn(struct cpool *cpool,
 
    The cpool lock is still held when the callback is called. It needs it,
    so that it can safely continue traversing the lists once the callback
-   returns.
+   returns. In a sharded pool, only the lock of the shard the connection
+   belongs to is held.
 
    Returns TRUE if the loop was aborted due to the callback's return code.
 
@@ -435,48 +664,60 @@ static bool cpool_foreach(struct Curl_easy *data,
 {
   struct Curl_hash_iterator iter;
   struct Curl_hash_element *he;
+  size_t i;
 
   if(!cpool)
     return FALSE;
 
-  Curl_hash_start_iterate(&cpool->dest2bundle, &iter);
+  for(i = 0; i < cpool->num_shards; ++i) {
+    struct cpool_shard *shard = &cpool->shards[i];
 
-  he = Curl_hash_next_element(&iter);
-  while(he) {
-    struct Curl_llist_node *curr;
-    struct cpool_bundle *bundle = he->ptr;
-    he = Curl_hash_next_element(&iter);
+    cpool_shard_lock(cpool, shard);
+    Curl_hash_start_iterate(&shard->dest2bundle, &iter);
 
-    curr = Curl_llist_head(&bundle->conns);
-    while(curr) {
-      /* Yes, we need to update curr before calling func(), because func()
-         might decide to remove the connection */
-      struct connectdata *conn = Curl_node_elem(curr);
-      curr = Curl_node_next(curr);
-
-      if(1 == func(data, conn, param)) {
-        return TRUE;
+    he = Curl_hash_next_element(&iter);
+    while(he) {
+      struct Curl_llist_node *curr;
+      struct cpool_bundle *bundle = he->ptr;
+      he = Curl_hash_next_element(&iter);
+
+      curr = Curl_llist_head(&bundle->conns);
+      while(curr) {
+        /* Yes, we need to update curr before calling func(), because func()
+           might decide to remove the connection */
+        struct connectdata *conn = Curl_node_elem(curr);
+        curr = Curl_node_next(curr);
+
+        if(1 == func(data, conn, param)) {
+          cpool_shard_unlock(cpool, shard);
+          return TRUE;
+        }
       }
     }
+    cpool_shard_unlock(cpool, shard);
   }
   return FALSE;
 }
 
-/* Return a live connection in the pool or NULL. */
+/* Return a live connection in the pool or NULL. Only used when
+ * tearing the pool down, no other thread may be using it then. */
 static struct connectdata *cpool_get_live_conn(struct cpool *cpool)
 {
   struct Curl_hash_iterator iter;
   struct Curl_hash_element *he;
   struct cpool_bundle *bundle;
   struct Curl_llist_node *conn_node;
-
-  Curl_hash_start_iterate(&cpool->dest2bundle, &iter);
-  for(he = Curl_hash_next_element(&iter); he;
-      he = Curl_hash_next_element(&iter)) {
-    bundle = he->ptr;
-    conn_node = Curl_llist_head(&bundle->conns);
-    if(conn_node)
-      return Curl_node_elem(conn_node);
+  size_t i;
+
+  for(i = 0; i < cpool->num_shards; ++i) {
+    Curl_hash_start_iterate(&cpool->shards[i].dest2bundle, &iter);
+    for(he = Curl_hash_next_element(&iter); he;
+        he = Curl_hash_next_element(&iter)) {
+      bundle = he->ptr;
+      conn_node = Curl_llist_head(&bundle->conns);
+      if(conn_node)
+        return Curl_node_elem(conn_node);
+    }
   }
   return NULL;
 }
@@ -500,17 +741,36 @@ bool Curl_cpool_conn_now_idle(struct Curl_easy *data,
   if(cpool && maxconnects) {
     /* may be called form a callback already under lock */
     bool do_lock = !CPOOL_IS_LOCKED(cpool);
+    struct cpool_shard *shard = cpool_conn_shard(cpool, conn);
+    struct cpool_shard *oldest_shard = NULL;
+    size_t num_conn;
+
     if(do_lock)
       CPOOL_LOCK(cpool);
-    if(cpool->num_conn > maxconnects) {
+    cpool_shard_lock(cpool, shard);
+    if(conn->bits.in_cpool) {
+      struct cpool_bundle *bundle = cpool_find_bundle(shard, conn);
+      if(bundle)
+        cpool_conn_idle(cpool, shard, bundle, conn);
+    }
+    CPOOL_COUNT_LOCK(cpool);
+    num_conn = cpool->num_conn;
+    CPOOL_COUNT_UNLOCK(cpool);
+
+    if(num_conn > maxconnects) {
       infof(data, "Connection pool is full, closing the oldest one");
 
-      oldest_idle = cpool_get_oldest_idle(cpool);
+      /* When sharded, this does not wait for the lock of a different
+       * shard. If that is busy, the pool stays above the limit until
+       * the next connection becomes idle. */
+      oldest_idle = cpool_get_oldest_idle(cpool, shard, &oldest_shard);
       kept = (oldest_idle != conn);
       if(oldest_idle) {
-        Curl_cpool_disconnect(cpool->idata, oldest_idle, FALSE);
+        Curl_cpool_disconnect(data, oldest_idle, FALSE);
+        cpool_shard_unlock(cpool, oldest_shard);
       }
     }
+    cpool_shard_unlock(cpool, shard);
     if(do_lock)
       CPOOL_UNLOCK(cpool);
   }
@@ -520,70 +780,127 @@ bool Curl_cpool_conn_now_idle(struct Curl_easy *data,
 
 /*
  * This function finds the connection in the connection bundle that has been
- * unused for the longest time.
+ * unused for the longest time. Connections found in use again are dropped
+ * from the idle list on the way.
  */
 static struct connectdata *
 cpool_bundle_get_oldest_idle(struct cpool_bundle *bundle)
 {
-  struct Curl_llist_node *curr;
-  timediff_t highscore = -1;
-  timediff_t score;
-  struct curltime now;
-  struct connectdata *oldest_idle = NULL;
+  struct Curl_llist_node *e;
   struct connectdata *conn;
 
-  now = Curl_now();
-  curr = Curl_llist_head(&bundle->conns);
-  while(curr) {
-    conn = Curl_node_elem(curr);
+  for(e = Curl_llist_head(&bundle->idle); e;
+      e = Curl_llist_head(&bundle->idle)) {
+    conn = Curl_node_elem(e);
+    if(!CONN_INUSE(conn))
+      return conn;
+    Curl_node_remove(e);
+  }
+  return NULL;
+}
 
-    if(!CONN_INUSE(conn)) {
-      /* Set higher score for the age passed since the connection was used */
-      score = Curl_timediff(now, conn->lastused);
+/*
+ * Find the connection in the shard that has been unused for the longest
+ * time. The shard must be locked. Connections in use again, or that may
+ * not be reused, are dropped from the idle list on the way. The shard's
+ * idle hint is updated.
+ */
+static struct connectdata *
+cpool_shard_get_oldest_idle(struct cpool *cpool, struct cpool_shard *shard)
+{
+  struct Curl_llist_node *e;
+  struct connectdata *conn, *oldest_idle = NULL;
+  bool dropped = FALSE;
 
-      if(score > highscore) {
-        highscore = score;
-        oldest_idle = conn;
-      }
+  for(e = Curl_llist_head(&shard->idle); e;
+      e = Curl_llist_head(&shard->idle)) {
+    conn = Curl_node_elem(e);
+    if(!CONN_INUSE(conn) && !conn->bits.close && !conn->connect_only) {
+      oldest_idle = conn;
+      break;
     }
-    curr = Curl_node_next(curr);
+    Curl_node_remove(e);
+    dropped = TRUE;
   }
+
+  if(dropped || (!!oldest_idle != !!shard->has_idle_hint))
+    cpool_shard_update_hint(cpool, shard);
   return oldest_idle;
 }
 
-static struct connectdata *cpool_get_oldest_idle(struct cpool *cpool)
+/* Return the shard with the oldest idle hint, not being `skip`,
+ * or NULL if no shard has one. */
+static struct cpool_shard *cpool_get_idle_shard(struct cpool *cpool,
+                                                struct cpool_shard *skip)
+{
+  struct cpool_shard *best = NULL;
+  size_t i;
+
+  CPOOL_COUNT_LOCK(cpool);
+  for(i = 0; i < cpool->num_shards; ++i) {
+    struct cpool_shard *shard = &cpool->shards[i];
+    if((shard == skip) || !shard->has_idle_hint)
+      continue;
+    if(!best || (Curl_timediff(shard->idle_hint, best->idle_hint) < 0))
+      best = shard;
+  }
+  CPOOL_COUNT_UNLOCK(cpool);
+  return best;
+}
+
+/*
+ * Find the connection in the pool that has been unused for the longest
+ * time. On success, the connection's shard is locked and returned in
+ * `*pshard` for the caller to unlock.
+ *
+ * Every shard keeps its idle connections in least recently used order,
+ * so the oldest idle one of a shard is at the head of its list. In a
+ * sharded pool, the shard to look into is selected by the hints the
+ * shards keep on their list heads, without locking any other shard.
+ *
+ * If `locked` is given, the caller holds that shard's lock and locks of
+ * other shards are only taken when available right away.
+ */
+UNITTEST struct connectdata *cpool_get_oldest_idle(struct cpool *cpool,
+                                                  struct cpool_shard *locked,
+                                                  struct cpool_shard **pshard)
 {
-  struct Curl_hash_iterator iter;
-  struct Curl_llist_node *curr;
-  struct Curl_hash_element *he;
   struct connectdata *oldest_idle = NULL;
-  struct cpool_bundle *bundle;
-  struct curltime now;
-  timediff_t highscore =- 1;
-  timediff_t score;
+  struct cpool_shard *shard;
+  size_t i;
+
+  *pshard = NULL;
+  if(!CPOOL_SHARDED(cpool)) {
+    /* one shard, locked by the pool lock */
+    *pshard = &cpool->shards[0];
+    return cpool_shard_get_oldest_idle(cpool, &cpool->shards[0]);
+  }
 
-  now = Curl_now();
-  Curl_hash_start_iterate(&cpool->dest2bundle, &iter);
+  /* A hint is older than the shard's real oldest idle connection when
+   * its list head is in use again. Looking into the shard corrects it,
+   * so look again when another shard now seems to have an older one. */
+  for(i = 0; i < cpool->num_shards; ++i) {
+    struct cpool_shard *next;
 
-  for(he = Curl_hash_next_element(&iter); he;
-      he = Curl_hash_next_element(&iter)) {
-    struct connectdata *conn;
-    bundle = he->ptr;
+    shard = cpool_get_idle_shard(cpool, NULL);
+    if(!shard)
+      break;
+    if((shard == locked) || !locked)
+      cpool_shard_lock(cpool, shard);
+    else if(!cpool_shard_trylock(cpool, shard))
+      break;
 
-    for(curr = Curl_llist_head(&bundle->conns); curr;
-        curr = Curl_node_next(curr)) {
-      conn = Curl_node_elem(curr);
-      if(CONN_INUSE(conn) || conn->bits.close || conn->connect_only)
-        continue;
-      /* Set higher score for the age passed since the connection was used */
-      score = Curl_timediff(now, conn->lastused);
-      if(score > highscore) {
-        highscore = score;
-        oldest_idle = conn;
-      }
+    oldest_idle = cpool_shard_get_oldest_idle(cpool, shard);
+    next = cpool_get_idle_shard(cpool, shard);
+    if(oldest_idle &&
+       (!next || (Curl_timediff(oldest_idle->lastused, next->idle_hint) <= 0)
+        || (i + 1 == cpool->num_shards))) {
+      *pshard = shard;
+      return oldest_idle;
     }
+    cpool_shard_unlock(cpool, shard);
   }
-  return oldest_idle;
+  return NULL;
 }
 
 bool Curl_cpool_find(struct Curl_easy *data,
@@ -593,6 +910,7 @@ bool Curl_cpool_find(struct Curl_easy *data,
                      void *userdata)
 {
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
   struct cpool_bundle *bundle;
   bool result = FALSE;
 
@@ -602,7 +920,9 @@ bool Curl_cpool_find(struct Curl_easy *data,
     return FALSE;
 
   CPOOL_LOCK(cpool);
-  bundle = Curl_hash_pick(&cpool->dest2bundle, (void *)destination, dest_len);
+  shard = cpool_shard_get(cpool, destination, dest_len);
+  cpool_shard_lock(cpool, shard);
+  bundle = Curl_hash_pick(&shard->dest2bundle, (void *)destination, dest_len);
   if(bundle) {
     struct Curl_llist_node *curr = Curl_llist_head(&bundle->conns);
     while(curr) {
@@ -620,6 +940,7 @@ bool Curl_cpool_find(struct Curl_easy *data,
   if(done_cb) {
     result = done_cb(result, userdata);
   }
+  cpool_shard_unlock(cpool, shard);
   CPOOL_UNLOCK(cpool);
   return result;
 }
@@ -788,6 +1109,7 @@ void Curl_cpool_disconnect(struct Curl_easy *data,
                            bool aborted)
 {
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
   bool do_lock;
 
   DEBUGASSERT(cpool);
@@ -808,6 +1130,8 @@ void Curl_cpool_disconnect(struct Curl_easy *data,
   do_lock = !CPOOL_IS_LOCKED(cpool);
   if(do_lock)
     CPOOL_LOCK(cpool);
+  shard = cpool_conn_shard(cpool, conn);
+  cpool_shard_lock(cpool, shard);
 
   if(conn->bits.in_cpool) {
     cpool_remove_conn(cpool, conn);
@@ -829,6 +1153,7 @@ void Curl_cpool_disconnect(struct Curl_easy *data,
     cpool_close_and_destroy(NULL, conn, data, !aborted);
   }
 
+  cpool_shard_unlock(cpool, shard);
   if(do_lock)
     CPOOL_UNLOCK(cpool);
 }
@@ -1195,20 +1520,35 @@ static void cpool_shutdown_all(struct cpool *cpool,
   cpool_shutdown_discard_all(cpool);
 }
 
-struct cpool_reaper_ctx {
-  struct curltime now;
-};
-
-static int cpool_reap_dead_cb(struct Curl_easy *data,
-                              struct connectdata *conn, void *param)
+/* Close and remove the dead idle connections in the shard, which is
+ * locked. Connections in use are not checked. */
+static void cpool_shard_prune_dead(struct Curl_easy *data,
+                                   struct cpool_shard *shard,
+                                   struct curltime *now)
 {
-  struct cpool_reaper_ctx *rctx = param;
-  if(Curl_conn_seems_dead(conn, data, &rctx->now)) {
-    /* stop the iteration here, pass back the connection that was pruned */
-    Curl_cpool_disconnect(data, conn, FALSE);
-    return 1;
+  struct Curl_hash_iterator iter;
+  struct Curl_hash_element *he;
+
+  Curl_hash_start_iterate(&shard->dest2bundle, &iter);
+  he = Curl_hash_next_element(&iter);
+  while(he) {
+    struct cpool_bundle *bundle = he->ptr;
+    struct Curl_llist_node *e = Curl_llist_head(&bundle->idle);
+    /* The bundle goes away when its last connection is removed, get
+     * the next one before that happens. */
+    he = Curl_hash_next_element(&iter);
+
+    while(e) {
+      struct connectdata *conn = Curl_node_elem(e);
+      struct Curl_llist_node *enext = Curl_node_next(e);
+
+      /* When this removes the bundle's last connection, the bundle
+       * is freed and `enext` is NULL. */
+      if(Curl_conn_seems_dead(conn, data, now))
+        Curl_cpool_disconnect(data, conn, FALSE);
+      e = enext;
+    }
   }
-  return 0; /* continue iteration */
 }
 
 /*
@@ -1221,20 +1561,27 @@ static int cpool_reap_dead_cb(struct Curl_easy *data,
 void Curl_cpool_prune_dead(struct Curl_easy *data)
 {
   struct cpool *cpool = cpool_get_instance(data);
-  struct cpool_reaper_ctx rctx;
+  struct curltime now;
   timediff_t elapsed;
+  size_t i;
 
   if(!cpool)
     return;
 
-  rctx.now = Curl_now();
+  now = Curl_now();
   CPOOL_LOCK(cpool);
-  elapsed = Curl_timediff(rctx.now, cpool->last_cleanup);
+  CPOOL_COUNT_LOCK(cpool);
+  elapsed = Curl_timediff(now, cpool->last_cleanup);
+  if(elapsed >= 1000L)
+    cpool->last_cleanup = now;
+  CPOOL_COUNT_UNLOCK(cpool);
 
   if(elapsed >= 1000L) {
-    while(cpool_foreach(data, cpool, &rctx, cpool_reap_dead_cb))
-      ;
-    cpool->last_cleanup = rctx.now;
+    for(i = 0; i < cpool->num_shards; ++i) {
+      cpool_shard_lock(cpool, &cpool->shards[i]);
+      cpool_shard_prune_dead(data, &cpool->shards[i], &now);
+      cpool_shard_unlock(cpool, &cpool->shards[i]);
+    }
   }
   CPOOL_UNLOCK(cpool);
 }
@@ -1336,8 +1683,11 @@ void Curl_cpool_do_locked(struct Curl_easy *data,
 {
   struct cpool *cpool = cpool_get_instance(data);
   if(cpool) {
+    struct cpool_shard *shard = cpool_conn_shard(cpool, conn);
     CPOOL_LOCK(cpool);
+    cpool_shard_lock(cpool, shard);
     cb(conn, data, cbdata);
+    cpool_shard_unlock(cpool, shard);
     CPOOL_UNLOCK(cpool);
   }
   else
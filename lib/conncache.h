@@ -27,6 +27,8 @@
 
 #include <curl/curl.h>
 #include "timeval.h"
+#include "hash.h"
+#include "curl_threads.h"
 
 struct connectdata;
 struct Curl_easy;
@@ -47,9 +49,33 @@ typedef bool Curl_cpool_disconnect_cb(struct Curl_easy *data,
                                       struct connectdata *conn,
                                       bool aborted);
 
+/* Pools shared via a share handle may be split into shards, each with
+ * its own lock, when libcurl has thread support. */
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+#define CPOOL_SHARDING
+#endif
+
+/* The maximum number of shards a pool may be split into. */
+#define CPOOL_MAX_SHARDS 256
+
+/* A part of the pool, holding the bundles whose destination hashes
+ * to it. When the pool is not sharded, there is only one. */
+struct cpool_shard {
+  struct Curl_hash dest2bundle; /* the bundles in this shard */
+  struct Curl_llist idle;       /* idle connections, least recently used
+                                   first. May hold some in use again. */
+  struct curltime idle_hint;    /* `lastused` of the oldest idle connection
+                                   in this shard, may be stale */
+#ifdef CPOOL_SHARDING
+  curl_mutex_t mutex;           /* the shard lock, when sharded */
+#endif
+  BIT(has_idle_hint);           /* `idle_hint` is set */
+};
+
 struct cpool {
    /* the pooled connections, bundled per destination */
-  struct Curl_hash dest2bundle;
+  struct cpool_shard *shards;
+  size_t num_shards;
   size_t num_conn;
   curl_off_t next_connection_id;
   curl_off_t next_easy_id;
@@ -59,17 +85,24 @@ struct cpool {
   struct Curl_multi *multi; /* != NULL iff pool belongs to multi */
   struct Curl_share *share; /* != NULL iff pool belongs to share */
   Curl_cpool_disconnect_cb *disconnect_cb;
+#ifdef CPOOL_SHARDING
+  curl_mutex_t mutex; /* guards counters and idle hints, when sharded */
+#endif
   BIT(locked);
+  BIT(sharded); /* shards have their own locks, share lock is not used */
 };
 
 /* Init the pool, pass multi only if pool is owned by it.
+ * A pool owned by a share may be split into `shards` parts that are
+ * locked independently. Pass 0 or 1 for a pool using a single lock.
  * returns 1 on error, 0 is fine.
  */
 int Curl_cpool_init(struct cpool *cpool,
                     Curl_cpool_disconnect_cb *disconnect_cb,
                     struct Curl_multi *multi,
                     struct Curl_share *share,
-                    size_t size);
+                    size_t size,
+                    size_t shards);
 
 /* Destroy all connections and free all members */
 void Curl_cpool_destroy(struct cpool *connc);
@@ -53,13 +53,19 @@ struct Cookie *Curl_cookie_add(struct Curl_easy *data,
 SENDING COOKIE INFORMATION
 ==========================
 
-struct Cookies *Curl_cookie_getlist(struct CookieInfo *cookie,
-                                    char *host, char *path, bool secure);
-
-        For a given host and path, return a linked list of cookies that
-        the client should send to the server if used now. The secure
-        boolean informs the cookie if a secure connection is achieved or
-        not.
+struct Cookie *Curl_cookie_first(struct Curl_easy *data,
+                                 struct CookieInfo *c,
+                                 struct Curl_cookie_iter *iter,
+                                 const char *host, const char *path,
+                                 bool secure);
+struct Cookie *Curl_cookie_next(struct Curl_cookie_iter *iter);
+void Curl_cookie_done(struct Curl_cookie_iter *iter);
+
+        For a given host and path, walk the cookies that the client
+        should send to the server if used now, longest path first. The
+        secure boolean informs the cookie if a secure connection is
+        achieved or not. The cookies are not copied, the caller holds
+        the cookie share lock while it uses them.
 
         It shall only return cookies that have not expired.
 
@@ -102,6 +108,7 @@ Example set of cookies:
 #include "rename.h"
 #include "fopen.h"
 #include "strdup.h"
+#include "hash.h"
 
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
@@ -109,6 +116,16 @@ Example set of cookies:
 #include "memdebug.h"
 
 static void strstore(char **str, const char *newstr, size_t len);
+static int cookie_sort(const void *p1, const void *p2);
+
+/* The longest domain index key, see cookie_domain_key() */
+#define COOKIE_KEYLEN 256
+
+/* The cookies set for one domain */
+struct cookie_domain {
+  struct Cookie *cookies; /* in the order they are sent, see cookie_sort() */
+  curl_off_t next_expiration; /* the earliest expiry among them */
+};
 
 static void freecookie(struct Cookie *co)
 {
@@ -120,6 +137,18 @@ static void freecookie(struct Cookie *co)
   free(co);
 }
 
+static void cookie_domain_dtor(void *p)
+{
+  struct cookie_domain *d = p;
+  struct Cookie *co;
+  struct Cookie *next;
+  for(co = d->cookies; co; co = next) {
+    next = co->next;
+    freecookie(co);
+  }
+  free(d);
+}
+
 static bool cookie_tailmatch(const char *cookie_domain,
                              size_t cookie_domain_len,
                              const char *hostname)
@@ -225,68 +254,58 @@ pathmatched:
 }
 
 /*
- * Return the top-level domain, for optimal hashing.
+ * Store the key of this domain in the domain index: the lowercase domain,
+ * zero terminated. Cookies without a domain get the empty key. Returns the
+ * length of the key.
  */
-static const char *get_top_domain(const char * const domain, size_t *outlen)
+static size_t cookie_domain_key(const char *domain, char *key)
 {
   size_t len = 0;
-  const char *first = NULL, *last;
 
   if(domain) {
     len = strlen(domain);
-    last = memrchr(domain, '.', len);
-    if(last) {
-      first = memrchr(domain, '.', (last - domain));
-      if(first)
-        len -= (++first - domain);
+    if(len >= COOKIE_KEYLEN) {
+      /* use the end of overly long names */
+      domain += len - (COOKIE_KEYLEN - 1);
+      len = COOKIE_KEYLEN - 1;
     }
+    Curl_strntolower(key, domain, len);
   }
-
-  if(outlen)
-    *outlen = len;
-
-  return first ? first : domain;
+  key[len] = 0;
+  return len + 1;
 }
 
-/* Avoid C1001, an "internal error" with MSVC14 */
-#if defined(_MSC_VER) && (_MSC_VER == 1900)
-#pragma optimize("", off)
-#endif
-
 /*
- * A case-insensitive hash for the cookie domains.
+ * Return the cookies set for this domain, optionally creating an empty set
+ * for it. Returns NULL if there are none or on out of memory. A domain is
+ * only kept in the index while it has cookies.
  */
-static size_t cookie_hash_domain(const char *domain, const size_t len)
+static struct cookie_domain *cookie_domain(struct CookieInfo *c,
+                                           const char *domain, bool create)
 {
-  const char *end = domain + len;
-  size_t h = 5381;
+  char key[COOKIE_KEYLEN];
+  size_t klen = cookie_domain_key(domain, key);
+  struct cookie_domain *d = Curl_hash_pick(&c->domains, key, klen);
 
-  while(domain < end) {
-    size_t j = (size_t)Curl_raw_toupper(*domain++);
-    h += h << 5;
-    h ^= j;
+  if(!d && create) {
+    d = calloc(1, sizeof(*d));
+    if(!d)
+      return NULL;
+    d->next_expiration = CURL_OFF_T_MAX;
+    if(!Curl_hash_add(&c->domains, key, klen, d)) {
+      free(d);
+      return NULL;
+    }
   }
-
-  return (h % COOKIE_HASH_SIZE);
+  return d;
 }
 
-#if defined(_MSC_VER) && (_MSC_VER == 1900)
-#pragma optimize("", on)
-#endif
-
-/*
- * Hash this domain.
- */
-static size_t cookiehash(const char * const domain)
+/* Remove the (empty) set of cookies for this domain */
+static void cookie_domain_drop(struct CookieInfo *c, const char *domain)
 {
-  const char *top;
-  size_t len;
-
-  if(!domain || Curl_host_is_ipnum(domain))
-    return 0;
-
-  top = get_top_domain(domain, &len);
-  return cookie_hash_domain(top, len);
+  char key[COOKIE_KEYLEN];
+  size_t klen = cookie_domain_key(domain, key);
+  Curl_hash_delete(&c->domains, key, klen);
 }
 
 /*
@@ -369,20 +388,68 @@ static void strstore(char **str, const char *newstr, size_t len)
   *str = Curl_memdup0(newstr, len);
 }
 
+/*
+ * remove_expired_domain
+ *
+ * Remove the expired cookies of one domain. The domain records the earliest
+ * expiry among its cookies, so this returns early until that time has come.
+ */
+static void remove_expired_domain(struct CookieInfo *cookies,
+                                  struct cookie_domain *d, curl_off_t now)
+{
+  struct Cookie *co, *nx;
+  struct Cookie *pv = NULL;
+
+  if(now < d->next_expiration)
+    return;
+
+  d->next_expiration = CURL_OFF_T_MAX;
+  for(co = d->cookies; co; co = nx) {
+    nx = co->next;
+    if(co->expires && co->expires < now) {
+      if(!pv)
+        d->cookies = nx;
+      else
+        pv->next = nx;
+      cookies->numcookies--;
+      freecookie(co);
+    }
+    else {
+      if(co->expires && co->expires < d->next_expiration)
+        d->next_expiration = co->expires;
+      pv = co;
+    }
+  }
+}
+
+struct cookie_expire {
+  struct CookieInfo *cookies;
+  curl_off_t now;
+};
+
+/* Curl_hash_clean_with_criterium() callback, drops domains left empty */
+static int cookie_domain_expire(void *user, void *p)
+{
+  struct cookie_expire *e = user;
+  struct cookie_domain *d = p;
+
+  remove_expired_domain(e->cookies, d, e->now);
+  if(d->next_expiration < e->cookies->next_expiration)
+    e->cookies->next_expiration = d->next_expiration;
+  return !d->cookies;
+}
+
 /*
  * remove_expired
  *
- * Remove expired cookies from the hash by inspecting the expires timestamp on
- * each cookie in the hash, freeing and deleting any where the timestamp is in
- * the past. If the cookiejar has recorded the next timestamp at which one or
- * more cookies expire, then processing will exit early in case this timestamp
- * is in the future.
+ * Remove expired cookies from all domains in the jar. If the cookiejar has
+ * recorded the next timestamp at which one or more cookies expire, then
+ * processing will exit early in case this timestamp is in the future.
  */
 static void remove_expired(struct CookieInfo *cookies)
 {
-  struct Cookie *co, *nx;
+  struct cookie_expire e;
   curl_off_t now = (curl_off_t)time(NULL);
-  unsigned int i;
 
   /*
    * If the earliest expiration timestamp in the jar is in the future we can
@@ -398,33 +465,10 @@ static void remove_expired(struct CookieInfo *cookies)
   else
     cookies->next_expiration = CURL_OFF_T_MAX;
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-    struct Cookie *pv = NULL;
-    co = cookies->cookies[i];
-    while(co) {
-      nx = co->next;
-      if(co->expires && co->expires < now) {
-        if(!pv) {
-          cookies->cookies[i] = co->next;
-        }
-        else {
-          pv->next = co->next;
-        }
-        cookies->numcookies--;
-        freecookie(co);
-      }
-      else {
-        /*
-         * If this cookie has an expiration timestamp earlier than what we have
-         * seen so far then record it for the next round of expirations.
-         */
-        if(co->expires && co->expires < cookies->next_expiration)
-          cookies->next_expiration = co->expires;
-        pv = co;
-      }
-      co = nx;
-    }
-  }
+  /* this records the earliest expiration timestamp for the next round */
+  e.cookies = cookies;
+  e.now = now;
+  Curl_hash_clean_with_criterium(&cookies->domains, &e, cookie_domain_expire);
 }
 
 #ifndef USE_LIBPSL
@@ -497,10 +541,11 @@ Curl_cookie_add(struct Curl_easy *data,
   struct Cookie *lastc = NULL;
   struct Cookie *replace_co = NULL;
   struct Cookie *replace_clist = NULL;
+  struct Cookie *replace_prev = NULL;
+  struct cookie_domain *d;
   time_t now = time(NULL);
   bool replace_old = FALSE;
   bool badcookie = FALSE; /* cookies are good by default. mmmmm yummy */
-  size_t myhash;
 
   DEBUGASSERT(data);
   DEBUGASSERT(MAX_SET_COOKIE_AMOUNT <= 255); /* counter is an unsigned char */
@@ -1018,10 +1063,6 @@ Curl_cookie_add(struct Curl_easy *data,
    * domain and path as this.
    */
 
-  /* at first, remove expired cookies */
-  if(!noexpire)
-    remove_expired(c);
-
 #ifdef USE_LIBPSL
   /*
    * Check if the domain is a Public Suffix and if yes, ignore the cookie. We
@@ -1061,9 +1102,19 @@ Curl_cookie_add(struct Curl_easy *data,
          co->name, co->domain, domain));
 #endif
 
+  d = cookie_domain(c, co->domain, FALSE);
+
+  /* at first, remove expired cookies */
+  if(d && !noexpire) {
+    remove_expired_domain(c, d, (curl_off_t)now);
+    if(!d->cookies) {
+      cookie_domain_drop(c, co->domain);
+      d = NULL;
+    }
+  }
+
   /* A non-secure cookie may not overlay an existing secure cookie. */
-  myhash = cookiehash(co->domain);
-  clist = c->cookies[myhash];
+  clist = d ? d->cookies : NULL;
   while(clist) {
     if(strcasecompare(clist->name, co->name)) {
       /* the names are identical */
@@ -1141,6 +1192,7 @@ Curl_cookie_add(struct Curl_easy *data,
       if(replace_old) {
         replace_co = co;
         replace_clist = clist;
+        replace_prev = lastc;
       }
     }
     lastc = clist;
@@ -1165,6 +1217,19 @@ Curl_cookie_add(struct Curl_easy *data,
 
     free(co);   /* free the newly allocated memory */
     co = clist;
+
+    /* the path may have changed, take it out to insert it again in order */
+    if(replace_prev)
+      replace_prev->next = co->next;
+    else
+      d->cookies = co->next;
+  }
+  else if(!d) {
+    d = cookie_domain(c, co->domain, TRUE);
+    if(!d) {
+      freecookie(co);
+      return NULL;
+    }
   }
 
   if(c->running)
@@ -1174,14 +1239,20 @@ Curl_cookie_add(struct Curl_easy *data,
           replace_old ? "Replaced":"Added", co->name, co->value,
           co->domain, co->path, co->expires);
 
-  if(!replace_old) {
-    /* then make the last item point on this new one */
-    if(lastc)
-      lastc->next = co;
-    else
-      c->cookies[myhash] = co;
-    c->numcookies++; /* one more cookie in the jar */
+  /* keep the list in the order the cookies are sent in */
+  for(clist = d->cookies, lastc = NULL; clist;
+      lastc = clist, clist = clist->next) {
+    if(cookie_sort(&co, &clist) < 0)
+      break;
   }
+  co->next = clist;
+  if(lastc)
+    lastc->next = co;
+  else
+    d->cookies = co;
+
+  if(!replace_old)
+    c->numcookies++; /* one more cookie in the jar */
 
   /*
    * Now that we have added a new cookie to the jar, update the expiration
@@ -1189,6 +1260,8 @@ Curl_cookie_add(struct Curl_easy *data,
    */
   if(co->expires && (co->expires < c->next_expiration))
     c->next_expiration = co->expires;
+  if(co->expires && (co->expires < d->next_expiration))
+    d->next_expiration = co->expires;
 
   return co;
 }
@@ -1221,6 +1294,8 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
     c = calloc(1, sizeof(struct CookieInfo));
     if(!c)
       return NULL; /* failed to get memory */
+    Curl_hash_init(&c->domains, COOKIE_HASH_SIZE, Curl_hash_str,
+                   Curl_str_key_compare, cookie_domain_dtor);
     /*
      * Initialize the next_expiration time to signal that we do not have enough
      * information yet.
@@ -1334,158 +1409,263 @@ static int cookie_sort_ct(const void *p1, const void *p2)
   return (c2->creationtime > c1->creationtime) ? 1 : -1;
 }
 
-#define CLONE(field)                     \
-  do {                                   \
-    if(src->field) {                     \
-      d->field = strdup(src->field);     \
-      if(!d->field)                      \
-        goto fail;                       \
-    }                                    \
-  } while(0)
-
-static struct Cookie *dup_cookie(struct Cookie *src)
+/* Make room for at least `need` cookies in the array */
+static CURLcode cookie_grow(struct Cookie ***arrayp, size_t *sizep,
+                            size_t need)
 {
-  struct Cookie *d = calloc(1, sizeof(struct Cookie));
-  if(d) {
-    CLONE(domain);
-    CLONE(path);
-    CLONE(spath);
-    CLONE(name);
-    CLONE(value);
-    d->expires = src->expires;
-    d->tailmatch = src->tailmatch;
-    d->secure = src->secure;
-    d->livecookie = src->livecookie;
-    d->httponly = src->httponly;
-    d->creationtime = src->creationtime;
+  if(need > *sizep) {
+    size_t size = *sizep ? *sizep : 16;
+    struct Cookie **array;
+    while(size < need)
+      size *= 2;
+    array = realloc(*arrayp, size * sizeof(*array));
+    if(!array)
+      return CURLE_OUT_OF_MEMORY;
+    *arrayp = array;
+    *sizep = size;
   }
-  return d;
-
-fail:
-  freecookie(d);
-  return NULL;
+  return CURLE_OK;
 }
 
 /*
- * Curl_cookie_getlist
- *
- * For a given host and path, return a linked list of cookies that the client
- * should send to the server if used now. The secure boolean informs the cookie
- * if a secure connection is achieved or not.
- *
- * It shall only return cookies that have not expired.
+ * Get the cookies set for this domain that are to be sent to the host and
+ * path of the walk into the run. This does not modify the jar, expired
+ * cookies are only skipped. Since the list of the domain is kept sorted, so
+ * is the run.
  */
-struct Cookie *Curl_cookie_getlist(struct Curl_easy *data,
-                                   struct CookieInfo *c,
-                                   const char *host, const char *path,
-                                   bool secure)
+static CURLcode cookie_collect(struct CookieInfo *c, const char *domain,
+                               struct Curl_cookie_iter *iter, curl_off_t now)
 {
-  struct Cookie *newco;
+  struct cookie_domain *d = cookie_domain(c, domain, FALSE);
   struct Cookie *co;
-  struct Cookie *mainco = NULL;
-  size_t matches = 0;
-  bool is_ip;
-  const size_t myhash = cookiehash(host);
 
-  if(!c || !c->cookies[myhash])
-    return NULL; /* no cookie struct or no cookies in the struct */
-
-  /* at first, remove expired cookies */
-  remove_expired(c);
-
-  /* check if host is an IP(v4|v6) address */
-  is_ip = Curl_host_is_ipnum(host);
+  iter->nrun = 0;
+  if(!d)
+    return CURLE_OK;
 
-  co = c->cookies[myhash];
+  for(co = d->cookies; co; co = co->next) {
+    if(co->expires && co->expires < now)
+      continue;
 
-  while(co) {
     /* if the cookie requires we are secure we must only continue if we are! */
-    if(co->secure ? secure : TRUE) {
+    if(co->secure && !iter->secure)
+      continue;
 
-      /* now check if the domain is correct */
-      if(!co->domain ||
-         (co->tailmatch && !is_ip &&
-          cookie_tailmatch(co->domain, strlen(co->domain), host)) ||
-         ((!co->tailmatch || is_ip) && strcasecompare(host, co->domain)) ) {
-        /*
-         * the right part of the host matches the domain stuff in the
-         * cookie data
-         */
+    /* now check if the domain is correct */
+    if(!co->domain ||
+       (co->tailmatch && !iter->is_ip &&
+        cookie_tailmatch(co->domain, strlen(co->domain), iter->host)) ||
+       ((!co->tailmatch || iter->is_ip) &&
+        strcasecompare(iter->host, co->domain)) ) {
+      /*
+       * the right part of the host matches the domain stuff in the cookie
+       * data
+       */
 
-        /*
-         * now check the left part of the path with the cookies path
-         * requirement
-         */
-        if(!co->spath || pathmatch(co->spath, path) ) {
+      /*
+       * now check the left part of the path with the cookies path requirement
+       */
+      if(!co->spath || pathmatch(co->spath, iter->path)) {
+        if(cookie_grow(&iter->run, &iter->runsize, iter->nrun + 1))
+          return CURLE_OUT_OF_MEMORY;
+        iter->run[iter->nrun++] = co;
+      }
+    }
+  }
+  return CURLE_OK;
+}
 
-          /*
-           * and now, we know this is a match and we should create an
-           * entry for the return-linked-list
-           */
+/*
+ * Merge the run into the cookies collected so far, keeping them in the
+ * order of cookie_sort(). Both are sorted already, so this is done from the
+ * back of the array without moving anything twice.
+ */
+static CURLcode cookie_merge(struct Curl_cookie_iter *iter)
+{
+  size_t i = iter->count;
+  size_t j = iter->nrun;
+  size_t k;
 
-          newco = dup_cookie(co);
-          if(newco) {
-            /* then modify our next */
-            newco->next = mainco;
+  if(!j)
+    return CURLE_OK;
+  if(cookie_grow(&iter->array, &iter->size, i + j))
+    return CURLE_OUT_OF_MEMORY;
 
-            /* point the main to us */
-            mainco = newco;
+  k = i + j;
+  while(j) {
+    if(i && (cookie_sort(&iter->array[i - 1], &iter->run[j - 1]) > 0))
+      iter->array[--k] = iter->array[--i];
+    else
+      iter->array[--k] = iter->run[--j];
+  }
+  iter->count += iter->nrun;
+  iter->nrun = 0;
+  return CURLE_OK;
+}
 
-            matches++;
-            if(matches >= MAX_COOKIE_SEND_AMOUNT) {
-              infof(data, "Included max number of cookies (%zu) in request!",
-                    matches);
-              break;
-            }
-          }
-          else
-            goto fail;
-        }
+/*
+ * Return the creation time of the `nth` oldest (counting from zero) of
+ * these creation times, reordering them. They are all unique.
+ */
+static int cookie_nth_oldest(int *ct, size_t n, size_t nth)
+{
+  size_t lo = 0;
+  size_t hi = n - 1;
+
+  while(lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    size_t store = lo;
+    size_t i;
+    int pivot = ct[mid];
+
+    ct[mid] = ct[hi];
+    ct[hi] = pivot;
+    for(i = lo; i < hi; i++) {
+      if(ct[i] < pivot) {
+        int tmp = ct[i];
+        ct[i] = ct[store];
+        ct[store++] = tmp;
       }
     }
-    co = co->next;
-  }
+    ct[hi] = ct[store];
+    ct[store] = pivot;
 
-  if(matches) {
-    /*
-     * Now we need to make sure that if there is a name appearing more than
-     * once, the longest specified path version comes first. To make this
-     * the swiftest way, we just sort them all based on path length.
-     */
-    struct Cookie **array;
-    size_t i;
+    if(nth == store)
+      return pivot;
+    if(nth < store)
+      hi = store - 1;
+    else
+      lo = store + 1;
+  }
+  return ct[nth];
+}
 
-    /* alloc an array and store all cookie pointers */
-    array = malloc(sizeof(struct Cookie *) * matches);
-    if(!array)
-      goto fail;
+/*
+ * Keep only the MAX_COOKIE_SEND_AMOUNT oldest of the collected cookies,
+ * without changing their order.
+ */
+static CURLcode cookie_keep_oldest(struct Curl_cookie_iter *iter)
+{
+  int *ct = malloc(iter->count * sizeof(int));
+  int limit;
+  size_t i;
+  size_t n = 0;
+
+  if(!ct)
+    return CURLE_OUT_OF_MEMORY;
+  for(i = 0; i < iter->count; i++)
+    ct[i] = iter->array[i]->creationtime;
+  limit = cookie_nth_oldest(ct, iter->count, MAX_COOKIE_SEND_AMOUNT - 1);
+  free(ct);
+
+  for(i = 0; i < iter->count; i++) {
+    if(iter->array[i]->creationtime <= limit)
+      iter->array[n++] = iter->array[i];
+  }
+  iter->count = n;
+  return CURLE_OK;
+}
 
-    co = mainco;
+/*
+ * Curl_cookie_first
+ *
+ * For a given host and path, return the first cookie that the client should
+ * send to the server if used now and set up `iter` to get the others with
+ * Curl_cookie_next(). The secure boolean informs the cookie if a secure
+ * connection is achieved or not. Call Curl_cookie_done() when done with the
+ * walk.
+ *
+ * The cookies are returned in the order they should be sent in. They are not
+ * copied, the caller holds the cookie share lock while using them. Since the
+ * jar is not modified, a shared lock is enough.
+ *
+ * It shall only return cookies that have not expired.
+ */
+struct Cookie *Curl_cookie_first(struct Curl_easy *data,
+                                 struct CookieInfo *c,
+                                 struct Curl_cookie_iter *iter,
+                                 const char *host, const char *path,
+                                 bool secure)
+{
+  curl_off_t now = (curl_off_t)time(NULL);
+  const char *domain;
 
-    for(i = 0; co; co = co->next)
-      array[i++] = co;
+  memset(iter, 0, sizeof(*iter));
+  if(!c || !c->numcookies)
+    return NULL; /* no cookie struct or no cookies in the struct */
 
-    /* now sort the cookie pointers in path length order */
-    qsort(array, matches, sizeof(struct Cookie *), cookie_sort);
+  iter->host = host;
+  iter->path = path;
+  iter->secure = secure;
+  /* check if host is an IP(v4|v6) address */
+  iter->is_ip = Curl_host_is_ipnum(host);
 
-    /* remake the linked list order according to the new order */
+  /*
+   * The cookies without a domain, those set for the host and, unless it is
+   * an IP address, for each of the domains it is in. The list of each domain
+   * is in the order of cookie_sort(): if there is a name appearing more than
+   * once, the longest specified path version comes first. Merging them keeps
+   * that order without sorting.
+   */
+  if(cookie_collect(c, NULL, iter, now) || cookie_merge(iter))
+    goto fail;
+  for(domain = host; domain && *domain;) {
+    /* domains too long for a key of their own are filed under the host */
+    if((domain == host) || (strlen(domain) < COOKIE_KEYLEN - 1)) {
+      if(cookie_collect(c, domain, iter, now) || cookie_merge(iter))
+        goto fail;
+    }
+    domain = iter->is_ip ? NULL : strchr(domain, '.');
+    if(domain)
+      domain++;
+  }
+  Curl_safefree(iter->run);
+  iter->runsize = 0;
 
-    mainco = array[0]; /* start here */
-    for(i = 0; i < matches-1; i++)
-      array[i]->next = array[i + 1];
-    array[matches-1]->next = NULL; /* terminate the list */
+  if(!iter->count)
+    return NULL;
 
-    free(array); /* remove the temporary data again */
+  if(iter->count > MAX_COOKIE_SEND_AMOUNT) {
+    /* only the oldest ones are sent */
+    if(cookie_keep_oldest(iter))
+      goto fail;
+    infof(data, "Included max number of cookies (%zu) in request!",
+          iter->count);
   }
 
-  return mainco; /* return the new list */
+  return Curl_cookie_next(iter);
 
 fail:
-  /* failure, clear up the allocated chain and return NULL */
-  Curl_cookie_freelist(mainco);
+  Curl_cookie_done(iter);
   return NULL;
 }
 
+/*
+ * Curl_cookie_next
+ *
+ * Return the next cookie of the walk started with Curl_cookie_first(), or
+ * NULL when there are no more.
+ */
+struct Cookie *Curl_cookie_next(struct Curl_cookie_iter *iter)
+{
+  if(iter->next < iter->count)
+    return iter->array[iter->next++];
+  return NULL;
+}
+
+/*
+ * Curl_cookie_done
+ *
+ * Free the resources of a walk started with Curl_cookie_first().
+ */
+void Curl_cookie_done(struct Curl_cookie_iter *iter)
+{
+  Curl_safefree(iter->array);
+  Curl_safefree(iter->run);
+  iter->count = iter->size = iter->next = 0;
+  iter->nrun = iter->runsize = 0;
+}
+
 /*
  * Curl_cookie_clearall
  *
@@ -1494,28 +1674,34 @@ fail:
 void Curl_cookie_clearall(struct CookieInfo *cookies)
 {
   if(cookies) {
-    unsigned int i;
-    for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-      Curl_cookie_freelist(cookies->cookies[i]);
-      cookies->cookies[i] = NULL;
-    }
+    Curl_hash_clean(&cookies->domains);
     cookies->numcookies = 0;
   }
 }
 
-/*
- * Curl_cookie_freelist
- *
- * Free a list of cookies previously returned by Curl_cookie_getlist();
- */
-void Curl_cookie_freelist(struct Cookie *co)
+/* Curl_hash_clean_with_criterium() callback, drops domains left empty */
+static int cookie_domain_clearsess(void *user, void *p)
 {
-  struct Cookie *next;
-  while(co) {
-    next = co->next;
-    freecookie(co);
-    co = next;
+  struct CookieInfo *cookies = user;
+  struct cookie_domain *d = p;
+  struct Cookie *curr, *next;
+  struct Cookie *prev = NULL;
+
+  for(curr = d->cookies; curr; curr = next) {
+    next = curr->next;
+    if(!curr->expires) {
+      if(!prev)
+        d->cookies = next;
+      else
+        prev->next = next;
+
+      freecookie(curr);
+      cookies->numcookies--;
+    }
+    else
+      prev = curr;
   }
+  return !d->cookies;
 }
 
 /*
@@ -1525,38 +1711,11 @@ void Curl_cookie_freelist(struct Cookie *co)
  */
 void Curl_cookie_clearsess(struct CookieInfo *cookies)
 {
-  struct Cookie *first, *curr, *next, *prev = NULL;
-  unsigned int i;
-
   if(!cookies)
     return;
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-    if(!cookies->cookies[i])
-      continue;
-
-    first = curr = prev = cookies->cookies[i];
-
-    for(; curr; curr = next) {
-      next = curr->next;
-      if(!curr->expires) {
-        if(first == curr)
-          first = next;
-
-        if(prev == curr)
-          prev = next;
-        else
-          prev->next = next;
-
-        freecookie(curr);
-        cookies->numcookies--;
-      }
-      else
-        prev = curr;
-    }
-
-    cookies->cookies[i] = first;
-  }
+  Curl_hash_clean_with_criterium(&cookies->domains, cookies,
+                                 cookie_domain_clearsess);
 }
 
 /*
@@ -1567,9 +1726,7 @@ void Curl_cookie_clearsess(struct CookieInfo *cookies)
 void Curl_cookie_cleanup(struct CookieInfo *c)
 {
   if(c) {
-    unsigned int i;
-    for(i = 0; i < COOKIE_HASH_SIZE; i++)
-      Curl_cookie_freelist(c->cookies[i]);
+    Curl_hash_destroy(&c->domains);
     free(c); /* free the base struct as well */
   }
 }
@@ -1651,6 +1808,8 @@ static CURLcode cookie_output(struct Curl_easy *data,
     unsigned int i;
     size_t nvalid = 0;
     struct Cookie **array;
+    struct Curl_hash_iterator iter;
+    struct Curl_hash_element *he;
 
     array = calloc(1, sizeof(struct Cookie *) * c->numcookies);
     if(!array) {
@@ -1659,8 +1818,11 @@ static CURLcode cookie_output(struct Curl_easy *data,
     }
 
     /* only sort the cookies with a domain property */
-    for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-      for(co = c->cookies[i]; co; co = co->next) {
+    Curl_hash_start_iterate(&c->domains, &iter);
+    for(he = Curl_hash_next_element(&iter); he;
+        he = Curl_hash_next_element(&iter)) {
+      struct cookie_domain *d = he->ptr;
+      for(co = d->cookies; co; co = co->next) {
         if(!co->domain)
           continue;
         array[nvalid++] = co;
@@ -1714,14 +1876,20 @@ static struct curl_slist *cookie_list(struct Curl_easy *data)
   struct curl_slist *beg;
   struct Cookie *c;
   char *line;
-  unsigned int i;
+  struct Curl_hash_iterator iter;
+  struct Curl_hash_element *he;
+  curl_off_t now = (curl_off_t)time(NULL);
 
   if(!data->cookies || (data->cookies->numcookies == 0))
     return NULL;
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-    for(c = data->cookies->cookies[i]; c; c = c->next) {
-      if(!c->domain)
+  Curl_hash_start_iterate(&data->cookies->domains, &iter);
+  for(he = Curl_hash_next_element(&iter); he;
+      he = Curl_hash_next_element(&iter)) {
+    struct cookie_domain *d = he->ptr;
+    for(c = d->cookies; c; c = c->next) {
+      /* expired ones are left for the next writer to remove */
+      if(!c->domain || (c->expires && c->expires < now))
         continue;
       line = get_netscape_format(c);
       if(!line) {
@@ -1744,7 +1912,7 @@ static struct curl_slist *cookie_list(struct Curl_easy *data)
 struct curl_slist *Curl_cookie_list(struct Curl_easy *data)
 {
   struct curl_slist *list;
-  Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SINGLE);
+  Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SHARED);
   list = cookie_list(data);
   Curl_share_unlock(data, CURL_LOCK_DATA_COOKIE);
   return list;
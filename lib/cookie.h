@@ -27,6 +27,8 @@
 
 #include <curl/curl.h>
 
+#include "hash.h"
+
 struct Cookie {
   struct Cookie *next; /* next in the chain */
   char *name;        /* <this> = value */
@@ -53,8 +55,8 @@ struct Cookie {
 #define COOKIE_HASH_SIZE 63
 
 struct CookieInfo {
-  /* linked list of cookies we know of */
-  struct Cookie *cookies[COOKIE_HASH_SIZE];
+  /* the cookies we know of, in lists per domain */
+  struct Curl_hash domains;
   curl_off_t next_expiration; /* the next time at which expiration happens */
   int numcookies;  /* number of cookies in the "jar" */
   int lastct;      /* last creation-time used in the jar */
@@ -112,10 +114,28 @@ struct Cookie *Curl_cookie_add(struct Curl_easy *data,
                                const char *domain, const char *path,
                                bool secure);
 
-struct Cookie *Curl_cookie_getlist(struct Curl_easy *data,
-                                   struct CookieInfo *c, const char *host,
-                                   const char *path, bool secure);
-void Curl_cookie_freelist(struct Cookie *cookies);
+/* The state of a walk over the cookies to send, see Curl_cookie_first() */
+struct Curl_cookie_iter {
+  struct Cookie **array; /* the cookies to send, in the order to send them */
+  size_t count; /* number of cookies in the array */
+  size_t size;  /* allocated size of the array */
+  size_t next;  /* index of the next cookie to return */
+  struct Cookie **run; /* the cookies of one domain, before they are merged */
+  size_t nrun;  /* number of cookies in the run */
+  size_t runsize; /* allocated size of the run */
+  const char *host;
+  const char *path;
+  bool secure;
+  bool is_ip;
+};
+
+struct Cookie *Curl_cookie_first(struct Curl_easy *data,
+                                 struct CookieInfo *c,
+                                 struct Curl_cookie_iter *iter,
+                                 const char *host, const char *path,
+                                 bool secure);
+struct Cookie *Curl_cookie_next(struct Curl_cookie_iter *iter);
+void Curl_cookie_done(struct Curl_cookie_iter *iter);
 void Curl_cookie_clearall(struct CookieInfo *cookies);
 void Curl_cookie_clearsess(struct CookieInfo *cookies);
 
@@ -86,6 +86,47 @@ Curl_freeaddrinfo(struct Curl_addrinfo *cahead)
   }
 }
 
+/*
+ * Curl_addrinfo_dup()
+ *
+ * Returns a copy of the given Curl_addrinfo list, allocated the same way
+ * Curl_getaddrinfo_ex() does it, or NULL if out of memory. The copy must be
+ * freed with Curl_freeaddrinfo().
+ */
+struct Curl_addrinfo *
+Curl_addrinfo_dup(const struct Curl_addrinfo *cahead)
+{
+  struct Curl_addrinfo *cafirst = NULL;
+  struct Curl_addrinfo *calast = NULL;
+  const struct Curl_addrinfo *ai;
+
+  for(ai = cahead; ai; ai = ai->ai_next) {
+    size_t namelen = ai->ai_canonname ? strlen(ai->ai_canonname) + 1 : 0;
+    struct Curl_addrinfo *ca = malloc(sizeof(struct Curl_addrinfo) +
+                                      ai->ai_addrlen + namelen);
+    if(!ca) {
+      Curl_freeaddrinfo(cafirst);
+      return NULL;
+    }
+    *ca = *ai;
+    ca->ai_next = NULL;
+    ca->ai_canonname = NULL;
+    ca->ai_addr = (void *)((char *)ca + sizeof(struct Curl_addrinfo));
+    memcpy(ca->ai_addr, ai->ai_addr, ai->ai_addrlen);
+    if(namelen) {
+      ca->ai_canonname = (void *)((char *)ca->ai_addr + ai->ai_addrlen);
+      memcpy(ca->ai_canonname, ai->ai_canonname, namelen);
+    }
+
+    if(calast)
+      calast->ai_next = ca;
+    else
+      cafirst = ca;
+    calast = ca;
+  }
+  return cafirst;
+}
+
 
 #ifdef HAVE_GETADDRINFO
 /*
@@ -63,6 +63,9 @@ struct Curl_addrinfo {
 void
 Curl_freeaddrinfo(struct Curl_addrinfo *cahead);
 
+struct Curl_addrinfo *
+Curl_addrinfo_dup(const struct Curl_addrinfo *cahead);
+
 #ifdef HAVE_GETADDRINFO
 int
 Curl_getaddrinfo_ex(const char *nodename,
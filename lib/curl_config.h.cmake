@@ -160,6 +160,9 @@
 /* disables TFTP */
 #cmakedefine CURL_DISABLE_TFTP 1
 
+/* disables the timer wheel, timeouts are kept in a splay tree */
+#cmakedefine CURL_DISABLE_TIMER_WHEEL 1
+
 /* disables verbose strings */
 #cmakedefine CURL_DISABLE_VERBOSE_STRINGS 1
 
@@ -433,6 +436,9 @@
 /* Define to 1 if you have the `eventfd' function. */
 #cmakedefine HAVE_EVENTFD 1
 
+/* Define to 1 if you have the `epoll_create1' function. */
+#cmakedefine HAVE_EPOLL_CREATE1 1
+
 /* If you have poll */
 #cmakedefine HAVE_POLL 1
 
@@ -565,6 +571,9 @@
 /* Define to 1 if you have the <sys/eventfd.h> header file. */
 #cmakedefine HAVE_SYS_EVENTFD_H 1
 
+/* Define to 1 if you have the <sys/epoll.h> header file. */
+#cmakedefine HAVE_SYS_EPOLL_H 1
+
 /* Define to 1 if you have the <sys/filio.h> header file. */
 #cmakedefine HAVE_SYS_FILIO_H 1
 
@@ -32,6 +32,7 @@
 #  define curl_thread_t_null     (pthread_t *)0
 #  define Curl_mutex_init(m)     pthread_mutex_init(m, NULL)
 #  define Curl_mutex_acquire(m)  pthread_mutex_lock(m)
+#  define Curl_mutex_try_acquire(m) (!pthread_mutex_trylock(m))
 #  define Curl_mutex_release(m)  pthread_mutex_unlock(m)
 #  define Curl_mutex_destroy(m)  pthread_mutex_destroy(m)
 #elif defined(USE_THREADS_WIN32)
@@ -46,10 +47,43 @@
 #    define Curl_mutex_init(m)   InitializeCriticalSectionEx(m, 0, 1)
 #  endif
 #  define Curl_mutex_acquire(m)  EnterCriticalSection(m)
+#  define Curl_mutex_try_acquire(m) (!!TryEnterCriticalSection(m))
 #  define Curl_mutex_release(m)  LeaveCriticalSection(m)
 #  define Curl_mutex_destroy(m)  DeleteCriticalSection(m)
 #endif
 
+/* Reader/writer locks. Release a lock acquired shared with
+   Curl_rwlock_release_shared(). */
+#if defined(USE_THREADS_POSIX)
+#  define curl_rwlock_t          pthread_rwlock_t
+#  define Curl_rwlock_init(l)    pthread_rwlock_init(l, NULL)
+#  define Curl_rwlock_acquire_shared(l) pthread_rwlock_rdlock(l)
+#  define Curl_rwlock_acquire(l) pthread_rwlock_wrlock(l)
+#  define Curl_rwlock_release_shared(l) pthread_rwlock_unlock(l)
+#  define Curl_rwlock_release(l) pthread_rwlock_unlock(l)
+#  define Curl_rwlock_destroy(l) pthread_rwlock_destroy(l)
+#elif defined(USE_THREADS_WIN32)
+#  if !defined(_WIN32_WINNT) || !defined(_WIN32_WINNT_VISTA) || \
+      (_WIN32_WINNT < _WIN32_WINNT_VISTA)
+/* no slim reader/writer locks, readers take turns */
+#    define curl_rwlock_t          CRITICAL_SECTION
+#    define Curl_rwlock_init(l)    InitializeCriticalSection(l)
+#    define Curl_rwlock_acquire_shared(l) EnterCriticalSection(l)
+#    define Curl_rwlock_acquire(l) EnterCriticalSection(l)
+#    define Curl_rwlock_release_shared(l) LeaveCriticalSection(l)
+#    define Curl_rwlock_release(l) LeaveCriticalSection(l)
+#    define Curl_rwlock_destroy(l) DeleteCriticalSection(l)
+#  else
+#    define curl_rwlock_t          SRWLOCK
+#    define Curl_rwlock_init(l)    InitializeSRWLock(l)
+#    define Curl_rwlock_acquire_shared(l) AcquireSRWLockShared(l)
+#    define Curl_rwlock_acquire(l) AcquireSRWLockExclusive(l)
+#    define Curl_rwlock_release_shared(l) ReleaseSRWLockShared(l)
+#    define Curl_rwlock_release(l) ReleaseSRWLockExclusive(l)
+#    define Curl_rwlock_destroy(l) Curl_nop_stmt
+#  endif
+#endif
+
 #if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
 
 curl_thread_t Curl_thread_create(
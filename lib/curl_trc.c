@@ -203,6 +203,22 @@ void Curl_trc_write(struct Curl_easy *data, const char *fmt, ...)
   }
 }
 
+struct curl_trc_feat Curl_trc_feat_mem = {
+  "MEM",
+  CURL_LOG_LVL_NONE,
+};
+
+void Curl_trc_mem(struct Curl_easy *data, const char *fmt, ...)
+{
+  DEBUGASSERT(!strchr(fmt, '\n'));
+  if(Curl_trc_ft_is_verbose(data, &Curl_trc_feat_mem)) {
+    va_list ap;
+    va_start(ap, fmt);
+    trc_infof(data, &Curl_trc_feat_mem, fmt, ap);
+    va_end(ap);
+  }
+}
+
 #ifndef CURL_DISABLE_FTP
 struct curl_trc_feat Curl_trc_feat_ftp = {
   "FTP",
@@ -270,6 +286,7 @@ struct trc_feat_def {
 static struct trc_feat_def trc_feats[] = {
   { &Curl_trc_feat_read,      TRC_CT_NONE },
   { &Curl_trc_feat_write,     TRC_CT_NONE },
+  { &Curl_trc_feat_mem,       TRC_CT_NONE },
 #ifndef CURL_DISABLE_FTP
   { &Curl_trc_feat_ftp,       TRC_CT_PROTOCOL },
 #endif
@@ -0,0 +1,324 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+/*
+ * A DNS cache file keeps resolved addresses between processes. It is read
+ * the first time the easy handle needs it and written when the handle is
+ * closed. The format is line-oriented text, one name per line:
+ *
+ *   example.com 443 "20241016 07:33:36" 93.184.215.14 2606:2800:21f:cb07::1
+ *
+ * with the hostname and port as used in the DNS cache, the time the name was
+ * resolved and its addresses in the order they were returned.
+ */
+#include "curl_setup.h"
+
+#include <curl/curl.h>
+#include "urldata.h"
+#include "dnsfile.h"
+#include "hostip.h"
+#include "curl_addrinfo.h"
+#include "curl_get_line.h"
+#include "parsedate.h"
+#include "sendf.h"
+#include "fopen.h"
+#include "rename.h"
+#include "strdup.h"
+
+/* The last 3 #include files should be in this order */
+#include "curl_printf.h"
+#include "curl_memory.h"
+#include "memdebug.h"
+
+#define MAX_DNSFILE_LINE 4095
+#define MAX_DNSFILE_DATELENSTR "64"
+#define MAX_DNSFILE_DATELEN 64
+#define MAX_DNSFILE_HOSTLENSTR "255"
+#define MAX_DNSFILE_HOSTLEN 255
+#define MAX_DNSFILE_ADDRLENSTR "63"
+#define MAX_DNSFILE_ADDRLEN 63
+
+struct dnsfile_entry {
+  struct Curl_addrinfo *addr;
+  time_t timestamp; /* when the name was resolved */
+  int port;
+  char hostname[1];
+};
+
+static void dnsfile_entry_free(void *p)
+{
+  struct dnsfile_entry *e = p;
+  Curl_freeaddrinfo(e->addr);
+  free(e);
+}
+
+/* Stores `addr` for the hostname and port, taking it over */
+static CURLcode dnsfile_store(struct dnsfile *dnsf, const char *hostname,
+                              int port, time_t timestamp,
+                              struct Curl_addrinfo *addr)
+{
+  char id[MAX_HOSTCACHE_LEN];
+  size_t idlen = Curl_hostcache_id(hostname, 0, port, id, sizeof(id));
+  size_t hostlen = strlen(hostname);
+  struct dnsfile_entry *e = calloc(1, sizeof(*e) + hostlen);
+
+  if(!e) {
+    Curl_freeaddrinfo(addr);
+    return CURLE_OUT_OF_MEMORY;
+  }
+  e->addr = addr;
+  e->timestamp = timestamp;
+  e->port = port;
+  memcpy(e->hostname, hostname, hostlen);
+  if(!Curl_hash_add(&dnsf->entries, id, idlen + 1, e)) {
+    dnsfile_entry_free(e);
+    return CURLE_OUT_OF_MEMORY;
+  }
+  return CURLE_OK;
+}
+
+/* only returns SERIOUS errors */
+static CURLcode dnsfile_add(struct dnsfile *dnsf, char *line)
+{
+  char hostname[MAX_DNSFILE_HOSTLEN + 1];
+  char date[MAX_DNSFILE_DATELEN + 1];
+  unsigned int port;
+  int len;
+  struct Curl_addrinfo *head = NULL;
+  struct Curl_addrinfo *tail = NULL;
+
+  if(sscanf(line, "%" MAX_DNSFILE_HOSTLENSTR "s %u "
+            "\"%" MAX_DNSFILE_DATELENSTR "[^\"]\"%n",
+            hostname, &port, date, &len) != 3 || (port > 0xffff))
+    return CURLE_OK;
+
+  line += len;
+  for(;;) {
+    char address[MAX_DNSFILE_ADDRLEN + 1];
+    struct Curl_addrinfo *ai;
+    int n;
+
+    if(sscanf(line, " %" MAX_DNSFILE_ADDRLENSTR "s%n", address, &n) != 1)
+      break;
+    line += n;
+    ai = Curl_str2addr(address, (int)port);
+    if(!ai) {
+      /* not an address, ignore the whole line */
+      Curl_freeaddrinfo(head);
+      return CURLE_OK;
+    }
+    if(tail)
+      tail->ai_next = ai;
+    else
+      head = ai;
+    tail = ai;
+  }
+  if(!head)
+    return CURLE_OK;
+
+  return dnsfile_store(dnsf, hostname, (int)port,
+                       Curl_getdate_capped(date), head);
+}
+
+/*
+ * Load the entries from the DNS cache file. This only returns error on
+ * major problems, lines it does not understand are ignored.
+ */
+static CURLcode dnsfile_load(struct dnsfile *dnsf)
+{
+  CURLcode result = CURLE_OK;
+  FILE *fp;
+
+  dnsf->loaded = TRUE;
+  if(!dnsf->filename[0])
+    return CURLE_OK;
+
+  fp = fopen(dnsf->filename, FOPEN_READTEXT);
+  if(fp) {
+    struct dynbuf buf;
+    Curl_dyn_init(&buf, MAX_DNSFILE_LINE);
+    while(Curl_get_line(&buf, fp)) {
+      char *lineptr = Curl_dyn_ptr(&buf);
+      while(*lineptr && ISBLANK(*lineptr))
+        lineptr++;
+      if(*lineptr == '#')
+        /* skip commented lines */
+        continue;
+
+      result = dnsfile_add(dnsf, lineptr);
+      if(result)
+        break;
+    }
+    Curl_dyn_free(&buf); /* free the line buffer */
+    fclose(fp);
+  }
+  return result;
+}
+
+/*
+ * Write this single entry to a single output line
+ */
+static CURLcode dnsfile_out(struct dnsfile_entry *e, FILE *fp)
+{
+  struct tm stamp;
+  struct Curl_addrinfo *ai;
+  CURLcode result = Curl_gmtime(e->timestamp, &stamp);
+  if(result)
+    return result;
+
+  fprintf(fp, "%s %d \"%d%02d%02d %02d:%02d:%02d\"",
+          e->hostname, e->port,
+          stamp.tm_year + 1900, stamp.tm_mon + 1, stamp.tm_mday,
+          stamp.tm_hour, stamp.tm_min, stamp.tm_sec);
+  for(ai = e->addr; ai; ai = ai->ai_next) {
+    char address[MAX_IPADR_LEN];
+    Curl_printable_address(ai, address, sizeof(address));
+    if(address[0])
+      fprintf(fp, " %s", address);
+  }
+  fputs("\n", fp);
+  return CURLE_OK;
+}
+
+/* ---- library-wide functions below ---- */
+
+/*
+ * Curl_dnsfile_init() creates a new DNS cache file instance for the file.
+ * Nothing is read until it is first used.
+ */
+struct dnsfile *Curl_dnsfile_init(const char *file)
+{
+  struct dnsfile *dnsf = calloc(1, sizeof(struct dnsfile));
+  if(!dnsf)
+    return NULL;
+  dnsf->filename = strdup(file);
+  if(!dnsf->filename) {
+    free(dnsf);
+    return NULL;
+  }
+  Curl_hash_init(&dnsf->entries, 31, Curl_hash_str, Curl_str_key_compare,
+                 dnsfile_entry_free);
+  return dnsf;
+}
+
+/*
+ * Curl_dnsfile_cleanup() frees the instance and all its entries.
+ */
+void Curl_dnsfile_cleanup(struct dnsfile **dnsfp)
+{
+  struct dnsfile *dnsf = *dnsfp;
+  if(dnsf) {
+    Curl_hash_destroy(&dnsf->entries);
+    free(dnsf->filename);
+    free(dnsf);
+    *dnsfp = NULL;
+  }
+}
+
+struct Curl_addrinfo *Curl_dnsfile_get(struct Curl_easy *data,
+                                       struct dnsfile *dnsf,
+                                       const char *hostname, int port,
+                                       int max_age, time_t *timestamp)
+{
+  char id[MAX_HOSTCACHE_LEN];
+  size_t idlen;
+  struct dnsfile_entry *e;
+
+  if(!dnsf->loaded && dnsfile_load(dnsf))
+    return NULL;
+
+  idlen = Curl_hostcache_id(hostname, 0, port, id, sizeof(id));
+  e = Curl_hash_pick(&dnsf->entries, id, idlen + 1);
+  if(!e)
+    return NULL;
+  if((max_age != -1) && ((time(NULL) - e->timestamp) >= max_age)) {
+    infof(data, "Hostname %s in DNS cache file is too old", hostname);
+    return NULL;
+  }
+  *timestamp = e->timestamp;
+  return Curl_addrinfo_dup(e->addr);
+}
+
+CURLcode Curl_dnsfile_add(struct Curl_easy *data, struct dnsfile *dnsf,
+                          const struct Curl_dns_entry *dns)
+{
+  struct Curl_addrinfo *addr;
+  (void)data;
+
+  if(!dnsf->loaded) {
+    /* load first, to not lose the entries of the file when saving */
+    CURLcode result = dnsfile_load(dnsf);
+    if(result)
+      return result;
+  }
+
+  addr = Curl_addrinfo_dup(dns->addr);
+  if(!addr)
+    return CURLE_OUT_OF_MEMORY;
+  return dnsfile_store(dnsf, dns->hostname, dns->hostport, dns->timestamp,
+                       addr);
+}
+
+/*
+ * Curl_dnsfile_save() writes the entries that have not been too old to be
+ * used for a while to the file, if it has been read.
+ */
+CURLcode Curl_dnsfile_save(struct Curl_easy *data, struct dnsfile *dnsf)
+{
+  CURLcode result = CURLE_OK;
+  FILE *out;
+  char *tempstore = NULL;
+  int max_age = data->set.dns_cache_timeout;
+  time_t now = time(NULL);
+
+  if(!dnsf || !dnsf->loaded || !dnsf->filename[0])
+    /* not used, or a zero length filename */
+    return CURLE_OK;
+
+  result = Curl_fopen(data, dnsf->filename, &out, &tempstore);
+  if(!result) {
+    struct Curl_hash_iterator iter;
+    struct Curl_hash_element *he;
+    fputs("# Your DNS cache file, see CURLOPT_DNS_CACHE_FILE\n"
+          "# This file was generated by libcurl! Edit at your own risk.\n",
+          out);
+    Curl_hash_start_iterate(&dnsf->entries, &iter);
+    for(he = Curl_hash_next_element(&iter); he;
+        he = Curl_hash_next_element(&iter)) {
+      struct dnsfile_entry *e = he->ptr;
+      if((max_age != -1) && ((now - e->timestamp) >= max_age))
+        continue;
+      result = dnsfile_out(e, out);
+      if(result)
+        break;
+    }
+    fclose(out);
+    if(!result && tempstore && Curl_rename(tempstore, dnsf->filename))
+      result = CURLE_WRITE_ERROR;
+
+    if(result && tempstore)
+      unlink(tempstore);
+  }
+  free(tempstore);
+  return result;
+}
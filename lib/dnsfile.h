@@ -0,0 +1,57 @@
+#ifndef HEADER_CURL_DNSFILE_H
+#define HEADER_CURL_DNSFILE_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curl_setup.h"
+#include "hash.h"
+
+struct Curl_addrinfo;
+struct Curl_dns_entry;
+
+/* The DNS cache file of an easy handle. Its entries are kept apart from the
+   DNS cache and are only put into that when a name is looked up. */
+struct dnsfile {
+  struct Curl_hash entries; /* hostcache id -> struct dnsfile_entry */
+  char *filename;
+  BIT(loaded);              /* the file has been read */
+};
+
+struct dnsfile *Curl_dnsfile_init(const char *file);
+void Curl_dnsfile_cleanup(struct dnsfile **dnsfp);
+
+/* Returns a copy of the addresses stored for the hostname and port, NULL if
+   there are none or they were resolved 'max_age' seconds ago or longer.
+   '*timestamp' is set to the time they were resolved. */
+struct Curl_addrinfo *Curl_dnsfile_get(struct Curl_easy *data,
+                                       struct dnsfile *dnsf,
+                                       const char *hostname, int port,
+                                       int max_age, time_t *timestamp);
+
+/* Stores a copy of the addresses of the DNS cache entry */
+CURLcode Curl_dnsfile_add(struct Curl_easy *data, struct dnsfile *dnsf,
+                          const struct Curl_dns_entry *dns);
+
+CURLcode Curl_dnsfile_save(struct Curl_easy *data, struct dnsfile *dnsf);
+
+#endif /* HEADER_CURL_DNSFILE_H */
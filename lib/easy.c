@@ -73,6 +73,7 @@
 #include "http2.h"
 #include "dynbuf.h"
 #include "altsvc.h"
+#include "dnsfile.h"
 #include "hsts.h"
 
 #include "easy_lock.h"
@@ -994,6 +995,11 @@ struct Curl_easy *curl_easy_duphandle(struct Curl_easy *data)
       (void)Curl_altsvc_load(outcurl->asi, outcurl->set.str[STRING_ALTSVC]);
   }
 #endif
+  if(data->dnsf) {
+    outcurl->dnsf = Curl_dnsfile_init(data->dnsf->filename);
+    if(!outcurl->dnsf)
+      goto fail;
+  }
 #ifndef CURL_DISABLE_HSTS
   if(data->hsts) {
     outcurl->hsts = Curl_hsts_init();
@@ -1054,6 +1060,7 @@ fail:
 #endif
     Curl_dyn_free(&outcurl->state.headerb);
     Curl_altsvc_cleanup(&outcurl->asi);
+    Curl_dnsfile_cleanup(&outcurl->dnsf);
     Curl_hsts_cleanup(&outcurl->hsts);
     Curl_freeset(outcurl);
     free(outcurl);
@@ -75,6 +75,8 @@ struct curl_easyoption Curl_easyopts[] = {
   {"DIRLISTONLY", CURLOPT_DIRLISTONLY, CURLOT_LONG, 0},
   {"DISALLOW_USERNAME_IN_URL", CURLOPT_DISALLOW_USERNAME_IN_URL,
    CURLOT_LONG, 0},
+  {"DNS_CACHE_FILE", CURLOPT_DNS_CACHE_FILE, CURLOT_STRING, 0},
+  {"DNS_CACHE_STALE", CURLOPT_DNS_CACHE_STALE, CURLOT_LONG, 0},
   {"DNS_CACHE_TIMEOUT", CURLOPT_DNS_CACHE_TIMEOUT, CURLOT_LONG, 0},
   {"DNS_INTERFACE", CURLOPT_DNS_INTERFACE, CURLOT_STRING, 0},
   {"DNS_LOCAL_IP4", CURLOPT_DNS_LOCAL_IP4, CURLOT_STRING, 0},
@@ -247,11 +249,14 @@ struct curl_easyoption Curl_easyopts[] = {
   {"PROXY_TRANSFER_MODE", CURLOPT_PROXY_TRANSFER_MODE, CURLOT_LONG, 0},
   {"PUT", CURLOPT_PUT, CURLOT_LONG, 0},
   {"QUICK_EXIT", CURLOPT_QUICK_EXIT, CURLOT_LONG, 0},
+  {"QUIC_CC_ALGO", CURLOPT_QUIC_CC_ALGO, CURLOT_VALUES, 0},
   {"QUOTE", CURLOPT_QUOTE, CURLOT_SLIST, 0},
   {"RANDOM_FILE", CURLOPT_RANDOM_FILE, CURLOT_STRING, 0},
   {"RANGE", CURLOPT_RANGE, CURLOT_STRING, 0},
   {"READDATA", CURLOPT_READDATA, CURLOT_CBPTR, 0},
   {"READFUNCTION", CURLOPT_READFUNCTION, CURLOT_FUNCTION, 0},
+  {"RECVBUFFERDATA", CURLOPT_RECVBUFFERDATA, CURLOT_CBPTR, 0},
+  {"RECVBUFFERFUNCTION", CURLOPT_RECVBUFFERFUNCTION, CURLOT_FUNCTION, 0},
   {"REDIR_PROTOCOLS", CURLOPT_REDIR_PROTOCOLS, CURLOT_LONG, 0},
   {"REDIR_PROTOCOLS_STR", CURLOPT_REDIR_PROTOCOLS_STR, CURLOT_STRING, 0},
   {"REFERER", CURLOPT_REFERER, CURLOT_STRING, 0},
@@ -377,6 +382,6 @@ struct curl_easyoption Curl_easyopts[] = {
  */
 int Curl_easyopts_check(void)
 {
-  return ((CURLOPT_LASTENTRY%10000) != (326 + 1));
+  return ((CURLOPT_LASTENTRY%10000) != (331 + 1));
 }
 #endif
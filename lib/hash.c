@@ -27,7 +27,6 @@
 #include <curl/curl.h>
 
 #include "hash.h"
-#include "llist.h"
 #include "curl_memory.h"
 
 /* The last #include file should be: */
@@ -37,12 +36,19 @@
 #define HASHINIT 0x7017e781
 #define ITERINIT 0x5FEDCBA9
 
-static void
-hash_element_dtor(void *user, void *element)
-{
-  struct Curl_hash *h = (struct Curl_hash *) user;
-  struct Curl_hash_element *e = (struct Curl_hash_element *) element;
+/* the table never gets smaller than this */
+#define HASH_MIN_SLOTS 8
+
+/* Marks a slot whose element has been deleted. Lookups probe past it,
+   inserts may reuse it. */
+static struct Curl_hash_element hash_tombstone;
+#define TOMBSTONE (&hash_tombstone)
 
+#define SLOT_LIVE(s) ((s)->he && ((s)->he != TOMBSTONE))
+
+static void hash_element_dtor(struct Curl_hash *h,
+                              struct Curl_hash_element *e)
+{
   if(e->ptr) {
     if(e->dtor)
       e->dtor(e->key, e->key_len, e->ptr);
@@ -56,11 +62,12 @@ hash_element_dtor(void *user, void *element)
   free(e);
 }
 
-/* Initializes a hash structure.
- * Return 1 on error, 0 is fine.
+/* Initializes a hash structure. `slots` is the initial size of the table,
+ * it is rounded up to a power of two and grows when needed.
  *
  * @unittest: 1602
  * @unittest: 1603
+ * @unittest: 1617
  */
 void
 Curl_hash_init(struct Curl_hash *h,
@@ -69,23 +76,110 @@ Curl_hash_init(struct Curl_hash *h,
                comp_function comparator,
                Curl_hash_dtor dtor)
 {
+  size_t n = HASH_MIN_SLOTS;
+
   DEBUGASSERT(h);
   DEBUGASSERT(slots);
   DEBUGASSERT(hfunc);
   DEBUGASSERT(comparator);
   DEBUGASSERT(dtor);
 
+  while(n < slots)
+    n <<= 1;
+
   h->table = NULL;
   h->hash_func = hfunc;
   h->comp_func = comparator;
   h->dtor = dtor;
   h->size = 0;
-  h->slots = slots;
+  h->used = 0;
+  h->slots = n;
 #ifdef DEBUGBUILD
   h->init = HASHINIT;
 #endif
 }
 
+/* Spread the bits of the hash function's value over the whole word, the
+ * table index is taken from the lowest bits and the functions in use do not
+ * all return evenly distributed values (think file descriptors). */
+static size_t hash_mix(size_t hv)
+{
+  unsigned int x = (unsigned int)hv;
+
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return (size_t)x;
+}
+
+#define HASH_KEY(h,k,l) hash_mix((h)->hash_func(k, l, CURL_HASH_RANGE))
+
+/* Return the index of the slot holding `key` or `h->slots` if there is
+ * none. */
+static size_t hash_find(struct Curl_hash *h, void *key, size_t key_len,
+                        size_t hv)
+{
+  size_t mask = h->slots - 1;
+  size_t i = hv & mask;
+
+  /* there is always an empty slot, see Curl_hash_add2() */
+  for(;;) {
+    struct Curl_hash_slot *s = &h->table[i];
+    if(!s->he)
+      return h->slots;
+    if((s->he != TOMBSTONE) && (s->hash == hv) &&
+       h->comp_func(s->he->key, s->he->key_len, key, key_len))
+      return i;
+    i = (i + 1) & mask;
+  }
+}
+
+/* Move all elements into a new table with `slots` entries, dropping the
+ * tombstones. Returns non-zero on OOM. */
+static int hash_resize(struct Curl_hash *h, size_t slots)
+{
+  struct Curl_hash_slot *table = calloc(slots, sizeof(*table));
+  size_t mask = slots - 1;
+  size_t i;
+
+  if(!table)
+    return 1;
+  for(i = 0; i < h->slots; ++i) {
+    struct Curl_hash_slot *s = &h->table[i];
+    if(SLOT_LIVE(s)) {
+      size_t j = s->hash & mask;
+      while(table[j].he)
+        j = (j + 1) & mask;
+      table[j] = *s;
+    }
+  }
+  free(h->table);
+  h->table = table;
+  h->slots = slots;
+  h->used = h->size;
+  return 0;
+}
+
+/* Empty the slot at index `i`. It only needs to become a tombstone when
+ * probes for other keys may have to go past it. */
+static void hash_slot_clear(struct Curl_hash *h, size_t i)
+{
+  size_t mask = h->slots - 1;
+
+  if(h->table[(i + 1) & mask].he) {
+    h->table[i].he = TOMBSTONE;
+    return;
+  }
+  /* no probe continues beyond here, neither through tombstones before */
+  do {
+    h->table[i].he = NULL;
+    --h->used;
+    i = (i - 1) & mask;
+  } while(h->table[i].he == TOMBSTONE);
+}
+
 static struct Curl_hash_element *
 mk_hash_element(const void *key, size_t key_len, const void *p,
                 Curl_hash_elem_dtor dtor)
@@ -103,46 +197,59 @@ mk_hash_element(const void *key, size_t key_len, const void *p,
   return he;
 }
 
-#define FETCH_LIST(x,y,z) &x->table[x->hash_func(y, z, x->slots)]
-
 void *Curl_hash_add2(struct Curl_hash *h, void *key, size_t key_len, void *p,
                      Curl_hash_elem_dtor dtor)
 {
-  struct Curl_hash_element  *he;
-  struct Curl_llist_node *le;
-  struct Curl_llist *l;
+  struct Curl_hash_element *he;
+  size_t hv;
+  size_t i;
 
   DEBUGASSERT(h);
   DEBUGASSERT(h->slots);
   DEBUGASSERT(h->init == HASHINIT);
   if(!h->table) {
-    size_t i;
-    h->table = malloc(h->slots * sizeof(struct Curl_llist));
+    h->table = calloc(h->slots, sizeof(struct Curl_hash_slot));
     if(!h->table)
       return NULL; /* OOM */
-    for(i = 0; i < h->slots; ++i)
-      Curl_llist_init(&h->table[i], hash_element_dtor);
   }
 
-  l = FETCH_LIST(h, key, key_len);
-
-  for(le = Curl_llist_head(l); le; le = Curl_node_next(le)) {
-    he = (struct Curl_hash_element *) Curl_node_elem(le);
-    if(h->comp_func(he->key, he->key_len, key, key_len)) {
-      Curl_node_uremove(le, (void *)h);
-      --h->size;
-      break;
-    }
+  hv = HASH_KEY(h, key, key_len);
+  i = hash_find(h, key, key_len, hv);
+  if(i < h->slots) {
+    /* replace the existing entry */
+    struct Curl_hash_element *old = h->table[i].he;
+    he = mk_hash_element(key, key_len, p, dtor);
+    if(!he)
+      return NULL;
+    h->table[i].he = he;
+    hash_element_dtor(h, old);
+    return p;
   }
 
-  he = mk_hash_element(key, key_len, p, dtor);
-  if(he) {
-    Curl_llist_append(l, he, &he->list);
-    ++h->size;
-    return p; /* return the new entry */
+  /* keep the table at most 3/4 full, counting tombstones, so that probes
+     stay short and always find an empty slot */
+  if((h->used + 1) * 4 > h->slots * 3) {
+    size_t slots = h->slots;
+    if((h->size + 1) * 2 > slots)
+      slots <<= 1;
+    if(hash_resize(h, slots))
+      return NULL;
   }
 
-  return NULL; /* failure */
+  he = mk_hash_element(key, key_len, p, dtor);
+  if(!he)
+    return NULL; /* failure */
+
+  /* the first empty or deleted slot on the probe sequence */
+  i = hv & (h->slots - 1);
+  while(SLOT_LIVE(&h->table[i]))
+    i = (i + 1) & (h->slots - 1);
+  if(!h->table[i].he)
+    ++h->used;
+  h->table[i].hash = hv;
+  h->table[i].he = he;
+  ++h->size;
+  return p; /* return the new entry */
 }
 
 /* Insert the data in the hash. If there already was a match in the hash, that
@@ -152,6 +259,7 @@ void *Curl_hash_add2(struct Curl_hash *h, void *key, size_t key_len, void *p,
  * @unittest: 1305
  * @unittest: 1602
  * @unittest: 1603
+ * @unittest: 1617
  */
 void *
 Curl_hash_add(struct Curl_hash *h, void *key, size_t key_len, void *p)
@@ -163,6 +271,7 @@ Curl_hash_add(struct Curl_hash *h, void *key, size_t key_len, void *p)
  * Returns non-zero on failure.
  *
  * @unittest: 1603
+ * @unittest: 1617
  */
 int Curl_hash_delete(struct Curl_hash *h, void *key, size_t key_len)
 {
@@ -170,16 +279,13 @@ int Curl_hash_delete(struct Curl_hash *h, void *key, size_t key_len)
   DEBUGASSERT(h->slots);
   DEBUGASSERT(h->init == HASHINIT);
   if(h->table) {
-    struct Curl_llist_node *le;
-    struct Curl_llist *l = FETCH_LIST(h, key, key_len);
-
-    for(le = Curl_llist_head(l); le; le = Curl_node_next(le)) {
-      struct Curl_hash_element *he = Curl_node_elem(le);
-      if(h->comp_func(he->key, he->key_len, key, key_len)) {
-        Curl_node_uremove(le, (void *) h);
-        --h->size;
-        return 0;
-      }
+    size_t i = hash_find(h, key, key_len, HASH_KEY(h, key, key_len));
+    if(i < h->slots) {
+      struct Curl_hash_element *he = h->table[i].he;
+      hash_slot_clear(h, i);
+      --h->size;
+      hash_element_dtor(h, he);
+      return 0;
     }
   }
   return 1;
@@ -188,6 +294,7 @@ int Curl_hash_delete(struct Curl_hash *h, void *key, size_t key_len)
 /* Retrieves a hash element.
  *
  * @unittest: 1603
+ * @unittest: 1617
  */
 void *
 Curl_hash_pick(struct Curl_hash *h, void *key, size_t key_len)
@@ -195,16 +302,11 @@ Curl_hash_pick(struct Curl_hash *h, void *key, size_t key_len)
   DEBUGASSERT(h);
   DEBUGASSERT(h->init == HASHINIT);
   if(h->table) {
-    struct Curl_llist_node *le;
-    struct Curl_llist *l;
+    size_t i;
     DEBUGASSERT(h->slots);
-    l = FETCH_LIST(h, key, key_len);
-    for(le = Curl_llist_head(l); le; le = Curl_node_next(le)) {
-      struct Curl_hash_element *he = Curl_node_elem(le);
-      if(h->comp_func(he->key, he->key_len, key, key_len)) {
-        return he->ptr;
-      }
-    }
+    i = hash_find(h, key, key_len, HASH_KEY(h, key, key_len));
+    if(i < h->slots)
+      return h->table[i].he->ptr;
   }
 
   return NULL;
@@ -224,11 +326,16 @@ Curl_hash_destroy(struct Curl_hash *h)
   if(h->table) {
     size_t i;
     for(i = 0; i < h->slots; ++i) {
-      Curl_llist_destroy(&h->table[i], (void *) h);
+      struct Curl_hash_element *he = h->table[i].he;
+      if(he && (he != TOMBSTONE)) {
+        h->table[i].he = NULL;
+        hash_element_dtor(h, he);
+      }
     }
     Curl_safefree(h->table);
   }
   h->size = 0;
+  h->used = 0;
   h->slots = 0;
 }
 
@@ -260,20 +367,19 @@ Curl_hash_clean_with_criterium(struct Curl_hash *h, void *user,
 
   DEBUGASSERT(h->init == HASHINIT);
   for(i = 0; i < h->slots; ++i) {
-    struct Curl_llist *list = &h->table[i];
-    struct Curl_llist_node *le =
-      Curl_llist_head(list); /* get first list entry */
-    while(le) {
-      struct Curl_hash_element *he = Curl_node_elem(le);
-      struct Curl_llist_node *lnext = Curl_node_next(le);
-      /* ask the callback function if we shall remove this entry or not */
-      if(!comp || comp(user, he->ptr)) {
-        Curl_node_uremove(le, (void *) h);
-        --h->size; /* one less entry in the hash now */
-      }
-      le = lnext;
+    struct Curl_hash_element *he = h->table[i].he;
+    /* ask the callback function if we shall remove this entry or not */
+    if(he && (he != TOMBSTONE) && (!comp || comp(user, he->ptr))) {
+      hash_slot_clear(h, i);
+      --h->size; /* one less entry in the hash now */
+      hash_element_dtor(h, he);
     }
   }
+  if(!h->size && h->used) {
+    /* only tombstones left, start over */
+    memset(h->table, 0, h->slots * sizeof(struct Curl_hash_slot));
+    h->used = 0;
+  }
 }
 
 size_t Curl_hash_str(void *key, size_t key_length, size_t slots_num)
@@ -306,41 +412,31 @@ void Curl_hash_start_iterate(struct Curl_hash *hash,
   DEBUGASSERT(hash->init == HASHINIT);
   iter->hash = hash;
   iter->slot_index = 0;
-  iter->current_element = NULL;
 #ifdef DEBUGBUILD
   iter->init = ITERINIT;
 #endif
 }
 
+/* Return the next element of the hash or NULL when all have been seen. The
+ * element last returned may be deleted while iterating, but adding to the
+ * hash may make the iteration miss elements or see them twice. */
 struct Curl_hash_element *
 Curl_hash_next_element(struct Curl_hash_iterator *iter)
 {
   struct Curl_hash *h;
+  size_t i;
   DEBUGASSERT(iter->init == ITERINIT);
   h = iter->hash;
   if(!h->table)
     return NULL; /* empty hash, nothing to return */
 
-  /* Get the next element in the current list, if any */
-  if(iter->current_element)
-    iter->current_element = Curl_node_next(iter->current_element);
-
-  /* If we have reached the end of the list, find the next one */
-  if(!iter->current_element) {
-    size_t i;
-    for(i = iter->slot_index; i < h->slots; i++) {
-      if(Curl_llist_head(&h->table[i])) {
-        iter->current_element = Curl_llist_head(&h->table[i]);
-        iter->slot_index = i + 1;
-        break;
-      }
+  for(i = iter->slot_index; i < h->slots; i++) {
+    if(SLOT_LIVE(&h->table[i])) {
+      iter->slot_index = i + 1;
+      return h->table[i].he;
     }
   }
-
-  if(iter->current_element) {
-    struct Curl_hash_element *he = Curl_node_elem(iter->current_element);
-    return he;
-  }
+  iter->slot_index = h->slots;
   return NULL;
 }
 
@@ -30,11 +30,15 @@
 
 #include "llist.h"
 
-/* Hash function prototype */
+/* Hash function prototype. The table calls it with `slots_num` set to
+   CURL_HASH_RANGE and wants a value below that, as well spread as possible.
+   The table mixes it further and keeps it to skip comparing most keys. */
 typedef size_t (*hash_function) (void *key,
                                  size_t key_length,
                                  size_t slots_num);
 
+#define CURL_HASH_RANGE 0x7fffffff
+
 /*
    Comparator function prototype. Compares two keys.
 */
@@ -45,8 +49,17 @@ typedef size_t (*comp_function) (void *key1,
 
 typedef void (*Curl_hash_dtor)(void *);
 
+struct Curl_hash_element;
+
+/* A slot in the open addressed table. `he` is NULL when the slot has never
+   been used and the hash's tombstone when its element was deleted. */
+struct Curl_hash_slot {
+  size_t hash; /* mixed hash value of the element's key */
+  struct Curl_hash_element *he;
+};
+
 struct Curl_hash {
-  struct Curl_llist *table;
+  struct Curl_hash_slot *table;
 
   /* Hash function to be used for this hash table */
   hash_function hash_func;
@@ -54,8 +67,9 @@ struct Curl_hash {
   /* Comparator function to compare keys */
   comp_function comp_func;
   Curl_hash_dtor   dtor;
-  size_t slots;
-  size_t size;
+  size_t slots; /* entries in `table`, always a power of two */
+  size_t size;  /* elements in the hash */
+  size_t used;  /* slots not empty, elements plus tombstones */
 #ifdef DEBUGBUILD
   int init;
 #endif
@@ -64,7 +78,6 @@ struct Curl_hash {
 typedef void (*Curl_hash_elem_dtor)(void *key, size_t key_len, void *p);
 
 struct Curl_hash_element {
-  struct Curl_llist_node list;
   void   *ptr;
   Curl_hash_elem_dtor dtor;
   size_t key_len;
@@ -77,7 +90,6 @@ struct Curl_hash_element {
 struct Curl_hash_iterator {
   struct Curl_hash *hash;
   size_t slot_index;
-  struct Curl_llist_node *current_element;
 #ifdef DEBUGBUILD
   int init;
 #endif
@@ -29,6 +29,7 @@
 #include "strcase.h"
 #include "sendf.h"
 #include "headers.h"
+#include "slab.h"
 
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
@@ -37,6 +38,174 @@
 
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_HEADERS_API)
 
+/*
+ * The headers of a transfer are kept in an arena: blocks of memory that
+ * each header, and anything else stored for it, is cut from in order. They
+ * are all freed at once when the transfer is done with them.
+ *
+ * The headers with the same name in the same request form a group, found
+ * by name and request in an open addressing hash table. The group knows
+ * how many headers of each type it has and links them in the order they
+ * arrived, so that finding a header does not need to look at others.
+ */
+
+#define HDS_INDEX_SLOTS 16  /* initial index size, must be a power of 2 */
+#define HDS_TYPES 5         /* the number of CURLH_* origin bits */
+
+struct hds_block {
+  struct hds_block *next;
+  size_t size; /* usable bytes after the struct */
+  size_t used; /* bytes handed out */
+};
+
+struct hds_name {
+  const char *name;  /* the name of the group's first header */
+  size_t hash;
+  int request;
+  size_t counts[HDS_TYPES]; /* number of headers per CURLH_* bit */
+  struct Curl_header_store *first;
+  struct Curl_header_store *last;
+};
+
+struct Curl_header_arena {
+  struct hds_block *blocks; /* the one new memory is taken from first */
+  struct hds_name **index;  /* 'slots' entries, NULL when unused */
+  size_t slots;
+  size_t used;
+};
+
+#define HDS_ALIGN(x) (((x) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define HDS_HEAD HDS_ALIGN(sizeof(struct hds_block))
+#define HDS_MEM(b) ((char *)(b) + HDS_HEAD)
+/* usable bytes in a regular block, which fills the largest slab class */
+#define HDS_BLOCK_SIZE (CURL_SLAB_MAX - HDS_HEAD)
+
+/* Get 'len' bytes, aligned for any struct stored here */
+static void *hds_alloc(struct Curl_easy *data, size_t len)
+{
+  struct Curl_header_arena *a = data->state.hdsarena;
+  struct hds_block *b = a->blocks;
+  size_t size = len > HDS_BLOCK_SIZE ? len : HDS_BLOCK_SIZE;
+  size_t offset;
+  char *p;
+
+  if(b) {
+    offset = HDS_ALIGN(b->used);
+    if((offset <= b->size) && (len <= b->size - offset)) {
+      b->used = offset + len;
+      return HDS_MEM(b) + offset;
+    }
+  }
+
+  b = Curl_slab_alloc(data, HDS_HEAD + size);
+  if(!b)
+    return NULL;
+  b->size = size;
+  b->used = len;
+  p = HDS_MEM(b);
+  if(a->blocks && (len > HDS_BLOCK_SIZE)) {
+    /* a block of its own, keep filling the current one */
+    b->next = a->blocks->next;
+    a->blocks->next = b;
+  }
+  else {
+    b->next = a->blocks;
+    a->blocks = b;
+  }
+  return p;
+}
+
+/* Give back the last 'len' bytes taken, if nothing was taken after them */
+static void hds_unalloc(struct Curl_header_arena *a, void *p, size_t len)
+{
+  struct hds_block *b = a->blocks;
+  if(b && ((char *)p + len == HDS_MEM(b) + b->used))
+    b->used -= len;
+}
+
+static size_t hds_hash(const char *name, int request)
+{
+  size_t h = 5381 + (size_t)request;
+  while(*name)
+    h = (h << 5) + h + (unsigned char)Curl_raw_tolower(*name++);
+  return h;
+}
+
+/* Find the slot for the group with 'name' in 'request': the one that holds
+   it, or the empty one it would be put in. The index must not be full. */
+static struct hds_name **hds_slot(struct Curl_header_arena *a,
+                                  const char *name, int request, size_t hash)
+{
+  size_t mask = a->slots - 1;
+  size_t i = hash & mask;
+  for(;;) {
+    struct hds_name *g = a->index[i];
+    if(!g ||
+       ((g->hash == hash) && (g->request == request) &&
+        strcasecompare(g->name, name)))
+      return &a->index[i];
+    i = (i + 1) & mask;
+  }
+}
+
+/* Make room for one more group in the index */
+static CURLcode hds_grow(struct Curl_easy *data, struct Curl_header_arena *a)
+{
+  struct hds_name **old = a->index;
+  size_t oldslots = a->slots;
+  size_t i;
+
+  if(old && ((a->used + 1) * 4 <= a->slots * 3))
+    return CURLE_OK;
+
+  a->slots = old ? oldslots * 2 : HDS_INDEX_SLOTS;
+  a->index = Curl_slab_alloc(data, a->slots * sizeof(struct hds_name *));
+  if(!a->index) {
+    a->index = old;
+    a->slots = oldslots;
+    return CURLE_OUT_OF_MEMORY;
+  }
+  for(i = 0; i < oldslots; i++) {
+    struct hds_name *g = old[i];
+    if(g)
+      *hds_slot(a, g->name, g->request, g->hash) = g;
+  }
+  Curl_slab_free(data, old, oldslots * sizeof(struct hds_name *));
+  return CURLE_OK;
+}
+
+static struct hds_name *hds_group(struct Curl_easy *data, const char *name,
+                                  int request)
+{
+  struct Curl_header_arena *a = data->state.hdsarena;
+  if(!a || !a->index)
+    return NULL;
+  return *hds_slot(a, name, request, hds_hash(name, request));
+}
+
+/* The number of the type's bit, which has to be a single CURLH_* one */
+static unsigned int hds_typebit(unsigned char type)
+{
+  unsigned int i = 0;
+  while(!(type & 1) && (i < HDS_TYPES - 1)) {
+    type >>= 1;
+    i++;
+  }
+  return i;
+}
+
+/* The number of headers in the group whose type is in the mask */
+static size_t hds_amount(const struct hds_name *g, unsigned int type)
+{
+  size_t amount = 0;
+  unsigned int i;
+  for(i = 0; i < HDS_TYPES; i++) {
+    if(type & (1u << i))
+      amount += g->counts[i];
+  }
+  return amount;
+}
+
 /* Generate the curl_header struct for the user. This function MUST assign all
    struct fields in the output struct. */
 static void copy_header_external(struct Curl_header_store *hs,
@@ -66,13 +235,11 @@ CURLHcode curl_easy_header(CURL *easy,
                            int request,
                            struct curl_header **hout)
 {
-  struct Curl_llist_node *e;
-  struct Curl_llist_node *e_pick = NULL;
   struct Curl_easy *data = easy;
   size_t match = 0;
-  size_t amount = 0;
-  struct Curl_header_store *hs = NULL;
-  struct Curl_header_store *pick = NULL;
+  size_t amount;
+  struct hds_name *group;
+  struct Curl_header_store *hs;
   if(!name || !hout || !data ||
      (type > (CURLH_HEADER|CURLH_TRAILER|CURLH_CONNECT|CURLH_1XX|
               CURLH_PSEUDO)) || !type || (request < -1))
@@ -84,41 +251,22 @@ CURLHcode curl_easy_header(CURL *easy,
   if(request == -1)
     request = data->state.requests;
 
-  /* we need a first round to count amount of this header */
-  for(e = Curl_llist_head(&data->state.httphdrs); e; e = Curl_node_next(e)) {
-    hs = Curl_node_elem(e);
-    if(strcasecompare(hs->name, name) &&
-       (hs->type & type) &&
-       (hs->request == request)) {
-      amount++;
-      pick = hs;
-      e_pick = e;
-    }
-  }
+  group = hds_group(data, name, request);
+  amount = group ? hds_amount(group, type) : 0;
   if(!amount)
     return CURLHE_MISSING;
   else if(nameindex >= amount)
     return CURLHE_BADINDEX;
 
-  if(nameindex == amount - 1)
-    /* if the last or only occurrence is what's asked for, then we know it */
-    hs = pick;
-  else {
-    for(e = Curl_llist_head(&data->state.httphdrs); e; e = Curl_node_next(e)) {
-      hs = Curl_node_elem(e);
-      if(strcasecompare(hs->name, name) &&
-         (hs->type & type) &&
-         (hs->request == request) &&
-         (match++ == nameindex)) {
-        e_pick = e;
-        break;
-      }
-    }
-    if(!e) /* this should not happen */
-      return CURLHE_MISSING;
+  for(hs = group->first; hs; hs = hs->next_same) {
+    if((hs->type & type) && (match++ == nameindex))
+      break;
   }
+  if(!hs) /* this should not happen */
+    return CURLHE_MISSING;
+
   /* this is the name we want */
-  copy_header_external(hs, nameindex, amount, e_pick,
+  copy_header_external(hs, nameindex, amount, &hs->node,
                        &data->state.headerout[0]);
   *hout = &data->state.headerout[0];
   return CURLHE_OK;
@@ -132,9 +280,8 @@ struct curl_header *curl_easy_nextheader(CURL *easy,
 {
   struct Curl_easy *data = easy;
   struct Curl_llist_node *pick;
-  struct Curl_llist_node *e;
   struct Curl_header_store *hs;
-  size_t amount = 0;
+  struct Curl_header_store *check;
   size_t index = 0;
 
   if(request > data->state.requests)
@@ -168,19 +315,13 @@ struct curl_header *curl_easy_nextheader(CURL *easy,
 
   hs = Curl_node_elem(pick);
 
-  /* count number of occurrences of this name within the mask and figure out
-     the index for the currently selected entry */
-  for(e = Curl_llist_head(&data->state.httphdrs); e; e = Curl_node_next(e)) {
-    struct Curl_header_store *check = Curl_node_elem(e);
-    if(strcasecompare(hs->name, check->name) &&
-       (check->request == request) &&
-       (check->type & type))
-      amount++;
-    if(e == pick)
-      index = amount - 1;
+  /* the index of the selected entry among its name within the mask */
+  for(check = hs->group->first; check != hs; check = check->next_same) {
+    if(check->type & type)
+      index++;
   }
 
-  copy_header_external(hs, index, amount, pick,
+  copy_header_external(hs, index, hds_amount(hs->group, type), pick,
                        &data->state.headerout[1]);
   return &data->state.headerout[1];
 }
@@ -223,16 +364,14 @@ static CURLcode namevalue(char *header, size_t hlen, unsigned int type,
 static CURLcode unfold_value(struct Curl_easy *data, const char *value,
                              size_t vlen)  /* length of the incoming header */
 {
+  struct Curl_header_arena *a = data->state.hdsarena;
   struct Curl_header_store *hs;
-  struct Curl_header_store *newhs;
+  struct hds_block *b;
   size_t olen; /* length of the old value */
-  size_t oalloc; /* length of the old name + value + separator */
-  size_t offset;
+  char *newv;
   DEBUGASSERT(data->state.prevhead);
   hs = data->state.prevhead;
   olen = strlen(hs->value);
-  offset = hs->value - hs->buffer;
-  oalloc = olen + offset + 1;
 
   /* skip all trailing space letters */
   while(vlen && ISSPACE(value[vlen - 1]))
@@ -244,31 +383,60 @@ static CURLcode unfold_value(struct Curl_easy *data, const char *value,
     value++;
   }
 
-  /* since this header block might move in the realloc below, it needs to
-     first be unlinked from the list and then re-added again after the
-     realloc */
-  Curl_node_remove(&hs->node);
-
-  /* new size = struct + new value length + old name+value length */
-  newhs = Curl_saferealloc(hs, sizeof(*hs) + vlen + oalloc + 1);
-  if(!newhs)
-    return CURLE_OUT_OF_MEMORY;
-  /* ->name and ->value point into ->buffer (to keep the header allocation
-     in a single memory block), which now potentially have moved. Adjust
-     them. */
-  newhs->name = newhs->buffer;
-  newhs->value = &newhs->buffer[offset];
+  b = a->blocks;
+  if((hs->value + olen + 1 == HDS_MEM(b) + b->used) &&
+     (vlen <= b->size - b->used)) {
+    /* the value is the last thing in the block, extend it where it is */
+    b->used += vlen;
+    newv = hs->value;
+  }
+  else {
+    newv = hds_alloc(data, olen + vlen + 1);
+    if(!newv)
+      return CURLE_OUT_OF_MEMORY;
+    memcpy(newv, hs->value, olen);
+    hs->value = newv;
+  }
 
   /* put the data at the end of the previous data, not the newline */
-  memcpy(&newhs->value[olen], value, vlen);
-  newhs->value[olen + vlen] = 0; /* null-terminate at newline */
-
-  /* insert this node into the list of headers */
-  Curl_llist_append(&data->state.httphdrs, newhs, &newhs->node);
-  data->state.prevhead = newhs;
+  memcpy(&newv[olen], value, vlen);
+  newv[olen + vlen] = 0; /* null-terminate at newline */
   return CURLE_OK;
 }
 
+/* Add the header to the group of its name in its request */
+static CURLcode hds_index(struct Curl_easy *data,
+                          struct Curl_header_store *hs)
+{
+  struct Curl_header_arena *a = data->state.hdsarena;
+  size_t hash = hds_hash(hs->name, hs->request);
+  struct hds_name **slot;
+  struct hds_name *g;
+
+  if(hds_grow(data, a))
+    return CURLE_OUT_OF_MEMORY;
+  slot = hds_slot(a, hs->name, hs->request, hash);
+  g = *slot;
+  if(!g) {
+    g = hds_alloc(data, sizeof(*g));
+    if(!g)
+      return CURLE_OUT_OF_MEMORY;
+    memset(g, 0, sizeof(*g));
+    g->name = hs->name;
+    g->hash = hash;
+    g->request = hs->request;
+    *slot = g;
+    a->used++;
+  }
+  else
+    g->last->next_same = hs;
+  if(!g->first)
+    g->first = hs;
+  g->last = hs;
+  g->counts[hds_typebit(hs->type)]++;
+  hs->group = g;
+  return CURLE_OK;
+}
 
 /*
  * Curl_headers_push() gets passed a full HTTP header to store. It gets called
@@ -281,6 +449,7 @@ CURLcode Curl_headers_push(struct Curl_easy *data, const char *header,
   char *name = NULL;
   char *end;
   size_t hlen; /* length of the incoming header */
+  size_t hslen;
   struct Curl_header_store *hs;
   CURLcode result = CURLE_OUT_OF_MEMORY;
 
@@ -313,9 +482,18 @@ CURLcode Curl_headers_push(struct Curl_easy *data, const char *header,
     }
   }
 
-  hs = calloc(1, sizeof(*hs) + hlen);
+  if(!data->state.hdsarena) {
+    data->state.hdsarena = Curl_slab_alloc(data,
+                                           sizeof(struct Curl_header_arena));
+    if(!data->state.hdsarena)
+      return CURLE_OUT_OF_MEMORY;
+  }
+
+  hslen = offsetof(struct Curl_header_store, buffer) + hlen + 1;
+  hs = hds_alloc(data, hslen);
   if(!hs)
     return CURLE_OUT_OF_MEMORY;
+  memset(hs, 0, offsetof(struct Curl_header_store, buffer));
   memcpy(hs->buffer, header, hlen);
   hs->buffer[hlen] = 0; /* nul terminate */
 
@@ -325,13 +503,15 @@ CURLcode Curl_headers_push(struct Curl_easy *data, const char *header,
     hs->value = value;
     hs->type = type;
     hs->request = data->state.requests;
-
+    result = hds_index(data, hs);
+  }
+  if(!result) {
     /* insert this node into the list of headers */
     Curl_llist_append(&data->state.httphdrs, hs, &hs->node);
     data->state.prevhead = hs;
   }
   else
-    free(hs);
+    hds_unalloc(data->state.hdsarena, hs, hslen);
   return result;
 }
 
@@ -405,13 +585,17 @@ CURLcode Curl_headers_init(struct Curl_easy *data)
  */
 CURLcode Curl_headers_cleanup(struct Curl_easy *data)
 {
-  struct Curl_llist_node *e;
-  struct Curl_llist_node *n;
+  struct Curl_header_arena *a = data->state.hdsarena;
 
-  for(e = Curl_llist_head(&data->state.httphdrs); e; e = n) {
-    struct Curl_header_store *hs = Curl_node_elem(e);
-    n = Curl_node_next(e);
-    free(hs);
+  if(a) {
+    while(a->blocks) {
+      struct hds_block *b = a->blocks;
+      a->blocks = b->next;
+      Curl_slab_free(data, b, HDS_HEAD + b->size);
+    }
+    Curl_slab_free(data, a->index, a->slots * sizeof(struct hds_name *));
+    Curl_slab_free(data, a, sizeof(*a));
+    data->state.hdsarena = NULL;
   }
   headers_reset(data);
   return CURLE_OK;
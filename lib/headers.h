@@ -27,10 +27,14 @@
 
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_HEADERS_API)
 
+struct hds_name;
+
 struct Curl_header_store {
   struct Curl_llist_node node;
   char *name; /* points into 'buffer' */
-  char *value; /* points into 'buffer */
+  char *value; /* points into 'buffer', or elsewhere in the arena */
+  struct hds_name *group; /* the headers of this name and request */
+  struct Curl_header_store *next_same; /* next header in 'group' */
   int request; /* 0 is the first request, then 1.. 2.. */
   unsigned char type; /* CURLH_* defines */
   char buffer[1]; /* this is the raw header blob */
@@ -55,6 +55,7 @@
 #include "inet_pton.h"
 #include "multiif.h"
 #include "doh.h"
+#include "dnsfile.h"
 #include "warnless.h"
 #include "strcase.h"
 #include "easy_lock.h"
@@ -72,7 +73,6 @@
 #define USE_ALARM_TIMEOUT
 #endif
 
-#define MAX_HOSTCACHE_LEN (255 + 7) /* max FQDN + colon + port number + zero */
 
 #define MAX_DNS_CACHE_SIZE 29999
 
@@ -161,10 +161,10 @@ void Curl_printable_address(const struct Curl_addrinfo *ai, char *buf,
  * Create a hostcache id string for the provided host + port, to be used by
  * the DNS caching. Without alloc. Return length of the id string.
  */
-static size_t
-create_hostcache_id(const char *name,
-                    size_t nlen, /* 0 or actual name length */
-                    int port, char *ptr, size_t buflen)
+size_t
+Curl_hostcache_id(const char *name,
+                  size_t nlen, /* 0 or actual name length */
+                  int port, char *ptr, size_t buflen)
 {
   size_t len = nlen ? nlen : strlen(name);
   DEBUGASSERT(buflen >= MAX_HOSTCACHE_LEN);
@@ -246,6 +246,16 @@ void Curl_hostcache_prune(struct Curl_easy *data)
 
   now = time(NULL);
 
+#ifdef CURLRES_THREADED
+  /* stale entries are kept for a while to be used during a refresh */
+  if(timeout >= 0) {
+    if(data->set.dns_cache_stale < INT_MAX - 1 - timeout)
+      timeout += data->set.dns_cache_stale;
+    else
+      timeout = INT_MAX - 1;
+  }
+#endif
+
   do {
     /* Remove outdated and unused entries from the hostcache */
     time_t oldest = hostcache_prune(data->dns.hostcache, timeout, now);
@@ -272,6 +282,61 @@ static sigjmp_buf curl_jmpenv;
 static curl_simple_lock curl_jmpenv_lock;
 #endif
 
+#ifdef CURLRES_THREADED
+/*
+ * For CURLOPT_DNS_CACHE_STALE seconds after the entry `dns` has gone stale,
+ * it is still used while a lookup in the background gets a new result for
+ * it. Once that is there, it replaces the entry. Returns the entry to use or
+ * NULL when the name has to be resolved again before it can be used. This
+ * assumes that a lock has already been taken.
+ */
+static struct Curl_dns_entry *fetch_stale(struct Curl_easy *data,
+                                          struct Curl_dns_entry *dns,
+                                          time_t now)
+{
+  struct Curl_addrinfo *res;
+
+  if(!data->set.dns_cache_stale ||
+     ((now - dns->timestamp) >= ((time_t)data->set.dns_cache_timeout +
+                                 data->set.dns_cache_stale)))
+    return NULL;
+#ifndef CURL_DISABLE_DOH
+  if(data->set.doh)
+    /* background lookups are not done with DoH */
+    return NULL;
+#endif
+
+  if(dns->refresh && Curl_resolver_refresh_done(dns->refresh, &res)) {
+    Curl_resolver_refresh_free(dns->refresh);
+    dns->refresh = NULL;
+    if(res) {
+      /* replaces `dns` in the cache, which may free it */
+      struct Curl_dns_entry *fresh =
+        Curl_cache_addr(data, res, dns->hostname, 0, dns->hostport, FALSE);
+      if(!fresh) {
+        Curl_freeaddrinfo(res);
+        return NULL;
+      }
+      infof(data, "Hostname %s in DNS cache was refreshed", fresh->hostname);
+      fresh->refcount--; /* the caller marks it in use */
+      return fresh;
+    }
+    infof(data, "Refreshing hostname %s failed", dns->hostname);
+  }
+
+  if(!dns->refresh) {
+    dns->refresh = Curl_resolver_refresh(data, dns->hostname, dns->hostport);
+    if(!dns->refresh)
+      return NULL;
+  }
+  infof(data, "Hostname %s in DNS cache is stale, used while refreshing",
+        dns->hostname);
+  return dns;
+}
+#else
+#define fetch_stale(x,y,z) NULL
+#endif
+
 /* lookup address, returns entry if found and not stale */
 static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
                                          const char *hostname,
@@ -281,15 +346,15 @@ static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
   char entry_id[MAX_HOSTCACHE_LEN];
 
   /* Create an entry id, based upon the hostname and port */
-  size_t entry_len = create_hostcache_id(hostname, 0, port,
-                                         entry_id, sizeof(entry_id));
+  size_t entry_len = Curl_hostcache_id(hostname, 0, port,
+                                       entry_id, sizeof(entry_id));
 
   /* See if it is already in our dns cache */
   dns = Curl_hash_pick(data->dns.hostcache, entry_id, entry_len + 1);
 
   /* No entry found in cache, check if we might have a wildcard entry */
   if(!dns && data->state.wildcard_resolve) {
-    entry_len = create_hostcache_id("*", 1, port, entry_id, sizeof(entry_id));
+    entry_len = Curl_hostcache_id("*", 1, port, entry_id, sizeof(entry_id));
 
     /* See if it is already in our dns cache */
     dns = Curl_hash_pick(data->dns.hostcache, entry_id, entry_len + 1);
@@ -304,9 +369,14 @@ static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
     user.oldest = 0;
 
     if(hostcache_entry_is_stale(&user, dns)) {
-      infof(data, "Hostname in DNS cache was stale, zapped");
-      dns = NULL; /* the memory deallocation is being handled by the hash */
-      Curl_hash_delete(data->dns.hostcache, entry_id, entry_len + 1);
+      struct Curl_dns_entry *stale = fetch_stale(data, dns, user.now);
+      if(stale)
+        dns = stale;
+      else {
+        infof(data, "Hostname in DNS cache was stale, zapped");
+        dns = NULL; /* the memory deallocation is being handled by the hash */
+        Curl_hash_delete(data->dns.hostcache, entry_id, entry_len + 1);
+      }
     }
   }
 
@@ -456,21 +526,16 @@ UNITTEST CURLcode Curl_shuffle_addr(struct Curl_easy *data,
 #endif
 
 /*
- * Curl_cache_addr() stores a 'Curl_addrinfo' struct in the DNS cache.
- *
- * When calling Curl_resolv() has resulted in a response with a returned
- * address, we call this function to store the information in the dns
- * cache etc
- *
- * Returns the Curl_dns_entry entry pointer or NULL if the storage failed.
+ * Store 'addr' in the DNS cache as resolved at 'timestamp', zero for an entry
+ * that never goes stale.
  */
-struct Curl_dns_entry *
-Curl_cache_addr(struct Curl_easy *data,
-                struct Curl_addrinfo *addr,
-                const char *hostname,
-                size_t hostlen, /* length or zero */
-                int port,
-                bool permanent)
+static struct Curl_dns_entry *
+hostcache_add(struct Curl_easy *data,
+              struct Curl_addrinfo *addr,
+              const char *hostname,
+              size_t hostlen, /* length or zero */
+              int port,
+              time_t timestamp)
 {
   char entry_id[MAX_HOSTCACHE_LEN];
   size_t entry_len;
@@ -495,18 +560,12 @@ Curl_cache_addr(struct Curl_easy *data,
   }
 
   /* Create an entry id, based upon the hostname and port */
-  entry_len = create_hostcache_id(hostname, hostlen, port,
-                                  entry_id, sizeof(entry_id));
+  entry_len = Curl_hostcache_id(hostname, hostlen, port,
+                                entry_id, sizeof(entry_id));
 
   dns->refcount = 1; /* the cache has the first reference */
   dns->addr = addr; /* this is the address(es) */
-  if(permanent)
-    dns->timestamp = 0; /* an entry that never goes stale */
-  else {
-    dns->timestamp = time(NULL);
-    if(dns->timestamp == 0)
-      dns->timestamp = 1;
-  }
+  dns->timestamp = timestamp;
   dns->hostport = port;
   if(hostlen)
     memcpy(dns->hostname, hostname, hostlen);
@@ -524,6 +583,68 @@ Curl_cache_addr(struct Curl_easy *data,
   return dns;
 }
 
+/*
+ * Curl_cache_addr() stores a 'Curl_addrinfo' struct in the DNS cache.
+ *
+ * When calling Curl_resolv() has resulted in a response with a returned
+ * address, we call this function to store the information in the dns
+ * cache etc
+ *
+ * Returns the Curl_dns_entry entry pointer or NULL if the storage failed.
+ */
+struct Curl_dns_entry *
+Curl_cache_addr(struct Curl_easy *data,
+                struct Curl_addrinfo *addr,
+                const char *hostname,
+                size_t hostlen, /* length or zero */
+                int port,
+                bool permanent)
+{
+  struct Curl_dns_entry *dns;
+  time_t timestamp = 0; /* an entry that never goes stale */
+
+  if(!permanent) {
+    timestamp = time(NULL);
+    if(timestamp == 0)
+      timestamp = 1;
+  }
+  dns = hostcache_add(data, addr, hostname, hostlen, port, timestamp);
+
+  if(dns && !permanent && data->dnsf && !Curl_host_is_ipnum(dns->hostname))
+    /* remembered for the next process, that may go wrong without harm */
+    (void)Curl_dnsfile_add(data, data->dnsf, dns);
+  return dns;
+}
+
+/*
+ * Put the addresses the DNS cache file has for the hostname and port into
+ * the DNS cache, unless they are too old. Returns the new entry or NULL.
+ * This assumes that a lock has already been taken.
+ */
+static struct Curl_dns_entry *fetch_dnsfile(struct Curl_easy *data,
+                                            const char *hostname, int port)
+{
+  struct Curl_dns_entry *dns;
+  struct Curl_addrinfo *addr;
+  time_t timestamp;
+
+  addr = Curl_dnsfile_get(data, data->dnsf, hostname, port,
+                          data->set.dns_cache_timeout, &timestamp);
+  if(!addr)
+    return NULL;
+  dns = hostcache_add(data, addr, hostname, 0, port,
+                      timestamp ? timestamp : 1);
+  if(!dns) {
+    Curl_freeaddrinfo(addr);
+    return NULL;
+  }
+  infof(data, "Hostname %s was found in DNS cache file", hostname);
+  dns->refcount--; /* the caller marks it in use */
+
+  /* the same checks as for any other entry in the cache */
+  return fetch_addr(data, hostname, port);
+}
+
 #ifdef USE_IPV6
 /* return a static IPv6 ::1 for the name */
 static struct Curl_addrinfo *get_localhost6(int port, const char *name)
@@ -711,6 +832,8 @@ enum resolve_t Curl_resolv(struct Curl_easy *data,
     Curl_share_lock(data, CURL_LOCK_DATA_DNS, CURL_LOCK_ACCESS_SINGLE);
 
   dns = fetch_addr(data, hostname, port);
+  if(!dns && data->dnsf)
+    dns = fetch_dnsfile(data, hostname, port);
 
   if(dns) {
     infof(data, "Hostname %s was found in DNS cache", hostname);
@@ -1073,6 +1196,10 @@ static void hostcache_unlink_entry(void *entry)
   dns->refcount--;
   if(dns->refcount == 0) {
     Curl_freeaddrinfo(dns->addr);
+#ifdef CURLRES_THREADED
+    if(dns->refresh)
+      Curl_resolver_refresh_free(dns->refresh);
+#endif
 #ifdef USE_HTTPSRR
     if(dns->hinfo) {
       if(dns->hinfo->target)
@@ -1153,8 +1280,8 @@ CURLcode Curl_loadhostpairs(struct Curl_easy *data)
         continue;
       }
       /* Create an entry id, based upon the hostname and port */
-      entry_len = create_hostcache_id(&hostp->data[1], hlen, (int)num,
-                                      entry_id, sizeof(entry_id));
+      entry_len = Curl_hostcache_id(&hostp->data[1], hlen, (int)num,
+                                    entry_id, sizeof(entry_id));
       if(data->share)
         Curl_share_lock(data, CURL_LOCK_DATA_DNS, CURL_LOCK_ACCESS_SINGLE);
 
@@ -1266,8 +1393,8 @@ err:
       }
 
       /* Create an entry id, based upon the hostname and port */
-      entry_len = create_hostcache_id(host_begin, hlen, port,
-                                      entry_id, sizeof(entry_id));
+      entry_len = Curl_hostcache_id(host_begin, hlen, port,
+                                    entry_id, sizeof(entry_id));
 
       if(data->share)
         Curl_share_lock(data, CURL_LOCK_DATA_DNS, CURL_LOCK_ACCESS_SINGLE);
@@ -101,6 +101,10 @@ struct Curl_dns_entry {
   time_t timestamp;
   /* reference counter, entry is freed on reaching 0 */
   size_t refcount;
+#ifdef CURLRES_THREADED
+  /* lookup getting a new result for this entry after it went stale */
+  struct resolv_query *refresh;
+#endif
   /* hostname port number that resolved to addr. */
   int hostport;
   /* hostname that resolved to addr. may be NULL (Unix domain sockets). */
@@ -168,6 +172,12 @@ void Curl_resolv_unlink(struct Curl_easy *data,
 /* init a new dns cache */
 void Curl_init_dnscache(struct Curl_hash *hash, size_t hashsize);
 
+#define MAX_HOSTCACHE_LEN (255 + 7) /* max FQDN + colon + port number + zero */
+
+/* the id of the hostname and port in the dns cache, stored in 'ptr' */
+size_t Curl_hostcache_id(const char *name, size_t nlen, int port,
+                         char *ptr, size_t buflen);
+
 /* prune old entries from the DNS cache */
 void Curl_hostcache_prune(struct Curl_easy *data);
 
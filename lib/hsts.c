@@ -31,6 +31,7 @@
 #include <curl/curl.h>
 #include "urldata.h"
 #include "llist.h"
+#include "hash.h"
 #include "hsts.h"
 #include "curl_get_line.h"
 #include "strcase.h"
@@ -53,6 +54,7 @@
 #define MAX_HSTS_DATELEN 64
 #define MAX_HSTS_DATELENSTR "64"
 #define UNLIMITED "unlimited"
+#define HSTS_HASH_SIZE 64
 
 #if defined(DEBUGBUILD) || defined(UNITTESTS)
 /* to play well with debug builds, we can *set* a fixed time this will
@@ -75,38 +77,67 @@ static time_t hsts_debugtime(void *unused)
 #define time(x) hsts_debugtime(x)
 #endif
 
+static void hsts_free(struct stsentry *e)
+{
+  free((char *)e->host);
+  free(e);
+}
+
+/* the hash owns the entries, removing one from it drops it from the list */
+static void hsts_entry_dtor(void *p)
+{
+  struct stsentry *sts = p;
+  Curl_node_remove(&sts->node);
+  hsts_free(sts);
+}
+
 struct hsts *Curl_hsts_init(void)
 {
   struct hsts *h = calloc(1, sizeof(struct hsts));
   if(h) {
     Curl_llist_init(&h->list, NULL);
+    Curl_hash_init(&h->hash, HSTS_HASH_SIZE, Curl_hash_str,
+                   Curl_str_key_compare, hsts_entry_dtor);
   }
   return h;
 }
 
-static void hsts_free(struct stsentry *e)
-{
-  free((char *)e->host);
-  free(e);
-}
-
 void Curl_hsts_cleanup(struct hsts **hp)
 {
   struct hsts *h = *hp;
   if(h) {
-    struct Curl_llist_node *e;
-    struct Curl_llist_node *n;
-    for(e = Curl_llist_head(&h->list); e; e = n) {
-      struct stsentry *sts = Curl_node_elem(e);
-      n = Curl_node_next(e);
-      hsts_free(sts);
-    }
+    Curl_hash_destroy(&h->hash);
     free(h->filename);
     free(h);
     *hp = NULL;
   }
 }
 
+/* Removes the entry from the cache and frees it */
+static void hsts_remove(struct hsts *h, struct stsentry *sts)
+{
+  char key[MAX_HSTS_HOSTLEN];
+  size_t klen = strlen(sts->host);
+  DEBUGASSERT(klen <= MAX_HSTS_HOSTLEN);
+  Curl_strntolower(key, sts->host, klen);
+  Curl_hash_delete(&h->hash, key, klen);
+}
+
+/* Returns the entry stored for exactly this lowercase hostname, unless it
+   has expired. Lookups do not modify the cache, expired entries are replaced
+   when added again and dropped when saving. */
+static struct stsentry *hsts_pick(struct hsts *h, char *key, size_t klen,
+                                  time_t now)
+{
+  struct stsentry *sts;
+  if(!klen)
+    return NULL;
+  sts = Curl_hash_pick(&h->hash, key, klen);
+  if(sts && (sts->expires <= now))
+    return NULL;
+  return sts;
+}
+
 static CURLcode hsts_create(struct hsts *h,
                             const char *hostname,
                             bool subdomains,
@@ -120,7 +151,9 @@ static CURLcode hsts_create(struct hsts *h,
   if(hlen && (hostname[hlen - 1] == '.'))
     /* strip off any trailing dot */
     --hlen;
-  if(hlen) {
+  /* longer names are never looked up */
+  if(hlen && (hlen <= MAX_HSTS_HOSTLEN)) {
+    char key[MAX_HSTS_HOSTLEN];
     char *duphost;
     struct stsentry *sts = calloc(1, sizeof(struct stsentry));
     if(!sts)
@@ -136,6 +169,11 @@ static CURLcode hsts_create(struct hsts *h,
     sts->expires = expires;
     sts->includeSubDomains = subdomains;
     Curl_llist_append(&h->list, sts, &sts->node);
+    Curl_strntolower(key, hostname, hlen);
+    if(!Curl_hash_add(&h->hash, key, hlen, sts)) {
+      hsts_entry_dtor(sts);
+      return CURLE_OUT_OF_MEMORY;
+    }
   }
   return CURLE_OK;
 }
@@ -214,10 +252,8 @@ CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
   if(!expires) {
     /* remove the entry if present verbatim (without subdomain match) */
     sts = Curl_hsts(h, hostname, FALSE);
-    if(sts) {
-      Curl_node_remove(&sts->node);
-      hsts_free(sts);
-    }
+    if(sts)
+      hsts_remove(h, sts);
     return CURLE_OK;
   }
 
@@ -244,48 +280,35 @@ CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
  * Return TRUE if the given hostname is currently an HSTS one.
  *
  * The 'subdomain' argument tells the function if subdomain matching should be
- * attempted.
+ * attempted. The parent domains are then checked for an entry with
+ * includeSubDomains set, the shortest one first, before the hostname itself.
  */
 struct stsentry *Curl_hsts(struct hsts *h, const char *hostname,
                            bool subdomain)
 {
   if(h) {
-    char buffer[MAX_HSTS_HOSTLEN + 1];
+    char buffer[MAX_HSTS_HOSTLEN];
     time_t now = time(NULL);
     size_t hlen = strlen(hostname);
-    struct Curl_llist_node *e;
-    struct Curl_llist_node *n;
 
     if((hlen > MAX_HSTS_HOSTLEN) || !hlen)
       return NULL;
-    memcpy(buffer, hostname, hlen);
     if(hostname[hlen-1] == '.')
       /* remove the trailing dot */
       --hlen;
-    buffer[hlen] = 0;
-    hostname = buffer;
-
-    for(e = Curl_llist_head(&h->list); e; e = n) {
-      struct stsentry *sts = Curl_node_elem(e);
-      n = Curl_node_next(e);
-      if(sts->expires <= now) {
-        /* remove expired entries */
-        Curl_node_remove(&sts->node);
-        hsts_free(sts);
-        continue;
-      }
-      if(subdomain && sts->includeSubDomains) {
-        size_t ntail = strlen(sts->host);
-        if(ntail < hlen) {
-          size_t offs = hlen - ntail;
-          if((hostname[offs-1] == '.') &&
-             strncasecompare(&hostname[offs], sts->host, ntail))
+    Curl_strntolower(buffer, hostname, hlen);
+
+    if(subdomain) {
+      size_t i;
+      for(i = hlen; i > 0; i--) {
+        if(buffer[i - 1] == '.') {
+          struct stsentry *sts = hsts_pick(h, &buffer[i], hlen - i, now);
+          if(sts && sts->includeSubDomains)
             return sts;
         }
       }
-      if(strcasecompare(hostname, sts->host))
-        return sts;
     }
+    return hsts_pick(h, buffer, hlen, now);
   }
   return NULL; /* no match */
 }
@@ -358,11 +381,21 @@ CURLcode Curl_hsts_save(struct Curl_easy *data, struct hsts *h,
   CURLcode result = CURLE_OK;
   FILE *out;
   char *tempstore = NULL;
+  time_t now;
 
   if(!h)
     /* no cache activated */
     return CURLE_OK;
 
+  /* drop the expired entries first */
+  now = time(NULL);
+  for(e = Curl_llist_head(&h->list); e; e = n) {
+    struct stsentry *sts = Curl_node_elem(e);
+    n = Curl_node_next(e);
+    if(sts->expires <= now)
+      hsts_remove(h, sts);
+  }
+
   /* if no new name is given, use the one we stored from the load */
   if(!file && h->filename)
     file = h->filename;
@@ -28,6 +28,7 @@
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_HSTS)
 #include <curl/curl.h>
 #include "llist.h"
+#include "hash.h"
 
 #if defined(DEBUGBUILD) || defined(UNITTESTS)
 extern time_t deltatime;
@@ -40,9 +41,12 @@ struct stsentry {
   curl_off_t expires; /* the timestamp of this entry's expiry */
 };
 
-/* The HSTS cache. Needs to be able to tailmatch hostnames. */
+/* The HSTS cache. Needs to be able to tailmatch hostnames. The entries are
+   kept in a list in the order they were added and in a hash keyed on the
+   lowercase hostname, so that matching takes one lookup per label. */
 struct hsts {
   struct Curl_llist list;
+  struct Curl_hash hash;
   char *filename;
   unsigned int flags;
 };
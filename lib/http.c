@@ -2248,7 +2248,6 @@ CURLcode Curl_http_cookies(struct Curl_easy *data,
     addcookies = data->set.str[STRING_COOKIE];
 
   if(data->cookies || addcookies) {
-    struct Cookie *co = NULL; /* no cookies from start */
     int count = 0;
 
     if(data->cookies && data->state.cookie_engine) {
@@ -2259,14 +2258,14 @@ CURLcode Curl_http_cookies(struct Curl_easy *data,
         strcasecompare("localhost", host) ||
         !strcmp(host, "127.0.0.1") ||
         !strcmp(host, "::1") ? TRUE : FALSE;
-      Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SINGLE);
-      co = Curl_cookie_getlist(data, data->cookies, host, data->state.up.path,
-                               secure_context);
-      Curl_share_unlock(data, CURL_LOCK_DATA_COOKIE);
-    }
-    if(co) {
-      struct Cookie *store = co;
+      struct Curl_cookie_iter iter;
+      struct Cookie *co;
       size_t clen = 8; /* hold the size of the generated Cookie: header */
+
+      /* the cookies are not copied, keep the jar locked while using them */
+      Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SHARED);
+      co = Curl_cookie_first(data, data->cookies, &iter, host,
+                             data->state.up.path, secure_context);
       /* now loop through all cookies that matched */
       while(co) {
         if(co->value) {
@@ -2290,9 +2289,10 @@ CURLcode Curl_http_cookies(struct Curl_easy *data,
           clen += add + (count ? 2 : 0);
           count++;
         }
-        co = co->next; /* next cookie please */
+        co = Curl_cookie_next(&iter); /* next cookie please */
       }
-      Curl_cookie_freelist(store);
+      Curl_cookie_done(&iter);
+      Curl_share_unlock(data, CURL_LOCK_DATA_COOKIE);
     }
     if(addcookies && !result && !linecap) {
       if(!count)
@@ -2800,10 +2800,6 @@ checkprotoprefix(struct Curl_easy *data, struct connectdata *conn,
 #define HD_IS(hd, hdlen, n) \
   (((hdlen) >= (sizeof(n)-1)) && curl_strnequal((n), (hd), (sizeof(n)-1)))
 
-#define HD_VAL(hd, hdlen, n) \
-  ((((hdlen) >= (sizeof(n)-1)) && \
-    curl_strnequal((n), (hd), (sizeof(n)-1)))? (hd + (sizeof(n)-1)) : NULL)
-
 /* HTTP header has field name `n` (a string constant) and contains `v`
  * (a string constant) in its value(s) */
 #define HD_IS_AND_SAYS(hd, hdlen, n, v) \
@@ -2811,6 +2807,72 @@ checkprotoprefix(struct Curl_easy *data, struct connectdata *conn,
    ((hdlen) > ((sizeof(n)-1) + (sizeof(v)-1))) && \
    Curl_compareheader(hd, STRCONST(n), STRCONST(v)))
 
+/* the names of the response header fields Curl_http_header() acts on, by
+   their enum http_hd */
+static const struct {
+  const char *name;
+  size_t len;
+} hd_names[] = {
+  { NULL, 0 }, /* HTTP_HD_OTHER */
+  { STRCONST("Alt-Svc") },
+  { STRCONST("Connection") },
+  { STRCONST("Content-Encoding") },
+  { STRCONST("Content-Length") },
+  { STRCONST("Content-Range") },
+  { STRCONST("Content-Type") },
+  { STRCONST("Last-Modified") },
+  { STRCONST("Location") },
+  { STRCONST("Persistent-Auth") },
+  { STRCONST("Proxy-authenticate") },
+  { STRCONST("Proxy-Connection") },
+  { STRCONST("Retry-After") },
+  { STRCONST("Set-Cookie") },
+  { STRCONST("Strict-Transport-Security") },
+  { STRCONST("Trailer") },
+  { STRCONST("Transfer-Encoding") },
+  { STRCONST("WWW-Authenticate") },
+};
+
+/* the longest name in `hd_names` */
+#define HD_NAME_MAX 25
+
+/* The index in `hd_slots` for a field name, from its length and first
+ * letter. A perfect hash: it differs for all names in `hd_names`. */
+#define HD_SLOT(len, c) \
+  ((((len) * 2) + ((unsigned char)(c) | 0x20)) & 63)
+
+/* the enum http_hd of the name in `hd_names` at each HD_SLOT(), or 0 */
+static const unsigned char hd_slots[64] = {
+   0,  0, 15,  3,  0,  0,  7, 13, 12,  0,  0,  0,  0,  0,  9,  0,
+  11,  0,  0,  0, 10,  0, 16, 17,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0, 14,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,
+   0,  0,  0,  0,  0,  0,  0,  2,  0,  0,  0,  6,  8,  5,  0,  4
+};
+
+/*
+ * Find which of the fields Curl_http_header() acts on the header `hd` is,
+ * with a single compare. Sets `*namelen` to the length of its name, which
+ * is followed by the colon. Returns HTTP_HD_OTHER for any other header.
+ */
+UNITTEST enum http_hd http_header_id(const char *hd, size_t hdlen,
+                                     size_t *namelen)
+{
+  const char *colon;
+  size_t len;
+  unsigned char id;
+
+  colon = memchr(hd, ':', CURLMIN(hdlen, HD_NAME_MAX + 1));
+  if(!colon || (colon == hd))
+    return HTTP_HD_OTHER;
+  len = (size_t)(colon - hd);
+  id = hd_slots[HD_SLOT(len, hd[0])];
+  if(!id || (hd_names[id].len != len) ||
+     !strncasecompare(hd_names[id].name, hd, len))
+    return HTTP_HD_OTHER;
+  *namelen = len;
+  return (enum http_hd)id;
+}
+
 /*
  * Curl_http_header() parses a single response header.
  */
@@ -2820,36 +2882,34 @@ CURLcode Curl_http_header(struct Curl_easy *data,
   struct connectdata *conn = data->conn;
   CURLcode result;
   struct SingleRequest *k = &data->req;
-  const char *v;
+  size_t namelen = 0;
+  enum http_hd id = http_header_id(hd, hdlen, &namelen);
+  /* the value, right after the colon */
+  const char *v = hd + namelen + 1;
 
-  switch(hd[0]) {
-  case 'a':
-  case 'A':
+  switch(id) {
+  case HTTP_HD_ALT_SVC:
 #ifndef CURL_DISABLE_ALTSVC
-    v = (data->asi &&
-         ((data->conn->handler->flags & PROTOPT_SSL) ||
+    if(data->asi &&
+       ((data->conn->handler->flags & PROTOPT_SSL) ||
 #ifdef DEBUGBUILD
-          /* allow debug builds to circumvent the HTTPS restriction */
-          getenv("CURL_ALTSVC_HTTP")
+        /* allow debug builds to circumvent the HTTPS restriction */
+        getenv("CURL_ALTSVC_HTTP")
 #else
-          0
+        0
 #endif
-        )) ? HD_VAL(hd, hdlen, "Alt-Svc:") : NULL;
-    if(v) {
+         )) {
       /* the ALPN of the current request */
-      enum alpnid id = (conn->httpversion == 30) ? ALPN_h3 :
-                         (conn->httpversion == 20) ? ALPN_h2 : ALPN_h1;
-      return Curl_altsvc_parse(data, data->asi, v, id, conn->host.name,
+      enum alpnid alpn = (conn->httpversion == 30) ? ALPN_h3 :
+                           (conn->httpversion == 20) ? ALPN_h2 : ALPN_h1;
+      return Curl_altsvc_parse(data, data->asi, v, alpn, conn->host.name,
                                curlx_uitous((unsigned int)conn->remote_port));
     }
 #endif
     break;
-  case 'c':
-  case 'C':
+  case HTTP_HD_CONTENT_LENGTH:
     /* Check for Content-Length: header lines to get size */
-    v = (!k->http_bodyless && !data->set.ignorecl) ?
-      HD_VAL(hd, hdlen, "Content-Length:") : NULL;
-    if(v) {
+    if(!k->http_bodyless && !data->set.ignorecl) {
       curl_off_t contentlength;
       CURLofft offt = curlx_strtoofft(v, NULL, 10, &contentlength);
 
@@ -2873,9 +2933,9 @@ CURLcode Curl_http_header(struct Curl_easy *data,
       }
       return CURLE_OK;
     }
-    v = (!k->http_bodyless && data->set.str[STRING_ENCODING]) ?
-      HD_VAL(hd, hdlen, "Content-Encoding:") : NULL;
-    if(v) {
+    break;
+  case HTTP_HD_CONTENT_ENCODING:
+    if(!k->http_bodyless && data->set.str[STRING_ENCODING]) {
       /*
        * Process Content-Encoding. Look for the values: identity,
        * gzip, deflate, compress, x-gzip and x-compress. x-gzip and
@@ -2885,21 +2945,22 @@ CURLcode Curl_http_header(struct Curl_easy *data,
        */
       return Curl_build_unencoding_stack(data, v, FALSE);
     }
+    break;
+  case HTTP_HD_CONTENT_TYPE: {
     /* check for Content-Type: header lines to get the MIME-type */
-    v = HD_VAL(hd, hdlen, "Content-Type:");
-    if(v) {
-      char *contenttype = Curl_copy_header_value(hd);
-      if(!contenttype)
-        return CURLE_OUT_OF_MEMORY;
-      if(!*contenttype)
-        /* ignore empty data */
-        free(contenttype);
-      else {
-        Curl_safefree(data->info.contenttype);
-        data->info.contenttype = contenttype;
-      }
-      return CURLE_OK;
+    char *contenttype = Curl_copy_header_value(hd);
+    if(!contenttype)
+      return CURLE_OUT_OF_MEMORY;
+    if(!*contenttype)
+      /* ignore empty data */
+      free(contenttype);
+    else {
+      Curl_safefree(data->info.contenttype);
+      data->info.contenttype = contenttype;
     }
+    return CURLE_OK;
+  }
+  case HTTP_HD_CONNECTION:
     if(HD_IS_AND_SAYS(hd, hdlen, "Connection:", "close")) {
       /*
        * [RFC 2616, section 8.1.2.1]
@@ -2922,8 +2983,9 @@ CURLcode Curl_http_header(struct Curl_easy *data,
       infof(data, "HTTP/1.0 connection set to keep alive");
       return CURLE_OK;
     }
-    v = !k->http_bodyless ? HD_VAL(hd, hdlen, "Content-Range:") : NULL;
-    if(v) {
+    break;
+  case HTTP_HD_CONTENT_RANGE:
+    if(!k->http_bodyless) {
       /* Content-Range: bytes [num]-
          Content-Range: bytes: [num]-
          Content-Range: [num]-
@@ -2953,20 +3015,18 @@ CURLcode Curl_http_header(struct Curl_easy *data,
         data->state.resume_from = 0; /* get everything */
     }
     break;
-  case 'l':
-  case 'L':
-    v = (!k->http_bodyless &&
-         (data->set.timecondition || data->set.get_filetime)) ?
-        HD_VAL(hd, hdlen, "Last-Modified:") : NULL;
-    if(v) {
+  case HTTP_HD_LAST_MODIFIED:
+    if(!k->http_bodyless &&
+       (data->set.timecondition || data->set.get_filetime)) {
       k->timeofdoc = Curl_getdate_capped(v);
       if(data->set.get_filetime)
         data->info.filetime = k->timeofdoc;
       return CURLE_OK;
     }
+    break;
+  case HTTP_HD_LOCATION:
     if((k->httpcode >= 300 && k->httpcode < 400) &&
-            HD_IS(hd, hdlen, "Location:") &&
-            !data->req.location) {
+       !data->req.location) {
       /* this is the URL that the server advises us to use instead */
       char *location = Curl_copy_header_value(hd);
       if(!location)
@@ -2995,35 +3055,34 @@ CURLcode Curl_http_header(struct Curl_easy *data,
       }
     }
     break;
-  case 'p':
-  case 'P':
+  case HTTP_HD_PROXY_CONNECTION:
 #ifndef CURL_DISABLE_PROXY
-    v = HD_VAL(hd, hdlen, "Proxy-Connection:");
-    if(v) {
-      if((conn->httpversion == 10) && conn->bits.httpproxy &&
-         HD_IS_AND_SAYS(hd, hdlen, "Proxy-Connection:", "keep-alive")) {
-        /*
-         * When an HTTP/1.0 reply comes when using a proxy, the
-         * 'Proxy-Connection: keep-alive' line tells us the
-         * connection will be kept alive for our pleasure.
-         * Default action for 1.0 is to close.
-         */
-        connkeep(conn, "Proxy-Connection keep-alive"); /* do not close */
-        infof(data, "HTTP/1.0 proxy connection set to keep alive");
-      }
-      else if((conn->httpversion == 11) && conn->bits.httpproxy &&
-              HD_IS_AND_SAYS(hd, hdlen, "Proxy-Connection:", "close")) {
-        /*
-         * We get an HTTP/1.1 response from a proxy and it says it will
-         * close down after this transfer.
-         */
-        connclose(conn, "Proxy-Connection: asked to close after done");
-        infof(data, "HTTP/1.1 proxy connection set close");
-      }
-      return CURLE_OK;
+    if((conn->httpversion == 10) && conn->bits.httpproxy &&
+       HD_IS_AND_SAYS(hd, hdlen, "Proxy-Connection:", "keep-alive")) {
+      /*
+       * When an HTTP/1.0 reply comes when using a proxy, the
+       * 'Proxy-Connection: keep-alive' line tells us the
+       * connection will be kept alive for our pleasure.
+       * Default action for 1.0 is to close.
+       */
+      connkeep(conn, "Proxy-Connection keep-alive"); /* do not close */
+      infof(data, "HTTP/1.0 proxy connection set to keep alive");
+    }
+    else if((conn->httpversion == 11) && conn->bits.httpproxy &&
+            HD_IS_AND_SAYS(hd, hdlen, "Proxy-Connection:", "close")) {
+      /*
+       * We get an HTTP/1.1 response from a proxy and it says it will
+       * close down after this transfer.
+       */
+      connclose(conn, "Proxy-Connection: asked to close after done");
+      infof(data, "HTTP/1.1 proxy connection set close");
     }
+    return CURLE_OK;
+#else
+    break;
 #endif
-    if((407 == k->httpcode) && HD_IS(hd, hdlen, "Proxy-authenticate:")) {
+  case HTTP_HD_PROXY_AUTHENTICATE:
+    if(407 == k->httpcode) {
       char *auth = Curl_copy_header_value(hd);
       if(!auth)
         return CURLE_OUT_OF_MEMORY;
@@ -3031,8 +3090,10 @@ CURLcode Curl_http_header(struct Curl_easy *data,
       free(auth);
       return result;
     }
+    break;
+  case HTTP_HD_PERSISTENT_AUTH:
 #ifdef USE_SPNEGO
-    if(HD_IS(hd, hdlen, "Persistent-Auth:")) {
+    {
       struct negotiatedata *negdata = &conn->negotiate;
       struct auth *authp = &data->state.authhost;
       if(authp->picked == CURLAUTH_NEGOTIATE) {
@@ -3049,30 +3110,23 @@ CURLcode Curl_http_header(struct Curl_easy *data,
     }
 #endif
     break;
-  case 'r':
-  case 'R':
-    v = HD_VAL(hd, hdlen, "Retry-After:");
-    if(v) {
-      /* Retry-After = HTTP-date / delay-seconds */
-      curl_off_t retry_after = 0; /* zero for unknown or "now" */
-      /* Try it as a decimal number, if it works it is not a date */
-      (void)curlx_strtoofft(v, NULL, 10, &retry_after);
-      if(!retry_after) {
-        time_t date = Curl_getdate_capped(v);
-        if(-1 != date)
-          /* convert date to number of seconds into the future */
-          retry_after = date - time(NULL);
-      }
-      data->info.retry_after = retry_after; /* store it */
-      return CURLE_OK;
+  case HTTP_HD_RETRY_AFTER: {
+    /* Retry-After = HTTP-date / delay-seconds */
+    curl_off_t retry_after = 0; /* zero for unknown or "now" */
+    /* Try it as a decimal number, if it works it is not a date */
+    (void)curlx_strtoofft(v, NULL, 10, &retry_after);
+    if(!retry_after) {
+      time_t date = Curl_getdate_capped(v);
+      if(-1 != date)
+        /* convert date to number of seconds into the future */
+        retry_after = date - time(NULL);
     }
-    break;
-  case 's':
-  case 'S':
+    data->info.retry_after = retry_after; /* store it */
+    return CURLE_OK;
+  }
+  case HTTP_HD_SET_COOKIE:
 #if !defined(CURL_DISABLE_COOKIES)
-    v = (data->cookies && data->state.cookie_engine) ?
-        HD_VAL(hd, hdlen, "Set-Cookie:") : NULL;
-    if(v) {
+    if(data->cookies && data->state.cookie_engine) {
       /* If there is a custom-set Host: name, use it here, or else use
        * real peer hostname. */
       const char *host = data->state.aptr.cookiehost ?
@@ -3091,21 +3145,22 @@ CURLcode Curl_http_header(struct Curl_easy *data,
       return CURLE_OK;
     }
 #endif
+    break;
+  case HTTP_HD_STRICT_TRANSPORT_SECURITY:
 #ifndef CURL_DISABLE_HSTS
     /* If enabled, the header is incoming and this is over HTTPS */
-    v = (data->hsts &&
-         ((conn->handler->flags & PROTOPT_SSL) ||
+    if(data->hsts &&
+       ((conn->handler->flags & PROTOPT_SSL) ||
 #ifdef DEBUGBUILD
-           /* allow debug builds to circumvent the HTTPS restriction */
-           getenv("CURL_HSTS_HTTP")
+        /* allow debug builds to circumvent the HTTPS restriction */
+        getenv("CURL_HSTS_HTTP")
 #else
-           0
+        0
 #endif
-            )
-        ) ? HD_VAL(hd, hdlen, "Strict-Transport-Security:") : NULL;
-    if(v) {
-      CURLcode check =
-        Curl_hsts_parse(data->hsts, conn->host.name, v);
+         )) {
+      CURLcode check;
+      Curl_share_lock(data, CURL_LOCK_DATA_HSTS, CURL_LOCK_ACCESS_SINGLE);
+      check = Curl_hsts_parse(data->hsts, conn->host.name, v);
       if(check)
         infof(data, "Illegal STS header skipped");
 #ifdef DEBUGBUILD
@@ -3113,11 +3168,11 @@ CURLcode Curl_http_header(struct Curl_easy *data,
         infof(data, "Parsed STS header fine (%zu entries)",
               Curl_llist_count(&data->hsts->list));
 #endif
+      Curl_share_unlock(data, CURL_LOCK_DATA_HSTS);
     }
 #endif
     break;
-  case 't':
-  case 'T':
+  case HTTP_HD_TRANSFER_ENCODING:
     /* RFC 9112, ch. 6.1
      * "Transfer-Encoding MAY be sent in a response to a HEAD request or
      *  in a 304 (Not Modified) response (Section 15.4.5 of [HTTP]) to a
@@ -3128,11 +3183,9 @@ CURLcode Curl_http_header(struct Curl_easy *data,
      * Read: in these cases the 'Transfer-Encoding' does not apply
      * to any data following the response headers. Do not add any decoders.
      */
-    v = (!k->http_bodyless &&
-         (data->state.httpreq != HTTPREQ_HEAD) &&
-         (k->httpcode != 304)) ?
-      HD_VAL(hd, hdlen, "Transfer-Encoding:") : NULL;
-    if(v) {
+    if(!k->http_bodyless &&
+       (data->state.httpreq != HTTPREQ_HEAD) &&
+       (k->httpcode != 304)) {
       /* One or more encodings. We check for chunked and/or a compression
          algorithm. */
       result = Curl_build_unencoding_stack(data, v, TRUE);
@@ -3147,15 +3200,12 @@ CURLcode Curl_http_header(struct Curl_easy *data,
       }
       return CURLE_OK;
     }
-    v = HD_VAL(hd, hdlen, "Trailer:");
-    if(v) {
-      data->req.resp_trailer = TRUE;
-      return CURLE_OK;
-    }
     break;
-  case 'w':
-  case 'W':
-    if((401 == k->httpcode) && HD_IS(hd, hdlen, "WWW-Authenticate:")) {
+  case HTTP_HD_TRAILER:
+    data->req.resp_trailer = TRUE;
+    return CURLE_OK;
+  case HTTP_HD_WWW_AUTHENTICATE:
+    if(401 == k->httpcode) {
       char *auth = Curl_copy_header_value(hd);
       if(!auth)
         return CURLE_OUT_OF_MEMORY;
@@ -3164,6 +3214,8 @@ CURLcode Curl_http_header(struct Curl_easy *data,
       return result;
     }
     break;
+  default:
+    break;
   }
 
   if(conn->handler->protocol & CURLPROTO_RTSP) {
@@ -4293,12 +4345,12 @@ static bool h2_non_field(const char *name, size_t namelen)
   return FALSE;
 }
 
-CURLcode Curl_http_req_to_h2(struct dynhds *h2_headers,
-                             struct httpreq *req, struct Curl_easy *data)
+CURLcode Curl_http_req_to_h2_pseudo(struct dynhds *h2_headers,
+                                    struct httpreq *req,
+                                    struct Curl_easy *data)
 {
   const char *scheme = NULL, *authority = NULL;
   struct dynhds_entry *e;
-  size_t i;
   CURLcode result;
 
   DEBUGASSERT(req);
@@ -4346,6 +4398,17 @@ CURLcode Curl_http_req_to_h2(struct dynhds *h2_headers,
     result = Curl_dynhds_add(h2_headers, STRCONST(HTTP_PSEUDO_PATH),
                              req->path, strlen(req->path));
   }
+  return result;
+}
+
+CURLcode Curl_http_req_to_h2_fields(struct dynhds *h2_headers,
+                                    struct httpreq *req)
+{
+  struct dynhds_entry *e;
+  size_t i;
+  CURLcode result = CURLE_OK;
+
+  Curl_dynhds_set_opts(h2_headers, DYNHDS_OPT_LOWERCASE);
   for(i = 0; !result && i < Curl_dynhds_count(&req->headers); ++i) {
     e = Curl_dynhds_getn(&req->headers, i);
     if(!h2_non_field(e->name, e->namelen)) {
@@ -4353,7 +4416,34 @@ CURLcode Curl_http_req_to_h2(struct dynhds *h2_headers,
                                e->value, e->valuelen);
     }
   }
+  return result;
+}
+
+bool Curl_http_req_h2_fields_same(struct dynhds *h2_fields,
+                                  struct httpreq *req)
+{
+  struct dynhds_entry *e, *f;
+  size_t i, n = 0;
+
+  for(i = 0; i < Curl_dynhds_count(&req->headers); ++i) {
+    e = Curl_dynhds_getn(&req->headers, i);
+    if(h2_non_field(e->name, e->namelen))
+      continue;
+    f = Curl_dynhds_getn(h2_fields, n++);
+    if(!f || (f->namelen != e->namelen) || (f->valuelen != e->valuelen) ||
+       !strncasecompare(f->name, e->name, e->namelen) ||
+       memcmp(f->value, e->value, e->valuelen))
+      return FALSE;
+  }
+  return n == Curl_dynhds_count(h2_fields);
+}
 
+CURLcode Curl_http_req_to_h2(struct dynhds *h2_headers,
+                             struct httpreq *req, struct Curl_easy *data)
+{
+  CURLcode result = Curl_http_req_to_h2_pseudo(h2_headers, req, data);
+  if(!result)
+    result = Curl_http_req_to_h2_fields(h2_headers, req);
   return result;
 }
 
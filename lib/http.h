@@ -103,6 +103,33 @@ CURLcode Curl_http_statusline(struct Curl_easy *data,
                               struct connectdata *conn);
 CURLcode Curl_http_header(struct Curl_easy *data,
                           const char *hd, size_t hdlen);
+
+/* the response header fields Curl_http_header() acts on */
+enum http_hd {
+  HTTP_HD_OTHER,
+  HTTP_HD_ALT_SVC,
+  HTTP_HD_CONNECTION,
+  HTTP_HD_CONTENT_ENCODING,
+  HTTP_HD_CONTENT_LENGTH,
+  HTTP_HD_CONTENT_RANGE,
+  HTTP_HD_CONTENT_TYPE,
+  HTTP_HD_LAST_MODIFIED,
+  HTTP_HD_LOCATION,
+  HTTP_HD_PERSISTENT_AUTH,
+  HTTP_HD_PROXY_AUTHENTICATE,
+  HTTP_HD_PROXY_CONNECTION,
+  HTTP_HD_RETRY_AFTER,
+  HTTP_HD_SET_COOKIE,
+  HTTP_HD_STRICT_TRANSPORT_SECURITY,
+  HTTP_HD_TRAILER,
+  HTTP_HD_TRANSFER_ENCODING,
+  HTTP_HD_WWW_AUTHENTICATE
+};
+
+#ifdef UNITTESTS
+UNITTEST enum http_hd http_header_id(const char *hd, size_t hdlen,
+                                     size_t *namelen);
+#endif
 CURLcode Curl_transferencode(struct Curl_easy *data);
 CURLcode Curl_http_req_set_reader(struct Curl_easy *data,
                                   Curl_HttpReq httpreq,
@@ -273,6 +300,28 @@ void Curl_http_req_free(struct httpreq *req);
 CURLcode Curl_http_req_to_h2(struct dynhds *h2_headers,
                              struct httpreq *req, struct Curl_easy *data);
 
+/**
+ * Create only the HTTP/2 pseudo headers of the request, as done by
+ * Curl_http_req_to_h2(). `h2_headers` is reset first.
+ */
+CURLcode Curl_http_req_to_h2_pseudo(struct dynhds *h2_headers,
+                                    struct httpreq *req,
+                                    struct Curl_easy *data);
+
+/**
+ * Add the header fields of the request to `h2_headers`, as done by
+ * Curl_http_req_to_h2(), without any pseudo headers.
+ */
+CURLcode Curl_http_req_to_h2_fields(struct dynhds *h2_headers,
+                                    struct httpreq *req);
+
+/**
+ * TRUE if `h2_fields`, made by Curl_http_req_to_h2_fields() for an
+ * earlier request, are exactly the header fields this request has.
+ */
+bool Curl_http_req_h2_fields_same(struct dynhds *h2_fields,
+                                  struct httpreq *req);
+
 /**
  * All about a core HTTP response, excluding body and trailers
  */
@@ -75,7 +75,8 @@
 #define H2_NW_RECV_CHUNKS       (H2_CONN_WINDOW_SIZE / H2_CHUNK_SIZE)
 /* on send into TLS, we just want to accumulate small frames */
 #define H2_NW_SEND_CHUNKS       1
-/* this is how much we want "in flight" for a stream, unthrottled  */
+/* this is how much we want "in flight" for a stream, unthrottled, until
+ * the bandwidth-delay product measured asks for more */
 #define H2_STREAM_WINDOW_SIZE_MAX   (10 * 1024 * 1024)
 /* this is how much we want "in flight" for a stream, initially, IFF
  * nghttp2 allows us to tweak the local window size. */
@@ -89,6 +90,10 @@
 #define H2_STREAM_SEND_CHUNKS   ((64 * 1024) / H2_CHUNK_SIZE)
 /* spare chunks we keep for a full window */
 #define H2_STREAM_POOL_SPARES   (H2_CONN_WINDOW_SIZE / H2_CHUNK_SIZE)
+/* request body bytes a stream of default weight sends in its turn */
+#define H2_SCHED_QUANTUM        (16 * 1024)
+/* pseudo headers a request has at most: method, scheme, authority, path */
+#define H2_REQ_PSEUDO_MAX       4
 
 /* We need to accommodate the max number of streams with their window sizes on
  * the overall connection. Streams might become PAUSED which will block their
@@ -135,13 +140,24 @@ struct cf_h2_ctx {
   struct bufq outbufq;          /* network output */
   struct bufc_pool stream_bufcp; /* spares for stream buffers */
   struct dynbuf scratch;        /* scratch buffer for temp use */
+  struct dynhds req_fields;     /* header fields of the last request */
+  nghttp2_nv *req_nva;          /* pseudo header slots + `req_fields` */
+  size_t req_nva_len;           /* entries allocated in `req_nva` */
 
   struct Curl_hash streams; /* hash of `data->mid` to `h2_stream_ctx` */
+  struct Curl_llist sched;  /* streams with request body to send */
+  struct h2_stream_ctx *sched_cur; /* stream whose turn it is to send */
+  size_t sched_quantum;     /* body bytes per turn at default weight */
   size_t drain_total; /* sum of all stream's UrlState drain */
   uint32_t max_concurrent_streams;
   uint32_t goaway_error;        /* goaway error code from server */
   int32_t remote_max_sid;       /* max id processed by server */
   int32_t local_max_sid;        /* max id processed by us */
+  struct curltime bdp_ping_sent; /* when the BDP PING was submitted */
+  size_t bdp_bytes;             /* DATA received since then */
+  curl_off_t bdp_bw_max;        /* highest bytes/s measured so far */
+  int32_t stream_win;           /* receive window we want for streams */
+  int32_t stream_win_max;       /* how large `stream_win` may grow */
   BIT(initialized);
   BIT(via_h1_upgrade);
   BIT(conn_closed);
@@ -149,6 +165,7 @@ struct cf_h2_ctx {
   BIT(sent_goaway);
   BIT(enable_push);
   BIT(nw_out_blocked);
+  BIT(bdp_ping_out);            /* a BDP PING awaits its ACK */
 };
 
 /* How to access `call_data` from a cf_h2 filter */
@@ -164,7 +181,20 @@ static void cf_h2_ctx_init(struct cf_h2_ctx *ctx, bool via_h1_upgrade)
   Curl_bufq_initp(&ctx->inbufq, &ctx->stream_bufcp, H2_NW_RECV_CHUNKS, 0);
   Curl_bufq_initp(&ctx->outbufq, &ctx->stream_bufcp, H2_NW_SEND_CHUNKS, 0);
   Curl_dyn_init(&ctx->scratch, CURL_MAX_HTTP_HEADER);
+  Curl_dynhds_init(&ctx->req_fields, 0, DYN_HTTP_REQUEST);
   Curl_hash_offt_init(&ctx->streams, 63, h2_stream_hash_free);
+  Curl_llist_init(&ctx->sched, NULL);
+  ctx->sched_quantum = H2_SCHED_QUANTUM;
+#ifdef DEBUGBUILD
+  {
+    char *p = getenv("CURL_DBG_H2_QUANTUM");
+    if(p) {
+      long l = strtol(p, NULL, 10);
+      if(l > 0)
+        ctx->sched_quantum = (size_t)l;
+    }
+  }
+#endif
   ctx->remote_max_sid = 2147483647;
   ctx->via_h1_upgrade = via_h1_upgrade;
   ctx->initialized = TRUE;
@@ -177,6 +207,8 @@ static void cf_h2_ctx_free(struct cf_h2_ctx *ctx)
     Curl_bufq_free(&ctx->outbufq);
     Curl_bufcp_free(&ctx->stream_bufcp);
     Curl_dyn_free(&ctx->scratch);
+    Curl_dynhds_free(&ctx->req_fields);
+    free(ctx->req_nva);
     Curl_hash_clean(&ctx->streams);
     Curl_hash_destroy(&ctx->streams);
     memset(ctx, 0, sizeof(*ctx));
@@ -202,6 +234,8 @@ struct h2_stream_ctx {
   struct bufq sendbuf; /* request buffer */
   struct h1_req_parser h1; /* parsing the request */
   struct dynhds resp_trailers; /* response trailer fields */
+  struct Curl_llist_node sched_node; /* in the filter's `sched` list */
+  size_t sched_credit; /* body bytes it may still send in its turn */
   size_t resp_hds_len; /* amount of response header bytes in recvbuf */
   curl_off_t nrcvd_data;  /* number of DATA bytes received */
 
@@ -221,6 +255,7 @@ struct h2_stream_ctx {
   BIT(bodystarted);
   BIT(body_eos);    /* the complete body has been added to `sendbuf` and
                      * is being/has been processed from there. */
+  BIT(sched_deferred); /* its body is held back for another's turn */
 };
 
 #define H2_STREAM_CTX(ctx,data)   ((struct h2_stream_ctx *)(\
@@ -262,6 +297,8 @@ static void free_push_headers(struct h2_stream_ctx *stream)
 
 static void h2_stream_ctx_free(struct h2_stream_ctx *stream)
 {
+  if(Curl_node_llist(&stream->sched_node))
+    Curl_node_remove(&stream->sched_node);
   Curl_bufq_free(&stream->sendbuf);
   Curl_h1_req_parse_free(&stream->h1);
   Curl_dynhds_free(&stream->resp_trailers);
@@ -275,11 +312,121 @@ static void h2_stream_hash_free(void *stream)
   h2_stream_ctx_free((struct h2_stream_ctx *)stream);
 }
 
+/*
+ * Request bodies are sent in turns, so that a large upload does not hold
+ * back the others on the connection. Streams with a body to send are in
+ * the `sched` list. nghttp2 only gets the body of the stream whose turn it
+ * is, the others are deferred. A turn ends after a quantum of data, scaled
+ * by the stream's weight, or when the stream cannot send more, and goes to
+ * the next stream in the list that can send (deficit round robin).
+ */
+static int sweight_wanted(const struct Curl_easy *data);
+
+static bool h2_sched_can_send(struct cf_h2_ctx *ctx,
+                              struct h2_stream_ctx *stream)
+{
+  if(stream->closed)
+    return FALSE;
+  if(Curl_bufq_is_empty(&stream->sendbuf))
+    return stream->body_eos;
+  return nghttp2_session_get_stream_remote_window_size(ctx->h2,
+                                                        stream->id) > 0;
+}
+
+/* give the turn to the stream after `stream` that can send */
+static void h2_sched_next(struct cf_h2_ctx *ctx,
+                          struct h2_stream_ctx *stream)
+{
+  struct Curl_llist_node *e = Curl_node_llist(&stream->sched_node) ?
+    Curl_node_next(&stream->sched_node) : NULL;
+  size_t i, n = Curl_llist_count(&ctx->sched);
+
+  for(i = 0; i < n; ++i) {
+    struct h2_stream_ctx *s;
+    if(!e)
+      e = Curl_llist_head(&ctx->sched);
+    s = Curl_node_elem(e);
+    if(s != stream && h2_sched_can_send(ctx, s)) {
+      ctx->sched_cur = s;
+      s->sched_credit = 0;
+      return;
+    }
+    e = Curl_node_next(e);
+  }
+  ctx->sched_cur = (Curl_node_llist(&stream->sched_node) &&
+                    h2_sched_can_send(ctx, stream)) ? stream : NULL;
+}
+
+/* the stream has no more body to send */
+static void h2_sched_done(struct cf_h2_ctx *ctx,
+                          struct h2_stream_ctx *stream)
+{
+  if(Curl_node_llist(&stream->sched_node)) {
+    if(ctx->sched_cur == stream) {
+      h2_sched_next(ctx, stream);
+      if(ctx->sched_cur == stream)
+        ctx->sched_cur = NULL;
+    }
+    Curl_node_remove(&stream->sched_node);
+  }
+}
+
+/* the turn of the current stream is over when it can no longer send */
+static void h2_sched_check(struct cf_h2_ctx *ctx)
+{
+  if(ctx->sched_cur && !h2_sched_can_send(ctx, ctx->sched_cur))
+    h2_sched_next(ctx, ctx->sched_cur);
+}
+
+/* have nghttp2 ask for the body of the current stream again, if we had it
+   deferred. Not done inside nghttp2 callbacks. */
+static void h2_sched_resume(struct cf_h2_ctx *ctx)
+{
+  struct h2_stream_ctx *stream = ctx->sched_cur;
+  if(stream && stream->sched_deferred) {
+    stream->sched_deferred = FALSE;
+    (void)nghttp2_session_resume_data(ctx->h2, stream->id);
+  }
+}
+
+/* How much of its body the stream may give nghttp2 now, 0 to defer it */
+static size_t h2_sched_allow(struct cf_h2_ctx *ctx,
+                             struct Curl_easy *data,
+                             struct h2_stream_ctx *stream)
+{
+  if(ctx->sched_cur != stream) {
+    if(ctx->sched_cur && h2_sched_can_send(ctx, ctx->sched_cur)) {
+      stream->sched_deferred = TRUE;
+      return 0;
+    }
+    ctx->sched_cur = stream;
+    stream->sched_credit = 0;
+  }
+  if(!stream->sched_credit) {
+    stream->sched_credit = ctx->sched_quantum *
+      (size_t)sweight_wanted(data) / NGHTTP2_DEFAULT_WEIGHT;
+    if(!stream->sched_credit)
+      stream->sched_credit = 1;
+  }
+  return stream->sched_credit;
+}
+
+/* the stream gave `nread` bytes of its body to nghttp2 */
+static void h2_sched_sent(struct cf_h2_ctx *ctx,
+                          struct h2_stream_ctx *stream,
+                          size_t nread, int32_t window)
+{
+  stream->sched_credit -= nread;
+  if(!stream->sched_credit || ((int32_t)nread >= window) ||
+     Curl_bufq_is_empty(&stream->sendbuf))
+    h2_sched_next(ctx, stream);
+}
+
 #ifdef NGHTTP2_HAS_SET_LOCAL_WINDOW_SIZE
 static int32_t cf_h2_get_desired_local_win(struct Curl_cfilter *cf,
                                            struct Curl_easy *data)
 {
-  (void)cf;
+  struct cf_h2_ctx *ctx = cf->ctx;
   if(data->set.max_recv_speed && data->set.max_recv_speed < INT32_MAX) {
     /* The transfer should only receive `max_recv_speed` bytes per second.
      * We restrict the stream's local window size, so that the server cannot
@@ -287,7 +434,7 @@ static int32_t cf_h2_get_desired_local_win(struct Curl_cfilter *cf,
      * This gets less precise the higher the latency. */
     return (int32_t)data->set.max_recv_speed;
   }
-  return H2_STREAM_WINDOW_SIZE_MAX;
+  return ctx->stream_win;
 }
 
 static CURLcode cf_h2_update_local_win(struct Curl_cfilter *cf,
@@ -346,6 +493,58 @@ static CURLcode cf_h2_update_local_win(struct Curl_cfilter *cf,
 }
 #endif /* !NGHTTP2_HAS_SET_LOCAL_WINDOW_SIZE */
 
+/* opaque data of the PINGs measuring the bandwidth-delay product */
+static const uint8_t h2_bdp_ping[8] = { 'c', 'u', 'r', 'l', 'b', 'd', 'p', 0 };
+
+/*
+ * Count DATA received for the bandwidth-delay product sample, or start a
+ * new sample with a PING. The DATA received until its ACK arrives is what
+ * the server can have in flight in a round trip with the windows we give.
+ */
+static void h2_bdp_data_recvd(struct cf_h2_ctx *ctx, size_t len)
+{
+  if(ctx->bdp_ping_out)
+    ctx->bdp_bytes += len;
+  else if(ctx->stream_win < ctx->stream_win_max) {
+    if(!nghttp2_submit_ping(ctx->h2, NGHTTP2_FLAG_NONE, h2_bdp_ping)) {
+      ctx->bdp_ping_out = TRUE;
+      ctx->bdp_ping_sent = Curl_now();
+      ctx->bdp_bytes = len;
+    }
+  }
+}
+
+/*
+ * The ACK to our BDP PING arrived. When the sample came close to filling
+ * the stream window and the bandwidth did not drop, the window limits us,
+ * so let the server send twice the sample in a round trip.
+ */
+static void h2_bdp_ping_ack(struct Curl_cfilter *cf, struct Curl_easy *data)
+{
+  struct cf_h2_ctx *ctx = cf->ctx;
+  timediff_t rtt_us = Curl_timediff_us(Curl_now(), ctx->bdp_ping_sent);
+  curl_off_t bw;
+
+  ctx->bdp_ping_out = FALSE;
+  if(rtt_us <= 0)
+    rtt_us = 1;
+  bw = (curl_off_t)ctx->bdp_bytes * 1000000 / rtt_us;
+  if(bw > ctx->bdp_bw_max)
+    ctx->bdp_bw_max = bw;
+  if((ctx->bdp_bytes >= (size_t)ctx->stream_win / 3 * 2) &&
+     (bw == ctx->bdp_bw_max)) {
+    size_t win = ctx->bdp_bytes * 2;
+    if(win > (size_t)ctx->stream_win_max)
+      win = (size_t)ctx->stream_win_max;
+    if(win > (size_t)ctx->stream_win) {
+      ctx->stream_win = (int32_t)win;
+      CURL_TRC_CF(data, cf, "[0] BDP %zu bytes in %" FMT_TIMEDIFF_T "us, "
+                  "stream window now %d", ctx->bdp_bytes, rtt_us,
+                  ctx->stream_win);
+    }
+  }
+}
+
 /*
  * Mark this transfer to get "drained".
  */
@@ -421,6 +620,7 @@ static void http2_data_done(struct Curl_cfilter *cf, struct Curl_easy *data)
       flush_egress = TRUE;
     }
 
+    h2_sched_done(ctx, stream);
     if(flush_egress)
       nghttp2_session_send(ctx->h2);
   }
@@ -597,6 +797,20 @@ static CURLcode cf_h2_ctx_open(struct Curl_cfilter *cf,
     }
   }
 
+  ctx->stream_win_max = (int32_t)Curl_multi_max_stream_window(data->multi);
+  ctx->stream_win = CURLMIN(H2_STREAM_WINDOW_SIZE_MAX, ctx->stream_win_max);
+#ifdef DEBUGBUILD
+  {
+    /* start from a smaller window to see it grow */
+    char *p = getenv("CURL_DBG_H2_STREAM_WIN");
+    if(p) {
+      long l = strtol(p, NULL, 10);
+      if(l > 0 && l < ctx->stream_win)
+        ctx->stream_win = (int32_t)l;
+    }
+  }
+#endif
+
   rc = nghttp2_session_set_local_window_size(ctx->h2, NGHTTP2_FLAG_NONE, 0,
                                              HTTP2_HUGE_WINDOW_SIZE);
   if(rc) {
@@ -1341,6 +1555,11 @@ static int on_frame_recv(nghttp2_session *session, const nghttp2_frame *frame,
         Curl_multi_connchanged(data->multi);
       }
       break;
+    case NGHTTP2_PING:
+      if((frame->hd.flags & NGHTTP2_FLAG_ACK) && ctx->bdp_ping_out &&
+         !memcmp(frame->ping.opaque_data, h2_bdp_ping, sizeof(h2_bdp_ping)))
+        h2_bdp_ping_ack(cf, data);
+      break;
     default:
       break;
     }
@@ -1368,6 +1587,7 @@ static int on_data_chunk_recv(nghttp2_session *session, uint8_t flags,
 
   DEBUGASSERT(stream_id); /* should never be a zero stream ID here */
   DEBUGASSERT(CF_DATA_CURRENT(cf));
+  h2_bdp_data_recvd(ctx, len);
 
   /* get the stream from the hash based on Stream ID */
   data_s = nghttp2_session_get_stream_user_data(session, stream_id);
@@ -1654,6 +1874,8 @@ static ssize_t req_body_read_callback(nghttp2_session *session,
   struct h2_stream_ctx *stream = NULL;
   CURLcode result;
   ssize_t nread;
+  size_t allowed;
+  int32_t window;
   (void)source;
 
   (void)cf;
@@ -1672,7 +1894,15 @@ static ssize_t req_body_read_callback(nghttp2_session *session,
   if(!stream)
     return NGHTTP2_ERR_CALLBACK_FAILURE;
 
-  nread = Curl_bufq_read(&stream->sendbuf, buf, length, &result);
+  allowed = h2_sched_allow(ctx, data_s, stream);
+  if(!allowed) {
+    CURL_TRC_CF(data_s, cf, "[%d] req_body_read, deferred for [%d]",
+                stream_id, ctx->sched_cur->id);
+    return NGHTTP2_ERR_DEFERRED;
+  }
+  window = nghttp2_session_get_stream_remote_window_size(session, stream_id);
+  nread = Curl_bufq_read(&stream->sendbuf, buf, CURLMIN(length, allowed),
+                         &result);
   if(nread < 0) {
     if(result != CURLE_AGAIN)
       return NGHTTP2_ERR_CALLBACK_FAILURE;
@@ -1684,8 +1914,10 @@ static ssize_t req_body_read_callback(nghttp2_session *session,
 
   if(stream->body_eos && Curl_bufq_is_empty(&stream->sendbuf)) {
     *data_flags = NGHTTP2_DATA_FLAG_EOF;
+    h2_sched_done(ctx, stream);
     return nread;
   }
+  h2_sched_sent(ctx, stream, (size_t)nread, window);
   return (nread == 0) ? NGHTTP2_ERR_DEFERRED : nread;
 }
 
@@ -1888,9 +2120,14 @@ static CURLcode h2_progress_egress(struct Curl_cfilter *cf,
       goto out;
   }
 
+  h2_sched_check(ctx);
   ctx->nw_out_blocked = 0;
-  while(!rv && !ctx->nw_out_blocked && nghttp2_session_want_write(ctx->h2))
+  while(!rv && !ctx->nw_out_blocked) {
+    h2_sched_resume(ctx);
+    if(!nghttp2_session_want_write(ctx->h2))
+      break;
     rv = nghttp2_session_send(ctx->h2);
+  }
 
 out:
   if(nghttp2_is_fatal(rv)) {
@@ -2131,6 +2368,81 @@ static ssize_t cf_h2_body_send(struct Curl_cfilter *cf,
   return nwritten;
 }
 
+static void h2_nv_set(nghttp2_nv *nv, struct dynhds_entry *e)
+{
+  nv->name = (unsigned char *)e->name;
+  nv->namelen = e->namelen;
+  nv->value = (unsigned char *)e->value;
+  nv->valuelen = e->valuelen;
+  nv->flags = NGHTTP2_NV_FLAG_NONE;
+}
+
+/*
+ * Make the nghttp2 headers for the request. Requests on a connection
+ * often carry the very same header fields, e.g. from API clients, and
+ * the lowercased fields of the last request are kept for that. When they
+ * match, only the pseudo headers of the new request are put in front of
+ * them. `*pnva` points into the filter context and its entries into
+ * `h2_headers` and the context, valid until the next request.
+ */
+static CURLcode h2_req_nva(struct Curl_cfilter *cf, struct Curl_easy *data,
+                           struct dynhds *h2_headers, struct httpreq *req,
+                           nghttp2_nv **pnva, size_t *pcount)
+{
+  struct cf_h2_ctx *ctx = cf->ctx;
+  size_t i, npseudo, nfields;
+  CURLcode result;
+
+  *pnva = NULL;
+  *pcount = 0;
+  result = Curl_http_req_to_h2_pseudo(h2_headers, req, data);
+  if(result)
+    return result;
+  npseudo = Curl_dynhds_count(h2_headers);
+  DEBUGASSERT(npseudo <= H2_REQ_PSEUDO_MAX);
+
+  if(ctx->req_nva && Curl_http_req_h2_fields_same(&ctx->req_fields, req)) {
+    CURL_TRC_CF(data, cf, "reusing header fields of the last request");
+    nfields = Curl_dynhds_count(&ctx->req_fields);
+  }
+  else {
+    Curl_dynhds_reset(&ctx->req_fields);
+    result = Curl_http_req_to_h2_fields(&ctx->req_fields, req);
+    if(result)
+      goto out;
+    nfields = Curl_dynhds_count(&ctx->req_fields);
+    if(ctx->req_nva_len < H2_REQ_PSEUDO_MAX + nfields) {
+      free(ctx->req_nva);
+      ctx->req_nva_len = 0;
+      ctx->req_nva = malloc(sizeof(nghttp2_nv) *
+                            (H2_REQ_PSEUDO_MAX + nfields));
+      if(!ctx->req_nva) {
+        result = CURLE_OUT_OF_MEMORY;
+        goto out;
+      }
+      ctx->req_nva_len = H2_REQ_PSEUDO_MAX + nfields;
+    }
+    for(i = 0; i < nfields; ++i)
+      h2_nv_set(&ctx->req_nva[H2_REQ_PSEUDO_MAX + i],
+                Curl_dynhds_getn(&ctx->req_fields, i));
+  }
+
+  /* the pseudo headers go right in front of the fields */
+  *pnva = &ctx->req_nva[H2_REQ_PSEUDO_MAX - npseudo];
+  for(i = 0; i < npseudo; ++i)
+    h2_nv_set(&(*pnva)[i], Curl_dynhds_getn(h2_headers, i));
+  *pcount = npseudo + nfields;
+
+out:
+  if(result) {
+    /* do not match the next request against a partial set */
+    Curl_dynhds_reset(&ctx->req_fields);
+    Curl_safefree(ctx->req_nva);
+    ctx->req_nva_len = 0;
+  }
+  return result;
+}
+
 static ssize_t h2_submit(struct h2_stream_ctx **pstream,
                          struct Curl_cfilter *cf, struct Curl_easy *data,
                          const void *buf, size_t len,
@@ -2139,7 +2451,7 @@ static ssize_t h2_submit(struct h2_stream_ctx **pstream,
   struct cf_h2_ctx *ctx = cf->ctx;
   struct h2_stream_ctx *stream = NULL;
   struct dynhds h2_headers;
-  nghttp2_nv *nva = NULL;
+  nghttp2_nv *nva;
   const void *body = NULL;
   size_t nheader, bodylen, i;
   nghttp2_data_provider data_prd;
@@ -2164,7 +2476,7 @@ static ssize_t h2_submit(struct h2_stream_ctx **pstream,
   }
   DEBUGASSERT(stream->h1.req);
 
-  *err = Curl_http_req_to_h2(&h2_headers, stream->h1.req, data);
+  *err = h2_req_nva(cf, data, &h2_headers, stream->h1.req, &nva, &nheader);
   if(*err) {
     nwritten = -1;
     goto out;
@@ -2172,13 +2484,6 @@ static ssize_t h2_submit(struct h2_stream_ctx **pstream,
   /* no longer needed */
   Curl_h1_req_parse_free(&stream->h1);
 
-  nva = Curl_dynhds_to_nva(&h2_headers, &nheader);
-  if(!nva) {
-    *err = CURLE_OUT_OF_MEMORY;
-    nwritten = -1;
-    goto out;
-  }
-
   h2_pri_spec(ctx, data, &pri_spec);
   if(!nghttp2_session_check_request_allowed(ctx->h2))
     CURL_TRC_CF(data, cf, "send request NOT allowed (via nghttp2)");
@@ -2192,6 +2497,8 @@ static ssize_t h2_submit(struct h2_stream_ctx **pstream,
     data_prd.source.ptr = NULL;
     stream_id = nghttp2_submit_request(ctx->h2, &pri_spec, nva, nheader,
                                        &data_prd, data);
+    if(stream_id > 0)
+      Curl_llist_append(&ctx->sched, stream, &stream->sched_node);
     break;
   default:
     stream_id = nghttp2_submit_request(ctx->h2, &pri_spec, nva, nheader,
@@ -2248,7 +2555,6 @@ static ssize_t h2_submit(struct h2_stream_ctx **pstream,
 out:
   CURL_TRC_CF(data, cf, "[%d] submit -> %zd, %d",
               stream ? stream->id : -1, nwritten, *err);
-  Curl_safefree(nva);
   *pstream = stream;
   Curl_dynhds_free(&h2_headers);
   return nwritten;
@@ -2743,6 +3049,7 @@ static CURLcode http2_cfilter_add(struct Curl_cfilter **pcf,
   if(!ctx)
     goto out;
   cf_h2_ctx_init(ctx, via_h1_upgrade);
+  Curl_bufcp_use_share(&ctx->stream_bufcp, Curl_multi_bufc_share(data));
 
   result = Curl_cf_create(&cf, &Curl_cft_nghttp2, ctx);
   if(result)
@@ -2766,11 +3073,11 @@ static CURLcode http2_cfilter_insert_after(struct Curl_cfilter *cf,
   struct cf_h2_ctx *ctx;
   CURLcode result = CURLE_OUT_OF_MEMORY;
 
-  (void)data;
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx)
     goto out;
   cf_h2_ctx_init(ctx, via_h1_upgrade);
+  Curl_bufcp_use_share(&ctx->stream_bufcp, Curl_multi_bufc_share(data));
 
   result = Curl_cf_create(&cf_h2, &Curl_cft_nghttp2, ctx);
   if(result)
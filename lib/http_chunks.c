@@ -145,17 +145,22 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
   while(blen) {
     switch(ch->state) {
     case CHUNK_HEX:
-      if(ISXDIGIT(*buf)) {
-        if(ch->hexindex >= CHUNK_MAXNUM_LEN) {
+      /* take all hex digits there are in the buffer at once */
+      piece = 0;
+      while((piece < blen) && ISXDIGIT(buf[piece]))
+        piece++;
+      if(piece) {
+        if(piece > (size_t)(CHUNK_MAXNUM_LEN - ch->hexindex)) {
           failf(data, "chunk hex-length longer than %d", CHUNK_MAXNUM_LEN);
           ch->state = CHUNK_FAILED;
           ch->last_code = CHUNKE_TOO_LONG_HEX; /* longer than we support */
           return CURLE_RECV_ERROR;
         }
-        ch->hexbuffer[ch->hexindex++] = *buf;
-        buf++;
-        blen--;
-        (*pconsumed)++;
+        memcpy(&ch->hexbuffer[ch->hexindex], buf, piece);
+        ch->hexindex = (unsigned char)(ch->hexindex + piece);
+        buf += piece;
+        blen -= piece;
+        *pconsumed += piece;
       }
       else {
         if(0 == ch->hexindex) {
@@ -179,9 +184,11 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
       }
       break;
 
-    case CHUNK_LF:
-      /* waiting for the LF after a chunk size */
-      if(*buf == 0x0a) {
+    case CHUNK_LF: {
+      /* waiting for the LF after a chunk size, skip all before it */
+      const char *lf = memchr(buf, 0x0a, blen);
+      piece = lf ? (size_t)(lf - buf) + 1 : blen;
+      if(lf) {
         /* we are now expecting data to come, unless size was zero! */
         if(0 == ch->datasize) {
           ch->state = CHUNK_TRAILER; /* now check for trailers */
@@ -193,10 +200,11 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
         }
       }
 
-      buf++;
-      blen--;
-      (*pconsumed)++;
+      buf += piece;
+      blen -= piece;
+      *pconsumed += piece;
       break;
+    }
 
     case CHUNK_DATA:
       /* We expect 'datasize' of data. We have 'blen' right now, it can be
@@ -295,12 +303,20 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
         }
       }
       else {
-        result = Curl_dyn_addn(&ch->trailer, buf, 1);
+        /* add the trailer line up to its end at once */
+        piece = 1;
+        while((piece < blen) && (buf[piece] != 0x0d) && (buf[piece] != 0x0a))
+          piece++;
+        result = Curl_dyn_addn(&ch->trailer, buf, piece);
         if(result) {
           ch->state = CHUNK_FAILED;
           ch->last_code = CHUNKE_OUT_OF_MEMORY;
           return result;
         }
+        buf += piece;
+        blen -= piece;
+        *pconsumed += piece;
+        break;
       }
       buf++;
       blen--;
@@ -50,6 +50,11 @@
 #include "http2.h"
 #include "socketpair.h"
 #include "socks.h"
+
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
 #include "curl_memory.h"
@@ -101,6 +106,84 @@ static void multi_xfer_bufs_free(struct Curl_multi *multi);
 static void Curl_expire_ex(struct Curl_easy *data, const struct curltime *nowp,
                            timediff_t milli, expire_id id);
 
+/*
+ * Each transfer with a pending timeout is in the multi's timer queue once,
+ * keyed on its nearest expire time in data->state.expiretime. The queue is
+ * a timer wheel unless that is disabled at build time, then a splay tree.
+ */
+#ifndef CURL_DISABLE_TIMER_WHEEL
+
+static void multi_timer_add(struct Curl_multi *multi, struct Curl_easy *data)
+{
+  Curl_wheelset(&data->state.timenode, data);
+  Curl_wheel_add(&multi->timers, data->state.expiretime,
+                 &data->state.timenode);
+}
+
+static int multi_timer_remove(struct Curl_multi *multi,
+                              struct Curl_easy *data)
+{
+  return Curl_wheel_remove(&multi->timers, &data->state.timenode);
+}
+
+/* Remove and return a transfer whose timer has expired at `now` */
+static struct Curl_easy *multi_timer_getbest(struct Curl_multi *multi,
+                                             struct curltime now)
+{
+  struct Curl_wheel_node *t = Curl_wheel_getbest(&multi->timers, now);
+  return t ? Curl_wheelget(t) : NULL;
+}
+
+/* Get the nearest expire time of all transfers, FALSE if there is none */
+static bool multi_timer_first(struct Curl_multi *multi,
+                              struct curltime *expire_time)
+{
+  return Curl_wheel_first(&multi->timers, expire_time);
+}
+
+#else /* !CURL_DISABLE_TIMER_WHEEL */
+
+static void multi_timer_add(struct Curl_multi *multi, struct Curl_easy *data)
+{
+  Curl_splayset(&data->state.timenode, data);
+  multi->timetree = Curl_splayinsert(data->state.expiretime, multi->timetree,
+                                     &data->state.timenode);
+}
+
+static int multi_timer_remove(struct Curl_multi *multi,
+                              struct Curl_easy *data)
+{
+  return Curl_splayremove(multi->timetree, &data->state.timenode,
+                          &multi->timetree);
+}
+
+static struct Curl_easy *multi_timer_getbest(struct Curl_multi *multi,
+                                             struct curltime now)
+{
+  struct Curl_tree *t = NULL;
+  multi->timetree = Curl_splaygetbest(now, multi->timetree, &t);
+  return t ? Curl_splayget(t) : NULL;
+}
+
+static bool multi_timer_first(struct Curl_multi *multi,
+                              struct curltime *expire_time)
+{
+  static const struct curltime tv_zero = {0, 0};
+
+  if(!multi->timetree)
+    return FALSE;
+  /* splay the lowest to the bottom */
+  multi->timetree = Curl_splay(tv_zero, multi->timetree);
+  /* this will not return NULL from a non-emtpy tree, but some compilers
+   * are not convinced of that. Analyzers are hard. */
+  if(!multi->timetree)
+    return FALSE;
+  *expire_time = multi->timetree->key;
+  return TRUE;
+}
+
+#endif /* CURL_DISABLE_TIMER_WHEEL */
+
 #if defined( DEBUGBUILD) && !defined(CURL_DISABLE_VERBOSE_STRINGS)
 static const char * const multi_statename[]={
   "INIT",
@@ -372,6 +455,155 @@ static void sh_init(struct Curl_hash *hash, size_t hashsize)
                  sh_freeentry);
 }
 
+#ifdef USE_EPOLL
+/* curl_multi_wait() switches to the epoll set when processing at least
+   this many transfers. Below that, polling them all is cheaper. */
+#define MULTI_EV_MIN_XFERS 8
+
+static void multi_ev_init(struct Curl_multi *multi)
+{
+  multi->ev_fd = -1;
+  multi->ev_min_xfers = MULTI_EV_MIN_XFERS;
+#ifdef DEBUGBUILD
+  {
+    char *p = getenv("CURL_DBG_MULTI_EPOLL");
+    if(p) {
+      long l = strtol(p, NULL, 10);
+      if(l >= 0)
+        multi->ev_min_xfers = (size_t)l;
+    }
+  }
+#endif
+}
+
+static void multi_ev_close(struct Curl_multi *multi)
+{
+  if(multi->ev_fd != -1) {
+    close(multi->ev_fd);
+    multi->ev_fd = -1;
+  }
+  multi->ev_count = 0;
+  Curl_safefree(multi->ev_events);
+  multi->ev_events_len = 0;
+}
+
+/* The epoll set is out of sync with the socket hash, drop it and poll the
+   transfers from now on. */
+static void multi_ev_fail(struct Curl_multi *multi)
+{
+  multi_ev_close(multi);
+  multi->ev_failed = TRUE;
+}
+
+/*
+ * Change the events the epoll set waits for on socket `s` from the `old`
+ * to the `cur` combined CURL_POLL_* action of its socket hash entry.
+ */
+static void multi_ev_update(struct Curl_multi *multi, curl_socket_t s,
+                            unsigned int old, unsigned int cur)
+{
+  struct epoll_event ev;
+  int op;
+
+  if((multi->ev_fd == -1) || (old == cur))
+    return;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.data.fd = s;
+  if(!cur) {
+    /* closing the socket already removed it from the set */
+    if(epoll_ctl(multi->ev_fd, EPOLL_CTL_DEL, s, &ev) &&
+       (errno != ENOENT) && (errno != EBADF))
+      multi_ev_fail(multi);
+    else if(multi->ev_count)
+      multi->ev_count--;
+    return;
+  }
+
+  if(cur & CURL_POLL_IN)
+    ev.events |= EPOLLIN;
+  if(cur & CURL_POLL_OUT)
+    ev.events |= EPOLLOUT;
+  op = old ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  if(epoll_ctl(multi->ev_fd, op, s, &ev)) {
+    /* the socket may have been closed and its number reused since */
+    if(errno == ENOENT)
+      op = EPOLL_CTL_ADD;
+    else if(errno == EEXIST)
+      op = EPOLL_CTL_MOD;
+    else
+      op = 0;
+    if(!op || epoll_ctl(multi->ev_fd, op, s, &ev)) {
+      multi_ev_fail(multi);
+      return;
+    }
+  }
+  if(!old)
+    multi->ev_count++;
+}
+
+/*
+ * Check if multi_wait() should wait on the epoll set instead of the
+ * sockets of all transfers, creating the set when there are enough of them.
+ * While the set exists, curl_multi_perform() keeps the socket hash current
+ * for each transfer it runs, the same way curl_multi_socket_action() does.
+ */
+static CURLMcode multi_ev_prepare(struct Curl_multi *multi, bool *use_ev)
+{
+  CURLMcode result = CURLM_OK;
+
+  *use_ev = FALSE;
+  if(multi->ev_failed)
+    return CURLM_OK;
+
+  if(multi->ev_fd == -1) {
+    struct Curl_hash_iterator iter;
+    struct Curl_hash_element *he;
+    struct Curl_llist_node *e;
+
+    if(Curl_llist_count(&multi->process) < multi->ev_min_xfers)
+      return CURLM_OK;
+    multi->ev_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(multi->ev_fd == -1) {
+      multi->ev_failed = TRUE;
+      return CURLM_OK;
+    }
+
+    /* add what the socket hash already knows, then bring it up to date */
+    Curl_hash_start_iterate(&multi->sockhash, &iter);
+    for(he = Curl_hash_next_element(&iter); he && (multi->ev_fd != -1);
+        he = Curl_hash_next_element(&iter)) {
+      struct Curl_sh_entry *entry = (struct Curl_sh_entry *)he->ptr;
+      multi_ev_update(multi, *(curl_socket_t *)he->key, 0, entry->action);
+    }
+    for(e = Curl_llist_head(&multi->process); e && !result;
+        e = Curl_node_next(e)) {
+      if(Curl_node_elem(e) != multi->cpool.idata)
+        result = singlesocket(multi, Curl_node_elem(e));
+    }
+    if(result)
+      return result;
+    if(multi->ev_fd == -1)
+      return CURLM_OK;
+  }
+
+  if(multi->ev_events_len < multi->ev_count) {
+    size_t len = multi->ev_count * 2;
+    struct epoll_event *events;
+
+    events = realloc(multi->ev_events, len * sizeof(*events));
+    if(!events)
+      return CURLM_OUT_OF_MEMORY;
+    multi->ev_events = events;
+    multi->ev_events_len = len;
+  }
+  *use_ev = TRUE;
+  return CURLM_OK;
+}
+#else
+#define multi_ev_update(m,s,o,c) Curl_nop_stmt
+#endif /* USE_EPOLL */
+
 /* multi->proto_hash destructor. Should never be called as elements
  * MUST be added with their own destructor */
 static void ph_freeentry(void *p)
@@ -412,10 +644,16 @@ struct Curl_multi *Curl_multi_handle(size_t hashsize, /* socket hash */
   Curl_hash_init(&multi->proto_hash, 23,
                  Curl_hash_str, Curl_str_key_compare, ph_freeentry);
 
+  Curl_slab_init(&multi->slab);
+  Curl_bufcs_init(&multi->bufcs, CURL_BUFC_SHARE_MAX);
+
   if(Curl_cpool_init(&multi->cpool, Curl_on_disconnect,
-                         multi, NULL, chashsize))
+                         multi, NULL, chashsize, 1))
     goto error;
 
+#ifndef CURL_DISABLE_TIMER_WHEEL
+  Curl_wheel_init(&multi->timers);
+#endif
   Curl_llist_init(&multi->msglist, NULL);
   Curl_llist_init(&multi->process, NULL);
   Curl_llist_init(&multi->pending, NULL);
@@ -423,7 +661,12 @@ struct Curl_multi *Curl_multi_handle(size_t hashsize, /* socket hash */
 
   multi->multiplexing = TRUE;
   multi->max_concurrent_streams = 100;
+  multi->max_stream_window = CURL_STREAM_WINDOW_MAX;
+  multi->resolver_threads = CURL_RESOLVER_THREADS_DEFAULT;
   multi->last_timeout_ms = -1;
+#ifdef USE_EPOLL
+  multi_ev_init(multi);
+#endif
 
 #ifdef USE_WINSOCK
   multi->wsa_event = WSACreateEvent();
@@ -446,6 +689,8 @@ error:
   Curl_hash_destroy(&multi->proto_hash);
   Curl_hash_destroy(&multi->hostcache);
   Curl_cpool_destroy(&multi->cpool);
+  Curl_bufcs_free(&multi->bufcs);
+  Curl_slab_destroy(&multi->slab);
   free(multi);
   return NULL;
 }
@@ -756,6 +1001,13 @@ static CURLcode multi_done(struct Curl_easy *data,
   mdctx.premature = premature;
   Curl_cpool_do_locked(data, data->conn, multi_done_locked, &mdctx);
 
+  Curl_slab_trace(data);
+  if(data->multi) {
+    struct bufc_share *bufcs = &data->multi->bufcs;
+    CURL_TRC_MEM(data, "chunks: %zu reused, %zu allocated, %zu freed over "
+                 "the high watermark, %zu bytes kept now", bufcs->hits,
+                 bufcs->misses, bufcs->trimmed, bufcs->spare_bytes);
+  }
   return result;
 }
 
@@ -825,7 +1077,7 @@ CURLMcode curl_multi_remove_handle(struct Curl_multi *multi,
   }
 
   /* The timer must be shut down before data->multi is set to NULL, else the
-     timenode will remain in the splay tree after curl_easy_cleanup is
+     timenode will remain in the timer queue after curl_easy_cleanup is
      called. Do it after multi_done() in case that sets another time! */
   removed_timer = Curl_expire_clear(data);
 
@@ -1253,6 +1505,10 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
   unsigned int curl_nfds = 0; /* how many pfds are for curl transfers */
   CURLMcode result = CURLM_OK;
   struct Curl_llist_node *e;
+#ifdef USE_EPOLL
+  bool use_ev = FALSE;
+  bool ev_polled = FALSE; /* the epoll set is in cpfds[0] */
+#endif
 
 #ifdef USE_WINSOCK
   WSANETWORKEVENTS wsa_events;
@@ -1273,14 +1529,32 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
 
   Curl_pollfds_init(&cpfds, a_few_on_stack, NUM_POLLS_ON_STACK);
 
-  /* Add the curl handles to our pollfds first */
-  for(e = Curl_llist_head(&multi->process); e; e = Curl_node_next(e)) {
-    struct Curl_easy *data = Curl_node_elem(e);
+#ifdef USE_EPOLL
+  result = multi_ev_prepare(multi, &use_ev);
+  if(result)
+    goto out;
+  if(use_ev) {
+    /* the epoll set stands in for the sockets of all transfers */
+    if(multi->ev_count) {
+      if(Curl_pollfds_add_sock(&cpfds, multi->ev_fd, POLLIN)) {
+        result = CURLM_OUT_OF_MEMORY;
+        goto out;
+      }
+      ev_polled = TRUE;
+    }
+  }
+  else
+#endif
+  {
+    /* Add the curl handles to our pollfds first */
+    for(e = Curl_llist_head(&multi->process); e; e = Curl_node_next(e)) {
+      struct Curl_easy *data = Curl_node_elem(e);
 
-    multi_getsock(data, &data->last_poll);
-    if(Curl_pollfds_add_ps(&cpfds, &data->last_poll)) {
-      result = CURLM_OUT_OF_MEMORY;
-      goto out;
+      multi_getsock(data, &data->last_poll);
+      if(Curl_pollfds_add_ps(&cpfds, &data->last_poll)) {
+        result = CURLM_OUT_OF_MEMORY;
+        goto out;
+      }
     }
   }
 
@@ -1357,6 +1631,17 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
     else
       pollrc = 0;
 #else
+#ifdef USE_EPOLL
+    if(ev_polled && (cpfds.n == 1)) {
+      /* nothing but the epoll set, wait on it directly */
+      pollrc = epoll_wait(multi->ev_fd, multi->ev_events,
+                          (int)multi->ev_events_len, timeout_ms);
+      if((pollrc == -1) && (SOCKERRNO == EINTR))
+        pollrc = 0;
+      ev_polled = FALSE; /* counted already */
+    }
+    else
+#endif
     pollrc = Curl_poll(cpfds.pfds, cpfds.n, timeout_ms); /* wait... */
 #endif
     if(pollrc < 0) {
@@ -1432,6 +1717,15 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
 
       WSAResetEvent(multi->wsa_event);
 #else
+#ifdef USE_EPOLL
+      if(ev_polled && (cpfds.pfds[0].revents & POLLIN)) {
+        /* count the ready sockets in the set instead of the set itself */
+        int nready = epoll_wait(multi->ev_fd, multi->ev_events,
+                                (int)multi->ev_events_len, 0);
+        if(nready > 0)
+          retcode += nready - 1;
+      }
+#endif
 #ifdef ENABLE_WAKEUP
       if(use_wakeup && multi->wakeup_pair[0] != CURL_SOCKET_BAD) {
         if(cpfds.pfds[curl_nfds + extra_nfds].revents & POLLIN) {
@@ -2630,7 +2924,6 @@ statemachine_end:
 CURLMcode curl_multi_perform(struct Curl_multi *multi, int *running_handles)
 {
   CURLMcode returncode = CURLM_OK;
-  struct Curl_tree *t = NULL;
   struct curltime now = Curl_now();
   struct Curl_llist_node *e;
   struct Curl_llist_node *n = NULL;
@@ -2657,6 +2950,11 @@ CURLMcode curl_multi_perform(struct Curl_multi *multi, int *running_handles)
       /* connection pool handle is processed below */
       sigpipe_apply(data, &pipe_st);
       result = multi_runsingle(multi, &now, data);
+#ifdef USE_EPOLL
+      /* keep the epoll set current */
+      if(!result && (multi->ev_fd != -1))
+        result = singlesocket(multi, data);
+#endif
       if(result)
         returncode = result;
     }
@@ -2668,31 +2966,30 @@ CURLMcode curl_multi_perform(struct Curl_multi *multi, int *running_handles)
   sigpipe_restore(&pipe_st);
 
   /*
-   * Simply remove all expired timers from the splay since handles are dealt
+   * Simply remove all expired timers from the queue since handles are dealt
    * with unconditionally by this function and curl_multi_timeout() requires
-   * that already passed/handled expire times are removed from the splay.
+   * that already passed/handled expire times are removed from the queue.
    *
    * It is important that the 'now' value is set at the entry of this function
    * and not for the current time as it may have ticked a little while since
    * then and then we risk this loop to remove timers that actually have not
    * been handled!
    */
-  do {
-    multi->timetree = Curl_splaygetbest(now, multi->timetree, &t);
-    if(t) {
-      /* the removed may have another timeout in queue */
-      struct Curl_easy *data = Curl_splayget(t);
-      if(data->mstate == MSTATE_PENDING) {
-        bool stream_unused;
-        CURLcode result_unused;
-        if(multi_handle_timeout(data, &now, &stream_unused, &result_unused)) {
-          infof(data, "PENDING handle timeout");
-          move_pending_to_connect(multi, data);
-        }
+  for(;;) {
+    struct Curl_easy *data = multi_timer_getbest(multi, now);
+    if(!data)
+      break;
+    /* the removed may have another timeout in queue */
+    if(data->mstate == MSTATE_PENDING) {
+      bool stream_unused;
+      CURLcode result_unused;
+      if(multi_handle_timeout(data, &now, &stream_unused, &result_unused)) {
+        infof(data, "PENDING handle timeout");
+        move_pending_to_connect(multi, data);
       }
-      (void)add_next_timeout(now, multi, Curl_splayget(t));
     }
-  } while(t);
+    (void)add_next_timeout(now, multi, data);
+  }
 
   if(running_handles)
     *running_handles = (int)multi->num_alive;
@@ -2708,8 +3005,11 @@ CURLMcode curl_multi_perform(struct Curl_multi *multi, int *running_handles)
 static void unlink_all_msgsent_handles(struct Curl_multi *multi)
 {
   struct Curl_llist_node *e;
-  for(e = Curl_llist_head(&multi->msgsent); e; e = Curl_node_next(e)) {
+  struct Curl_llist_node *n;
+  for(e = Curl_llist_head(&multi->msgsent); e; e = n) {
     struct Curl_easy *data = Curl_node_elem(e);
+    /* the node moves to another list */
+    n = Curl_node_next(e);
     if(data) {
       DEBUGASSERT(data->mstate == MSTATE_MSGSENT);
       Curl_node_remove(&data->multi_queue);
@@ -2732,7 +3032,8 @@ CURLMcode curl_multi_cleanup(struct Curl_multi *multi)
     /* move the pending and msgsent entries back to process
        so that there is just one list to iterate over */
     unlink_all_msgsent_handles(multi);
-    process_pending_handles(multi);
+    while(Curl_llist_head(&multi->pending))
+      process_pending_handles(multi);
 
     /* First remove all remaining easy handles */
     for(e = Curl_llist_head(&multi->process); e; e = n) {
@@ -2761,8 +3062,12 @@ CURLMcode curl_multi_cleanup(struct Curl_multi *multi)
     }
 
     Curl_cpool_destroy(&multi->cpool);
+    Curl_resolver_multi_cleanup(multi);
 
     sockhash_destroy(&multi->sockhash);
+#ifdef USE_EPOLL
+    multi_ev_close(multi);
+#endif
     Curl_hash_destroy(&multi->proto_hash);
     Curl_hash_destroy(&multi->hostcache);
     Curl_psl_destroy(&multi->psl);
@@ -2779,6 +3084,8 @@ CURLMcode curl_multi_cleanup(struct Curl_multi *multi)
 #endif
 
     multi_xfer_bufs_free(multi);
+    Curl_bufcs_free(&multi->bufcs);
+    Curl_slab_destroy(&multi->slab);
     free(multi);
 
     return CURLM_OK;
@@ -2940,6 +3247,7 @@ CURLMcode Curl_multi_pollset_ev(struct Curl_multi *multi,
     }
 
     /* store the current action state */
+    multi_ev_update(multi, s, entry->action, (unsigned int)comboaction);
     entry->action = (unsigned int)comboaction;
   }
 
@@ -2982,6 +3290,7 @@ CURLMcode Curl_multi_pollset_ev(struct Curl_multi *multi,
           if(rc == -1)
             dead = TRUE;
         }
+        multi_ev_update(multi, s, entry->action, 0);
         sh_delentry(entry, &multi->sockhash, s);
         if(dead) {
           multi->dead = TRUE;
@@ -3043,6 +3352,7 @@ void Curl_multi_closed(struct Curl_easy *data, curl_socket_t s)
         }
 
         /* now remove it from the socket hash */
+        multi_ev_update(multi, s, entry->action, 0);
         sh_delentry(entry, &multi->sockhash, s);
         if(rc == -1)
           /* This just marks the multi handle as "dead" without returning an
@@ -3058,12 +3368,12 @@ void Curl_multi_closed(struct Curl_easy *data, curl_socket_t s)
  * add_next_timeout()
  *
  * Each Curl_easy has a list of timeouts. The add_next_timeout() is called
- * when it has just been removed from the splay tree because the timeout has
+ * when it has just been removed from the timer queue because the timeout has
  * expired. This function is then to advance in the list to pick the next
  * timeout to use (skip the already expired ones) and add this node back to
- * the splay tree again.
+ * the timer queue again.
  *
- * The splay tree only has each sessionhandle as a single node and the nearest
+ * The timer queue only has each sessionhandle as a single node and the nearest
  * timeout is used to sort it on.
  */
 static CURLMcode add_next_timeout(struct curltime now,
@@ -3092,7 +3402,7 @@ static CURLMcode add_next_timeout(struct curltime now,
   e = Curl_llist_head(list);
   if(!e) {
     /* clear the expire times within the handles that we remove from the
-       splay tree */
+       timer queue */
     tv->tv_sec = 0;
     tv->tv_usec = 0;
   }
@@ -3101,10 +3411,9 @@ static CURLMcode add_next_timeout(struct curltime now,
     /* copy the first entry to 'tv' */
     memcpy(tv, &node->time, sizeof(*tv));
 
-    /* Insert this node again into the splay. Keep the timer in the list in
-       case we need to recompute future timers. */
-    multi->timetree = Curl_splayinsert(*tv, multi->timetree,
-                                       &d->state.timenode);
+    /* Insert this node again into the timer queue. Keep the timer in the
+       list in case we need to recompute future timers. */
+    multi_timer_add(multi, d);
   }
   return CURLM_OK;
 }
@@ -3121,24 +3430,19 @@ static CURLMcode multi_run_expired(struct multi_run_ctx *mrc)
 {
   struct Curl_multi *multi = mrc->multi;
   struct Curl_easy *data = NULL;
-  struct Curl_tree *t = NULL;
   CURLMcode result = CURLM_OK;
 
   /*
    * The loop following here will go on as long as there are expire-times left
-   * to process (compared to mrc->now) in the splay and 'data' will be
+   * to process (compared to mrc->now) in the timer queue and 'data' will be
    * re-assigned for every expired handle we deal with.
    */
   while(1) {
     /* Check if there is one (more) expired timer to deal with! This function
        extracts a matching node if there is one */
-    multi->timetree = Curl_splaygetbest(mrc->now, multi->timetree, &t);
-    if(!t)
-      goto out;
-
-    data = Curl_splayget(t); /* assign this for next loop */
+    data = multi_timer_getbest(multi, mrc->now);
     if(!data)
-      continue;
+      goto out;
 
     (void)add_next_timeout(mrc->now, multi, data);
     if(data == multi->cpool.idata) {
@@ -3224,7 +3528,7 @@ static CURLMcode multi_socket(struct Curl_multi *multi,
           mrc.run_cpool = TRUE;
         else {
           /* Expire with out current now, so we will get it below when
-           * asking the splaytree for expired transfers. */
+           * asking the timer queue for expired transfers. */
           Curl_expire_ex(data, &mrc.now, 0, EXPIRE_RUN_NOW);
         }
       }
@@ -3331,6 +3635,41 @@ CURLMcode curl_multi_setopt(struct Curl_multi *multi,
       multi->max_concurrent_streams = (unsigned int)streams;
     }
     break;
+  case CURLMOPT_RESOLVER_THREADS:
+    {
+      long threads = va_arg(param, long);
+      if((threads < 1) || (threads > INT_MAX))
+        threads = CURL_RESOLVER_THREADS_DEFAULT;
+      multi->resolver_threads = (unsigned int)threads;
+    }
+    break;
+  case CURLMOPT_RESOLVER_QUEUE:
+    {
+      long queue = va_arg(param, long);
+      if((queue < 0) || (queue > INT_MAX))
+        res = CURLM_BAD_FUNCTION_ARGUMENT;
+      else
+        multi->resolver_queue = (unsigned int)queue;
+    }
+    break;
+  case CURLMOPT_MAX_BUFFER_POOL:
+    {
+      long max = va_arg(param, long);
+      if(max < 0)
+        res = CURLM_BAD_FUNCTION_ARGUMENT;
+      else
+        Curl_bufcs_set_max(&multi->bufcs, (size_t)max);
+    }
+    break;
+  case CURLMOPT_MAX_STREAM_WINDOW:
+    {
+      long window = va_arg(param, long);
+      /* from the HTTP/2 default window to the largest one allowed */
+      if((window < 65535) || (window > INT_MAX))
+        window = CURL_STREAM_WINDOW_MAX;
+      multi->max_stream_window = (unsigned int)window;
+    }
+    break;
   default:
     res = CURLM_UNKNOWN_OPTION;
     break;
@@ -3376,22 +3715,13 @@ static CURLMcode multi_timeout(struct Curl_multi *multi,
     return CURLM_OK;
   }
 
-  if(multi->timetree) {
-    /* we have a tree of expire times */
+  if(multi_timer_first(multi, expire_time)) {
+    /* we have a queue of expire times */
     struct curltime now = Curl_now();
 
-    /* splay the lowest to the bottom */
-    multi->timetree = Curl_splay(tv_zero, multi->timetree);
-    /* this will not return NULL from a non-emtpy tree, but some compilers
-     * are not convinced of that. Analyzers are hard. */
-    *expire_time = multi->timetree ? multi->timetree->key : tv_zero;
-
-    /* 'multi->timetree' will be non-NULL here but the compilers sometimes
-       yell at us if we assume so */
-    if(multi->timetree &&
-       Curl_timediff_us(multi->timetree->key, now) > 0) {
+    if(Curl_timediff_us(*expire_time, now) > 0) {
       /* some time left before expiration */
-      timediff_t diff = Curl_timediff_ceil(multi->timetree->key, now);
+      timediff_t diff = Curl_timediff_ceil(*expire_time, now);
       /* this should be safe even on 32-bit archs, as we do not use that
          overly long timeouts */
       *timeout_ms = (long)diff;
@@ -3604,32 +3934,29 @@ static void Curl_expire_ex(struct Curl_easy *data,
   multi_addtimeout(data, &set, id);
 
   if(curr_expire->tv_sec || curr_expire->tv_usec) {
-    /* This means that the struct is added as a node in the splay tree.
+    /* This means that the struct is added as a node in the timer queue.
        Compare if the new time is earlier, and only remove-old/add-new if it
        is. */
     timediff_t diff = Curl_timediff(set, *curr_expire);
     int rc;
 
     if(diff > 0) {
-      /* The current splay tree entry is sooner than this new expiry time.
-         We do not need to update our splay tree entry. */
+      /* The current timer queue entry is sooner than this new expiry time.
+         We do not need to update our timer queue entry. */
       return;
     }
 
     /* Since this is an updated time, we must remove the previous entry from
-       the splay tree first and then re-add the new value */
-    rc = Curl_splayremove(multi->timetree, &data->state.timenode,
-                          &multi->timetree);
+       the timer queue first and then re-add the new value */
+    rc = multi_timer_remove(multi, data);
     if(rc)
-      infof(data, "Internal error removing splay node = %d", rc);
+      infof(data, "Internal error removing timer node = %d", rc);
   }
 
-  /* Indicate that we are in the splay tree and insert the new timer expiry
+  /* Indicate that we are in the timer queue and insert the new timer expiry
      value since it is our local minimum. */
   *curr_expire = set;
-  Curl_splayset(&data->state.timenode, data);
-  multi->timetree = Curl_splayinsert(*curr_expire, multi->timetree,
-                                     &data->state.timenode);
+  multi_timer_add(multi, data);
 }
 
 void Curl_expire(struct Curl_easy *data, timediff_t milli, expire_id id)
@@ -3667,14 +3994,13 @@ bool Curl_expire_clear(struct Curl_easy *data)
 
   if(nowp->tv_sec || nowp->tv_usec) {
     /* Since this is an cleared time, we must remove the previous entry from
-       the splay tree */
+       the timer queue */
     struct Curl_llist *list = &data->state.timeoutlist;
     int rc;
 
-    rc = Curl_splayremove(multi->timetree, &data->state.timenode,
-                          &multi->timetree);
+    rc = multi_timer_remove(multi, data);
     if(rc)
-      infof(data, "Internal error clearing splay node = %d", rc);
+      infof(data, "Internal error clearing timer node = %d", rc);
 
     /* clear the timeout list too */
     Curl_llist_destroy(list, NULL);
@@ -3763,6 +4089,23 @@ unsigned int Curl_multi_max_concurrent_streams(struct Curl_multi *multi)
   return multi->max_concurrent_streams;
 }
 
+unsigned int Curl_multi_max_stream_window(struct Curl_multi *multi)
+{
+  DEBUGASSERT(multi);
+  return multi->max_stream_window;
+}
+
+struct bufc_share *Curl_multi_bufc_share(struct Curl_easy *data)
+{
+  /* the connection goes into the pool of the same multi handle, see
+     cpool_get_instance(). A pool shared by several of them outlives each. */
+  if(CURL_SHARE_KEEP_CONNECT(data->share))
+    return NULL;
+  if(data->multi_easy)
+    return &data->multi_easy->bufcs;
+  return data->multi ? &data->multi->bufcs : NULL;
+}
+
 struct Curl_easy **curl_multi_get_handles(struct Curl_multi *multi)
 {
   struct Curl_easy **a = malloc(sizeof(struct Curl_easy *) *
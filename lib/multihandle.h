@@ -29,8 +29,30 @@
 #include "conncache.h"
 #include "psl.h"
 #include "socketpair.h"
+#include "timewheel.h"
+#include "slab.h"
+#include "bufq.h"
 
 struct connectdata;
+struct resolv_pool;
+
+/* On Linux, curl_multi_wait() and curl_multi_poll() keep the transfer
+   sockets in a persistent epoll set, updated from the socket hash, instead
+   of collecting and polling all of them on each call. */
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE1) && \
+  !defined(USE_WINSOCK)
+#define USE_EPOLL
+struct epoll_event;
+#endif
+
+/* default CURLMOPT_RESOLVER_THREADS */
+#define CURL_RESOLVER_THREADS_DEFAULT 16
+
+/* default CURLMOPT_MAX_BUFFER_POOL */
+#define CURL_BUFC_SHARE_MAX (10 * 1024 * 1024)
+
+/* default CURLMOPT_MAX_STREAM_WINDOW */
+#define CURL_STREAM_WINDOW_MAX (64 * 1024 * 1024)
 
 struct Curl_message {
   struct Curl_llist_node list;
@@ -114,9 +136,14 @@ struct Curl_multi {
   struct PslCache psl;
 #endif
 
+#ifdef CURL_DISABLE_TIMER_WHEEL
   /* timetree points to the splay-tree of time nodes to figure out expire
      times of all currently set timers */
   struct Curl_tree *timetree;
+#else
+  /* the timer wheel of all transfers' nearest expire times */
+  struct Curl_wheel timers;
+#endif
 
   /* buffer used for transfer data, lazy initialized */
   char *xfer_buf; /* the actual buffer */
@@ -140,6 +167,11 @@ struct Curl_multi {
   /* Shared connection cache (bundles)*/
   struct cpool cpool;
 
+  /* objects of transfers and connections kept for reuse */
+  struct Curl_slab slab;
+  /* spare buffer chunks for the connections in `cpool` */
+  struct bufc_share bufcs;
+
   long max_host_connections; /* if >0, a fixed limit of the maximum number
                                 of connections per host */
 
@@ -163,7 +195,20 @@ struct Curl_multi {
                                    for write */
 #endif
 #endif
+#ifdef USE_EPOLL
+  struct epoll_event *ev_events; /* result buffer for epoll_wait() */
+  size_t ev_events_len; /* number of elements in `ev_events` */
+  size_t ev_count; /* number of sockets in the epoll set */
+  size_t ev_min_xfers; /* use the epoll set from this many transfers on */
+  int ev_fd; /* epoll set of the sockets in `sockhash` or -1 */
+#endif
+#ifdef CURLRES_THREADED
+  struct resolv_pool *resolv_pool; /* threads resolving for our transfers */
+#endif
+  unsigned int resolver_threads; /* max threads in `resolv_pool` */
+  unsigned int resolver_queue; /* max lookups waiting for a thread, or 0 */
   unsigned int max_concurrent_streams;
+  unsigned int max_stream_window; /* max receive window of a stream */
   unsigned int maxconnects; /* if >0, a fixed limit of the maximum number of
                                entries we are allowed to grow the connection
                                cache to */
@@ -181,6 +226,9 @@ struct Curl_multi {
                 burn */
   BIT(xfer_buf_borrowed);      /* xfer_buf is currently being borrowed */
   BIT(xfer_ulbuf_borrowed);    /* xfer_ulbuf is currently being borrowed */
+#ifdef USE_EPOLL
+  BIT(ev_failed);              /* the epoll set failed, poll instead */
+#endif
 #ifdef DEBUGBUILD
   BIT(warned);                 /* true after user warned of DEBUGBUILD */
 #endif
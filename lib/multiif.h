@@ -95,6 +95,13 @@ CURLMcode Curl_multi_add_perform(struct Curl_multi *multi,
 /* Return the value of the CURLMOPT_MAX_CONCURRENT_STREAMS option */
 unsigned int Curl_multi_max_concurrent_streams(struct Curl_multi *multi);
 
+/* Return the value of the CURLMOPT_MAX_STREAM_WINDOW option */
+unsigned int Curl_multi_max_stream_window(struct Curl_multi *multi);
+
+/* The chunk share for the pools of a connection the transfer creates, NULL
+   if the connection may outlive the multi handle */
+struct bufc_share *Curl_multi_bufc_share(struct Curl_easy *data);
+
 /**
  * Borrow the transfer buffer from the multi, suitable
  * for the given transfer `data`. The buffer may only be used in one
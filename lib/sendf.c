@@ -46,6 +46,7 @@
 #include "vssh/ssh.h"
 #include "easyif.h"
 #include "multiif.h"
+#include "slab.h"
 #include "strerror.h"
 #include "select.h"
 #include "strdup.h"
@@ -100,7 +101,7 @@ static void cl_reset_writer(struct Curl_easy *data)
   while(writer) {
     data->req.writer_stack = writer->next;
     writer->cwt->do_close(data, writer);
-    free(writer);
+    Curl_slab_free(data, writer, writer->cwt->cwriter_size);
     writer = data->req.writer_stack;
   }
 }
@@ -111,7 +112,7 @@ static void cl_reset_reader(struct Curl_easy *data)
   while(reader) {
     data->req.reader_stack = reader->next;
     reader->crt->do_close(data, reader);
-    free(reader);
+    Curl_slab_free(data, reader, reader->crt->creader_size);
     reader = data->req.reader_stack;
   }
 }
@@ -387,7 +388,7 @@ CURLcode Curl_cwriter_create(struct Curl_cwriter **pwriter,
   void *p;
 
   DEBUGASSERT(cwt->cwriter_size >= sizeof(struct Curl_cwriter));
-  p = calloc(1, cwt->cwriter_size);
+  p = Curl_slab_alloc(data, cwt->cwriter_size);
   if(!p)
     goto out;
 
@@ -400,7 +401,7 @@ CURLcode Curl_cwriter_create(struct Curl_cwriter **pwriter,
 out:
   *pwriter = result ? NULL : writer;
   if(result)
-    free(writer);
+    Curl_slab_free(data, writer, cwt->cwriter_size);
   return result;
 }
 
@@ -409,7 +410,7 @@ void Curl_cwriter_free(struct Curl_easy *data,
 {
   if(writer) {
     writer->cwt->do_close(data, writer);
-    free(writer);
+    Curl_slab_free(data, writer, writer->cwt->cwriter_size);
   }
 }
 
@@ -919,7 +920,7 @@ CURLcode Curl_creader_create(struct Curl_creader **preader,
   void *p;
 
   DEBUGASSERT(crt->creader_size >= sizeof(struct Curl_creader));
-  p = calloc(1, crt->creader_size);
+  p = Curl_slab_alloc(data, crt->creader_size);
   if(!p)
     goto out;
 
@@ -932,7 +933,7 @@ CURLcode Curl_creader_create(struct Curl_creader **preader,
 out:
   *preader = result ? NULL : reader;
   if(result)
-    free(reader);
+    Curl_slab_free(data, reader, crt->creader_size);
   return result;
 }
 
@@ -940,7 +941,7 @@ void Curl_creader_free(struct Curl_easy *data, struct Curl_creader *reader)
 {
   if(reader) {
     reader->crt->do_close(data, reader);
-    free(reader);
+    Curl_slab_free(data, reader, reader->crt->creader_size);
   }
 }
 
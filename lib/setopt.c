@@ -49,6 +49,7 @@
 #include "setopt.h"
 #include "multiif.h"
 #include "altsvc.h"
+#include "dnsfile.h"
 #include "hsts.h"
 #include "tftp.h"
 #include "strdup.h"
@@ -278,6 +279,32 @@ CURLcode Curl_vsetopt(struct Curl_easy *data, CURLoption option, va_list param)
 
     data->set.dns_cache_timeout = (int)arg;
     break;
+  case CURLOPT_DNS_CACHE_STALE:
+#ifdef CURLRES_THREADED
+    arg = va_arg(param, long);
+    if(arg < 0)
+      return CURLE_BAD_FUNCTION_ARGUMENT;
+    else if(arg > INT_MAX)
+      arg = INT_MAX;
+
+    data->set.dns_cache_stale = (int)arg;
+#else
+    result = CURLE_NOT_BUILT_IN;
+#endif
+    break;
+  case CURLOPT_DNS_CACHE_FILE:
+    argptr = va_arg(param, char *);
+    result = Curl_setstropt(&data->set.str[STRING_DNS_CACHE_FILE], argptr);
+    if(result)
+      return result;
+    /* the file of a previous setting is not written */
+    Curl_dnsfile_cleanup(&data->dnsf);
+    if(argptr) {
+      data->dnsf = Curl_dnsfile_init(argptr);
+      if(!data->dnsf)
+        return CURLE_OUT_OF_MEMORY;
+    }
+    break;
   case CURLOPT_CA_CACHE_TIMEOUT:
     if(Curl_ssl_supports(data, SSLSUPP_CA_CACHE)) {
       arg = va_arg(param, long);
@@ -2315,10 +2342,8 @@ CURLcode Curl_vsetopt(struct Curl_easy *data, CURLoption option, va_list param)
       }
 #endif
 #ifdef USE_SSL
-      if(data->share->sslsession) {
-        data->set.general_ssl.max_ssl_sessions = data->share->max_ssl_sessions;
+      if(data->share->sslsession)
         data->state.session = data->share->sslsession;
-      }
 #endif
 #ifdef USE_LIBPSL
       if(data->share->specifier & (1 << CURL_LOCK_DATA_PSL))
@@ -2940,6 +2965,12 @@ CURLcode Curl_vsetopt(struct Curl_easy *data, CURLoption option, va_list param)
       arg = INT_MAX;
     data->set.tcp_keepcnt = (int)arg;
     break;
+  case CURLOPT_QUIC_CC_ALGO:
+    arg = va_arg(param, long);
+    if((arg < CURL_QUIC_CC_DEFAULT) || (arg > CURL_QUIC_CC_BBR))
+      return CURLE_BAD_FUNCTION_ARGUMENT;
+    data->set.quic_cc_algo = (unsigned char)arg;
+    break;
   case CURLOPT_TCP_FASTOPEN:
 #if defined(CONNECT_DATA_IDEMPOTENT) || defined(MSG_FASTOPEN) || \
    defined(TCP_FASTOPEN_CONNECT)
@@ -3141,6 +3172,12 @@ CURLcode Curl_vsetopt(struct Curl_easy *data, CURLoption option, va_list param)
   case CURLOPT_PREREQDATA:
     data->set.prereq_userp = va_arg(param, void *);
     break;
+  case CURLOPT_RECVBUFFERFUNCTION:
+    data->set.frecvbuf = va_arg(param, curl_recvbuffer_callback);
+    break;
+  case CURLOPT_RECVBUFFERDATA:
+    data->set.recvbuf_userp = va_arg(param, void *);
+    break;
 #ifndef CURL_DISABLE_WEBSOCKETS
   case CURLOPT_WS_OPTIONS: {
     bool raw;
@@ -38,6 +38,72 @@
 #include "curl_memory.h"
 #include "memdebug.h"
 
+#ifdef CURLSH_BUILTIN_LOCKS
+static CURLSHcode share_locks_create(struct Curl_share *share)
+{
+  if(!share->locks) {
+    int i;
+    share->locks = calloc(CURL_LOCK_DATA_LAST, sizeof(struct share_lock));
+    if(!share->locks)
+      return CURLSHE_NOMEM;
+    for(i = 0; i < CURL_LOCK_DATA_LAST; i++)
+      Curl_rwlock_init(&share->locks[i].lock);
+  }
+  return CURLSHE_OK;
+}
+
+static void share_locks_destroy(struct Curl_share *share)
+{
+  if(share->locks) {
+    int i;
+    for(i = 0; i < CURL_LOCK_DATA_LAST; i++)
+      Curl_rwlock_destroy(&share->locks[i].lock);
+    Curl_safefree(share->locks);
+  }
+}
+#endif
+
+/* Lock the data of this type with the built-in lock or the application's
+   callback, whichever the share uses */
+static void share_lock(struct Curl_share *share, struct Curl_easy *data,
+                       curl_lock_data type, curl_lock_access accesstype)
+{
+#ifdef CURLSH_BUILTIN_LOCKS
+  if(share->locks) {
+    struct share_lock *l = &share->locks[type];
+    if(accesstype == CURL_LOCK_ACCESS_SHARED)
+      Curl_rwlock_acquire_shared(&l->lock);
+    else {
+      Curl_rwlock_acquire(&l->lock);
+      l->exclusive = TRUE;
+    }
+    return;
+  }
+#endif
+  if(share->lockfunc) /* only call this if set! */
+    share->lockfunc(data, type, accesstype, share->clientdata);
+}
+
+static void share_unlock(struct Curl_share *share, struct Curl_easy *data,
+                         curl_lock_data type)
+{
+#ifdef CURLSH_BUILTIN_LOCKS
+  if(share->locks) {
+    struct share_lock *l = &share->locks[type];
+    /* no writer can have set this while readers hold the lock */
+    if(l->exclusive) {
+      l->exclusive = FALSE;
+      Curl_rwlock_release(&l->lock);
+    }
+    else
+      Curl_rwlock_release_shared(&l->lock);
+    return;
+  }
+#endif
+  if(share->unlockfunc) /* only call this if set! */
+    share->unlockfunc(data, type, share->clientdata);
+}
+
 struct Curl_share *
 curl_share_init(void)
 {
@@ -60,6 +126,7 @@ curl_share_setopt(struct Curl_share *share, CURLSHoption option, ...)
   curl_lock_function lockfunc;
   curl_unlock_function unlockfunc;
   void *ptr;
+  long lval;
   CURLSHcode res = CURLSHE_OK;
 
   if(!GOOD_SHARE_HANDLE(share))
@@ -108,10 +175,8 @@ curl_share_setopt(struct Curl_share *share, CURLSHoption option, ...)
     case CURL_LOCK_DATA_SSL_SESSION:
 #ifdef USE_SSL
       if(!share->sslsession) {
-        share->max_ssl_sessions = 8;
-        share->sslsession = calloc(share->max_ssl_sessions,
-                                   sizeof(struct Curl_ssl_session));
-        share->sessionage = 0;
+        share->sslsession = Curl_ssl_scache_create(8,
+                                                   share->sslsession_shards);
         if(!share->sslsession)
           res = CURLSHE_NOMEM;
       }
@@ -124,7 +189,7 @@ curl_share_setopt(struct Curl_share *share, CURLSHoption option, ...)
       /* It is safe to set this option several times on a share. */
       if(!share->cpool.idata) {
         if(Curl_cpool_init(&share->cpool, Curl_on_disconnect,
-                           NULL, share, 103))
+                           NULL, share, 103, share->cpool_shards))
           res = CURLSHE_NOMEM;
       }
       break;
@@ -173,7 +238,8 @@ curl_share_setopt(struct Curl_share *share, CURLSHoption option, ...)
 
     case CURL_LOCK_DATA_SSL_SESSION:
 #ifdef USE_SSL
-      Curl_safefree(share->sslsession);
+      Curl_ssl_scache_destroy(share->sslsession);
+      share->sslsession = NULL;
 #else
       res = CURLSHE_NOT_BUILT_IN;
 #endif
@@ -203,6 +269,53 @@ curl_share_setopt(struct Curl_share *share, CURLSHoption option, ...)
     share->clientdata = ptr;
     break;
 
+  case CURLSHOPT_CONNECT_SHARDS:
+    lval = va_arg(param, long);
+    if((lval < 0) || (lval > CPOOL_MAX_SHARDS))
+      res = CURLSHE_BAD_OPTION;
+#ifndef CPOOL_SHARDING
+    else if(lval > 1)
+      res = CURLSHE_NOT_BUILT_IN;
+#endif
+    else if(share->cpool.idata)
+      /* the connection pool is already set up */
+      res = CURLSHE_IN_USE;
+    else
+      share->cpool_shards = (size_t)lval;
+    break;
+
+  case CURLSHOPT_BUILTIN_LOCKS:
+    lval = va_arg(param, long);
+#ifdef CURLSH_BUILTIN_LOCKS
+    if(lval)
+      res = share_locks_create(share);
+    else
+      share_locks_destroy(share);
+#else
+    if(lval)
+      res = CURLSHE_NOT_BUILT_IN;
+#endif
+    break;
+
+  case CURLSHOPT_SSL_SESSION_SHARDS:
+    lval = va_arg(param, long);
+#ifdef USE_SSL
+    if((lval < 0) || (lval > SSL_SCACHE_MAX_SHARDS))
+      res = CURLSHE_BAD_OPTION;
+#if !defined(USE_THREADS_POSIX) && !defined(USE_THREADS_WIN32)
+    else if(lval > 1)
+      res = CURLSHE_NOT_BUILT_IN;
+#endif
+    else if(share->sslsession)
+      /* the session cache is already set up */
+      res = CURLSHE_IN_USE;
+    else
+      share->sslsession_shards = (size_t)lval;
+#else
+    res = CURLSHE_NOT_BUILT_IN;
+#endif
+    break;
+
   default:
     res = CURLSHE_BAD_OPTION;
     break;
@@ -219,13 +332,10 @@ curl_share_cleanup(struct Curl_share *share)
   if(!GOOD_SHARE_HANDLE(share))
     return CURLSHE_INVALID;
 
-  if(share->lockfunc)
-    share->lockfunc(NULL, CURL_LOCK_DATA_SHARE, CURL_LOCK_ACCESS_SINGLE,
-                    share->clientdata);
+  share_lock(share, NULL, CURL_LOCK_DATA_SHARE, CURL_LOCK_ACCESS_SINGLE);
 
   if(share->dirty) {
-    if(share->unlockfunc)
-      share->unlockfunc(NULL, CURL_LOCK_DATA_SHARE, share->clientdata);
+    share_unlock(share, NULL, CURL_LOCK_DATA_SHARE);
     return CURLSHE_IN_USE;
   }
 
@@ -243,18 +353,15 @@ curl_share_cleanup(struct Curl_share *share)
 #endif
 
 #ifdef USE_SSL
-  if(share->sslsession) {
-    size_t i;
-    for(i = 0; i < share->max_ssl_sessions; i++)
-      Curl_ssl_kill_session(&(share->sslsession[i]));
-    free(share->sslsession);
-  }
+  Curl_ssl_scache_destroy(share->sslsession);
 #endif
 
   Curl_psl_destroy(&share->psl);
 
-  if(share->unlockfunc)
-    share->unlockfunc(NULL, CURL_LOCK_DATA_SHARE, share->clientdata);
+  share_unlock(share, NULL, CURL_LOCK_DATA_SHARE);
+#ifdef CURLSH_BUILTIN_LOCKS
+  share_locks_destroy(share);
+#endif
   share->magic = 0;
   free(share);
 
@@ -271,10 +378,8 @@ Curl_share_lock(struct Curl_easy *data, curl_lock_data type,
   if(!share)
     return CURLSHE_INVALID;
 
-  if(share->specifier & (unsigned int)(1 << type)) {
-    if(share->lockfunc) /* only call this if set! */
-      share->lockfunc(data, type, accesstype, share->clientdata);
-  }
+  if(share->specifier & (unsigned int)(1 << type))
+    share_lock(share, data, type, accesstype);
   /* else if we do not share this, pretend successful lock */
 
   return CURLSHE_OK;
@@ -288,10 +393,8 @@ Curl_share_unlock(struct Curl_easy *data, curl_lock_data type)
   if(!share)
     return CURLSHE_INVALID;
 
-  if(share->specifier & (unsigned int)(1 << type)) {
-    if(share->unlockfunc) /* only call this if set! */
-      share->unlockfunc (data, type, share->clientdata);
-  }
+  if(share->specifier & (unsigned int)(1 << type))
+    share_unlock(share, data, type);
 
   return CURLSHE_OK;
 }
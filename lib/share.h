@@ -30,6 +30,7 @@
 #include "psl.h"
 #include "urldata.h"
 #include "conncache.h"
+#include "curl_threads.h"
 
 #define CURL_GOOD_SHARE 0x7e117a1e
 #define GOOD_SHARE_HANDLE(x) ((x) && (x)->magic == CURL_GOOD_SHARE)
@@ -37,6 +38,17 @@
 #define CURL_SHARE_KEEP_CONNECT(s)    \
         ((s) && ((s)->specifier & (1<< CURL_LOCK_DATA_CONNECT)))
 
+/* The share handle may lock its data with libcurl's own reader/writer locks
+ * instead of the application's callbacks, when libcurl has thread support. */
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+#define CURLSH_BUILTIN_LOCKS
+
+struct share_lock {
+  curl_rwlock_t lock;
+  bool exclusive; /* held for writing, only set by the writer */
+};
+#endif
+
 /* this struct is libcurl-private, do not export details */
 struct Curl_share {
   unsigned int magic; /* CURL_GOOD_SHARE */
@@ -46,7 +58,11 @@ struct Curl_share {
   curl_lock_function lockfunc;
   curl_unlock_function unlockfunc;
   void *clientdata;
+#ifdef CURLSH_BUILTIN_LOCKS
+  struct share_lock *locks; /* CURL_LOCK_DATA_LAST built-in locks, if used */
+#endif
   struct cpool cpool;
+  size_t cpool_shards;
   struct Curl_hash hostcache;
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_COOKIES)
   struct CookieInfo *cookies;
@@ -58,9 +74,8 @@ struct Curl_share {
   struct hsts *hsts;
 #endif
 #ifdef USE_SSL
-  struct Curl_ssl_session *sslsession;
-  size_t max_ssl_sessions;
-  long sessionage;
+  struct Curl_ssl_scache *sslsession;
+  size_t sslsession_shards;
 #endif
 };
 
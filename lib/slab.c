@@ -0,0 +1,116 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include "curl_setup.h"
+
+#include "urldata.h"
+#include "multihandle.h"
+#include "slab.h"
+#include "curl_trc.h"
+
+/* The last 3 #include files should be in this order */
+#include "curl_printf.h"
+#include "curl_memory.h"
+#include "memdebug.h"
+
+/* the class of objects of `size` bytes, CURL_SLAB_CLASSES if none */
+#define SLAB_CLASS(size) \
+  ((size) && ((size) <= CURL_SLAB_MAX) ? \
+   (((size) - 1) / CURL_SLAB_STEP) : CURL_SLAB_CLASSES)
+#define SLAB_SIZE(c) (((c) + 1) * CURL_SLAB_STEP)
+
+void Curl_slab_init(struct Curl_slab *slab)
+{
+  memset(slab, 0, sizeof(*slab));
+}
+
+void Curl_slab_destroy(struct Curl_slab *slab)
+{
+  size_t c;
+  for(c = 0; c < CURL_SLAB_CLASSES; c++) {
+    while(slab->spare[c]) {
+      void *p = slab->spare[c];
+      slab->spare[c] = *(void **)p;
+      free(p);
+    }
+  }
+  slab->kept = 0;
+}
+
+void *Curl_slab_alloc(struct Curl_easy *data, size_t size)
+{
+  struct Curl_slab *slab = data->multi ? &data->multi->slab : NULL;
+  size_t c = SLAB_CLASS(size);
+  void *p;
+
+  if(c == CURL_SLAB_CLASSES)
+    return calloc(1, size);
+  if(slab) {
+    slab->allocs++;
+    p = slab->spare[c];
+    if(p) {
+      slab->spare[c] = *(void **)p;
+      slab->kept -= SLAB_SIZE(c);
+      slab->reused++;
+      memset(p, 0, size);
+      return p;
+    }
+  }
+  /* allocate the full class size, so that it can serve all of the class
+     when it is kept */
+  p = malloc(SLAB_SIZE(c));
+  if(p)
+    memset(p, 0, size);
+  return p;
+}
+
+void Curl_slab_free(struct Curl_easy *data, void *p, size_t size)
+{
+  struct Curl_slab *slab = data && data->multi ? &data->multi->slab : NULL;
+  size_t c = SLAB_CLASS(size);
+
+  if(!p)
+    return;
+  if(slab && (c < CURL_SLAB_CLASSES)) {
+    slab->frees++;
+    if(slab->kept + SLAB_SIZE(c) <= CURL_SLAB_KEEP) {
+      *(void **)p = slab->spare[c];
+      slab->spare[c] = p;
+      slab->kept += SLAB_SIZE(c);
+      return;
+    }
+    slab->dropped++;
+  }
+  free(p);
+}
+
+void Curl_slab_trace(struct Curl_easy *data)
+{
+  if(data->multi) {
+    struct Curl_slab *slab = &data->multi->slab;
+    CURL_TRC_MEM(data, "slab: %zu of %zu objects reused, %zu of %zu freed "
+                 "ones kept, %zu bytes kept now", slab->reused, slab->allocs,
+                 slab->frees - slab->dropped, slab->frees, slab->kept);
+  }
+}
@@ -0,0 +1,75 @@
+#ifndef HEADER_CURL_SLAB_H
+#define HEADER_CURL_SLAB_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curl_setup.h"
+
+struct Curl_easy;
+
+#define CURL_SLAB_STEP    64    /* objects are kept in classes this wide */
+#define CURL_SLAB_MAX     4096  /* larger objects are not kept */
+#define CURL_SLAB_CLASSES (CURL_SLAB_MAX / CURL_SLAB_STEP)
+#define CURL_SLAB_KEEP    (512 * 1024) /* max bytes kept in all classes */
+
+/**
+ * Fixed size objects a multi handle keeps after they are freed, to hand
+ * them out again instead of allocating new ones. Objects of up to
+ * CURL_SLAB_MAX bytes are kept in lists by their size rounded up to
+ * CURL_SLAB_STEP.
+ *
+ * Every object is a regular allocation of its class size. It can be given
+ * to any multi's slab when it is freed, or just be freed when there is
+ * none. Not thread safe, like the multi handle it belongs to.
+ */
+struct Curl_slab {
+  void *spare[CURL_SLAB_CLASSES]; /* kept objects, linked by their start */
+  size_t kept;     /* bytes in the `spare` lists */
+  size_t allocs;   /* objects asked for */
+  size_t reused;   /* ... that were taken from `spare` */
+  size_t frees;    /* objects given back */
+  size_t dropped;  /* ... that were freed for lack of room */
+};
+
+void Curl_slab_init(struct Curl_slab *slab);
+void Curl_slab_destroy(struct Curl_slab *slab);
+
+/**
+ * Get a zeroed object of `size` bytes from the slab of the transfer's
+ * multi handle, or a newly allocated one when it has none to give.
+ * Returns NULL when out of memory.
+ */
+void *Curl_slab_alloc(struct Curl_easy *data, size_t size);
+
+/**
+ * Give back an object from Curl_slab_alloc() of the same `size`. It is
+ * kept by the transfer's multi handle if there is room, freed otherwise.
+ */
+void Curl_slab_free(struct Curl_easy *data, void *p, size_t size);
+
+/**
+ * Trace what the slab of the transfer's multi handle has done so far.
+ */
+void Curl_slab_trace(struct Curl_easy *data);
+
+#endif /* HEADER_CURL_SLAB_H */
@@ -0,0 +1,309 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include "curl_setup.h"
+
+#include "timeval.h"
+#include "timewheel.h"
+
+/*
+ * A hierarchical timing wheel. Expire times are turned into millisecond
+ * ticks and split into groups of WHEEL_BITS bits. A node is kept on the
+ * level of the highest group in which its tick differs from the wheel's
+ * current tick, in the slot given by its own bits of that group. Adding and
+ * removing a node is O(1).
+ *
+ * When the wheel turns to a later tick, the slots it has moved into are
+ * emptied and their nodes are placed again: either on a lower level or,
+ * when their tick has been reached, on the expired list. Each node moves at
+ * most once per level.
+ *
+ * The nodes on a level all have later ticks than those on the levels below,
+ * so the earliest one is in the first non-empty slot of the lowest level in
+ * use.
+ */
+
+#define WHEEL_EXPIRED -1
+#define WHEEL_FAR     -2
+#define WHEEL_TODO    -3
+
+#define ONE CURL_UINT64_C(1)
+
+/* the millisecond tick of `t` */
+static curl_uint64_t wheel_tick(const struct curltime *t)
+{
+  if(t->tv_sec < 0)
+    return 0;
+  return (curl_uint64_t)t->tv_sec * 1000 + (unsigned int)t->tv_usec / 1000;
+}
+
+/* the index of the lowest bit set in `x`, which must not be 0 */
+static unsigned int wheel_ctz(curl_uint64_t x)
+{
+  unsigned int n = 0;
+  if(!(x & 0xffffffff)) {
+    n += 32;
+    x >>= 32;
+  }
+  if(!(x & 0xffff)) {
+    n += 16;
+    x >>= 16;
+  }
+  if(!(x & 0xff)) {
+    n += 8;
+    x >>= 8;
+  }
+  if(!(x & 0xf)) {
+    n += 4;
+    x >>= 4;
+  }
+  if(!(x & 0x3)) {
+    n += 2;
+    x >>= 2;
+  }
+  if(!(x & 0x1))
+    n++;
+  return n;
+}
+
+static void wheel_link(struct Curl_wheel_node **head,
+                       struct Curl_wheel_node *node)
+{
+  node->next = *head;
+  if(*head)
+    (*head)->prevp = &node->next;
+  *head = node;
+  node->prevp = head;
+}
+
+static void wheel_unlink(struct Curl_wheel *w, struct Curl_wheel_node *node)
+{
+  if((node->where == WHEEL_EXPIRED) && !node->next)
+    w->expired_tail = node->prevp;
+  *node->prevp = node->next;
+  if(node->next)
+    node->next->prevp = node->prevp;
+  node->next = NULL;
+  node->prevp = NULL;
+  if(node->where >= 0) {
+    int level = node->where / WHEEL_SLOTS;
+    int slot = node->where % WHEEL_SLOTS;
+    if(!w->slots[level][slot])
+      w->pending[level] &= ~(ONE << slot);
+  }
+}
+
+/* put `node` where it belongs relative to the wheel's current tick */
+static void wheel_place(struct Curl_wheel *w, struct Curl_wheel_node *node)
+{
+  curl_uint64_t diff;
+  int level = 0;
+  int slot;
+
+  if(node->tick <= w->now) {
+    /* appended, so that they expire in the order they got here */
+    node->where = WHEEL_EXPIRED;
+    node->next = NULL;
+    node->prevp = w->expired_tail;
+    *w->expired_tail = node;
+    w->expired_tail = &node->next;
+    return;
+  }
+
+  diff = node->tick ^ w->now;
+  while(diff >> WHEEL_BITS) {
+    diff >>= WHEEL_BITS;
+    level++;
+  }
+  if(level >= WHEEL_LEVELS) {
+    node->where = WHEEL_FAR;
+    wheel_link(&w->far, node);
+    return;
+  }
+  slot = (int)((node->tick >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1));
+  node->where = level * WHEEL_SLOTS + slot;
+  wheel_link(&w->slots[level][slot], node);
+  w->pending[level] |= ONE << slot;
+}
+
+/* take `node` off its list onto `todo` */
+static void wheel_move(struct Curl_wheel *w, struct Curl_wheel_node *node,
+                       struct Curl_wheel_node **todo)
+{
+  wheel_unlink(w, node);
+  node->where = WHEEL_TODO;
+  wheel_link(todo, node);
+}
+
+/* turn the wheel to `tick`, moving the nodes of the slots passed */
+static void wheel_turn(struct Curl_wheel *w, curl_uint64_t tick)
+{
+  struct Curl_wheel_node *todo = NULL;
+  curl_uint64_t old = w->now;
+  int level;
+
+  if(tick <= old)
+    return;
+
+  for(level = 0; level < WHEEL_LEVELS; level++) {
+    int shift = level * WHEEL_BITS;
+    curl_uint64_t take;
+
+    if(!w->pending[level])
+      continue;
+    if((tick ^ old) >> (shift + WHEEL_BITS))
+      /* the level has come around completely, all of it is due */
+      take = w->pending[level];
+    else {
+      unsigned int from = (unsigned int)(old >> shift) & (WHEEL_SLOTS - 1);
+      unsigned int to = (unsigned int)(tick >> shift) & (WHEEL_SLOTS - 1);
+      /* the slots after `from` up to and including `to` */
+      take = w->pending[level] &
+        (((ONE << to) << 1) - 1) & ~(((ONE << from) << 1) - 1);
+    }
+    while(take) {
+      unsigned int slot = wheel_ctz(take);
+      take &= take - 1;
+      while(w->slots[level][slot])
+        wheel_move(w, w->slots[level][slot], &todo);
+    }
+  }
+  if(w->far && ((tick ^ old) >> (WHEEL_LEVELS * WHEEL_BITS))) {
+    while(w->far)
+      wheel_move(w, w->far, &todo);
+  }
+
+  w->now = tick;
+  while(todo) {
+    struct Curl_wheel_node *node = todo;
+    wheel_unlink(w, node);
+    wheel_place(w, node);
+  }
+}
+
+void Curl_wheel_init(struct Curl_wheel *w)
+{
+  memset(w, 0, sizeof(*w));
+  w->expired_tail = &w->expired;
+}
+
+/*
+ * Add `node` with the expire time `key`. The node must not already be in a
+ * wheel.
+ */
+void Curl_wheel_add(struct Curl_wheel *w, struct curltime key,
+                    struct Curl_wheel_node *node)
+{
+  DEBUGASSERT(!node->prevp);
+  node->key = key;
+  node->tick = wheel_tick(&key);
+  wheel_place(w, node);
+  w->count++;
+  if(w->first && (Curl_timediff_us(key, w->first->key) < 0))
+    w->first = node;
+}
+
+/*
+ * Remove `node` from the wheel. Returns 1 if it was not in it.
+ */
+int Curl_wheel_remove(struct Curl_wheel *w, struct Curl_wheel_node *node)
+{
+  if(!node->prevp)
+    return 1;
+  wheel_unlink(w, node);
+  w->count--;
+  if(w->first == node)
+    w->first = NULL;
+  return 0;
+}
+
+struct Curl_wheel_node *Curl_wheel_getbest(struct Curl_wheel *w,
+                                           struct curltime now)
+{
+  struct Curl_wheel_node *node;
+
+  if(!w->count)
+    return NULL;
+  wheel_turn(w, wheel_tick(&now));
+
+  /* the nodes of the current tick may still be a fraction away */
+  for(node = w->expired; node; node = node->next) {
+    if(Curl_timediff_us(node->key, now) <= 0) {
+      Curl_wheel_remove(w, node);
+      return node;
+    }
+  }
+  return NULL;
+}
+
+/* the node with the earliest key in the list at `head` */
+static struct Curl_wheel_node *wheel_min(struct Curl_wheel_node *head)
+{
+  struct Curl_wheel_node *best = head;
+  struct Curl_wheel_node *node;
+
+  for(node = head; node; node = node->next) {
+    if(Curl_timediff_us(node->key, best->key) < 0)
+      best = node;
+  }
+  return best;
+}
+
+bool Curl_wheel_first(struct Curl_wheel *w, struct curltime *key)
+{
+  if(!w->count)
+    return FALSE;
+
+  if(!w->first) {
+    if(w->expired)
+      w->first = wheel_min(w->expired);
+    else {
+      int level;
+      for(level = 0; level < WHEEL_LEVELS; level++) {
+        if(w->pending[level]) {
+          unsigned int slot = wheel_ctz(w->pending[level]);
+          w->first = wheel_min(w->slots[level][slot]);
+          break;
+        }
+      }
+      if(!w->first)
+        w->first = wheel_min(w->far);
+    }
+  }
+  DEBUGASSERT(w->first);
+  *key = w->first->key;
+  return TRUE;
+}
+
+void Curl_wheelset(struct Curl_wheel_node *node, void *payload)
+{
+  DEBUGASSERT(node);
+  node->ptr = payload;
+}
+
+void *Curl_wheelget(struct Curl_wheel_node *node)
+{
+  DEBUGASSERT(node);
+  return node->ptr;
+}
@@ -0,0 +1,74 @@
+#ifndef HEADER_CURL_TIMEWHEEL_H
+#define HEADER_CURL_TIMEWHEEL_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curl_setup.h"
+#include "timeval.h"
+
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 6 /* covers 2^36 milliseconds, about two years */
+
+/* only use function calls to access this struct */
+struct Curl_wheel_node {
+  struct Curl_wheel_node *next;
+  struct Curl_wheel_node **prevp; /* NULL when not in a wheel */
+  struct curltime key;            /* this node's expire time */
+  curl_uint64_t tick;             /* `key` in milliseconds */
+  void *ptr;                      /* data the wheel does not care about */
+  int where;                      /* level * WHEEL_SLOTS + slot, or < 0 */
+};
+
+struct Curl_wheel {
+  /* level N holds nodes whose tick differs from `now` first in bit group N,
+     in the slot of their own bits in that group */
+  struct Curl_wheel_node *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+  curl_uint64_t pending[WHEEL_LEVELS]; /* bit per non-empty slot */
+  struct Curl_wheel_node *expired; /* tick not after `now` */
+  struct Curl_wheel_node **expired_tail;
+  struct Curl_wheel_node *far;     /* beyond the last level */
+  struct Curl_wheel_node *first;   /* the earliest node, NULL if unknown */
+  curl_uint64_t now;               /* the tick the wheel has turned to */
+  size_t count;                    /* nodes in the wheel */
+};
+
+void Curl_wheel_init(struct Curl_wheel *w);
+
+void Curl_wheel_add(struct Curl_wheel *w, struct curltime key,
+                    struct Curl_wheel_node *node);
+
+int Curl_wheel_remove(struct Curl_wheel *w, struct Curl_wheel_node *node);
+
+/* Remove and return a node that has expired at `now`, NULL if none. */
+struct Curl_wheel_node *Curl_wheel_getbest(struct Curl_wheel *w,
+                                           struct curltime now);
+
+/* Get the earliest expire time in the wheel. Returns FALSE if empty. */
+bool Curl_wheel_first(struct Curl_wheel *w, struct curltime *key);
+
+/* set and get the custom payload for this wheel node */
+void Curl_wheelset(struct Curl_wheel_node *node, void *payload);
+void *Curl_wheelget(struct Curl_wheel_node *node);
+
+#endif /* HEADER_CURL_TIMEWHEEL_H */
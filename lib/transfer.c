@@ -255,6 +255,32 @@ static ssize_t Curl_xfer_recv_resp(struct Curl_easy *data,
   return nread;
 }
 
+/*
+ * Lease a buffer from the application's CURLOPT_RECVBUFFERFUNCTION to
+ * receive the next response bytes into. This is only done when those bytes
+ * are BODY data that reach the client writer undecoded, so the write
+ * callback gets invoked on the application's buffer without any copy.
+ * Returns 0 when the transfer's own buffer needs to be used.
+ */
+static size_t xfer_recv_lease(struct Curl_easy *data,
+                              char **pbuf, size_t blen)
+{
+  size_t nlen;
+
+  if(!data->set.frecvbuf || data->req.header || !blen ||
+     Curl_cwriter_count(data, CURL_CW_TRANSFER_DECODE) ||
+     Curl_cwriter_count(data, CURL_CW_CONTENT_DECODE))
+    return 0;
+
+  *pbuf = NULL;
+  Curl_set_in_callback(data, TRUE);
+  nlen = data->set.frecvbuf(pbuf, blen, data->set.recvbuf_userp);
+  Curl_set_in_callback(data, FALSE);
+  if(!*pbuf || !nlen)
+    return 0;
+  return CURLMIN(nlen, blen);
+}
+
 /*
  * Go ahead and do a read if we have a readable socket or if
  * the stream was rewound (in which case we have data in a
@@ -303,6 +329,19 @@ static CURLcode sendrecv_dl(struct Curl_easy *data,
         bytestoread = (size_t)data->set.max_recv_speed;
     }
 
+    if(data->set.frecvbuf) {
+      /* receive BODY bytes directly into the application's buffer */
+      char *lease_buf;
+      size_t lease_len;
+      if((size_t)data->set.buffer_size < bytestoread)
+        bytestoread = (size_t)data->set.buffer_size;
+      lease_len = xfer_recv_lease(data, &lease_buf, bytestoread);
+      if(lease_len) {
+        buf = lease_buf;
+        bytestoread = lease_len;
+      }
+    }
+
     nread = Curl_xfer_recv_resp(data, buf, bytestoread,
                                 is_multiplex, &result);
     if(nread < 0) {
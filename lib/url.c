@@ -114,9 +114,11 @@
 #include "http_proxy.h"
 #include "conncache.h"
 #include "multihandle.h"
+#include "slab.h"
 #include "strdup.h"
 #include "setopt.h"
 #include "altsvc.h"
+#include "dnsfile.h"
 #include "dynbuf.h"
 #include "headers.h"
 
@@ -281,8 +283,12 @@ CURLcode Curl_close(struct Curl_easy **datap)
   Curl_altsvc_save(data, data->asi, data->set.str[STRING_ALTSVC]);
   Curl_altsvc_cleanup(&data->asi);
 #endif
+  Curl_dnsfile_save(data, data->dnsf);
+  Curl_dnsfile_cleanup(&data->dnsf);
 #ifndef CURL_DISABLE_HSTS
+  Curl_share_lock(data, CURL_LOCK_DATA_HSTS, CURL_LOCK_ACCESS_SINGLE);
   Curl_hsts_save(data, data->hsts, data->set.str[STRING_HSTS]);
+  Curl_share_unlock(data, CURL_LOCK_DATA_HSTS);
   if(!data->share || !data->share->hsts)
     Curl_hsts_cleanup(&data->hsts);
   curl_slist_free_all(data->state.hstslist); /* clean up list */
@@ -599,7 +605,8 @@ void Curl_conn_free(struct Curl_easy *data, struct connectdata *conn)
 #endif
   Curl_safefree(conn->destination);
 
-  free(conn); /* free all the connection oriented data */
+  /* free all the connection oriented data */
+  Curl_slab_free(data, conn, sizeof(struct connectdata));
 }
 
 /*
@@ -1309,7 +1316,8 @@ void Curl_verboseconnect(struct Curl_easy *data,
  */
 static struct connectdata *allocate_conn(struct Curl_easy *data)
 {
-  struct connectdata *conn = calloc(1, sizeof(struct connectdata));
+  struct connectdata *conn = Curl_slab_alloc(data,
+                                             sizeof(struct connectdata));
   if(!conn)
     return NULL;
 
@@ -1397,7 +1405,7 @@ static struct connectdata *allocate_conn(struct Curl_easy *data)
 error:
 
   free(conn->localdev);
-  free(conn);
+  Curl_slab_free(data, conn, sizeof(struct connectdata));
   return NULL;
 }
 
@@ -1827,8 +1835,12 @@ static CURLcode parseurlandfillconn(struct Curl_easy *data,
 #ifndef CURL_DISABLE_HSTS
   /* HSTS upgrade */
   if(data->hsts && strcasecompare("http", data->state.up.scheme)) {
+    bool upgrade;
+    Curl_share_lock(data, CURL_LOCK_DATA_HSTS, CURL_LOCK_ACCESS_SHARED);
     /* This MUST use the IDN decoded name */
-    if(Curl_hsts(data->hsts, conn->host.name, TRUE)) {
+    upgrade = !!Curl_hsts(data->hsts, conn->host.name, TRUE);
+    Curl_share_unlock(data, CURL_LOCK_DATA_HSTS);
+    if(upgrade) {
       char *url;
       Curl_safefree(data->state.up.scheme);
       uc = curl_url_set(uh, CURLUPART_SCHEME, "https", 0);
@@ -160,6 +160,7 @@ typedef unsigned int curl_prot_t;
 #include "hostip.h"
 #include "hash.h"
 #include "splay.h"
+#include "timewheel.h"
 #include "dynbuf.h"
 #include "dynhds.h"
 #include "request.h"
@@ -341,21 +342,6 @@ struct ssl_general_config {
 
 typedef void Curl_ssl_sessionid_dtor(void *sessionid, size_t idsize);
 
-/* information stored about one single SSL session */
-struct Curl_ssl_session {
-  char *name;       /* hostname for which this ID was used */
-  char *conn_to_host; /* hostname for the connection (may be NULL) */
-  const char *scheme; /* protocol scheme used */
-  void *sessionid;  /* as returned from the SSL layer */
-  size_t idsize;    /* if known, otherwise 0 */
-  Curl_ssl_sessionid_dtor *sessionid_free; /* free `sessionid` callback */
-  long age;         /* just a number, the higher the more recent */
-  int remote_port;  /* remote port */
-  int conn_to_port; /* remote port for the connection (may be -1) */
-  int transport;    /* TCP or QUIC */
-  struct ssl_primary_config ssl_config; /* setup for this session */
-};
-
 #ifdef USE_WINDOWS_SSPI
 #include "curl_sspi.h"
 #endif
@@ -787,6 +773,8 @@ struct ldapconninfo;
  */
 struct connectdata {
   struct Curl_llist_node cpool_node; /* conncache lists */
+  struct Curl_llist_node cpool_idle_node; /* idle list of pool shard */
+  struct Curl_llist_node bundle_idle_node; /* idle list of pool bundle */
 
   curl_closesocket_callback fclosesocket; /* function closing the socket(s) */
   void *closesocket_client;
@@ -1224,8 +1212,7 @@ struct UrlState {
   curl_prot_t first_remote_protocol;
 
   int retrycount; /* number of retries on a new connection */
-  struct Curl_ssl_session *session; /* array of 'max_ssl_sessions' size */
-  long sessionage;                  /* number of the most recent session */
+  struct Curl_ssl_scache *session; /* SSL session ID cache */
   int os_errno;  /* filled in with errno whenever an error occurs */
   long followlocation; /* redirect counter */
   int requests; /* request counter: redirects + authentication retakes */
@@ -1248,7 +1235,11 @@ struct UrlState {
   void *engine;
 #endif /* USE_OPENSSL */
   struct curltime expiretime; /* set this with Curl_expire() only */
+#ifdef CURL_DISABLE_TIMER_WHEEL
   struct Curl_tree timenode; /* for the splay stuff */
+#else
+  struct Curl_wheel_node timenode; /* for the timer wheel */
+#endif
   struct Curl_llist timeoutlist; /* list of pending timeouts */
   struct time_node expires[EXPIRE_LAST]; /* nodes for each expire type */
 
@@ -1294,6 +1285,8 @@ struct UrlState {
   struct Curl_llist httphdrs; /* received headers */
   struct curl_header headerout[2]; /* for external purposes */
   struct Curl_header_store *prevhead; /* the latest added header */
+  struct Curl_header_arena *hdsarena; /* storage for the received headers,
+                                         allocated on demand */
   trailers_state trailers_state; /* whether we are sending trailers
                                     and what stage are we at */
 #endif
@@ -1503,6 +1496,7 @@ enum dupstring {
   STRING_HSTS,                  /* CURLOPT_HSTS */
 #endif
   STRING_SASL_AUTHZID,          /* CURLOPT_SASL_AUTHZID */
+  STRING_DNS_CACHE_FILE,        /* CURLOPT_DNS_CACHE_FILE */
 #ifdef USE_ARES
   STRING_DNS_SERVERS,
   STRING_DNS_INTERFACE,
@@ -1592,6 +1586,8 @@ struct UserDefined {
   void *closesocket_client;
   curl_prereq_callback fprereq; /* pre-initial request callback */
   void *prereq_userp; /* pre-initial request user data */
+  curl_recvbuffer_callback frecvbuf; /* hands out buffers to receive into */
+  void *recvbuf_userp; /* pointer to pass to the recvbuffer callback */
 
   void *seek_client;    /* pointer to pass to the seek callback */
 #ifndef CURL_DISABLE_HSTS
@@ -1650,6 +1646,7 @@ struct UserDefined {
 #endif
   struct ssl_general_config general_ssl; /* general user defined SSL stuff */
   int dns_cache_timeout; /* DNS cache timeout (seconds) */
+  int dns_cache_stale; /* seconds a stale DNS entry is used while refreshed */
   unsigned int buffer_size;      /* size of receive buffer to use */
   unsigned int upload_buffer_size; /* size of upload buffer to use,
                                       keep it >= CURL_MAX_WRITE_SIZE */
@@ -1719,6 +1716,7 @@ struct UserDefined {
   int tcp_keepidle;     /* seconds in idle before sending keepalive probe */
   int tcp_keepintvl;    /* seconds between TCP keepalive probes */
   int tcp_keepcnt;      /* maximum number of keepalive probes */
+  unsigned char quic_cc_algo; /* CURL_QUIC_CC_* for QUIC connections */
 
   long expect_100_timeout; /* in milliseconds */
 #if defined(USE_HTTP2) || defined(USE_HTTP3)
@@ -1935,6 +1933,7 @@ struct Curl_easy {
 #ifndef CURL_DISABLE_ALTSVC
   struct altsvcinfo *asi;      /* the alt-svc cache */
 #endif
+  struct dnsfile *dnsf;        /* the DNS cache file */
   struct Progress progress;    /* for all the progress meter data */
   struct UrlState state;       /* struct for fields used for state info and
                                   other dynamic purposes */
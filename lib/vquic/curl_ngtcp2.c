@@ -334,10 +334,6 @@ static void h3_drain_stream(struct Curl_cfilter *cf,
   }
 }
 
-/* ngtcp2 default congestion controller does not perform pacing. Limit
-   the maximum packet burst to MAX_PKT_BURST packets. */
-#define MAX_PKT_BURST 10
-
 struct pkt_io_ctx {
   struct Curl_cfilter *cf;
   struct Curl_easy *data;
@@ -425,7 +421,19 @@ static void quic_settings(struct cf_ngtcp2_ctx *ctx,
   s->log_printf = NULL;
 #endif
 
-  (void)data;
+  switch(data->set.quic_cc_algo) {
+  case CURL_QUIC_CC_RENO:
+    s->cc_algo = NGTCP2_CC_ALGO_RENO;
+    break;
+  case CURL_QUIC_CC_CUBIC:
+    s->cc_algo = NGTCP2_CC_ALGO_CUBIC;
+    break;
+  case CURL_QUIC_CC_BBR:
+    s->cc_algo = NGTCP2_CC_ALGO_BBR;
+    break;
+  default:
+    break;
+  }
   s->initial_ts = pktx->ts;
   s->handshake_timeout = QUIC_HANDSHAKE_TIMEOUT;
   s->max_window = 100 * ctx->max_stream_window;
@@ -1814,7 +1822,9 @@ static CURLcode cf_progress_egress(struct Curl_cfilter *cf,
   struct cf_ngtcp2_ctx *ctx = cf->ctx;
   ssize_t nread;
   size_t max_payload_size, path_max_payload_size, max_pktcnt;
+  size_t max_burst;
   size_t pktcnt = 0;
+  size_t burstcnt = 0;
   size_t gsolen = 0;  /* this disables gso until we have a clue */
   CURLcode curlcode;
   struct pkt_io_ctx local_pktx;
@@ -1851,8 +1861,14 @@ static CURLcode cf_progress_egress(struct Curl_cfilter *cf,
   max_payload_size = ngtcp2_conn_get_max_tx_udp_payload_size(ctx->qconn);
   path_max_payload_size =
       ngtcp2_conn_get_path_max_tx_udp_payload_size(ctx->qconn);
+  /* Packets are paced. We send at most a "send quantum" in one go, as
+   * the congestion controller calculates it from its pacing rate. When
+   * to send the next packets, ngtcp2 tells us via its expiry. */
+  max_burst = ngtcp2_conn_get_send_quantum(ctx->qconn) / max_payload_size;
+  if(!max_burst)
+    max_burst = 1;
   /* maximum number of packets buffered before we flush to the socket */
-  max_pktcnt = CURLMIN(MAX_PKT_BURST,
+  max_pktcnt = CURLMIN(max_burst,
                        ctx->q.sendbuf.chunk_size / max_payload_size);
 
   for(;;) {
@@ -1867,7 +1883,7 @@ static CURLcode cf_progress_egress(struct Curl_cfilter *cf,
       if(curlcode) {
         if(curlcode == CURLE_AGAIN) {
           Curl_expire(data, 1, EXPIRE_QUIC);
-          return CURLE_OK;
+          goto out;
         }
         return curlcode;
       }
@@ -1875,6 +1891,7 @@ static CURLcode cf_progress_egress(struct Curl_cfilter *cf,
     }
 
     DEBUGASSERT(nread > 0);
+    ++burstcnt;
     if(pktcnt == 0) {
       /* first packet in buffer. This is either of a known, "good"
        * payload size or it is a PMTUD. We will see. */
@@ -1890,7 +1907,7 @@ static CURLcode cf_progress_egress(struct Curl_cfilter *cf,
       if(curlcode) {
         if(curlcode == CURLE_AGAIN) {
           Curl_expire(data, 1, EXPIRE_QUIC);
-          return CURLE_OK;
+          goto out;
         }
         return curlcode;
       }
@@ -1898,24 +1915,30 @@ static CURLcode cf_progress_egress(struct Curl_cfilter *cf,
       continue;
     }
 
-    if(++pktcnt >= max_pktcnt || (size_t)nread < gsolen) {
-      /* Reached MAX_PKT_BURST *or*
+    if(++pktcnt >= max_pktcnt || (size_t)nread < gsolen ||
+       burstcnt >= max_burst) {
+      /* Reached the send quantum *or*
        * the capacity of our buffer *or*
        * last add was shorter than the previous ones, flush */
       curlcode = vquic_send(cf, data, &ctx->q, gsolen);
       if(curlcode) {
         if(curlcode == CURLE_AGAIN) {
           Curl_expire(data, 1, EXPIRE_QUIC);
-          return CURLE_OK;
+          goto out;
         }
         return curlcode;
       }
       /* pktbuf has been completely sent */
       pktcnt = 0;
+      if(burstcnt >= max_burst)
+        goto out;
     }
   }
 
 out:
+  if(burstcnt)
+    /* let the congestion controller schedule the next packets */
+    ngtcp2_conn_update_pkt_tx_time(ctx->qconn, pktx->ts);
   return CURLE_OK;
 }
 
@@ -2512,13 +2535,13 @@ CURLcode Curl_cf_ngtcp2_create(struct Curl_cfilter **pcf,
   struct Curl_cfilter *cf = NULL, *udp_cf = NULL;
   CURLcode result;
 
-  (void)data;
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx) {
     result = CURLE_OUT_OF_MEMORY;
     goto out;
   }
   cf_ngtcp2_ctx_init(ctx);
+  Curl_bufcp_use_share(&ctx->stream_bufcp, Curl_multi_bufc_share(data));
 
   result = Curl_cf_create(&cf, &Curl_cft_http3, ctx);
   if(result)
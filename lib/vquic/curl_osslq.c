@@ -2337,13 +2337,13 @@ CURLcode Curl_cf_osslq_create(struct Curl_cfilter **pcf,
   struct Curl_cfilter *cf = NULL, *udp_cf = NULL;
   CURLcode result;
 
-  (void)data;
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx) {
     result = CURLE_OUT_OF_MEMORY;
     goto out;
   }
   cf_osslq_ctx_init(ctx);
+  Curl_bufcp_use_share(&ctx->stream_bufcp, Curl_multi_bufc_share(data));
 
   result = Curl_cf_create(&cf, &Curl_cft_http3, ctx);
   if(result)
@@ -1646,7 +1646,6 @@ CURLcode Curl_cf_quiche_create(struct Curl_cfilter **pcf,
   struct Curl_cfilter *cf = NULL, *udp_cf = NULL;
   CURLcode result;
 
-  (void)data;
   (void)conn;
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx) {
@@ -1654,6 +1653,7 @@ CURLcode Curl_cf_quiche_create(struct Curl_cfilter **pcf,
     goto out;
   }
   cf_quiche_ctx_init(ctx);
+  Curl_bufcp_use_share(&ctx->stream_bufcp, Curl_multi_bufc_share(data));
 
   result = Curl_cf_create(&cf, &Curl_cft_http3, ctx);
   if(result)
@@ -612,13 +612,13 @@ static CURLcode bearssl_connect_step1(struct Curl_cfilter *cf,
     void *session;
 
     CURL_TRC_CF(data, cf, "connect_step1, check session cache");
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     if(!Curl_ssl_getsessionid(cf, data, &connssl->peer, &session, NULL)) {
       br_ssl_engine_set_session_parameters(&backend->ctx.eng, session);
       session_set = 1;
       infof(data, "BearSSL: reusing session ID");
     }
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, &connssl->peer);
   }
 
   if(connssl->alpn) {
@@ -831,10 +831,10 @@ static CURLcode bearssl_connect_step3(struct Curl_cfilter *cf,
     if(!session)
       return CURLE_OUT_OF_MEMORY;
     br_ssl_engine_get_session_parameters(&backend->ctx.eng, session);
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     ret = Curl_ssl_set_sessionid(cf, data, &connssl->peer, session, 0,
                                  bearssl_session_free);
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, &connssl->peer);
     if(ret)
       return ret;
   }
@@ -747,12 +747,12 @@ static CURLcode gtls_update_session_id(struct Curl_cfilter *cf,
 
       CURL_TRC_CF(data, cf, "get session id (len=%zu) and store in cache",
                   connect_idsize);
-      Curl_ssl_sessionid_lock(data);
+      Curl_ssl_sessionid_lock(data, &connssl->peer);
       /* store this session id, takes ownership */
       result = Curl_ssl_set_sessionid(cf, data, &connssl->peer,
                                       connect_sessionid, connect_idsize,
                                       gtls_sessionid_free);
-      Curl_ssl_sessionid_unlock(data);
+      Curl_ssl_sessionid_unlock(data, &connssl->peer);
     }
   }
   return result;
@@ -784,6 +784,58 @@ static int gtls_handshake_cb(gnutls_session_t session, unsigned int htype,
   return 0;
 }
 
+/* Since GnuTLS 3.6.0 sessions hold a reference to the priorities set,
+ * parsed ones may then be used by many connections. */
+#if GNUTLS_VERSION_NUMBER >= 0x030600
+#define GTLS_PRIORITY_SHARE
+#endif
+
+#ifdef GTLS_PRIORITY_SHARE
+static void gtls_priority_free(void *ctx)
+{
+  gnutls_priority_deinit(ctx);
+}
+#endif
+
+/* Set the priorities in `prioritylist` for the session, using parsed ones
+ * from the multi handle's cache when possible. */
+static int gtls_set_priority(struct Curl_cfilter *cf,
+                             struct Curl_easy *data,
+                             struct ssl_peer *peer,
+                             gnutls_session_t session,
+                             const char *prioritylist,
+                             const char **err)
+{
+#ifdef GTLS_PRIORITY_SHARE
+  gnutls_priority_t prio;
+  size_t len = strlen(prioritylist);
+  int rc;
+
+  prio = Curl_ssl_ctx_get(cf, data, "gnutls", peer->transport,
+                          prioritylist, len);
+  if(prio) {
+    CURL_TRC_CF(data, cf, "reusing cached priorities");
+    return gnutls_priority_set(session, prio);
+  }
+  rc = gnutls_priority_init(&prio, prioritylist, err);
+  if(rc != GNUTLS_E_SUCCESS)
+    return rc;
+  rc = gnutls_priority_set(session, prio);
+  if(rc != GNUTLS_E_SUCCESS) {
+    gnutls_priority_deinit(prio);
+    return rc;
+  }
+  Curl_ssl_ctx_add(cf, data, "gnutls", peer->transport, prioritylist, len,
+                   prio, gtls_priority_free);
+  return GNUTLS_E_SUCCESS;
+#else
+  (void)cf;
+  (void)data;
+  (void)peer;
+  return gnutls_priority_set_direct(session, prioritylist, err);
+#endif
+}
+
 static CURLcode gtls_client_init(struct Curl_cfilter *cf,
                                  struct Curl_easy *data,
                                  struct ssl_peer *peer,
@@ -919,7 +971,8 @@ static CURLcode gtls_client_init(struct Curl_cfilter *cf,
   else {
 #endif
     infof(data, "GnuTLS ciphers: %s", prioritylist);
-    rc = gnutls_priority_set_direct(gtls->session, prioritylist, &err);
+    rc = gtls_set_priority(cf, data, peer, gtls->session, prioritylist,
+                           &err);
 #ifdef USE_GNUTLS_SRP
   }
 #endif
@@ -1094,7 +1147,7 @@ CURLcode Curl_gtls_ctx_init(struct gtls_ctx *gctx,
     void *ssl_sessionid;
     size_t ssl_idsize;
 
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, peer);
     if(!Curl_ssl_getsessionid(cf, data, peer, &ssl_sessionid, &ssl_idsize)) {
       /* we got a session id, use it! */
       int rc;
@@ -1105,7 +1158,7 @@ CURLcode Curl_gtls_ctx_init(struct gtls_ctx *gctx,
       else
         infof(data, "SSL reusing session ID (size=%zu)", ssl_idsize);
     }
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, peer);
   }
   return CURLE_OK;
 }
@@ -874,17 +874,17 @@ mbed_connect_step1(struct Curl_cfilter *cf, struct Curl_easy *data)
   if(ssl_config->primary.cache_session) {
     void *old_session = NULL;
 
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     if(!Curl_ssl_getsessionid(cf, data, &connssl->peer, &old_session, NULL)) {
       ret = mbedtls_ssl_set_session(&backend->ssl, old_session);
       if(ret) {
-        Curl_ssl_sessionid_unlock(data);
+        Curl_ssl_sessionid_unlock(data, &connssl->peer);
         failf(data, "mbedtls_ssl_set_session returned -0x%x", -ret);
         return CURLE_SSL_CONNECT_ERROR;
       }
       infof(data, "mbedTLS reusing session");
     }
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, &connssl->peer);
   }
 
   mbedtls_ssl_conf_ca_chain(&backend->config,
@@ -1141,11 +1141,11 @@ mbed_connect_step3(struct Curl_cfilter *cf, struct Curl_easy *data)
     }
 
     /* If there is already a matching session in the cache, delete it */
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     retcode = Curl_ssl_set_sessionid(cf, data, &connssl->peer,
                                      our_ssl_sessionid, 0,
                                      mbedtls_session_free);
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, &connssl->peer);
     if(retcode)
       return retcode;
   }
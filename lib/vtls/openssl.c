@@ -307,6 +307,15 @@ typedef unsigned long sslerr_t;
 #define HAVE_SSL_X509_STORE_SHARE
 #endif
 
+/*
+ * Whether the OpenSSL version has the API needed to support sharing an
+ * SSL_CTX between connections. The API is:
+ * * `SSL_CTX_up_ref`          -- Introduced: OpenSSL 1.1.0.
+ */
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) /* OpenSSL >= 1.1.0 */
+#define HAVE_SSL_CTX_SHARE
+#endif
+
 /* What API version do we use? */
 #if defined(LIBRESSL_VERSION_NUMBER)
 #define USE_PRE_1_1_API (LIBRESSL_VERSION_NUMBER < 0x2070000f)
@@ -696,6 +705,102 @@ static CURLcode ossl_certchain(struct Curl_easy *data, SSL *ssl)
 #define BIO_set_shutdown(x,v)      ((x)->shutdown=(v))
 #endif /* USE_PRE_1_1_API */
 
+#ifdef HAVE_SSL_CTX_SHARE
+/* the settings besides the primary config an SSL_CTX is set up with */
+struct ossl_ctx_extra {
+  unsigned char enable_beast;
+  unsigned char native_ca_store;
+  unsigned char no_partialchain;
+};
+
+static void ossl_ctx_extra_init(struct Curl_cfilter *cf,
+                                struct Curl_easy *data,
+                                struct ossl_ctx_extra *extra)
+{
+  struct ssl_config_data *ssl_config = Curl_ssl_cf_get_config(cf, data);
+
+  memset(extra, 0, sizeof(*extra));
+  extra->enable_beast = ssl_config->enable_beast;
+  extra->native_ca_store = ssl_config->native_ca_store;
+  extra->no_partialchain = ssl_config->no_partialchain;
+}
+
+static void ossl_ctx_free(void *ctx)
+{
+  SSL_CTX_free(ctx);
+}
+
+/* Whether the SSL_CTX for this filter may be used by other connections.
+ * Those made by a callback, with a client certificate or with SRP
+ * credentials are left alone. */
+static bool ossl_ctx_cacheable(struct Curl_cfilter *cf,
+                               struct Curl_easy *data,
+                               int transport,
+                               Curl_ossl_ctx_setup_cb *cb_setup)
+{
+  struct ssl_config_data *ssl_config = Curl_ssl_cf_get_config(cf, data);
+
+  if((transport != TRNSPRT_TCP) || cb_setup || data->set.ssl.fsslctx ||
+     ssl_config->primary.clientcert || ssl_config->primary.cert_blob ||
+     ssl_config->cert_type)
+    return FALSE;
+#ifdef USE_TLS_SRP
+  if(ssl_config->primary.username)
+    return FALSE;
+#endif
+  return TRUE;
+}
+
+/* Use an SSL_CTX from the multi handle's cache, if there is one. */
+static bool ossl_ctx_from_cache(struct ossl_ctx *octx,
+                                struct Curl_cfilter *cf,
+                                struct Curl_easy *data,
+                                int transport,
+                                Curl_ossl_ctx_setup_cb *cb_setup)
+{
+  struct ossl_ctx_extra extra;
+  SSL_CTX *ssl_ctx;
+
+  octx->ssl_ctx_cacheable = ossl_ctx_cacheable(cf, data, transport,
+                                               cb_setup);
+  if(!octx->ssl_ctx_cacheable)
+    return FALSE;
+  ossl_ctx_extra_init(cf, data, &extra);
+  ssl_ctx = Curl_ssl_ctx_get(cf, data, "openssl", transport,
+                             &extra, sizeof(extra));
+  if(!ssl_ctx || !SSL_CTX_up_ref(ssl_ctx))
+    return FALSE;
+  DEBUGASSERT(!octx->ssl_ctx);
+  octx->ssl_ctx = ssl_ctx;
+  /* contexts are only cached with their x509 store set up */
+  octx->x509_store_setup = TRUE;
+  octx->ssl_ctx_cacheable = FALSE;
+  CURL_TRC_CF(data, cf, "reusing cached SSL_CTX");
+  return TRUE;
+}
+
+/* Add the SSL_CTX to the multi handle's cache, once its x509 store is
+ * set up. */
+static void ossl_ctx_cache_add(struct Curl_cfilter *cf,
+                               struct Curl_easy *data,
+                               struct ossl_ctx *octx)
+{
+  struct ossl_ctx_extra extra;
+
+  if(!octx->ssl_ctx_cacheable)
+    return;
+  octx->ssl_ctx_cacheable = FALSE;
+  if(!SSL_CTX_up_ref(octx->ssl_ctx))
+    return;
+  ossl_ctx_extra_init(cf, data, &extra);
+  Curl_ssl_ctx_add(cf, data, "openssl", TRNSPRT_TCP, &extra, sizeof(extra),
+                   octx->ssl_ctx, ossl_ctx_free);
+}
+#else
+#define ossl_ctx_from_cache(a,b,c,d,e) FALSE
+#define ossl_ctx_cache_add(a,b,c) Curl_nop_stmt
+#endif /* HAVE_SSL_CTX_SHARE */
+
 static int ossl_bio_cf_create(BIO *bio)
 {
   BIO_set_shutdown(bio, 1);
@@ -812,6 +917,7 @@ static int ossl_bio_cf_in_read(BIO *bio, char *buf, int blen)
       return -1;
     }
     octx->x509_store_setup = TRUE;
+    ossl_ctx_cache_add(cf, data, octx);
   }
 
   return (int)nread;
@@ -2010,6 +2116,7 @@ static void ossl_close(struct Curl_cfilter *cf, struct Curl_easy *data)
     SSL_CTX_free(octx->ssl_ctx);
     octx->ssl_ctx = NULL;
     octx->x509_store_setup = FALSE;
+    octx->ssl_ctx_cacheable = FALSE;
   }
   if(octx->bio_method) {
     ossl_bio_cf_method_free(octx->bio_method);
@@ -2913,10 +3020,10 @@ CURLcode Curl_ossl_add_session(struct Curl_cfilter *cf,
       goto out;
     }
 
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, peer);
     result = Curl_ssl_set_sessionid(cf, data, peer, der_session_buf,
                                     der_session_size, ossl_session_free);
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, peer);
   }
 
 out:
@@ -3470,24 +3577,19 @@ CURLcode Curl_ssl_setup_x509_store(struct Curl_cfilter *cf,
 }
 #endif /* HAVE_SSL_X509_STORE_SHARE */
 
-CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
-                            struct Curl_cfilter *cf,
-                            struct Curl_easy *data,
-                            struct ssl_peer *peer,
-                            int transport, /* TCP or QUIC */
-                            const unsigned char *alpn, size_t alpn_len,
-                            Curl_ossl_ctx_setup_cb *cb_setup,
-                            void *cb_user_data,
-                            Curl_ossl_new_session_cb *cb_new_session,
-                            void *ssl_user_data)
+/* Create and set up the SSL_CTX for a connection with `cf`'s config. */
+static CURLcode ossl_init_ssl_ctx(struct ossl_ctx *octx,
+                                  struct Curl_cfilter *cf,
+                                  struct Curl_easy *data,
+                                  int transport, /* TCP or QUIC */
+                                  SSL_METHOD_QUAL SSL_METHOD *req_method,
+                                  Curl_ossl_ctx_setup_cb *cb_setup,
+                                  void *cb_user_data,
+                                  Curl_ossl_new_session_cb *cb_new_session)
 {
   CURLcode result = CURLE_OK;
   const char *ciphers;
-  SSL_METHOD_QUAL SSL_METHOD *req_method = NULL;
   ctx_option_t ctx_options = 0;
-  SSL_SESSION *ssl_session = NULL;
-  const unsigned char *der_sessionid = NULL;
-  size_t der_sessionid_size = 0;
   struct ssl_primary_config *conn_config = Curl_ssl_cf_get_primary_config(cf);
   struct ssl_config_data *ssl_config = Curl_ssl_cf_get_config(cf, data);
   const long int ssl_version_min = conn_config->version;
@@ -3497,62 +3599,6 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
   const bool verifypeer = conn_config->verifypeer;
   char error_buffer[256];
 
-  /* Make funny stuff to get random input */
-  result = ossl_seed(data);
-  if(result)
-    return result;
-
-  ssl_config->certverifyresult = !X509_V_OK;
-
-  switch(transport) {
-  case TRNSPRT_TCP:
-    /* check to see if we have been told to use an explicit SSL/TLS version */
-    switch(ssl_version_min) {
-    case CURL_SSLVERSION_DEFAULT:
-    case CURL_SSLVERSION_TLSv1:
-    case CURL_SSLVERSION_TLSv1_0:
-    case CURL_SSLVERSION_TLSv1_1:
-    case CURL_SSLVERSION_TLSv1_2:
-    case CURL_SSLVERSION_TLSv1_3:
-      /* it will be handled later with the context options */
-  #if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
-      req_method = TLS_client_method();
-  #else
-      req_method = SSLv23_client_method();
-  #endif
-      break;
-    case CURL_SSLVERSION_SSLv2:
-      failf(data, "No SSLv2 support");
-      return CURLE_NOT_BUILT_IN;
-    case CURL_SSLVERSION_SSLv3:
-      failf(data, "No SSLv3 support");
-      return CURLE_NOT_BUILT_IN;
-    default:
-      failf(data, "Unrecognized parameter passed via CURLOPT_SSLVERSION");
-      return CURLE_SSL_CONNECT_ERROR;
-    }
-    break;
-  case TRNSPRT_QUIC:
-    if(conn_config->version_max &&
-       (conn_config->version_max != CURL_SSLVERSION_MAX_TLSv1_3)) {
-      failf(data, "QUIC needs at least TLS version 1.3");
-      return CURLE_SSL_CONNECT_ERROR;
-    }
-
-#ifdef USE_OPENSSL_QUIC
-    req_method = OSSL_QUIC_client_method();
-#elif (OPENSSL_VERSION_NUMBER >= 0x10100000L)
-    req_method = TLS_method();
-#else
-    req_method = SSLv23_client_method();
-#endif
-    break;
-  default:
-    failf(data, "unsupported transport %d in SSL init", transport);
-    return CURLE_SSL_CONNECT_ERROR;
-  }
-
-
   DEBUGASSERT(!octx->ssl_ctx);
   octx->ssl_ctx = SSL_CTX_new(req_method);
 
@@ -3568,14 +3614,6 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
       return result;
   }
 
-#ifdef SSL_CTRL_SET_MSG_CALLBACK
-  if(data->set.fdebug && data->set.verbose) {
-    /* the SSL trace callback is only used for verbose logging */
-    SSL_CTX_set_msg_callback(octx->ssl_ctx, ossl_trace);
-    SSL_CTX_set_msg_callback_arg(octx->ssl_ctx, cf);
-  }
-#endif
-
   /* OpenSSL contains code to work around lots of bugs and flaws in various
      SSL-implementations. SSL_CTX_set_options() is used to enabled those
      work-arounds. The manpage for this option states that SSL_OP_ALL enables
@@ -3672,15 +3710,6 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
   SSL_CTX_set_mode(octx->ssl_ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 #endif
 
-#ifdef HAS_ALPN
-  if(alpn && alpn_len) {
-    if(SSL_CTX_set_alpn_protos(octx->ssl_ctx, alpn, (int)alpn_len)) {
-      failf(data, "Error setting ALPN");
-      return CURLE_SSL_CONNECT_ERROR;
-    }
-  }
-#endif
-
   if(ssl_cert || ssl_cert_blob || ssl_cert_type) {
     if(!result &&
        !cert_stuff(data, octx->ssl_ctx,
@@ -3694,7 +3723,7 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
   }
 
   ciphers = conn_config->cipher_list;
-  if(!ciphers && (peer->transport != TRNSPRT_QUIC))
+  if(!ciphers && (transport != TRNSPRT_QUIC))
     ciphers = DEFAULT_CIPHER_SELECTION;
   if(ciphers) {
     if(!SSL_CTX_set_cipher_list(octx->ssl_ctx, ciphers)) {
@@ -3805,6 +3834,92 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
     }
   }
 
+  return CURLE_OK;
+}
+
+CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
+                            struct Curl_cfilter *cf,
+                            struct Curl_easy *data,
+                            struct ssl_peer *peer,
+                            int transport, /* TCP or QUIC */
+                            const unsigned char *alpn, size_t alpn_len,
+                            Curl_ossl_ctx_setup_cb *cb_setup,
+                            void *cb_user_data,
+                            Curl_ossl_new_session_cb *cb_new_session,
+                            void *ssl_user_data)
+{
+  CURLcode result = CURLE_OK;
+  SSL_METHOD_QUAL SSL_METHOD *req_method = NULL;
+  SSL_SESSION *ssl_session = NULL;
+  const unsigned char *der_sessionid = NULL;
+  size_t der_sessionid_size = 0;
+  struct ssl_primary_config *conn_config = Curl_ssl_cf_get_primary_config(cf);
+  struct ssl_config_data *ssl_config = Curl_ssl_cf_get_config(cf, data);
+  const long int ssl_version_min = conn_config->version;
+  char error_buffer[256];
+
+  /* Make funny stuff to get random input */
+  result = ossl_seed(data);
+  if(result)
+    return result;
+
+  ssl_config->certverifyresult = !X509_V_OK;
+
+  switch(transport) {
+  case TRNSPRT_TCP:
+    /* check to see if we have been told to use an explicit SSL/TLS version */
+    switch(ssl_version_min) {
+    case CURL_SSLVERSION_DEFAULT:
+    case CURL_SSLVERSION_TLSv1:
+    case CURL_SSLVERSION_TLSv1_0:
+    case CURL_SSLVERSION_TLSv1_1:
+    case CURL_SSLVERSION_TLSv1_2:
+    case CURL_SSLVERSION_TLSv1_3:
+      /* it will be handled later with the context options */
+  #if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+      req_method = TLS_client_method();
+  #else
+      req_method = SSLv23_client_method();
+  #endif
+      break;
+    case CURL_SSLVERSION_SSLv2:
+      failf(data, "No SSLv2 support");
+      return CURLE_NOT_BUILT_IN;
+    case CURL_SSLVERSION_SSLv3:
+      failf(data, "No SSLv3 support");
+      return CURLE_NOT_BUILT_IN;
+    default:
+      failf(data, "Unrecognized parameter passed via CURLOPT_SSLVERSION");
+      return CURLE_SSL_CONNECT_ERROR;
+    }
+    break;
+  case TRNSPRT_QUIC:
+    if(conn_config->version_max &&
+       (conn_config->version_max != CURL_SSLVERSION_MAX_TLSv1_3)) {
+      failf(data, "QUIC needs at least TLS version 1.3");
+      return CURLE_SSL_CONNECT_ERROR;
+    }
+
+#ifdef USE_OPENSSL_QUIC
+    req_method = OSSL_QUIC_client_method();
+#elif (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+    req_method = TLS_method();
+#else
+    req_method = SSLv23_client_method();
+#endif
+    break;
+  default:
+    failf(data, "unsupported transport %d in SSL init", transport);
+    return CURLE_SSL_CONNECT_ERROR;
+  }
+
+  if(!ossl_ctx_from_cache(octx, cf, data, transport, cb_setup)) {
+    result = ossl_init_ssl_ctx(octx, cf, data, transport, req_method,
+                               cb_setup, cb_user_data, cb_new_session);
+    if(result)
+      return result;
+  }
+
   /* Let's make an SSL structure */
   if(octx->ssl)
     SSL_free(octx->ssl);
@@ -3816,6 +3931,23 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
 
   SSL_set_app_data(octx->ssl, ssl_user_data);
 
+#ifdef SSL_CTRL_SET_MSG_CALLBACK
+  if(data->set.fdebug && data->set.verbose) {
+    /* the SSL trace callback is only used for verbose logging */
+    SSL_set_msg_callback(octx->ssl, ossl_trace);
+    SSL_set_msg_callback_arg(octx->ssl, cf);
+  }
+#endif
+
+#ifdef HAS_ALPN
+  if(alpn && alpn_len) {
+    if(SSL_set_alpn_protos(octx->ssl, alpn, (unsigned int)alpn_len)) {
+      failf(data, "Error setting ALPN");
+      return CURLE_SSL_CONNECT_ERROR;
+    }
+  }
+#endif
+
 #if (OPENSSL_VERSION_NUMBER >= 0x0090808fL) && !defined(OPENSSL_NO_TLSEXT) && \
   !defined(OPENSSL_NO_OCSP)
   if(conn_config->verifystatus)
@@ -3971,7 +4103,7 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
 
   octx->reused_session = FALSE;
   if(ssl_config->primary.cache_session && transport == TRNSPRT_TCP) {
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, peer);
     if(!Curl_ssl_getsessionid(cf, data, peer, (void **)&der_sessionid,
       &der_sessionid_size)) {
       /* we got a session id, use it! */
@@ -3979,7 +4111,7 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
         (long)der_sessionid_size);
       if(ssl_session) {
         if(!SSL_set_session(octx->ssl, ssl_session)) {
-          Curl_ssl_sessionid_unlock(data);
+          Curl_ssl_sessionid_unlock(data, peer);
           SSL_SESSION_free(ssl_session);
           failf(data, "SSL: SSL_set_session failed: %s",
                 ossl_strerror(ERR_get_error(), error_buffer,
@@ -3992,11 +4124,11 @@ CURLcode Curl_ossl_ctx_init(struct ossl_ctx *octx,
         octx->reused_session = TRUE;
       }
       else {
-        Curl_ssl_sessionid_unlock(data);
+        Curl_ssl_sessionid_unlock(data, peer);
         return CURLE_SSL_CONNECT_ERROR;
       }
     }
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, peer);
   }
 
   return CURLE_OK;
@@ -4147,6 +4279,7 @@ static CURLcode ossl_connect_step2(struct Curl_cfilter *cf,
     if(result)
       return result;
     octx->x509_store_setup = TRUE;
+    ossl_ctx_cache_add(cf, data, octx);
   }
 
 #ifndef HAVE_KEYLOG_CALLBACK
@@ -4708,14 +4841,14 @@ CURLcode Curl_oss_check_peer_cert(struct Curl_cfilter *cf,
       if(!Curl_ssl_cf_is_proxy(cf)) {
         void *old_ssl_sessionid = NULL;
         bool incache;
-        Curl_ssl_sessionid_lock(data);
+        Curl_ssl_sessionid_lock(data, peer);
         incache = !(Curl_ssl_getsessionid(cf, data, peer,
                                           &old_ssl_sessionid, NULL));
         if(incache) {
           infof(data, "Remove session ID again from cache");
-          Curl_ssl_delsessionid(data, old_ssl_sessionid);
+          Curl_ssl_delsessionid(cf, data, peer, old_ssl_sessionid);
         }
-        Curl_ssl_sessionid_unlock(data);
+        Curl_ssl_sessionid_unlock(data, peer);
       }
 
       X509_free(octx->server_cert);
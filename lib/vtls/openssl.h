@@ -51,6 +51,7 @@ struct ossl_ctx {
 #endif
   BIT(x509_store_setup);            /* x509 store has been set up */
   BIT(reused_session);              /* session-ID was reused for this */
+  BIT(ssl_ctx_cacheable);           /* ssl_ctx is to be cached once set up */
 };
 
 typedef CURLcode Curl_ossl_ctx_setup_cb(struct Curl_cfilter *cf,
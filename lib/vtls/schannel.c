@@ -1128,7 +1128,7 @@ schannel_connect_step1(struct Curl_cfilter *cf, struct Curl_easy *data)
 
   /* check for an existing reusable credential handle */
   if(ssl_config->primary.cache_session) {
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     if(!Curl_ssl_getsessionid(cf, data, &connssl->peer,
                               (void **)&old_cred, NULL)) {
       backend->cred = old_cred;
@@ -1140,7 +1140,7 @@ schannel_connect_step1(struct Curl_cfilter *cf, struct Curl_easy *data)
                    "schannel: incremented credential handle refcount = %d",
                    backend->cred->refcount));
     }
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, &connssl->peer);
   }
 
   if(!backend->cred) {
@@ -1773,13 +1773,13 @@ schannel_connect_step3(struct Curl_cfilter *cf, struct Curl_easy *data)
 
   /* save the current session data for possible reuse */
   if(ssl_config->primary.cache_session) {
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     /* Up ref count since call takes ownership */
     backend->cred->refcount++;
     result = Curl_ssl_set_sessionid(cf, data, &connssl->peer, backend->cred,
                                     sizeof(struct Curl_schannel_cred),
                                     schannel_session_free);
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, &connssl->peer);
     if(result)
       return result;
   }
@@ -2611,9 +2611,9 @@ static void schannel_close(struct Curl_cfilter *cf, struct Curl_easy *data)
 
   /* free SSPI Schannel API credential handle */
   if(backend->cred) {
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     schannel_session_free(backend->cred, 0);
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, &connssl->peer);
     backend->cred = NULL;
   }
 
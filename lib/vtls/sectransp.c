@@ -1332,12 +1332,12 @@ static CURLcode sectransp_connect_step1(struct Curl_cfilter *cf,
     char *ssl_sessionid;
     size_t ssl_sessionid_len;
 
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     if(!Curl_ssl_getsessionid(cf, data, &connssl->peer,
                               (void **)&ssl_sessionid, &ssl_sessionid_len)) {
       /* we got a session id, use it! */
       err = SSLSetPeerID(backend->ssl_ctx, ssl_sessionid, ssl_sessionid_len);
-      Curl_ssl_sessionid_unlock(data);
+      Curl_ssl_sessionid_unlock(data, &connssl->peer);
       if(err != noErr) {
         failf(data, "SSL: SSLSetPeerID() failed: OSStatus %d", err);
         return CURLE_SSL_CONNECT_ERROR;
@@ -1357,7 +1357,7 @@ static CURLcode sectransp_connect_step1(struct Curl_cfilter *cf,
 
       err = SSLSetPeerID(backend->ssl_ctx, ssl_sessionid, ssl_sessionid_len);
       if(err != noErr) {
-        Curl_ssl_sessionid_unlock(data);
+        Curl_ssl_sessionid_unlock(data, &connssl->peer);
         failf(data, "SSL: SSLSetPeerID() failed: OSStatus %d", err);
         return CURLE_SSL_CONNECT_ERROR;
       }
@@ -1365,7 +1365,7 @@ static CURLcode sectransp_connect_step1(struct Curl_cfilter *cf,
       result = Curl_ssl_set_sessionid(cf, data, &connssl->peer, ssl_sessionid,
                                       ssl_sessionid_len,
                                       sectransp_session_free);
-      Curl_ssl_sessionid_unlock(data);
+      Curl_ssl_sessionid_unlock(data, &connssl->peer);
       if(result)
         return result;
     }
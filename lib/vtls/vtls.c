@@ -72,6 +72,10 @@
 #include "select.h"
 #include "strdup.h"
 #include "rand.h"
+#include "hash.h"
+#include "llist.h"
+#include "curl_threads.h"
+#include "multihandle.h"
 
 /* The last #include files should be: */
 #include "curl_memory.h"
@@ -501,22 +505,250 @@ ssl_connect_nonblocking(struct Curl_cfilter *cf, struct Curl_easy *data,
   return Curl_ssl->connect_nonblocking(cf, data, done);
 }
 
+/* Session caches shared via a share handle may be split into shards, each
+ * with its own lock, when libcurl has thread support. */
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+#define SCACHE_SHARDING
+#endif
+
+/* information stored about one single SSL session */
+struct Curl_ssl_session {
+  struct Curl_llist_node lru; /* in its shard's list of sessions */
+  void *sessionid;  /* as returned from the SSL layer */
+  size_t idsize;    /* if known, otherwise 0 */
+  Curl_ssl_sessionid_dtor *sessionid_free; /* free `sessionid` callback */
+  struct ssl_primary_config ssl_config; /* setup for this session */
+  size_t keylen;    /* length of `key` */
+  char key[1];      /* the peer key this session is cached by */
+};
+
+/* A part of the session cache, holding the sessions of the peers whose
+ * hostname and port hash to it. When the cache is not sharded, there is
+ * only one. */
+struct scache_shard {
+  struct Curl_hash sessions; /* peer key to session */
+  struct Curl_llist lru;     /* the sessions, least recently used first */
+#ifdef SCACHE_SHARDING
+  curl_mutex_t mutex;        /* the shard lock, when sharded */
+#endif
+};
+
+struct Curl_ssl_scache {
+  struct scache_shard *shards;
+  size_t num_shards;
+  size_t max_per_shard; /* the most sessions a shard keeps */
+  BIT(sharded); /* shards have their own locks, share lock is not used */
+};
+
+/* the longest peer key a session is cached for */
+#define SCACHE_KEY_MAX 1024
+
+#define SCACHE_HASH_INIT ((size_t)2166136261U)
+
+/* FNV-1a over `len` bytes, ending with a separator so that neighboring
+   fields do not run into each other */
+static size_t scache_hash_mem(size_t h, const void *mem, size_t len,
+                              bool nocase)
+{
+  const unsigned char *p = mem;
+  size_t i;
+
+  for(i = 0; i < len; i++) {
+    unsigned char c = p[i];
+    if(nocase)
+      c = (unsigned char)Curl_raw_tolower((char)c);
+    h = (h ^ c) * 16777619;
+  }
+  return (h ^ 0xff) * 16777619;
+}
+
+static size_t scache_hash_str(size_t h, const char *s, bool nocase)
+{
+  return scache_hash_mem(h, s, s ? strlen(s) : 0, nocase);
+}
+
+static size_t scache_hash_blob(size_t h, const struct curl_blob *b)
+{
+  return b ? scache_hash_mem(h, b->data, b->len, FALSE) :
+    scache_hash_mem(h, NULL, 0, FALSE);
+}
+
+/*
+ * A hash over the parts of `c` that match_ssl_primary_config() compares,
+ * the same for all configs it finds equal. Credentials are left out, the
+ * config of a session found is always compared in full.
+ */
+static size_t scache_config_hash(const struct ssl_primary_config *c)
+{
+  unsigned int bits[6];
+  size_t h = SCACHE_HASH_INIT;
+
+  bits[0] = c->version;
+  bits[1] = c->version_max;
+  bits[2] = c->ssl_options;
+  bits[3] = c->verifypeer;
+  bits[4] = c->verifyhost;
+  bits[5] = c->verifystatus;
+  h = scache_hash_mem(h, bits, sizeof(bits), FALSE);
+  h = scache_hash_blob(h, c->cert_blob);
+  h = scache_hash_blob(h, c->ca_info_blob);
+  h = scache_hash_blob(h, c->issuercert_blob);
+  h = scache_hash_str(h, c->CApath, FALSE);
+  h = scache_hash_str(h, c->CAfile, FALSE);
+  h = scache_hash_str(h, c->issuercert, FALSE);
+  h = scache_hash_str(h, c->clientcert, FALSE);
+  h = scache_hash_str(h, c->cipher_list, TRUE);
+  h = scache_hash_str(h, c->cipher_list13, TRUE);
+  h = scache_hash_str(h, c->curves, TRUE);
+  h = scache_hash_str(h, c->CRLfile, TRUE);
+  h = scache_hash_str(h, c->pinned_key, TRUE);
+  return h;
+}
+
+/*
+ * Write the key sessions for `peer` using `conn_config` are cached by into
+ * `buf`. Returns the length of the key, 0 if it does not fit.
+ */
+static size_t scache_peer_key(struct Curl_cfilter *cf,
+                              const struct ssl_peer *peer,
+                              const struct ssl_primary_config *conn_config,
+                              char *buf, size_t blen)
+{
+  struct connectdata *conn = cf->conn;
+  int len;
+
+  len = msnprintf(buf, blen, "%s://%s:%d/%s:%d/%d/%zx",
+                  conn->handler->scheme, peer->hostname, peer->port,
+                  conn->bits.conn_to_host ? conn->conn_to_host.name : "",
+                  conn->bits.conn_to_port ? conn->conn_to_port : -1,
+                  peer->transport, scache_config_hash(conn_config));
+  if((len <= 0) || ((size_t)len >= blen - 1))
+    return 0;
+  /* names are compared case insensitively */
+  Curl_strntolower(buf, buf, (size_t)len);
+  return (size_t)len + 1;
+}
+
+/* the shard holding the sessions for `peer` */
+static struct scache_shard *scache_shard(struct Curl_ssl_scache *scache,
+                                         const struct ssl_peer *peer)
+{
+  size_t h;
+
+  if(scache->num_shards == 1)
+    return &scache->shards[0];
+  h = scache_hash_str(SCACHE_HASH_INIT, peer->hostname, TRUE);
+  h = scache_hash_mem(h, &peer->port, sizeof(peer->port), FALSE);
+  return &scache->shards[h % scache->num_shards];
+}
+
+/* called when a session leaves its shard's hash */
+static void scache_session_dtor(void *p)
+{
+  struct Curl_ssl_session *session = p;
+
+  Curl_node_remove(&session->lru);
+  /* free the ID the SSL-layer specific way */
+  session->sessionid_free(session->sessionid, session->idsize);
+  Curl_free_primary_ssl_config(&session->ssl_config);
+  free(session);
+}
+
 /*
- * Lock shared SSL session data
+ * Create a session cache keeping up to `max_sessions`, split into `shards`
+ * parts. Pass 0 or 1 for a cache that is not sharded.
  */
-void Curl_ssl_sessionid_lock(struct Curl_easy *data)
+struct Curl_ssl_scache *Curl_ssl_scache_create(size_t max_sessions,
+                                               size_t shards)
 {
-  if(SSLSESSION_SHARED(data))
+  struct Curl_ssl_scache *scache;
+  size_t i;
+
+  if(!shards)
+    shards = 1;
+  scache = calloc(1, sizeof(*scache));
+  if(!scache)
+    return NULL;
+  scache->shards = calloc(shards, sizeof(struct scache_shard));
+  if(!scache->shards) {
+    free(scache);
+    return NULL;
+  }
+  scache->num_shards = shards;
+  scache->max_per_shard = (max_sessions + shards - 1) / shards;
+  for(i = 0; i < shards; i++) {
+    Curl_hash_init(&scache->shards[i].sessions, 7, Curl_hash_str,
+                   Curl_str_key_compare, scache_session_dtor);
+    Curl_llist_init(&scache->shards[i].lru, NULL);
+  }
+#ifdef SCACHE_SHARDING
+  if(shards > 1) {
+    for(i = 0; i < shards; i++)
+      Curl_mutex_init(&scache->shards[i].mutex);
+    scache->sharded = TRUE;
+  }
+#else
+  DEBUGASSERT(shards == 1);
+#endif
+  return scache;
+}
+
+/*
+ * Free the session cache and all sessions in it.
+ */
+void Curl_ssl_scache_destroy(struct Curl_ssl_scache *scache)
+{
+  size_t i;
+
+  if(!scache)
+    return;
+  for(i = 0; i < scache->num_shards; i++) {
+    Curl_hash_destroy(&scache->shards[i].sessions);
+#ifdef SCACHE_SHARDING
+    if(scache->sharded)
+      Curl_mutex_destroy(&scache->shards[i].mutex);
+#endif
+  }
+  free(scache->shards);
+  free(scache);
+}
+
+/*
+ * Lock shared SSL session data for `peer`
+ */
+void Curl_ssl_sessionid_lock(struct Curl_easy *data,
+                             const struct ssl_peer *peer)
+{
+  if(SSLSESSION_SHARED(data)) {
+#ifdef SCACHE_SHARDING
+    struct Curl_ssl_scache *scache = data->state.session;
+    if(scache && scache->sharded) {
+      Curl_mutex_acquire(&scache_shard(scache, peer)->mutex);
+      return;
+    }
+#endif
+    (void)peer;
     Curl_share_lock(data, CURL_LOCK_DATA_SSL_SESSION, CURL_LOCK_ACCESS_SINGLE);
+  }
 }
 
 /*
- * Unlock shared SSL session data
+ * Unlock shared SSL session data for `peer`
  */
-void Curl_ssl_sessionid_unlock(struct Curl_easy *data)
+void Curl_ssl_sessionid_unlock(struct Curl_easy *data,
+                               const struct ssl_peer *peer)
 {
-  if(SSLSESSION_SHARED(data))
+  if(SSLSESSION_SHARED(data)) {
+#ifdef SCACHE_SHARDING
+    struct Curl_ssl_scache *scache = data->state.session;
+    if(scache && scache->sharded) {
+      Curl_mutex_release(&scache_shard(scache, peer)->mutex);
+      return;
+    }
+#endif
+    (void)peer;
     Curl_share_unlock(data, CURL_LOCK_DATA_SSL_SESSION);
+  }
 }
 
 /*
@@ -531,9 +763,9 @@ bool Curl_ssl_getsessionid(struct Curl_cfilter *cf,
 {
   struct ssl_primary_config *conn_config = Curl_ssl_cf_get_primary_config(cf);
   struct ssl_config_data *ssl_config = Curl_ssl_cf_get_config(cf, data);
-  struct Curl_ssl_session *check;
-  size_t i;
-  long *general_age;
+  struct Curl_ssl_scache *scache = data->state.session;
+  char key[SCACHE_KEY_MAX];
+  size_t keylen;
   bool no_match = TRUE;
 
   *ssl_sessionid = NULL;
@@ -542,41 +774,25 @@ bool Curl_ssl_getsessionid(struct Curl_cfilter *cf,
 
   DEBUGASSERT(ssl_config->primary.cache_session);
 
-  if(!ssl_config->primary.cache_session || !data->state.session)
+  if(!ssl_config->primary.cache_session || !scache)
     /* session ID reuse is disabled or the session cache has not been
        setup */
     return TRUE;
 
-  /* Lock if shared */
-  if(SSLSESSION_SHARED(data))
-    general_age = &data->share->sessionage;
-  else
-    general_age = &data->state.sessionage;
-
-  for(i = 0; i < data->set.general_ssl.max_ssl_sessions; i++) {
-    check = &data->state.session[i];
-    if(!check->sessionid)
-      /* not session ID means blank entry */
-      continue;
-    if(strcasecompare(peer->hostname, check->name) &&
-       ((!cf->conn->bits.conn_to_host && !check->conn_to_host) ||
-        (cf->conn->bits.conn_to_host && check->conn_to_host &&
-         strcasecompare(cf->conn->conn_to_host.name, check->conn_to_host))) &&
-       ((!cf->conn->bits.conn_to_port && check->conn_to_port == -1) ||
-        (cf->conn->bits.conn_to_port && check->conn_to_port != -1 &&
-         cf->conn->conn_to_port == check->conn_to_port)) &&
-       (peer->port == check->remote_port) &&
-       (peer->transport == check->transport) &&
-       strcasecompare(cf->conn->handler->scheme, check->scheme) &&
-       match_ssl_primary_config(data, conn_config, &check->ssl_config)) {
-      /* yes, we have a session ID! */
-      (*general_age)++;          /* increase general age */
-      check->age = *general_age; /* set this as used in this age */
+  keylen = scache_peer_key(cf, peer, conn_config, key, sizeof(key));
+  if(keylen) {
+    struct scache_shard *shard = scache_shard(scache, peer);
+    struct Curl_ssl_session *check =
+      Curl_hash_pick(&shard->sessions, key, keylen);
+    if(check && match_ssl_primary_config(data, conn_config,
+                                         &check->ssl_config)) {
+      /* yes, we have a session ID! It is the most recently used now */
+      Curl_node_remove(&check->lru);
+      Curl_llist_append(&shard->lru, check, &check->lru);
       *ssl_sessionid = check->sessionid;
       if(idsize)
         *idsize = check->idsize;
       no_match = FALSE;
-      break;
     }
   }
 
@@ -587,41 +803,27 @@ bool Curl_ssl_getsessionid(struct Curl_cfilter *cf,
 }
 
 /*
- * Kill a single session ID entry in the cache.
- */
-void Curl_ssl_kill_session(struct Curl_ssl_session *session)
-{
-  if(session->sessionid) {
-    /* defensive check */
-
-    /* free the ID the SSL-layer specific way */
-    session->sessionid_free(session->sessionid, session->idsize);
-
-    session->sessionid = NULL;
-    session->sessionid_free = NULL;
-    session->age = 0; /* fresh */
-
-    Curl_free_primary_ssl_config(&session->ssl_config);
-
-    Curl_safefree(session->name);
-    Curl_safefree(session->conn_to_host);
-  }
-}
-
-/*
- * Delete the given session ID from the cache.
+ * Delete the given session ID for `peer` from the cache.
  */
-void Curl_ssl_delsessionid(struct Curl_easy *data, void *ssl_sessionid)
+void Curl_ssl_delsessionid(struct Curl_cfilter *cf,
+                           struct Curl_easy *data,
+                           const struct ssl_peer *peer,
+                           void *ssl_sessionid)
 {
-  size_t i;
-
-  for(i = 0; i < data->set.general_ssl.max_ssl_sessions; i++) {
-    struct Curl_ssl_session *check = &data->state.session[i];
+  struct ssl_primary_config *conn_config = Curl_ssl_cf_get_primary_config(cf);
+  struct Curl_ssl_scache *scache = data->state.session;
+  char key[SCACHE_KEY_MAX];
+  size_t keylen;
 
-    if(check->sessionid == ssl_sessionid) {
-      Curl_ssl_kill_session(check);
-      break;
-    }
+  if(!scache)
+    return;
+  keylen = scache_peer_key(cf, peer, conn_config, key, sizeof(key));
+  if(keylen) {
+    struct scache_shard *shard = scache_shard(scache, peer);
+    struct Curl_ssl_session *check =
+      Curl_hash_pick(&shard->sessions, key, keylen);
+    if(check && (check->sessionid == ssl_sessionid))
+      Curl_hash_delete(&shard->sessions, key, keylen);
   }
 }
 
@@ -634,13 +836,11 @@ CURLcode Curl_ssl_set_sessionid(struct Curl_cfilter *cf,
 {
   struct ssl_config_data *ssl_config = Curl_ssl_cf_get_config(cf, data);
   struct ssl_primary_config *conn_config = Curl_ssl_cf_get_primary_config(cf);
-  size_t i;
+  struct Curl_ssl_scache *scache = data->state.session;
+  struct scache_shard *shard;
   struct Curl_ssl_session *store;
-  long oldest_age;
-  char *clone_host = NULL;
-  char *clone_conn_to_host = NULL;
-  int conn_to_port;
-  long *general_age;
+  char key[SCACHE_KEY_MAX];
+  size_t keylen;
   void *old_sessionid;
   size_t old_size;
   CURLcode result = CURLE_OUT_OF_MEMORY;
@@ -648,7 +848,7 @@ CURLcode Curl_ssl_set_sessionid(struct Curl_cfilter *cf,
   DEBUGASSERT(ssl_sessionid);
   DEBUGASSERT(sessionid_free_cb);
 
-  if(!data->state.session) {
+  if(!scache || !scache->max_per_shard) {
     sessionid_free_cb(ssl_sessionid, idsize);
     return CURLE_OK;
   }
@@ -661,95 +861,252 @@ CURLcode Curl_ssl_set_sessionid(struct Curl_cfilter *cf,
       sessionid_free_cb(ssl_sessionid, idsize);
       return CURLE_OK;
     }
-    Curl_ssl_delsessionid(data, old_sessionid);
   }
 
-  store = &data->state.session[0];
-  oldest_age = data->state.session[0].age; /* zero if unused */
   DEBUGASSERT(ssl_config->primary.cache_session);
   (void)ssl_config;
 
-  clone_host = strdup(peer->hostname);
-  if(!clone_host)
-    goto out;
-
-  if(cf->conn->bits.conn_to_host) {
-    clone_conn_to_host = strdup(cf->conn->conn_to_host.name);
-    if(!clone_conn_to_host)
-      goto out;
+  keylen = scache_peer_key(cf, peer, conn_config, key, sizeof(key));
+  if(!keylen) {
+    /* too long a name to remember */
+    sessionid_free_cb(ssl_sessionid, idsize);
+    return CURLE_OK;
   }
+  shard = scache_shard(scache, peer);
 
-  if(cf->conn->bits.conn_to_port)
-    conn_to_port = cf->conn->conn_to_port;
-  else
-    conn_to_port = -1;
-
-  /* Now we should add the session ID and the hostname to the cache, (remove
-     the oldest if necessary) */
-
-  /* If using shared SSL session, lock! */
-  if(SSLSESSION_SHARED(data)) {
-    general_age = &data->share->sessionage;
-  }
-  else {
-    general_age = &data->state.sessionage;
+  /* replace the session cached for this key, if any, and remove the least
+     recently used ones if the shard is full */
+  Curl_hash_delete(&shard->sessions, key, keylen);
+  while(Curl_llist_count(&shard->lru) >= scache->max_per_shard) {
+    struct Curl_ssl_session *oldest =
+      Curl_node_elem(Curl_llist_head(&shard->lru));
+    Curl_hash_delete(&shard->sessions, oldest->key, oldest->keylen);
   }
 
-  /* find an empty slot for us, or find the oldest */
-  for(i = 1; (i < data->set.general_ssl.max_ssl_sessions) &&
-        data->state.session[i].sessionid; i++) {
-    if(data->state.session[i].age < oldest_age) {
-      oldest_age = data->state.session[i].age;
-      store = &data->state.session[i];
-    }
-  }
-  if(i == data->set.general_ssl.max_ssl_sessions)
-    /* cache is full, we must "kill" the oldest entry! */
-    Curl_ssl_kill_session(store);
-  else
-    store = &data->state.session[i]; /* use this slot */
+  store = calloc(1, sizeof(*store) + keylen);
+  if(!store)
+    goto out;
+  memcpy(store->key, key, keylen);
+  store->keylen = keylen;
 
   /* now init the session struct wisely */
   if(!clone_ssl_primary_config(conn_config, &store->ssl_config)) {
     Curl_free_primary_ssl_config(&store->ssl_config);
-    store->sessionid = NULL; /* let caller free sessionid */
+    free(store);
     goto out;
   }
   store->sessionid = ssl_sessionid;
   store->idsize = idsize;
   store->sessionid_free = sessionid_free_cb;
-  store->age = *general_age;    /* set current age */
-  /* free it if there is one already present */
-  free(store->name);
-  free(store->conn_to_host);
-  store->name = clone_host;               /* clone hostname */
-  clone_host = NULL;
-  store->conn_to_host = clone_conn_to_host; /* clone connect to hostname */
-  clone_conn_to_host = NULL;
-  store->conn_to_port = conn_to_port; /* connect to port number */
-  /* port number */
-  store->remote_port = peer->port;
-  store->scheme = cf->conn->handler->scheme;
-  store->transport = peer->transport;
 
+  if(Curl_hash_add(&shard->sessions, key, keylen, store) != store) {
+    Curl_free_primary_ssl_config(&store->ssl_config);
+    free(store);
+    goto out;
+  }
+  Curl_llist_append(&shard->lru, store, &store->lru);
   result = CURLE_OK;
 
 out:
-  free(clone_host);
-  free(clone_conn_to_host);
   if(result) {
     failf(data, "Failed to add Session ID to cache for %s://%s:%d [%s]",
-          store->scheme, store->name, store->remote_port,
+          cf->conn->handler->scheme, peer->hostname, peer->port,
           Curl_ssl_cf_is_proxy(cf) ? "PROXY" : "server");
     sessionid_free_cb(ssl_sessionid, idsize);
     return result;
   }
   CURL_TRC_CF(data, cf, "Added Session ID to cache for %s://%s:%d [%s]",
-              store->scheme, store->name, store->remote_port,
+              cf->conn->handler->scheme, peer->hostname, peer->port,
               Curl_ssl_cf_is_proxy(cf) ? "PROXY" : "server");
   return CURLE_OK;
 }
 
+/* key to use at `multi->proto_hash` */
+#define MPROTO_SSL_CTX_KEY "tls:ctx:cache"
+
+/* the most TLS backend contexts a multi handle keeps */
+#define SSL_CTX_CACHE_MAX 8
+
+/* a TLS backend context, set up for one primary config */
+struct ssl_ctx_entry {
+  struct Curl_llist_node lru;       /* in the cache's list of contexts */
+  struct ssl_primary_config config; /* the config `ctx` was set up for */
+  void *ctx;                        /* the reference the cache holds */
+  Curl_ssl_ctx_free_cb *ctx_free;   /* drops that reference */
+  struct curltime created;
+  size_t keylen;                    /* length of `key` */
+  char key[1];                      /* the key the context is cached by */
+};
+
+struct ssl_ctx_cache {
+  struct Curl_hash entries; /* key to ssl_ctx_entry */
+  struct Curl_llist lru;    /* the contexts, least recently used first */
+};
+
+/* called when a context leaves the cache's hash */
+static void ssl_ctx_entry_dtor(void *p)
+{
+  struct ssl_ctx_entry *entry = p;
+
+  Curl_node_remove(&entry->lru);
+  entry->ctx_free(entry->ctx);
+  Curl_free_primary_ssl_config(&entry->config);
+  free(entry);
+}
+
+static void ssl_ctx_cache_free(void *key, size_t key_len, void *p)
+{
+  struct ssl_ctx_cache *cache = p;
+  DEBUGASSERT(key_len == (sizeof(MPROTO_SSL_CTX_KEY)-1));
+  DEBUGASSERT(!memcmp(MPROTO_SSL_CTX_KEY, key, key_len));
+  (void)key;
+  (void)key_len;
+  Curl_hash_destroy(&cache->entries);
+  free(cache);
+}
+
+/*
+ * Write the key contexts of backend `name` for the filter's config and
+ * the backend's `extra` bytes are cached by into `buf`. Returns the length
+ * of the key, 0 if it does not fit.
+ */
+static size_t ssl_ctx_key(struct Curl_cfilter *cf, const char *name,
+                          int transport, const void *extra, size_t extra_len,
+                          char *buf, size_t blen)
+{
+  struct ssl_primary_config *conn_config = Curl_ssl_cf_get_primary_config(cf);
+  int len;
+
+  len = msnprintf(buf, blen, "%s/%d/%zx/", name, transport,
+                  scache_config_hash(conn_config));
+  if((len <= 0) || ((size_t)len + extra_len >= blen))
+    return 0;
+  if(extra_len)
+    memcpy(buf + len, extra, extra_len);
+  return (size_t)len + extra_len;
+}
+
+static bool ssl_ctx_expired(const struct Curl_easy *data,
+                            const struct ssl_ctx_entry *entry)
+{
+  const struct ssl_general_config *cfg = &data->set.general_ssl;
+  if(cfg->ca_cache_timeout < 0)
+    return FALSE;
+  return Curl_timediff(Curl_now(), entry->created) >=
+    cfg->ca_cache_timeout * (timediff_t)1000;
+}
+
+void *Curl_ssl_ctx_get(struct Curl_cfilter *cf,
+                       struct Curl_easy *data,
+                       const char *name, int transport,
+                       const void *extra, size_t extra_len)
+{
+  struct ssl_primary_config *conn_config = Curl_ssl_cf_get_primary_config(cf);
+  struct ssl_ctx_cache *cache;
+  struct ssl_ctx_entry *entry;
+  char key[SCACHE_KEY_MAX];
+  size_t keylen;
+
+  if(!data->multi || !data->set.general_ssl.ca_cache_timeout)
+    return NULL;
+  cache = Curl_hash_pick(&data->multi->proto_hash,
+                         (void *)MPROTO_SSL_CTX_KEY,
+                         sizeof(MPROTO_SSL_CTX_KEY)-1);
+  if(!cache)
+    return NULL;
+  keylen = ssl_ctx_key(cf, name, transport, extra, extra_len,
+                       key, sizeof(key));
+  if(!keylen)
+    return NULL;
+  entry = Curl_hash_pick(&cache->entries, key, keylen);
+  if(!entry || !match_ssl_primary_config(data, conn_config, &entry->config))
+    return NULL;
+  if(ssl_ctx_expired(data, entry)) {
+    Curl_hash_delete(&cache->entries, key, keylen);
+    return NULL;
+  }
+  /* most recently used now */
+  Curl_node_remove(&entry->lru);
+  Curl_llist_append(&cache->lru, entry, &entry->lru);
+  return entry->ctx;
+}
+
+void Curl_ssl_ctx_add(struct Curl_cfilter *cf,
+                      struct Curl_easy *data,
+                      const char *name, int transport,
+                      const void *extra, size_t extra_len,
+                      void *ctx, Curl_ssl_ctx_free_cb *ctx_free)
+{
+  struct ssl_primary_config *conn_config = Curl_ssl_cf_get_primary_config(cf);
+  struct Curl_multi *multi = data->multi;
+  struct ssl_ctx_cache *cache;
+  struct ssl_ctx_entry *entry;
+  char key[SCACHE_KEY_MAX];
+  size_t keylen;
+
+  DEBUGASSERT(ctx);
+  DEBUGASSERT(ctx_free);
+  keylen = ssl_ctx_key(cf, name, transport, extra, extra_len,
+                       key, sizeof(key));
+  if(!multi || !data->set.general_ssl.ca_cache_timeout || !keylen)
+    goto fail;
+
+  cache = Curl_hash_pick(&multi->proto_hash,
+                         (void *)MPROTO_SSL_CTX_KEY,
+                         sizeof(MPROTO_SSL_CTX_KEY)-1);
+  if(!cache) {
+    cache = calloc(1, sizeof(*cache));
+    if(!cache)
+      goto fail;
+    Curl_hash_init(&cache->entries, SSL_CTX_CACHE_MAX, Curl_hash_str,
+                   Curl_str_key_compare, ssl_ctx_entry_dtor);
+    Curl_llist_init(&cache->lru, NULL);
+    if(!Curl_hash_add2(&multi->proto_hash,
+                       (void *)MPROTO_SSL_CTX_KEY,
+                       sizeof(MPROTO_SSL_CTX_KEY)-1,
+                       cache, ssl_ctx_cache_free)) {
+      Curl_hash_destroy(&cache->entries);
+      free(cache);
+      goto fail;
+    }
+  }
+
+  /* replace the context cached for this key, if any, and remove the least
+     recently used ones if the cache is full */
+  Curl_hash_delete(&cache->entries, key, keylen);
+  while(Curl_llist_count(&cache->lru) >= SSL_CTX_CACHE_MAX) {
+    struct ssl_ctx_entry *oldest =
+      Curl_node_elem(Curl_llist_head(&cache->lru));
+    Curl_hash_delete(&cache->entries, oldest->key, oldest->keylen);
+  }
+
+  entry = calloc(1, sizeof(*entry) + keylen);
+  if(!entry)
+    goto fail;
+  memcpy(entry->key, key, keylen);
+  entry->keylen = keylen;
+  if(!clone_ssl_primary_config(conn_config, &entry->config)) {
+    Curl_free_primary_ssl_config(&entry->config);
+    free(entry);
+    goto fail;
+  }
+  entry->ctx = ctx;
+  entry->ctx_free = ctx_free;
+  entry->created = Curl_now();
+
+  if(Curl_hash_add(&cache->entries, key, keylen, entry) != entry) {
+    Curl_free_primary_ssl_config(&entry->config);
+    free(entry);
+    goto fail;
+  }
+  Curl_llist_append(&cache->lru, entry, &entry->lru);
+  CURL_TRC_CF(data, cf, "added %s context to cache", name);
+  return;
+
+fail:
+  ctx_free(ctx);
+}
+
 CURLcode Curl_ssl_get_channel_binding(struct Curl_easy *data, int sockindex,
                                        struct dynbuf *binding)
 {
@@ -762,13 +1119,8 @@ void Curl_ssl_close_all(struct Curl_easy *data)
 {
   /* kill the session ID cache if not shared */
   if(data->state.session && !SSLSESSION_SHARED(data)) {
-    size_t i;
-    for(i = 0; i < data->set.general_ssl.max_ssl_sessions; i++)
-      /* the single-killer function handles empty table slots */
-      Curl_ssl_kill_session(&data->state.session[i]);
-
-    /* free the cache data */
-    Curl_safefree(data->state.session);
+    Curl_ssl_scache_destroy(data->state.session);
+    data->state.session = NULL;
   }
 
   Curl_ssl->close_all(data);
@@ -822,20 +1174,19 @@ struct curl_slist *Curl_ssl_engines_list(struct Curl_easy *data)
  */
 CURLcode Curl_ssl_initsessions(struct Curl_easy *data, size_t amount)
 {
-  struct Curl_ssl_session *session;
+  struct Curl_ssl_scache *scache;
 
   if(data->state.session)
     /* this is just a precaution to prevent multiple inits */
     return CURLE_OK;
 
-  session = calloc(amount, sizeof(struct Curl_ssl_session));
-  if(!session)
+  scache = Curl_ssl_scache_create(amount, 1);
+  if(!scache)
     return CURLE_OUT_OF_MEMORY;
 
   /* store the info in the SSL section */
   data->set.general_ssl.max_ssl_sessions = amount;
-  data->state.session = session;
-  data->state.sessionage = 1; /* this is brand new */
+  data->state.session = scache;
   return CURLE_OK;
 }
 
@@ -28,7 +28,8 @@
 struct connectdata;
 struct ssl_config_data;
 struct ssl_primary_config;
-struct Curl_ssl_session;
+struct ssl_peer;
+struct Curl_ssl_scache;
 
 #define SSLSUPP_CA_PATH      (1<<0) /* supports CAPATH */
 #define SSLSUPP_CERTINFO     (1<<1) /* supports CURLOPT_CERTINFO */
@@ -129,6 +130,17 @@ struct curl_slist *Curl_ssl_engines_list(struct Curl_easy *data);
 
 /* init the SSL session ID cache */
 CURLcode Curl_ssl_initsessions(struct Curl_easy *, size_t);
+
+/* Create a session ID cache keeping up to `max_sessions`. A cache owned by
+ * a share may be split into `shards` parts that are locked independently.
+ * Pass 0 or 1 for a cache using the share lock. Returns NULL on OOM. */
+struct Curl_ssl_scache *Curl_ssl_scache_create(size_t max_sessions,
+                                               size_t shards);
+/* Free a session ID cache and the sessions in it */
+void Curl_ssl_scache_destroy(struct Curl_ssl_scache *scache);
+
+/* The maximum number of shards a session ID cache may be split into. */
+#define SSL_SCACHE_MAX_SHARDS 256
 void Curl_ssl_version(char *buffer, size_t size);
 
 /* Certificate information list handling. */
@@ -144,32 +156,19 @@ CURLcode Curl_ssl_push_certinfo(struct Curl_easy *data, int certnum,
 
 /* Functions to be used by SSL library adaptation functions */
 
-/* Lock session cache mutex.
+/* Lock session cache mutex for the sessions of `peer`.
  * Call this before calling other Curl_ssl_*session* functions
  * Caller should unlock this mutex as soon as possible, as it may block
  * other SSL connection from making progress.
  * The purpose of explicitly locking SSL session cache data is to allow
  * individual SSL engines to manage session lifetime in their specific way.
  */
-void Curl_ssl_sessionid_lock(struct Curl_easy *data);
-
-/* Unlock session cache mutex */
-void Curl_ssl_sessionid_unlock(struct Curl_easy *data);
+void Curl_ssl_sessionid_lock(struct Curl_easy *data,
+                             const struct ssl_peer *peer);
 
-/* Kill a single session ID entry in the cache
- * Sessionid mutex must be locked (see Curl_ssl_sessionid_lock).
- * This will call engine-specific curlssl_session_free function, which must
- * take sessionid object ownership from sessionid cache
- * (e.g. decrement refcount).
- */
-void Curl_ssl_kill_session(struct Curl_ssl_session *session);
-/* delete a session from the cache
- * Sessionid mutex must be locked (see Curl_ssl_sessionid_lock).
- * This will call engine-specific curlssl_session_free function, which must
- * take sessionid object ownership from sessionid cache
- * (e.g. decrement refcount).
- */
-void Curl_ssl_delsessionid(struct Curl_easy *data, void *ssl_sessionid);
+/* Unlock session cache mutex for the sessions of `peer` */
+void Curl_ssl_sessionid_unlock(struct Curl_easy *data,
+                               const struct ssl_peer *peer);
 
 /* get N random bytes into the buffer */
 CURLcode Curl_ssl_random(struct Curl_easy *data, unsigned char *buffer,
@@ -264,7 +263,6 @@ extern struct Curl_cftype Curl_cft_ssl_proxy;
 #define Curl_ssl_engines_list(x) NULL
 #define Curl_ssl_initsessions(x,y) CURLE_OK
 #define Curl_ssl_free_certinfo(x) Curl_nop_stmt
-#define Curl_ssl_kill_session(x) Curl_nop_stmt
 #define Curl_ssl_random(x,y,z) ((void)x, CURLE_NOT_BUILT_IN)
 #define Curl_ssl_cert_status_request() FALSE
 #define Curl_ssl_false_start(a) FALSE
@@ -200,6 +200,17 @@ bool Curl_ssl_getsessionid(struct Curl_cfilter *cf,
                            void **ssl_sessionid,
                            size_t *idsize); /* set 0 if unknown */
 
+/* delete a session of `peer` from the cache
+ * Sessionid mutex must be locked (see Curl_ssl_sessionid_lock).
+ * This will call engine-specific curlssl_session_free function, which must
+ * take sessionid object ownership from sessionid cache
+ * (e.g. decrement refcount).
+ */
+void Curl_ssl_delsessionid(struct Curl_cfilter *cf,
+                           struct Curl_easy *data,
+                           const struct ssl_peer *peer,
+                           void *ssl_sessionid);
+
 /* Set a TLS session ID for `peer`. Replaces an existing session ID if
  * not already the very same.
  * Sessionid mutex must be locked (see Curl_ssl_sessionid_lock).
@@ -216,6 +227,30 @@ CURLcode Curl_ssl_set_sessionid(struct Curl_cfilter *cf,
                                 size_t sessionid_size,
                                 Curl_ssl_sessionid_dtor *sessionid_free_cb);
 
+/* Drops a reference to a TLS backend context. */
+typedef void Curl_ssl_ctx_free_cb(void *ctx);
+
+/* Get the context of backend `name` set up for the filter's config and
+ * the backend's own `extra` settings from the multi handle's cache, NULL
+ * if there is none. The context stays owned by the cache, a caller that
+ * keeps it must take its own reference.
+ */
+void *Curl_ssl_ctx_get(struct Curl_cfilter *cf,
+                       struct Curl_easy *data,
+                       const char *name, int transport,
+                       const void *extra, size_t extra_len);
+
+/* Add a context for the filter's config and `extra` to the multi handle's
+ * cache, for at most CURLOPT_CA_CACHE_TIMEOUT seconds. Takes over one
+ * reference to `ctx`, dropped with `ctx_free` when the context leaves the
+ * cache or could not be added.
+ */
+void Curl_ssl_ctx_add(struct Curl_cfilter *cf,
+                      struct Curl_easy *data,
+                      const char *name, int transport,
+                      const void *extra, size_t extra_len,
+                      void *ctx, Curl_ssl_ctx_free_cb *ctx_free);
+
 #include "openssl.h"        /* OpenSSL versions */
 #include "gtls.h"           /* GnuTLS versions */
 #include "wolfssl.h"        /* wolfSSL versions */
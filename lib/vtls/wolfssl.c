@@ -1056,18 +1056,18 @@ wolfssl_connect_step1(struct Curl_cfilter *cf, struct Curl_easy *data)
   if(ssl_config->primary.cache_session) {
     void *ssl_sessionid = NULL;
 
-    Curl_ssl_sessionid_lock(data);
+    Curl_ssl_sessionid_lock(data, &connssl->peer);
     if(!Curl_ssl_getsessionid(cf, data, &connssl->peer,
                               &ssl_sessionid, NULL)) {
       /* we got a session id, use it! */
       if(!SSL_set_session(backend->handle, ssl_sessionid)) {
-        Curl_ssl_delsessionid(data, ssl_sessionid);
+        Curl_ssl_delsessionid(cf, data, &connssl->peer, ssl_sessionid);
         infof(data, "cannot use session ID, going on without");
       }
       else
         infof(data, "SSL reusing session ID");
     }
-    Curl_ssl_sessionid_unlock(data);
+    Curl_ssl_sessionid_unlock(data, &connssl->peer);
   }
 
 #ifdef USE_ECH
@@ -1454,12 +1454,12 @@ wolfssl_connect_step3(struct Curl_cfilter *cf, struct Curl_easy *data)
     WOLFSSL_SESSION *our_ssl_sessionid = wolfSSL_get1_session(backend->handle);
 
     if(our_ssl_sessionid) {
-      Curl_ssl_sessionid_lock(data);
+      Curl_ssl_sessionid_lock(data, &connssl->peer);
       /* call takes ownership of `our_ssl_sessionid` */
       result = Curl_ssl_set_sessionid(cf, data, &connssl->peer,
                                       our_ssl_sessionid, 0,
                                       wolfssl_session_free);
-      Curl_ssl_sessionid_unlock(data);
+      Curl_ssl_sessionid_unlock(data, &connssl->peer);
       if(result) {
         failf(data, "failed to store ssl session");
         return result;
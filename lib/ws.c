@@ -636,38 +636,102 @@ static ssize_t ws_enc_write_head(struct Curl_easy *data,
   return n;
 }
 
+/* Copy `len` bytes from `src` to `dst`, XOR-ing them with the mask that
+ * starts at `mask[*pxori]`. Since the mask repeats every 4 bytes, the bulk
+ * is done a machine word at a time with the mask spread over a word. */
+static void ws_mask(unsigned char *dst, const unsigned char *src, size_t len,
+                    const unsigned char *mask, unsigned int *pxori)
+{
+  unsigned int xori = *pxori;
+  size_t i = 0;
+
+  if(len >= 2 * sizeof(size_t)) {
+    unsigned char mbytes[sizeof(size_t)];
+    size_t mword, word;
+
+    for(i = 0; i < sizeof(mbytes); ++i)
+      mbytes[i] = mask[(xori + i) & 3];
+    memcpy(&mword, mbytes, sizeof(mword));
+    /* a word's length is a multiple of 4, `xori` stays where it is */
+    for(i = 0; i + sizeof(word) <= len; i += sizeof(word)) {
+      memcpy(&word, src + i, sizeof(word));
+      word ^= mword;
+      memcpy(dst + i, &word, sizeof(word));
+    }
+  }
+  for(; i < len; ++i) {
+    dst[i] = src[i] ^ mask[xori];
+    xori = (xori + 1) & 3;
+  }
+  *pxori = xori;
+}
+
+struct ws_mask_src {
+  struct ws_encoder *enc;
+  const unsigned char *buf;
+  size_t len;
+};
+
+/* bufq reader, masks payload straight into the space of a chunk */
+static ssize_t ws_mask_read(void *reader_ctx, unsigned char *buf, size_t len,
+                            CURLcode *err)
+{
+  struct ws_mask_src *src = reader_ctx;
+
+  if(len > src->len)
+    len = src->len;
+  ws_mask(buf, src->buf, len, src->enc->mask, &src->enc->xori);
+  src->buf += len;
+  src->len -= len;
+  *err = CURLE_OK;
+  return (ssize_t)len;
+}
+
 static ssize_t ws_enc_write_payload(struct ws_encoder *enc,
                                     struct Curl_easy *data,
                                     const unsigned char *buf, size_t buflen,
                                     struct bufq *out, CURLcode *err)
 {
+  struct ws_mask_src src;
   ssize_t n;
-  size_t i, len;
+  size_t len;
 
   if(Curl_bufq_is_full(out)) {
     *err = CURLE_AGAIN;
     return -1;
   }
 
-  /* not the most performant way to do this */
   len = buflen;
   if((curl_off_t)len > enc->payload_remain)
     len = (size_t)enc->payload_remain;
 
-  for(i = 0; i < len; ++i) {
-    unsigned char c = buf[i] ^ enc->mask[enc->xori];
-    n = Curl_bufq_write(out, &c, 1, err);
-    if(n < 0) {
-      if((*err != CURLE_AGAIN) || !i)
+  src.enc = enc;
+  src.buf = buf;
+  src.len = len;
+  while(src.len) {
+    n = Curl_bufq_sipn(out, src.len, ws_mask_read, &src, err);
+    if(n <= 0) {
+      if((n < 0) && ((*err != CURLE_AGAIN) || (src.len == len)))
         return -1;
       break;
     }
-    enc->xori++;
-    enc->xori &= 3;
   }
-  enc->payload_remain -= (curl_off_t)i;
+  len -= src.len;
+  enc->payload_remain -= (curl_off_t)len;
   ws_enc_info(enc, data, "buffered");
-  return (ssize_t)i;
+  return (ssize_t)len;
+}
+
+/* Take back the last `len` payload bytes written to `out`. */
+static CURLcode ws_enc_unwrite_payload(struct ws_encoder *enc,
+                                       struct bufq *out, size_t len)
+{
+  CURLcode result = Curl_bufq_unwrite(out, len);
+  if(!result) {
+    enc->payload_remain += (curl_off_t)len;
+    enc->xori = (unsigned int)((enc->xori + 4 - (len & 3)) & 3);
+  }
+  return result;
 }
 
 
@@ -781,11 +845,15 @@ CURLcode Curl_ws_accept(struct Curl_easy *data,
                     BUFQ_OPT_SOFT_LIMIT);
     Curl_bufq_init2(&ws->sendbuf, chunk_size, WS_CHUNK_COUNT,
                     BUFQ_OPT_SOFT_LIMIT);
+    Curl_dyn_init(&ws->msg, DYN_WS_MESSAGE);
     ws_dec_init(&ws->dec);
     ws_enc_init(&ws->enc);
   }
   else {
     Curl_bufq_reset(&ws->recvbuf);
+    Curl_dyn_reset(&ws->msg);
+    ws->msg_flags = 0;
+    ws->leased = FALSE;
     ws_dec_reset(&ws->dec);
     ws_enc_reset(&ws->enc);
   }
@@ -924,14 +992,12 @@ static ssize_t nw_in_recv(void *reader_ctx,
   return (ssize_t)nread;
 }
 
-CURL_EXTERN CURLcode curl_ws_recv(struct Curl_easy *data, void *buffer,
-                                  size_t buflen, size_t *nread,
-                                  const struct curl_ws_frame **metap)
+/* the websocket of the connection the CONNECT_ONLY transfer uses */
+static CURLcode ws_recv_get(struct Curl_easy *data, struct websocket **pws)
 {
   struct connectdata *conn = data->conn;
-  struct websocket *ws;
-  struct ws_collect ctx;
 
+  *pws = NULL;
   if(!conn) {
     /* Unhappy hack with lifetimes of transfers and connection */
     if(!data->set.connect_only) {
@@ -945,14 +1011,49 @@ CURL_EXTERN CURLcode curl_ws_recv(struct Curl_easy *data, void *buffer,
       return CURLE_BAD_FUNCTION_ARGUMENT;
     }
   }
-  ws = conn->proto.ws;
-  if(!ws) {
+  *pws = conn->proto.ws;
+  if(!*pws) {
     failf(data, "connection is not setup for websocket");
     return CURLE_BAD_FUNCTION_ARGUMENT;
   }
+  return CURLE_OK;
+}
+
+/* receive more from the network into the empty `recvbuf` */
+static CURLcode ws_recv_more(struct Curl_easy *data, struct websocket *ws)
+{
+  CURLcode result;
+  ssize_t n = Curl_bufq_slurp(&ws->recvbuf, nw_in_recv, data, &result);
+
+  if(n < 0)
+    return result;
+  else if(n == 0) {
+    /* connection closed */
+    infof(data, "connection expectedly closed?");
+    return CURLE_GOT_NOTHING;
+  }
+  CURL_TRC_WS(data, "curl_ws_recv, added %zu bytes from network",
+              Curl_bufq_len(&ws->recvbuf));
+  return CURLE_OK;
+}
+
+CURL_EXTERN CURLcode curl_ws_recv(struct Curl_easy *data, void *buffer,
+                                  size_t buflen, size_t *nread,
+                                  const struct curl_ws_frame **metap)
+{
+  struct websocket *ws;
+  struct ws_collect ctx;
+  CURLcode result;
 
   *nread = 0;
   *metap = NULL;
+  result = ws_recv_get(data, &ws);
+  if(result)
+    return result;
+  if(ws->leased) {
+    failf(data, "WS: the last lease has not been released");
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  }
 
   memset(&ctx, 0, sizeof(ctx));
   ctx.data = data;
@@ -960,21 +1061,11 @@ CURL_EXTERN CURLcode curl_ws_recv(struct Curl_easy *data, void *buffer,
   ctx.buflen = buflen;
 
   while(1) {
-    CURLcode result;
-
     /* receive more when our buffer is empty */
     if(Curl_bufq_is_empty(&ws->recvbuf)) {
-      ssize_t n = Curl_bufq_slurp(&ws->recvbuf, nw_in_recv, data, &result);
-      if(n < 0) {
+      result = ws_recv_more(data, ws);
+      if(result)
         return result;
-      }
-      else if(n == 0) {
-        /* connection closed */
-        infof(data, "connection expectedly closed?");
-        return CURLE_GOT_NOTHING;
-      }
-      CURL_TRC_WS(data, "curl_ws_recv, added %zu bytes from network",
-                  Curl_bufq_len(&ws->recvbuf));
     }
 
     result = ws_dec_pass(&ws->dec, data, &ws->recvbuf,
@@ -1008,6 +1099,145 @@ CURL_EXTERN CURLcode curl_ws_recv(struct Curl_easy *data, void *buffer,
   return CURLE_OK;
 }
 
+/* Done with `len` bytes of the current frame's payload in `recvbuf`. */
+static void ws_recv_consume(struct websocket *ws, size_t len)
+{
+  Curl_bufq_skip(&ws->recvbuf, len);
+  ws->dec.payload_offset += (curl_off_t)len;
+  if(ws->dec.payload_offset == ws->dec.payload_len)
+    ws->dec.state = WS_DEC_INIT;
+}
+
+CURL_EXTERN CURLcode curl_ws_recv_lease(CURL *d, const void **bufp,
+                                        size_t *nread,
+                                        const struct curl_ws_frame **metap,
+                                        unsigned int flags)
+{
+  struct Curl_easy *data = d;
+  struct websocket *ws;
+  struct ws_decoder *dec;
+  const unsigned char *inbuf;
+  size_t inlen;
+  curl_off_t remain;
+  CURLcode result;
+
+  *bufp = NULL;
+  *nread = 0;
+  *metap = NULL;
+  result = ws_recv_get(data, &ws);
+  if(result)
+    return result;
+  if(ws->leased) {
+    failf(data, "WS: the last lease has not been released");
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  }
+  dec = &ws->dec;
+
+  while(1) {
+    if(Curl_bufq_is_empty(&ws->recvbuf)) {
+      result = ws_recv_more(data, ws);
+      if(result)
+        return result;
+    }
+
+    if(dec->state != WS_DEC_PAYLOAD) {
+      if(dec->state == WS_DEC_INIT) {
+        ws_dec_reset(dec);
+        dec->state = WS_DEC_HEAD;
+      }
+      result = ws_dec_read_head(dec, data, &ws->recvbuf);
+      if(result == CURLE_AGAIN)
+        continue; /* incomplete frame head, need more input */
+      else if(result)
+        return result;
+      dec->state = WS_DEC_PAYLOAD;
+    }
+
+    remain = dec->payload_len - dec->payload_offset;
+    inbuf = (const unsigned char *)"";
+    inlen = 0;
+    if(remain && !Curl_bufq_peek(&ws->recvbuf, &inbuf, &inlen))
+      continue;
+    if((curl_off_t)inlen > remain)
+      inlen = (size_t)remain;
+
+    if((dec->frame_flags & CURLWS_PING) && ((curl_off_t)inlen == remain)) {
+      /* auto-respond to PINGs, like curl_ws_recv() */
+      size_t sent;
+      infof(data, "WS: auto-respond to PING with a PONG");
+      result = curl_ws_send(data, inbuf, inlen, &sent, 0, CURLWS_PONG);
+      if(result)
+        return result;
+      ws_recv_consume(ws, inlen);
+      continue;
+    }
+
+    if((flags & CURLWS_LEASE_MESSAGE) &&
+       (dec->frame_flags & (CURLWS_TEXT|CURLWS_BINARY|CURLWS_CONT)) &&
+       (ws->msg_flags || !(dec->head[0] & WSBIT_FIN) ||
+        dec->payload_offset || ((curl_off_t)inlen != remain))) {
+      /* A message that is not one complete frame in the buffer,
+       * collect it until its final fragment. */
+      if(!ws->msg_flags)
+        ws->msg_flags = dec->frame_flags;
+      result = Curl_dyn_addn(&ws->msg, inbuf, inlen);
+      if(result) {
+        failf(data, "WS: message too large to reassemble");
+        ws->msg_flags = 0;
+        return result;
+      }
+      ws_recv_consume(ws, inlen);
+      if((dec->state != WS_DEC_INIT) || !(dec->head[0] & WSBIT_FIN))
+        continue;
+      update_meta(ws, 0, ws->msg_flags & ~CURLWS_CONT, 0,
+                  (curl_off_t)Curl_dyn_len(&ws->msg), Curl_dyn_len(&ws->msg));
+      *bufp = Curl_dyn_len(&ws->msg) ? Curl_dyn_uptr(&ws->msg) : inbuf;
+      ws->lease_msg = TRUE;
+      ws->lease_len = 0;
+    }
+    else {
+      /* lend the frame's payload where it is in the buffer */
+      update_meta(ws, dec->frame_age, dec->frame_flags, dec->payload_offset,
+                  dec->payload_len, inlen);
+      *bufp = inbuf;
+      ws->lease_msg = FALSE;
+      ws->lease_len = inlen;
+    }
+    break;
+  }
+
+  ws->leased = TRUE;
+  *metap = &ws->frame;
+  *nread = ws->frame.len;
+  CURL_TRC_WS(data, "curl_ws_recv_lease() -> %zu bytes (frame at %"
+              FMT_OFF_T ", %" FMT_OFF_T " left)",
+              *nread, ws->frame.offset, ws->frame.bytesleft);
+  return CURLE_OK;
+}
+
+CURL_EXTERN CURLcode curl_ws_recv_release(CURL *d)
+{
+  struct Curl_easy *data = d;
+  struct websocket *ws;
+  CURLcode result;
+
+  result = ws_recv_get(data, &ws);
+  if(result)
+    return result;
+  if(!ws->leased) {
+    failf(data, "WS: no lease to release");
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  }
+  if(ws->lease_msg) {
+    Curl_dyn_reset(&ws->msg);
+    ws->msg_flags = 0;
+  }
+  else
+    ws_recv_consume(ws, ws->lease_len);
+  ws->leased = FALSE;
+  return CURLE_OK;
+}
+
 static CURLcode ws_flush(struct Curl_easy *data, struct websocket *ws,
                          bool blocking)
 {
@@ -1248,7 +1478,7 @@ CURL_EXTERN CURLcode curl_ws_send(CURL *data, const void *buffer,
        * sent. This partial success should make the caller invoke us again
        * with the last byte. */
       *sent = payload_added - 1;
-      result = Curl_bufq_unwrite(&ws->sendbuf, 1);
+      result = ws_enc_unwrite_payload(&ws->enc, &ws->sendbuf, 1);
       if(!result)
         result = CURLE_AGAIN;
     }
@@ -1266,6 +1496,7 @@ static void ws_free(struct connectdata *conn)
   if(conn && conn->proto.ws) {
     Curl_bufq_free(&conn->proto.ws->recvbuf);
     Curl_bufq_free(&conn->proto.ws->sendbuf);
+    Curl_dyn_free(&conn->proto.ws->msg);
     Curl_safefree(conn->proto.ws);
   }
 }
@@ -1366,6 +1597,25 @@ CURL_EXTERN CURLcode curl_ws_recv(CURL *curl, void *buffer, size_t buflen,
   return CURLE_NOT_BUILT_IN;
 }
 
+CURL_EXTERN CURLcode curl_ws_recv_lease(CURL *curl, const void **bufp,
+                                        size_t *nread,
+                                        const struct curl_ws_frame **metap,
+                                        unsigned int flags)
+{
+  (void)curl;
+  (void)bufp;
+  (void)nread;
+  (void)metap;
+  (void)flags;
+  return CURLE_NOT_BUILT_IN;
+}
+
+CURL_EXTERN CURLcode curl_ws_recv_release(CURL *curl)
+{
+  (void)curl;
+  return CURLE_NOT_BUILT_IN;
+}
+
 CURL_EXTERN CURLcode curl_ws_send(CURL *curl, const void *buffer,
                                   size_t buflen, size_t *sent,
                                   curl_off_t fragsize,
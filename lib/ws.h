@@ -71,6 +71,11 @@ struct websocket {
   struct bufq recvbuf;    /* raw data from the server */
   struct bufq sendbuf;    /* raw data to be sent to the server */
   struct curl_ws_frame frame;  /* the current WS FRAME received */
+  struct dynbuf msg;      /* message reassembled for a lease */
+  int msg_flags;          /* flags of the message in `msg`, 0 if none */
+  size_t lease_len;       /* payload bytes of `recvbuf` leased out */
+  bool leased;            /* a lease is out and not released yet */
+  bool lease_msg;         /* the lease is the message in `msg` */
 };
 
 CURLcode Curl_ws_request(struct Curl_easy *data, REQTYPE *req);
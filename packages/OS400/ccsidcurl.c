@@ -1093,6 +1093,7 @@ curl_easy_setopt_ccsid(CURL *easy, CURLoption tag, ...)
   case CURLOPT_CRLFILE:
   case CURLOPT_CUSTOMREQUEST:
   case CURLOPT_DEFAULT_PROTOCOL:
+  case CURLOPT_DNS_CACHE_FILE:
   case CURLOPT_DNS_INTERFACE:
   case CURLOPT_DNS_LOCAL_IP4:
   case CURLOPT_DNS_LOCAL_IP6:
@@ -144,6 +144,8 @@ my %api = (
     'curl_easy_nextheader' => 'API',
     'curl_ws_meta' => 'API',
     'curl_ws_recv' => 'API',
+    'curl_ws_recv_lease' => 'API',
+    'curl_ws_recv_release' => 'API',
     'curl_ws_send' => 'API',
 
     # the following functions are provided globally in debug builds
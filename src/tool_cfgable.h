@@ -91,6 +91,7 @@ struct OperationConfig {
   char *dns_interface; /* interface name */
   char *dns_ipv4_addr; /* dot notation */
   char *dns_ipv6_addr; /* dot notation */
+  char *dns_cache_file; /* DNS cache filename */
   char *userpwd;
   char *login_options;
   char *tls_username;
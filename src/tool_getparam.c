@@ -111,6 +111,7 @@ static const struct LongShort aliases[]= {
   {"disable-eprt",               ARG_BOOL, ' ', C_DISABLE_EPRT},
   {"disable-epsv",               ARG_BOOL, ' ', C_DISABLE_EPSV},
   {"disallow-username-in-url",   ARG_BOOL, ' ', C_DISALLOW_USERNAME_IN_URL},
+  {"dns-cache-file",             ARG_STRG, ' ', C_DNS_CACHE_FILE},
   {"dns-interface",              ARG_STRG, ' ', C_DNS_INTERFACE},
   {"dns-ipv4-addr",              ARG_STRG, ' ', C_DNS_IPV4_ADDR},
   {"dns-ipv6-addr",              ARG_STRG, ' ', C_DNS_IPV6_ADDR},
@@ -1239,6 +1240,9 @@ ParameterError getparameter(const char *flag, /* f or -long-flag */
     case C_EPSV: /* --epsv */
       config->disable_epsv = (!toggle) ? TRUE : FALSE;
       break;
+    case C_DNS_CACHE_FILE: /* --dns-cache-file */
+      err = getstr(&config->dns_cache_file, nextarg, ALLOW_BLANK);
+      break;
     case C_DNS_SERVERS: /* --dns-servers */
       if(!curlinfo->ares_num) /* c-ares is needed for this */
         err = PARAM_LIBCURL_DOESNT_SUPPORT;
@@ -69,6 +69,7 @@ typedef enum {
   C_DISABLE_EPRT,
   C_DISABLE_EPSV,
   C_DISALLOW_USERNAME_IN_URL,
+  C_DNS_CACHE_FILE,
   C_DNS_INTERFACE,
   C_DNS_IPV4_ADDR,
   C_DNS_IPV6_ADDR,
@@ -144,6 +144,9 @@ const struct helptxt helptext[] = {
   {"    --disallow-username-in-url",
    "Disallow username in URL",
    CURLHELP_CURL},
+  {"    --dns-cache-file <filename>",
+   "Keep resolved addresses in this file",
+   CURLHELP_DNS},
   {"    --dns-interface <interface>",
    "Interface to use for DNS requests",
    CURLHELP_DNS},
@@ -2067,6 +2067,10 @@ static CURLcode single_transfer(struct GlobalConfig *global,
         if(config->dns_ipv6_addr)
           my_setopt_str(curl, CURLOPT_DNS_LOCAL_IP6, config->dns_ipv6_addr);
 
+        /* new in libcurl 8.11.0: */
+        if(config->dns_cache_file)
+          my_setopt_str(curl, CURLOPT_DNS_CACHE_FILE, config->dns_cache_file);
+
         /* new in libcurl 7.6.2: */
         my_setopt_slist(curl, CURLOPT_TELNETOPTIONS, config->telnet_options);
 
@@ -270,6 +270,7 @@ static void usage(const char *msg)
     "  -F number  fail writing response after `number` response bytes\n"
     "  -P number  pause transfer after `number` response bytes\n"
     "  -V http_version (http/1.1, h2, h3) http version to use\n"
+    "  -W number  max size of an HTTP/2 stream's receive window\n"
   );
 }
 #endif /* !_MSC_VER */
@@ -289,11 +290,12 @@ int main(int argc, char *argv[])
   size_t abort_offset = 0;
   size_t fail_offset = 0;
   int abort_paused = 0;
+  long max_stream_window = 0;
   struct transfer *t;
   int http_version = CURL_HTTP_VERSION_2_0;
   int ch;
 
-  while((ch = getopt(argc, argv, "afhm:n:A:F:P:V:")) != -1) {
+  while((ch = getopt(argc, argv, "afhm:n:A:F:P:V:W:")) != -1) {
     switch(ch) {
     case 'h':
       usage(NULL);
@@ -332,6 +334,9 @@ int main(int argc, char *argv[])
       }
       break;
     }
+    case 'W':
+      max_stream_window = strtol(optarg, NULL, 10);
+      break;
     default:
      usage("invalid option");
      return 1;
@@ -357,6 +362,9 @@ int main(int argc, char *argv[])
 
   multi_handle = curl_multi_init();
   curl_multi_setopt(multi_handle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  if(max_stream_window)
+    curl_multi_setopt(multi_handle, CURLMOPT_MAX_STREAM_WINDOW,
+                      max_stream_window);
 
   active_transfers = 0;
   for(i = 0; i < transfer_count; ++i) {
@@ -163,6 +163,7 @@ struct transfer {
 static size_t transfer_count = 1;
 static struct transfer *transfers;
 static int forbid_reuse = 0;
+static long quic_cc_algo = CURL_QUIC_CC_DEFAULT;
 
 static struct transfer *get_transfer_for_easy(CURL *easy)
 {
@@ -277,6 +278,8 @@ static int setup(CURL *hnd, const char *url, struct transfer *t,
   curl_easy_setopt(hnd, CURLOPT_XFERINFODATA, t);
   if(forbid_reuse)
     curl_easy_setopt(hnd, CURLOPT_FORBID_REUSE, 1L);
+  if(quic_cc_algo != CURL_QUIC_CC_DEFAULT)
+    curl_easy_setopt(hnd, CURLOPT_QUIC_CC_ALGO, quic_cc_algo);
 
   /* please be verbose */
   if(verbose) {
@@ -302,6 +305,7 @@ static void usage(const char *msg)
     "  -m number  max parallel uploads\n"
     "  -n number  total uploads\n"
     "  -A number  abort transfer after `number` request body bytes\n"
+    "  -C algo    QUIC congestion control (reno, cubic, bbr)\n"
     "  -F number  fail reading request body after `number` of bytes\n"
     "  -P number  pause transfer after `number` request body bytes\n"
     "  -S number  size to upload\n"
@@ -332,7 +336,7 @@ int main(int argc, char *argv[])
   int http_version = CURL_HTTP_VERSION_2_0;
   int ch;
 
-  while((ch = getopt(argc, argv, "afhm:n:A:F:M:P:RS:V:")) != -1) {
+  while((ch = getopt(argc, argv, "afhm:n:A:C:F:M:P:RS:V:")) != -1) {
     switch(ch) {
     case 'h':
       usage(NULL);
@@ -352,6 +356,18 @@ int main(int argc, char *argv[])
     case 'A':
       abort_offset = (size_t)strtol(optarg, NULL, 10);
       break;
+    case 'C':
+      if(!strcmp("reno", optarg))
+        quic_cc_algo = CURL_QUIC_CC_RENO;
+      else if(!strcmp("cubic", optarg))
+        quic_cc_algo = CURL_QUIC_CC_CUBIC;
+      else if(!strcmp("bbr", optarg))
+        quic_cc_algo = CURL_QUIC_CC_BBR;
+      else {
+        usage("invalid congestion control");
+        return 1;
+      }
+      break;
     case 'F':
       fail_offset = (size_t)strtol(optarg, NULL, 10);
       break;
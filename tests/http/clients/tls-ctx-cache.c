@@ -0,0 +1,292 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+/* <DESC>
+ * TLS context reuse between connections of a multi handle
+ * </DESC>
+ */
+#include <curl/curl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _MSC_VER
+/* somewhat Unix-specific */
+#include <unistd.h>  /* getopt(), sleep() */
+#endif
+
+#ifndef _MSC_VER
+
+/* One transfer, each on a new connection, with the TLS config changed from
+ * that of the first one as given. Prints to stdout whether the connection
+ * used a cached TLS context and which HTTP version was negotiated. */
+struct step {
+  const char *name;
+  long verifypeer;
+  int other_cafile;     /* the same CA file under another name */
+  const char *ciphers;
+  long ssl_options;
+  long ca_cache_timeout; /* -1 for the default */
+  unsigned int wait;     /* seconds to sleep before the transfer */
+};
+
+static const struct step steps[] = {
+  { "first",    1L, 0, NULL,      0L,                     -1L, 0 },
+  { "same",     1L, 0, NULL,      0L,                     -1L, 0 },
+  { "cafile",   1L, 1, NULL,      0L,                     -1L, 0 },
+  { "noverify", 0L, 0, NULL,      0L,                     -1L, 0 },
+  { "ciphers",  1L, 0, "DEFAULT", 0L,                     -1L, 0 },
+  { "beast",    1L, 0, NULL,      CURLSSLOPT_ALLOW_BEAST, -1L, 0 },
+  { "again",    1L, 0, NULL,      0L,                     -1L, 0 },
+  { "expired",  1L, 0, NULL,      0L,                     1L,  2 },
+  { "renewed",  1L, 0, NULL,      0L,                     1L,  0 },
+};
+
+struct trace {
+  int ctx_reused;
+  int ctx_added;
+};
+
+static int debug_cb(CURL *handle, curl_infotype type,
+                    char *data, size_t size,
+                    void *userdata)
+{
+  struct trace *t = userdata;
+  (void)handle;
+
+  if(type == CURLINFO_TEXT) {
+    fwrite(data, size, 1, stderr);
+    if(size < 512) {
+      char line[512];
+      memcpy(line, data, size);
+      line[size] = 0;
+      if(strstr(line, "reusing cached SSL_CTX"))
+        t->ctx_reused++;
+      else if(strstr(line, "context to cache"))
+        t->ctx_added++;
+    }
+  }
+  return 0;
+}
+
+static size_t write_cb(char *ptr, size_t size, size_t nmemb, void *opaque)
+{
+  (void)ptr;
+  (void)opaque;
+  return size * nmemb;
+}
+
+static void usage(const char *msg)
+{
+  if(msg)
+    fprintf(stderr, "%s\n", msg);
+  fprintf(stderr,
+    "usage: [options] url\n"
+    "  -c file   CA certificate file to verify the server with\n"
+    "  -V http_version (http/1.1, h2) http version to use\n"
+  );
+}
+
+static int run_step(CURLM *multi, const struct step *step,
+                    const char *url, struct curl_slist *resolve,
+                    const char *cafile, const char *other_cafile,
+                    long http_version)
+{
+  struct trace t;
+  CURL *easy;
+  CURLMsg *msg;
+  CURLcode result = CURLE_OK;
+  int running = 1;
+  int msgs_left;
+  long version = 0;
+
+  memset(&t, 0, sizeof(t));
+  easy = curl_easy_init();
+  if(!easy) {
+    fprintf(stderr, "curl_easy_init failed\n");
+    return 1;
+  }
+  curl_easy_setopt(easy, CURLOPT_URL, url);
+  curl_easy_setopt(easy, CURLOPT_RESOLVE, resolve);
+  curl_easy_setopt(easy, CURLOPT_VERBOSE, 1L);
+  curl_easy_setopt(easy, CURLOPT_DEBUGFUNCTION, debug_cb);
+  curl_easy_setopt(easy, CURLOPT_DEBUGDATA, &t);
+  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, write_cb);
+  curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, http_version);
+  curl_easy_setopt(easy, CURLOPT_FORBID_REUSE, 1L);
+  curl_easy_setopt(easy, CURLOPT_CAINFO,
+                   step->other_cafile ? other_cafile : cafile);
+  curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, step->verifypeer);
+  if(step->ciphers)
+    curl_easy_setopt(easy, CURLOPT_SSL_CIPHER_LIST, step->ciphers);
+  if(step->ssl_options)
+    curl_easy_setopt(easy, CURLOPT_SSL_OPTIONS, step->ssl_options);
+  if(step->ca_cache_timeout >= 0)
+    curl_easy_setopt(easy, CURLOPT_CA_CACHE_TIMEOUT,
+                     step->ca_cache_timeout);
+
+  if(step->wait)
+    sleep(step->wait);
+
+  curl_multi_add_handle(multi, easy);
+  while(running) {
+    CURLMcode mc = curl_multi_perform(multi, &running);
+    if(!mc && running)
+      mc = curl_multi_poll(multi, NULL, 0, 1000, NULL);
+    if(mc) {
+      fprintf(stderr, "curl_multi_perform/poll: %s\n",
+              curl_multi_strerror(mc));
+      return 1;
+    }
+  }
+  /* !checksrc! disable EQUALSNULL 1 */
+  while((msg = curl_multi_info_read(multi, &msgs_left)) != NULL) {
+    if(msg->msg == CURLMSG_DONE)
+      result = msg->data.result;
+  }
+  curl_easy_getinfo(easy, CURLINFO_HTTP_VERSION, &version);
+  curl_multi_remove_handle(multi, easy);
+  curl_easy_cleanup(easy);
+
+  if(result) {
+    fprintf(stderr, "%s: transfer failed with %d\n", step->name, result);
+    return 1;
+  }
+  printf("%s: ctx %s, %s\n", step->name,
+         t.ctx_reused ? "reused" : (t.ctx_added ? "new" : "uncached"),
+         (version == CURL_HTTP_VERSION_2_0) ? "h2" : "http/1.1");
+  return 0;
+}
+
+#endif /* !_MSC_VER */
+
+int main(int argc, char *argv[])
+{
+#ifndef _MSC_VER
+  const char *url;
+  const char *cafile = NULL;
+  char *other_cafile;
+  const char *slash;
+  CURLU *cu;
+  char *host = NULL, *port = NULL;
+  struct curl_slist *resolve = NULL;
+  char resolve_buf[1024];
+  long http_version = CURL_HTTP_VERSION_1_1;
+  CURLM *multi;
+  size_t i;
+  int ch;
+  int rc = 0;
+
+  while((ch = getopt(argc, argv, "c:hV:")) != -1) {
+    switch(ch) {
+    case 'h':
+      usage(NULL);
+      return 2;
+    case 'c':
+      cafile = optarg;
+      break;
+    case 'V':
+      if(!strcmp("http/1.1", optarg))
+        http_version = CURL_HTTP_VERSION_1_1;
+      else if(!strcmp("h2", optarg))
+        http_version = CURL_HTTP_VERSION_2_0;
+      else {
+        usage("invalid http version");
+        return 1;
+      }
+      break;
+    default:
+      usage("invalid option");
+      return 1;
+    }
+  }
+  argc -= optind;
+  argv += optind;
+
+  if(argc != 1 || !cafile) {
+    usage("not enough arguments");
+    return 2;
+  }
+  url = argv[0];
+
+  /* the CA file, named differently */
+  other_cafile = malloc(strlen(cafile) + 3);
+  if(!other_cafile)
+    return 1;
+  slash = strrchr(cafile, '/');
+  if(slash)
+    curl_msnprintf(other_cafile, strlen(cafile) + 3, "%.*s/.%s",
+                   (int)(slash - cafile), cafile, slash);
+  else
+    curl_msnprintf(other_cafile, strlen(cafile) + 3, "./%s", cafile);
+
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+  curl_global_trace("ssl");
+
+  cu = curl_url();
+  if(!cu) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  if(curl_url_set(cu, CURLUPART_URL, url, 0)) {
+    fprintf(stderr, "not a URL: '%s'\n", url);
+    exit(1);
+  }
+  if(curl_url_get(cu, CURLUPART_HOST, &host, 0)) {
+    fprintf(stderr, "could not get host of '%s'\n", url);
+    exit(1);
+  }
+  if(curl_url_get(cu, CURLUPART_PORT, &port, 0)) {
+    fprintf(stderr, "could not get port of '%s'\n", url);
+    exit(1);
+  }
+  curl_msnprintf(resolve_buf, sizeof(resolve_buf)-1, "%s:%s:127.0.0.1",
+                 host, port);
+  resolve = curl_slist_append(resolve, resolve_buf);
+
+  multi = curl_multi_init();
+  if(!multi) {
+    fprintf(stderr, "curl_multi_init failed\n");
+    return 1;
+  }
+
+  for(i = 0; !rc && (i < sizeof(steps)/sizeof(steps[0])); i++)
+    rc = run_step(multi, &steps[i], url, resolve, cafile, other_cafile,
+                  http_version);
+
+  curl_multi_cleanup(multi);
+  curl_slist_free_all(resolve);
+  curl_free(host);
+  curl_free(port);
+  curl_url_cleanup(cu);
+  curl_global_cleanup();
+  free(other_cafile);
+  return rc;
+#else
+  (void)argc;
+  (void)argv;
+  fprintf(stderr, "Not supported with this compiler.\n");
+  return 1;
+#endif /* !_MSC_VER */
+}
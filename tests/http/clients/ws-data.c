@@ -22,7 +22,7 @@
  *
  ***************************************************************************/
 /* <DESC>
- * WebSockets data echos
+ * WebSockets data echos, optionally measuring their throughput
  * </DESC>
  */
 /* curl stuff */
@@ -44,6 +44,33 @@
 #include <sys/time.h>
 #endif
 
+/* in benchmark mode, nothing is logged per frame and there is no sleeping
+   on EAGAIN */
+static int bench;
+
+static double now_ms(void)
+{
+#ifdef _WIN32
+  return (double)GetTickCount();
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec * 1000.0 + (double)tv.tv_usec / 1000.0;
+#endif
+}
+
+static void wait_again(void)
+{
+  if(bench)
+    return;
+  fprintf(stderr, "EAGAIN, sleep, try again\n");
+#ifdef _WIN32
+  Sleep(100);
+#else
+  usleep(100*1000);
+#endif
+}
+
 static
 void dump(const char *text, unsigned char *ptr, size_t size,
           char nohex)
@@ -95,36 +122,45 @@ void dump(const char *text, unsigned char *ptr, size_t size,
 
 static CURLcode send_binary(CURL *curl, char *buf, size_t buflen)
 {
-  size_t nwritten;
-  CURLcode result =
-    curl_ws_send(curl, buf, buflen, &nwritten, 0, CURLWS_BINARY);
-  fprintf(stderr, "ws: send_binary(len=%ld) -> %d, %ld\n",
-          (long)buflen, result, (long)nwritten);
+  size_t nwritten, sent = 0;
+  CURLcode result;
+
+  do {
+    result = curl_ws_send(curl, buf + sent, buflen - sent, &nwritten, 0,
+                          CURLWS_BINARY);
+    sent += nwritten;
+    if(result == CURLE_AGAIN) {
+      wait_again();
+      result = CURLE_OK;
+    }
+  } while(!result && sent < buflen);
+  if(!bench)
+    fprintf(stderr, "ws: send_binary(len=%ld) -> %d, %ld\n",
+            (long)buflen, result, (long)sent);
   return result;
 }
 
 static CURLcode recv_binary(CURL *curl, char *exp_data, size_t exp_len)
 {
   const struct curl_ws_frame *frame;
-  char recvbuf[256];
+  static char recvbuf[64 * 1024];
+  size_t recvlen = bench ? sizeof(recvbuf) : 256;
   size_t r_offset, nread;
   CURLcode result;
 
-  fprintf(stderr, "recv_binary: expected payload %ld bytes\n", (long)exp_len);
+  if(!bench)
+    fprintf(stderr, "recv_binary: expected payload %ld bytes\n",
+            (long)exp_len);
   r_offset = 0;
   while(1) {
-    result = curl_ws_recv(curl, recvbuf, sizeof(recvbuf), &nread, &frame);
+    result = curl_ws_recv(curl, recvbuf, recvlen, &nread, &frame);
     if(result == CURLE_AGAIN) {
-      fprintf(stderr, "EAGAIN, sleep, try again\n");
-#ifdef _WIN32
-      Sleep(100);
-#else
-      usleep(100*1000);
-#endif
+      wait_again();
       continue;
     }
-    fprintf(stderr, "ws: curl_ws_recv(offset=%ld, len=%ld) -> %d, %ld\n",
-            (long)r_offset, (long)sizeof(recvbuf), result, (long)nread);
+    if(!bench)
+      fprintf(stderr, "ws: curl_ws_recv(offset=%ld, len=%ld) -> %d, %ld\n",
+              (long)r_offset, (long)recvlen, result, (long)nread);
     if(result) {
       return result;
     }
@@ -157,7 +193,8 @@ static CURLcode recv_binary(CURL *curl, char *exp_data, size_t exp_len)
     }
     r_offset += nread;
     if(r_offset >= exp_len) {
-      fprintf(stderr, "recv_data: frame complete\n");
+      if(!bench)
+        fprintf(stderr, "recv_data: frame complete\n");
       break;
     }
   }
@@ -174,12 +211,14 @@ static void websocket_close(CURL *curl)
           "ws: curl_ws_send returned %u, sent %u\n", (int)result, (int)sent);
 }
 
-static CURLcode data_echo(CURL *curl, size_t plen_min, size_t plen_max)
+static CURLcode data_echo(CURL *curl, size_t plen_min, size_t plen_max,
+                          size_t count)
 {
   CURLcode res = CURLE_OK;
   size_t len;
   char *send_buf;
-  size_t i;
+  size_t i, n;
+  double start, ms;
 
   send_buf = calloc(1, plen_max);
   if(!send_buf)
@@ -188,15 +227,31 @@ static CURLcode data_echo(CURL *curl, size_t plen_min, size_t plen_max)
     send_buf[i] = (char)('0' + ((int)i % 10));
   }
 
-  for(len = plen_min; len <= plen_max; ++len) {
-    res = send_binary(curl, send_buf, len);
-    if(res)
-      goto out;
-    res = recv_binary(curl, send_buf, len);
-    if(res) {
-      fprintf(stderr, "recv_data(len=%ld) -> %d\n", (long)len, res);
-      goto out;
+  for(len = plen_min; len <= plen_max;) {
+    start = now_ms();
+    for(n = 0; n < count; ++n) {
+      res = send_binary(curl, send_buf, len);
+      if(res)
+        goto out;
+      res = recv_binary(curl, send_buf, len);
+      if(res) {
+        fprintf(stderr, "recv_data(len=%ld) -> %d\n", (long)len, res);
+        goto out;
+      }
+    }
+    if(bench) {
+      ms = now_ms() - start;
+      printf("%10ld bytes x %ld: %10.1f ms, %8.1f frames/s, %8.1f MB/s\n",
+             (long)len, (long)count, ms,
+             ms > 0 ? (double)count * 1000.0 / ms : 0.0,
+             ms > 0 ? (double)(len * count) / (ms * 1000.0) : 0.0);
+      /* payload lengths double, always ending with the max */
+      if(len == plen_max)
+        break;
+      len = (len && (len * 2 < plen_max)) ? len * 2 : plen_max;
     }
+    else
+      ++len;
   }
 
 out:
@@ -214,12 +269,26 @@ int main(int argc, char *argv[])
   CURL *curl;
   CURLcode res = CURLE_OK;
   const char *url;
-  long l1, l2;
+  long l1, l2, count = 1;
   size_t plen_min, plen_max;
 
-
-  if(argc != 4) {
-    fprintf(stderr, "usage: ws-data url minlen maxlen\n");
+  while(argc > 1 && argv[1][0] == '-') {
+    if(!strcmp(argv[1], "-b"))
+      bench = 1;
+    else if(!strcmp(argv[1], "-c") && argc > 2) {
+      count = strtol(argv[2], NULL, 10);
+      --argc;
+      ++argv;
+    }
+    else
+      break;
+    --argc;
+    ++argv;
+  }
+  if(argc != 4 || count < 1) {
+    fprintf(stderr, "usage: ws-data [-b] [-c count] url minlen maxlen\n"
+            "  echo payloads of minlen to maxlen bytes, each count times\n"
+            "  -b  benchmark, lengths double and throughput is reported\n");
     return 2;
   }
   url = argv[1];
@@ -249,12 +318,12 @@ int main(int argc, char *argv[])
 
     /* use the callback style */
     curl_easy_setopt(curl, CURLOPT_USERAGENT, "ws-data");
-    curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+    curl_easy_setopt(curl, CURLOPT_VERBOSE, bench ? 0L : 1L);
     curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 2L); /* websocket style */
     res = curl_easy_perform(curl);
     fprintf(stderr, "curl_easy_perform() returned %u\n", (int)res);
     if(res == CURLE_OK)
-      res = data_echo(curl, plen_min, plen_max);
+      res = data_echo(curl, plen_min, plen_max, (size_t)count);
 
     /* always cleanup */
     curl_easy_cleanup(curl);
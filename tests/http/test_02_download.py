@@ -29,6 +29,7 @@ import filecmp
 import logging
 import math
 import os
+import re
 from datetime import timedelta
 import pytest
 
@@ -591,3 +592,36 @@ class TestDownload:
         # we see 3 connections, because Apache only every serves a single
         # request via Upgrade: and then closed the connection.
         assert r.total_connects == 3, r.dump_logs()
+
+    # download via lib client with a small initial HTTP/2 stream window,
+    # see it grow with the bandwidth-delay product up to its maximum
+    @pytest.mark.parametrize("max_window", [None, 100*1024])
+    def test_02_32_h2_stream_window(self, env: Env, httpd, nghttpx, max_window):
+        if not env.curl_is_debug():
+            pytest.skip('only works for curl debug builds')
+        init_window = 64*1024
+        docname = 'data-10m'
+        url = f'https://localhost:{env.https_port}/{docname}'
+        client = LocalClient(name='hx-download', env=env, run_env={
+            'CURL_DBG_H2_STREAM_WIN': f'{init_window}',
+        })
+        if not client.exists():
+            pytest.skip(f'example client not built: {client.name}')
+        args = ['-n', '1', '-V', 'h2']
+        if max_window is not None:
+            args.extend(['-W', f'{max_window}'])
+        r = client.run(args=[*args, url])
+        r.check_exit_code(0)
+        srcfile = os.path.join(httpd.docs_dir, docname)
+        self.check_downloads(client, srcfile, 1)
+        windows = []
+        for line in r.trace_lines:
+            m = re.match(r'.*\[HTTP/2] \[0] BDP \d+ bytes in \d+us, '
+                         r'stream window now (\d+)', line)
+            if m:
+                windows.append(int(m.group(1)))
+        cap = max_window if max_window is not None else 64*1024*1024
+        assert len(windows) > 0, f'stream window never grew\n{r.dump_logs()}'
+        assert windows[0] > init_window, f'{windows}'
+        assert windows == sorted(set(windows)), f'{windows}'
+        assert windows[-1] <= cap, f'{windows}'
@@ -222,6 +222,28 @@ class TestUpload:
         r.check_exit_code(0)
         self.check_downloads(client, ["x" * upload_size], count)
 
+    # PUT over h3 with the different congestion controllers
+    @pytest.mark.parametrize("cc", ['reno', 'cubic', 'bbr'])
+    def test_07_18_h3_put_cc(self, env: Env, httpd, nghttpx, repeat, cc):
+        if not env.have_h3():
+            pytest.skip("h3 not supported")
+        if not env.curl_uses_lib('ngtcp2'):
+            pytest.skip("only ngtcp2 supports selecting the congestion control")
+        count = 1
+        upload_size = 10*1024*1024
+        url = f'https://localhost:{env.https_port}/curltest/put?id=[0-{count-1}]'
+        client = LocalClient(name='hx-upload', env=env)
+        if not client.exists():
+            pytest.skip(f'example client not built: {client.name}')
+        r = client.run(args=[
+             '-n', f'{count}', '-S', f'{upload_size}', '-C', cc, '-V', 'h3', url
+        ])
+        r.check_exit_code(0)
+        self.check_downloads(client, [f"{upload_size}"], count)
+        secs = r.duration.total_seconds()
+        log.info(f'h3 PUT {upload_size} bytes with {cc}: {secs:.3f}s, '
+                 f'{upload_size / secs / (1024*1024) if secs else 0:.1f} MB/s')
+
     # upload data parallel, check that they were echoed
     @pytest.mark.parametrize("proto", ['h2', 'h3'])
     def test_07_20_upload_parallel(self, env: Env, httpd, nghttpx, repeat, proto):
@@ -275,6 +297,32 @@ class TestUpload:
         exp_exit = 92 if proto == 'h2' else 95
         r.check_stats(count=count, exitcode=exp_exit)
 
+    # small uploads parallel to a large one on the same connection get
+    # their turns and are not held back until the large one is done
+    @pytest.mark.parametrize("proto", ['h2'])
+    def test_07_23_upload_parallel_mixed(self, env: Env, httpd, nghttpx, repeat, proto):
+        fbig = env.make_data_file(indir=env.gen_dir, fname="data-100m",
+                                  fsize=100*1024*1024)
+        fsmall = os.path.join(env.gen_dir, 'data-63k')
+        count = 10
+        curl = CurlClient(env=env)
+        url = f'https://{env.authority_for(env.domain1, proto)}/curltest/put'
+        args = ['--parallel', '-w', '%{json}\\n',
+                '-T', fbig, '-o', '/dev/null', f'{url}?id=big']
+        for i in range(count - 1):
+            args.extend(['-T', fsmall, '-o', '/dev/null', f'{url}?id={i}'])
+        args.extend(['-T', fsmall, '-o', '/dev/null'])
+        r = curl._raw(urls=[f'{url}?id={count-1}'], options=args,
+                      alpn_proto=proto, with_stats=True, with_headers=False)
+        r.check_stats(count=count + 1, http_status=200, exitcode=0)
+        big = [s for s in r.stats if s['size_upload'] > 1024*1024]
+        assert len(big) == 1, f'{r.stats}'
+        for s in r.stats:
+            if s['size_upload'] < 1024*1024:
+                assert s['time_total'] < big[0]['time_total'] / 4, \
+                    f'small upload took {s["time_total"]}s, large one ' \
+                    f'{big[0]["time_total"]}s\n{r.dump_logs()}'
+
     # PUT 100k
     @pytest.mark.parametrize("proto", ['http/1.1', 'h2', 'h3'])
     def test_07_30_put_100k(self, env: Env, httpd, nghttpx, repeat, proto):
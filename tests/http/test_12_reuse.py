@@ -146,3 +146,47 @@ class TestReuse:
         # which means our server gives us h2
         for s in r.stats:
             assert s['http_version'] == '2', f'{s}'
+
+    # requests with changing custom headers on one HTTP/2 connection. Equal
+    # header fields of the last request are sent again, the server needs to
+    # see each request's own.
+    def test_12_06_h2_changing_headers(self, env: Env, httpd, nghttpx):
+        httpd.clear_extra_configs()
+        httpd.set_extra_config(env.domain1, [
+            'Header echo ^X-Test-',
+        ])
+        httpd.reload()
+        url = f'https://{env.authority_for(env.domain1, "h2")}/data.json'
+        requests = [
+            {'a': 'one', 'b': 'two'},
+            {'a': 'one', 'b': 'two'},  # the same again
+            {'a': 'uno', 'b': 'two'},  # changed value
+            {'a': 'one', 'b': 'two', 'c': 'three'},  # added
+            {'b': 'two', 'c': 'three'},  # removed
+            {'a': 'one', 'b': 'two'},
+            {'a': 'one', 'b': 'two'},  # the same again
+        ]
+        args = ['-s', '-v', '--trace-config', 'http/2']
+        for i, hds in enumerate(requests):
+            if i > 0:
+                args.extend(['--next', '-o', '/dev/null'])
+            args.extend([
+                '--http2', '--cacert', env.ca.cert_file,
+                '--resolve', f'{env.domain1}:{env.https_port}:127.0.0.1',
+                '-w', '%{num_connects} a=%header{x-test-a} '
+                      'b=%header{x-test-b} c=%header{x-test-c}\\n',
+            ])
+            for name, value in hds.items():
+                args.extend(['-H', f'X-Test-{name.upper()}: {value}'])
+            args.append(url)
+        curl = CurlClient(env=env)
+        r = curl.run_direct(args=args)
+        r.check_exit_code(0)
+        expected = []
+        for i, hds in enumerate(requests):
+            expected.append(f'{1 if i == 0 else 0} a={hds.get("a", "")} '
+                            f'b={hds.get("b", "")} c={hds.get("c", "")}\n')
+        assert r.stdout == ''.join(expected), r.dump_logs()
+        reused = [line for line in r.stderr.splitlines()
+                  if 'reusing header fields of the last request' in line]
+        assert len(reused) == 2, r.dump_logs()
@@ -29,7 +29,7 @@ import logging
 import os
 import pytest
 
-from testenv import Env, CurlClient
+from testenv import Env, CurlClient, LocalClient
 
 
 log = logging.getLogger(__name__)
@@ -302,3 +302,32 @@ class TestSSLUse:
             assert r.json['SSL_PROTOCOL'] == tls_proto, r.dump_logs()
         else:
             assert r.exit_code != 0, r.dump_logs()
+
+    # connections with the same TLS config share an SSL_CTX, until the
+    # CA cache timeout expires. ALPN is still done on each connection.
+    @pytest.mark.skipif(condition=not Env.curl_uses_lib('openssl'),
+                        reason="SSL_CTX cache is OpenSSL only")
+    @pytest.mark.parametrize("proto", ['http/1.1', 'h2'])
+    def test_17_10_ssl_ctx_cache(self, env: Env, httpd, proto):
+        client = LocalClient(name='tls-ctx-cache', env=env)
+        if not client.exists():
+            pytest.skip(f'example client not built: {client.name}')
+        url = f'https://{env.authority_for(env.domain1, proto)}/data.json'
+        r = client.run(args=['-V', proto, '-c', env.ca.cert_file, url])
+        r.check_exit_code(0)
+        expected = [
+            ('first', 'new'),
+            ('same', 'reused'),
+            ('cafile', 'new'),
+            ('noverify', 'new'),
+            ('ciphers', 'new'),
+            ('beast', 'new'),
+            ('again', 'reused'),
+            ('expired', 'new'),
+            ('renewed', 'reused'),
+        ]
+        assert r.stdout == [f'{name}: ctx {ctx}, {proto}\n'
+                            for name, ctx in expected], f'{client.dump_logs()}'
+        alpn = [line for line in r.stderr
+                if line.startswith(f'ALPN: server accepted {proto}')]
+        assert len(alpn) == len(expected), f'{client.dump_logs()}'
@@ -140,3 +140,14 @@ class TestWebsockets:
         url = f'ws://localhost:{env.ws_port}/'
         r = client.run(args=[url, str(65535 - 5), str(65535 + 5)])
         r.check_exit_code(0)
+
+    # frames of 16 bytes up to 16MB, with throughput reported in the log
+    def test_20_08_data_bench(self, env: Env, ws_echo, repeat):
+        client = LocalClient(env=env, name='ws-data')
+        if not client.exists():
+            pytest.skip(f'example client not built: {client.name}')
+        url = f'ws://localhost:{env.ws_port}/'
+        r = client.run(args=['-b', '-c', '4', url, str(16),
+                             str(16 * 1024 * 1024)])
+        r.check_exit_code(0)
+        log.info(f'ws-data throughput:\n{r.stdout}')
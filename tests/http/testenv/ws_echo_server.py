@@ -41,7 +41,7 @@ async def echo(websocket):
 
 
 async def run_server(port):
-    async with server.serve(echo, "localhost", port):
+    async with server.serve(echo, "localhost", port, max_size=None):
         await asyncio.Future()  # run forever
 
 
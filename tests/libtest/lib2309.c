@@ -0,0 +1,126 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include "test.h"
+#include "testtrace.h"
+#include "memdebug.h"
+
+#ifndef CURL_DISABLE_WEBSOCKETS
+
+/* just close the connection */
+static void websocket_close(CURL *curl)
+{
+  size_t sent;
+  CURLcode result =
+    curl_ws_send(curl, "", 0, &sent, 0, CURLWS_CLOSE);
+  fprintf(stderr,
+          "ws: curl_ws_send returned %d, sent %d\n", result, (int)sent);
+}
+
+static void websocket(CURL *curl, unsigned int flags)
+{
+  const void *buf;
+  const struct curl_ws_frame *meta;
+  size_t nread;
+  size_t i = 0;
+  FILE *save = fopen(libtest_arg2, FOPEN_WRITETEXT);
+  if(!save)
+    return;
+
+  /* 12309 bytes of TEXT and BINARY payload are expected */
+  while(i < 12309) {
+    CURLcode result = curl_ws_recv_lease(curl, &buf, &nread, &meta, flags);
+    if(result) {
+      if(result == CURLE_AGAIN)
+        /* crude busy-loop */
+        continue;
+      fclose(save);
+      printf("curl_ws_recv_lease returned %d\n", result);
+      return;
+    }
+    if(flags)
+      printf("lease: nread %zu Flags %x "
+             "Offset %" CURL_FORMAT_CURL_OFF_T " "
+             "Bytesleft %" CURL_FORMAT_CURL_OFF_T "\n",
+             nread, meta->flags, meta->offset, meta->bytesleft);
+    if(meta->flags & (CURLWS_TEXT|CURLWS_BINARY|CURLWS_CONT)) {
+      fwrite(buf, 1, nread, save);
+      i += nread;
+    }
+    /* a second lease before the release is refused */
+    if(curl_ws_recv_lease(curl, &buf, &nread, &meta, flags) !=
+       CURLE_BAD_FUNCTION_ARGUMENT)
+      printf("second lease not refused\n");
+    result = curl_ws_recv_release(curl);
+    if(result) {
+      fclose(save);
+      printf("curl_ws_recv_release returned %d\n", result);
+      return;
+    }
+  }
+  fclose(save);
+  if(curl_ws_recv_release(curl) != CURLE_BAD_FUNCTION_ARGUMENT)
+    printf("release without lease not refused\n");
+
+  websocket_close(curl);
+}
+
+CURLcode test(char *URL)
+{
+  CURL *curl;
+  CURLcode res = CURLE_OK;
+  unsigned int flags = 0;
+
+  if(libtest_arg3 && !strcmp(libtest_arg3, "message"))
+    flags = CURLWS_LEASE_MESSAGE;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  curl = curl_easy_init();
+  if(curl) {
+    curl_easy_setopt(curl, CURLOPT_URL, URL);
+
+    /* use the callback style */
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "websocket/2309");
+    libtest_debug_config.nohex = 1;
+    libtest_debug_config.tracetime = 1;
+    curl_easy_setopt(curl, CURLOPT_DEBUGDATA, &libtest_debug_config);
+    curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, libtest_debug_cb);
+    curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 2L); /* websocket style */
+    res = curl_easy_perform(curl);
+    fprintf(stderr, "curl_easy_perform() returned %d\n", res);
+    if(res == CURLE_OK)
+      websocket(curl, flags);
+
+    /* always cleanup */
+    curl_easy_cleanup(curl);
+  }
+  curl_global_cleanup();
+  return res;
+}
+
+#else
+NO_SUPPORT_BUILT_IN
+#endif
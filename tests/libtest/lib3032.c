@@ -0,0 +1,129 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "test.h"
+#include "memdebug.h"
+
+static const char *ldata_names[] = {
+  "NONE",
+  "SHARE",
+  "COOKIE",
+  "DNS",
+  "SESSION",
+  "CONNECT",
+  "PSL",
+  "HSTS",
+  "NULL",
+};
+
+static void test_lock(CURL *handle, curl_lock_data data,
+                      curl_lock_access laccess, void *useptr)
+{
+  (void)handle;
+  (void)laccess;
+  (void)useptr;
+  printf("-> Mutex lock %s\n", ldata_names[data]);
+}
+
+static void test_unlock(CURL *handle, curl_lock_data data, void *useptr)
+{
+  (void)handle;
+  (void)useptr;
+  printf("<- Mutex unlock %s\n", ldata_names[data]);
+}
+
+/* test function */
+CURLcode test(char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLSH *share = NULL;
+  CURLSHcode shres;
+  int i;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  share = curl_share_init();
+  if(!share) {
+    fprintf(stderr, "curl_share_init() failed\n");
+    goto test_cleanup;
+  }
+
+  shres = curl_share_setopt(share, CURLSHOPT_CONNECT_SHARDS, 4L);
+  if(shres == CURLSHE_NOT_BUILT_IN) {
+    /* no thread support, run the test on a single lock */
+    shres = curl_share_setopt(share, CURLSHOPT_CONNECT_SHARDS, 1L);
+  }
+  if(shres) {
+    fprintf(stderr, "CURLSHOPT_CONNECT_SHARDS failed: %d\n", (int)shres);
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+  curl_share_setopt(share, CURLSHOPT_LOCKFUNC, test_lock);
+  curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, test_unlock);
+
+  /* the pool is set up now and can no longer be split */
+  shres = curl_share_setopt(share, CURLSHOPT_CONNECT_SHARDS, 8L);
+  if(shres != CURLSHE_IN_USE) {
+    fprintf(stderr, "CURLSHOPT_CONNECT_SHARDS returned %d\n", (int)shres);
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+
+  /* Loop the transfer and cleanup the handle properly every lap. The
+     connection is reused from the sharded pool in the shared object. */
+  for(i = 0; i < 3; i++) {
+    CURL *curl = curl_easy_init();
+    if(curl) {
+      long num_connects = -1;
+
+      curl_easy_setopt(curl, CURLOPT_URL, URL);
+
+      /* use the share object */
+      curl_easy_setopt(curl, CURLOPT_SHARE, share);
+
+      res = curl_easy_perform(curl);
+      if(!res)
+        res = curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &num_connects);
+
+      curl_easy_cleanup(curl);
+
+      if(res != CURLE_OK) {
+        fprintf(stderr, "curl_easy_perform() failed: %s\n",
+                curl_easy_strerror(res));
+        goto test_cleanup;
+      }
+      if(i && num_connects) {
+        fprintf(stderr, "transfer %d did not reuse the connection\n", i);
+        res = TEST_ERR_FAILURE;
+        goto test_cleanup;
+      }
+    }
+  }
+
+test_cleanup:
+  curl_share_cleanup(share);
+  curl_global_cleanup();
+
+  return res;
+}
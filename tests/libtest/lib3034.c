@@ -0,0 +1,87 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "test.h"
+
+#include "memdebug.h"
+
+/* Receive a response using CURLOPT_RECVBUFFERFUNCTION and report whether
+   the body arrived in the application's own buffer */
+
+struct recvbuf {
+  char buf[2048];
+  size_t leases;     /* times the buffer was handed out */
+  size_t in_place;   /* body bytes written from within 'buf' */
+  size_t total;      /* all body bytes written */
+};
+
+static size_t recvbuffer_cb(char **bufferp, size_t size, void *userdata)
+{
+  struct recvbuf *rb = (struct recvbuf *)userdata;
+  (void)size;
+  rb->leases++;
+  *bufferp = rb->buf;
+  return sizeof(rb->buf);
+}
+
+static size_t write_cb(char *ptr, size_t size, size_t nmemb, void *userp)
+{
+  struct recvbuf *rb = (struct recvbuf *)userp;
+  size_t len = size * nmemb;
+  if(ptr >= rb->buf && ptr < rb->buf + sizeof(rb->buf)) {
+    if(ptr + len > rb->buf + sizeof(rb->buf))
+      return 0; /* cannot happen */
+    rb->in_place += len;
+  }
+  rb->total += len;
+  return len;
+}
+
+CURLcode test(char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURL *curl = NULL;
+  struct recvbuf rb;
+
+  memset(&rb, 0, sizeof(rb));
+
+  global_init(CURL_GLOBAL_ALL);
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  /* small reads to have the body span several of them */
+  easy_setopt(curl, CURLOPT_BUFFERSIZE, 1024L);
+  easy_setopt(curl, CURLOPT_RECVBUFFERFUNCTION, recvbuffer_cb);
+  easy_setopt(curl, CURLOPT_RECVBUFFERDATA, &rb);
+  easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+  easy_setopt(curl, CURLOPT_WRITEDATA, &rb);
+
+  res = curl_easy_perform(curl);
+
+  printf("body: %zu bytes, received in place: %s\n", rb.total,
+         (rb.leases && rb.in_place) ? "yes" : "no");
+
+test_cleanup:
+  curl_easy_cleanup(curl);
+  curl_global_cleanup();
+  return res;
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "test.h"
+
+#include "testutil.h"
+#include "warnless.h"
+#include "memdebug.h"
+
+#define TEST_HANG_TIMEOUT 60 * 1000
+
+#define NUM_HANDLES 10
+
+/* Resolve the same name for many transfers at once with a small resolver
+   thread pool, every transfer gets the lookup's result */
+
+CURLcode test(char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURL *curl[NUM_HANDLES] = {0};
+  int running;
+  int num;
+  int fails = 0;
+  CURLM *m = NULL;
+  CURLMsg *msg;
+  int msgs;
+  int i;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(m);
+  multi_setopt(m, CURLMOPT_RESOLVER_THREADS, 2L);
+
+  for(i = 0; i < NUM_HANDLES; i++) {
+    easy_init(curl[i]);
+    easy_setopt(curl[i], CURLOPT_URL, URL);
+    easy_setopt(curl[i], CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+    multi_add_handle(m, curl[i]);
+  }
+
+  for(;;) {
+    multi_perform(m, &running);
+
+    abort_on_test_timeout();
+
+    if(!running)
+      break; /* done */
+
+    multi_poll(m, NULL, 0, 1000, &num);
+
+    abort_on_test_timeout();
+  }
+
+  do {
+    msg = curl_multi_info_read(m, &msgs);
+    if(msg && (msg->msg == CURLMSG_DONE) &&
+       (msg->data.result == CURLE_COULDNT_RESOLVE_HOST))
+      fails++;
+  } while(msg);
+
+  printf("%d of %d transfers could not resolve the host\n",
+         fails, NUM_HANDLES);
+
+test_cleanup:
+
+  for(i = 0; i < NUM_HANDLES; i++) {
+    curl_multi_remove_handle(m, curl[i]);
+    curl_easy_cleanup(curl[i]);
+  }
+
+  curl_multi_cleanup(m);
+  curl_global_cleanup();
+
+  return res;
+}
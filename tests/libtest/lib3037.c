@@ -0,0 +1,105 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "test.h"
+
+#include "testutil.h"
+#include "warnless.h"
+#include "memdebug.h"
+
+#define TEST_HANG_TIMEOUT 60 * 1000
+
+/* With a DNS cache timeout of zero every cached entry is stale at once. The
+   second transfer uses it anyway and has it refreshed in the background, a
+   later transfer gets the refreshed entry. */
+
+static int used_stale;
+static int refreshed;
+
+static int debug_cb(CURL *handle, curl_infotype type, char *data,
+                    size_t size, void *userp)
+{
+  (void)handle;
+  (void)userp;
+  if(type == CURLINFO_TEXT) {
+    if(strstr(data, "is stale, used while refreshing"))
+      used_stale++;
+    else if(strstr(data, "was refreshed"))
+      refreshed++;
+  }
+  (void)size;
+  return 0;
+}
+
+static size_t write_cb(char *ptr, size_t size, size_t nmemb, void *userp)
+{
+  (void)ptr;
+  (void)userp;
+  return size * nmemb;
+}
+
+CURLcode test(char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURL *curl = NULL;
+  int i;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+  easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+  easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, 0L);
+  easy_setopt(curl, CURLOPT_DNS_CACHE_STALE, 60L);
+  easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+  easy_setopt(curl, CURLOPT_DEBUGFUNCTION, debug_cb);
+  easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+
+  /* the first transfer resolves the name, the second uses it stale */
+  for(i = 0; i < 2; i++) {
+    res = curl_easy_perform(curl);
+    if(res)
+      goto test_cleanup;
+  }
+  printf("stale entry used: %s\n", used_stale ? "yes" : "no");
+
+  /* until the background lookup is done the stale entry is used */
+  while(!refreshed) {
+    wait_ms(50);
+    res = curl_easy_perform(curl);
+    if(res)
+      goto test_cleanup;
+    abort_on_test_timeout();
+  }
+  printf("entry refreshed: yes\n");
+
+test_cleanup:
+
+  curl_easy_cleanup(curl);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,270 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "test.h"
+#include "memdebug.h"
+
+/*
+ * Check the setting of CURLSHOPT_SSL_SESSION_SHARDS, then have transfers
+ * to several peers use a sharded session cache and see which of them reuse
+ * a session from it.
+ *
+ * The peers are names resolved to the HTTPS test server. The share creates
+ * its session cache for 8 sessions.
+ *
+ * With LIB3041, check that a session is removed from the cache again when
+ * the certificate status of its connection is not verified.
+ */
+
+#define PEERS 12
+
+static size_t discard(char *ptr, size_t size, size_t nmemb, void *userp)
+{
+  (void)ptr;
+  (void)userp;
+  return size * nmemb;
+}
+
+/* count the sessions offered for reuse */
+static int debug_cb(CURL *handle, curl_infotype type, char *data,
+                    size_t size, void *userp)
+{
+  int *reused = userp;
+  char line[256];
+
+  (void)handle;
+  if((type == CURLINFO_TEXT) && (size < sizeof(line))) {
+    memcpy(line, data, size);
+    line[size] = 0;
+    if(strstr(line, "reusing session"))
+      (*reused)++;
+  }
+  return 0;
+}
+
+/* one transfer on a new connection to `peer` */
+static CURLcode transfer(CURLSH *share, const char *URL, int peer,
+                         long verifystatus, int *reused)
+{
+  CURLcode res = CURLE_OK;
+  CURL *curl = NULL;
+  CURLU *cu = NULL;
+  struct curl_slist *resolve = NULL;
+  char *ip = NULL;
+  char *port = NULL;
+  char *url = NULL;
+  char host[32];
+  char entry[256];
+
+  *reused = 0;
+  cu = curl_url();
+  if(!cu) {
+    res = CURLE_OUT_OF_MEMORY;
+    goto test_cleanup;
+  }
+  msnprintf(host, sizeof(host), "peer%d.example", peer);
+  if(curl_url_set(cu, CURLUPART_URL, URL, 0) ||
+     curl_url_get(cu, CURLUPART_HOST, &ip, 0) ||
+     curl_url_get(cu, CURLUPART_PORT, &port, 0) ||
+     curl_url_set(cu, CURLUPART_HOST, host, 0) ||
+     curl_url_get(cu, CURLUPART_URL, &url, 0)) {
+    res = CURLE_OUT_OF_MEMORY;
+    goto test_cleanup;
+  }
+  msnprintf(entry, sizeof(entry), "%s:%s:%s", host, port, ip);
+  resolve = curl_slist_append(NULL, entry);
+  if(!resolve) {
+    res = CURLE_OUT_OF_MEMORY;
+    goto test_cleanup;
+  }
+
+  curl = curl_easy_init();
+  if(!curl) {
+    res = TEST_ERR_EASY_INIT;
+    goto test_cleanup;
+  }
+  test_setopt(curl, CURLOPT_SHARE, share);
+  test_setopt(curl, CURLOPT_URL, url);
+  test_setopt(curl, CURLOPT_RESOLVE, resolve);
+  test_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+  test_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+  test_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+  test_setopt(curl, CURLOPT_WRITEFUNCTION, discard);
+  test_setopt(curl, CURLOPT_VERBOSE, 1L);
+  test_setopt(curl, CURLOPT_DEBUGFUNCTION, debug_cb);
+  test_setopt(curl, CURLOPT_DEBUGDATA, reused);
+  if(verifystatus) {
+    /* the session is added to the cache during a TLS 1.2 handshake,
+       before the status is checked */
+    test_setopt(curl, CURLOPT_SSLVERSION,
+                CURL_SSLVERSION_TLSv1_2 | CURL_SSLVERSION_MAX_TLSv1_2);
+    test_setopt(curl, CURLOPT_SSL_VERIFYSTATUS, 1L);
+  }
+
+  res = curl_easy_perform(curl);
+
+test_cleanup:
+  curl_easy_cleanup(curl);
+  curl_slist_free_all(resolve);
+  curl_free(url);
+  curl_free(port);
+  curl_free(ip);
+  curl_url_cleanup(cu);
+  return res;
+}
+
+#ifdef LIB3041
+
+static CURLcode sessions(CURLSH *share, const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  int i;
+
+  /* the server sends no certificate status, the transfers fail. Had the
+     session of the first stayed in the cache, the second would have reused
+     it and skipped the check. */
+  for(i = 1; i <= 2; i++) {
+    int reused;
+    res = transfer(share, URL, 0, 1L, &reused);
+    printf("status check %d: %d, %s session\n", i, (int)res,
+           reused ? "reused" : "new");
+    if(res != CURLE_SSL_INVALIDCERTSTATUS)
+      return res ? res : TEST_ERR_FAILURE;
+  }
+  return CURLE_OK;
+}
+
+#else
+
+static CURLcode sessions(CURLSH *share, const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  int total = 0;
+  int reused;
+  int i;
+
+  res = transfer(share, URL, 0, 0L, &reused);
+  if(res)
+    return res;
+  printf("peer0: %s session\n", reused ? "reused" : "new");
+  res = transfer(share, URL, 0, 0L, &reused);
+  if(res)
+    return res;
+  printf("peer0 again: %s session\n", reused ? "reused" : "new");
+
+  /* more peers than the cache holds sessions for */
+  for(i = 1; i < PEERS; i++) {
+    res = transfer(share, URL, i, 0L, &reused);
+    if(res)
+      return res;
+    total += reused;
+  }
+  printf("peer1 to peer%d: %d reused\n", PEERS - 1, total);
+
+  /* the most recently used first, until a peer evicted from its shard
+     makes room for itself */
+  total = 0;
+  for(i = PEERS - 1; i >= 0; i--) {
+    res = transfer(share, URL, i, 0L, &reused);
+    if(res)
+      return res;
+    total += reused;
+  }
+  printf("all peers again: %s\n",
+         (total > 0 && total <= 8) ? "1 to 8 reused" : "wrong number reused");
+  return CURLE_OK;
+}
+
+#endif
+
+CURLcode test(char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLSH *share = NULL;
+  CURL *curl = NULL;
+  CURLSHcode shres;
+  long shards = 4;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  share = curl_share_init();
+  if(!share) {
+    fprintf(stderr, "curl_share_init() failed\n");
+    goto test_cleanup;
+  }
+
+#ifndef LIB3041
+  shres = curl_share_setopt(share, CURLSHOPT_SSL_SESSION_SHARDS, 257L);
+  printf("257 shards: %d\n", (int)shres);
+  shres = curl_share_setopt(share, CURLSHOPT_SSL_SESSION_SHARDS, -1L);
+  printf("-1 shards: %d\n", (int)shres);
+#endif
+
+  shres = curl_share_setopt(share, CURLSHOPT_SSL_SESSION_SHARDS, shards);
+  if(shres == CURLSHE_NOT_BUILT_IN) {
+    /* no thread support, run the test on a single lock */
+    shards = 1;
+    shres = curl_share_setopt(share, CURLSHOPT_SSL_SESSION_SHARDS, shards);
+  }
+  if(shres) {
+    fprintf(stderr, "CURLSHOPT_SSL_SESSION_SHARDS failed: %d\n", (int)shres);
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+  shres = curl_share_setopt(share, CURLSHOPT_SHARE,
+                            CURL_LOCK_DATA_SSL_SESSION);
+  printf("share sessions: %d\n", (int)shres);
+
+#ifndef LIB3041
+  /* the cache is set up now and can no longer be split */
+  shres = curl_share_setopt(share, CURLSHOPT_SSL_SESSION_SHARDS, 8L);
+  printf("8 shards when shared: %d\n", (int)shres);
+
+  curl = curl_easy_init();
+  if(!curl) {
+    res = TEST_ERR_EASY_INIT;
+    goto test_cleanup;
+  }
+  test_setopt(curl, CURLOPT_SHARE, share);
+  test_setopt(curl, CURLOPT_SHARE, NULL);
+
+  /* after it is no longer shared, the cache may be split again */
+  shres = curl_share_setopt(share, CURLSHOPT_UNSHARE,
+                            CURL_LOCK_DATA_SSL_SESSION);
+  printf("unshare sessions: %d\n", (int)shres);
+  shres = curl_share_setopt(share, CURLSHOPT_SSL_SESSION_SHARDS, shards);
+  printf("shards when unshared: %d\n", (int)shres);
+  shres = curl_share_setopt(share, CURLSHOPT_SHARE,
+                            CURL_LOCK_DATA_SSL_SESSION);
+  printf("share sessions again: %d\n", (int)shres);
+#endif
+
+  res = sessions(share, URL);
+
+test_cleanup:
+  curl_easy_cleanup(curl);
+  curl_share_cleanup(share);
+  curl_global_cleanup();
+
+  return res;
+}
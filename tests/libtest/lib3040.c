@@ -0,0 +1,107 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "test.h"
+
+#include "memdebug.h"
+
+/*
+ * Have two easy handles share cookies and DNS protected by the built-in
+ * locks. The second transfer sends the cookie the first one got.
+ */
+static CURLcode do_transfer(CURLSH *share, const char *url)
+{
+  CURLcode res = CURLE_OK;
+  CURL *curl = curl_easy_init();
+  if(!curl)
+    return TEST_ERR_EASY_INIT;
+  test_setopt(curl, CURLOPT_SHARE, share);
+  test_setopt(curl, CURLOPT_URL, url);
+  test_setopt(curl, CURLOPT_COOKIEFILE, "");
+  res = curl_easy_perform(curl);
+
+test_cleanup:
+  curl_easy_cleanup(curl);
+  return res;
+}
+
+CURLcode test(char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLSH *share = NULL;
+  CURL *curl = NULL;
+  CURLSHcode shres;
+  struct curl_slist *cookies = NULL;
+  struct curl_slist *c;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  share = curl_share_init();
+  if(!share) {
+    fprintf(stderr, "curl_share_init() failed\n");
+    goto test_cleanup;
+  }
+
+  shres = curl_share_setopt(share, CURLSHOPT_BUILTIN_LOCKS, 1L);
+  if(shres && (shres != CURLSHE_NOT_BUILT_IN)) {
+    /* without thread support, run the test without locks */
+    fprintf(stderr, "CURLSHOPT_BUILTIN_LOCKS failed: %d\n", (int)shres);
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+
+  res = do_transfer(share, URL);
+  if(res)
+    goto test_cleanup;
+
+  res = do_transfer(share, libtest_arg2);
+  if(res)
+    goto test_cleanup;
+
+  curl = curl_easy_init();
+  if(!curl) {
+    res = TEST_ERR_EASY_INIT;
+    goto test_cleanup;
+  }
+  test_setopt(curl, CURLOPT_SHARE, share);
+
+  /* the locks cannot be changed while the share is in use */
+  shres = curl_share_setopt(share, CURLSHOPT_BUILTIN_LOCKS, 0L);
+  printf("disable while in use: %d\n", (int)shres);
+
+  res = curl_easy_getinfo(curl, CURLINFO_COOKIELIST, &cookies);
+  if(res)
+    goto test_cleanup;
+  for(c = cookies; c; c = c->next)
+    printf("%s\n", c->data);
+
+test_cleanup:
+  curl_slist_free_all(cookies);
+  curl_easy_cleanup(curl);
+  curl_share_cleanup(share);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,325 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "hash.h"
+#include "timeval.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Runs random adds, deletes and lookups on a Curl_hash and on a simple
+ * chained hash table as it was used before the open addressing one,
+ * checking that both always agree.
+ *
+ * Set CURL_HASH_BENCH in the environment to also have the time both
+ * take for the same work shown.
+ */
+
+#define NUM_KEYS 5000  /* different keys in use */
+#define NUM_OPS 200000 /* random operations */
+#define BENCH_KEYS 20000
+
+static struct Curl_hash hash_static;
+static size_t dtor_calls;
+static char elems[NUM_KEYS]; /* element of key number N is &elems[N] */
+
+static void mydtor(void *p)
+{
+  (void)p;
+  ++dtor_calls;
+}
+
+static CURLcode unit_setup(void)
+{
+  Curl_hash_init(&hash_static, 7, Curl_hash_str, Curl_str_key_compare,
+                 mydtor);
+  return CURLE_OK;
+}
+
+static void unit_stop(void)
+{
+  Curl_hash_destroy(&hash_static);
+}
+
+/* the reference: a fixed number of slots, each a list of elements */
+struct ref_elem {
+  struct ref_elem *next;
+  void *ptr;
+  size_t key_len;
+  char key[1];
+};
+
+struct ref_hash {
+  struct ref_elem **table;
+  size_t slots;
+  size_t size;
+};
+
+static int ref_init(struct ref_hash *r, size_t slots)
+{
+  r->table = calloc(slots, sizeof(struct ref_elem *));
+  r->slots = slots;
+  r->size = 0;
+  return r->table ? 0 : 1;
+}
+
+static struct ref_elem **ref_find(struct ref_hash *r, const char *key,
+                                  size_t key_len)
+{
+  struct ref_elem **pe =
+    &r->table[Curl_hash_str((void *)key, key_len, r->slots)];
+  while(*pe) {
+    if(Curl_str_key_compare((*pe)->key, (*pe)->key_len,
+                            (void *)key, key_len))
+      break;
+    pe = &(*pe)->next;
+  }
+  return pe;
+}
+
+static int ref_add(struct ref_hash *r, const char *key, size_t key_len,
+                   void *p)
+{
+  struct ref_elem **pe = ref_find(r, key, key_len);
+  if(*pe) {
+    (*pe)->ptr = p;
+    return 0;
+  }
+  *pe = malloc(sizeof(struct ref_elem) + key_len);
+  if(!*pe)
+    return 1;
+  memcpy((*pe)->key, key, key_len);
+  (*pe)->key_len = key_len;
+  (*pe)->ptr = p;
+  (*pe)->next = NULL;
+  r->size++;
+  return 0;
+}
+
+static void *ref_pick(struct ref_hash *r, const char *key, size_t key_len)
+{
+  struct ref_elem **pe = ref_find(r, key, key_len);
+  return *pe ? (*pe)->ptr : NULL;
+}
+
+static int ref_delete(struct ref_hash *r, const char *key, size_t key_len)
+{
+  struct ref_elem **pe = ref_find(r, key, key_len);
+  struct ref_elem *e = *pe;
+  if(!e)
+    return 1;
+  *pe = e->next;
+  free(e);
+  r->size--;
+  return 0;
+}
+
+static void ref_destroy(struct ref_hash *r)
+{
+  size_t i;
+  for(i = 0; i < r->slots; i++) {
+    struct ref_elem *e = r->table[i];
+    while(e) {
+      struct ref_elem *n = e->next;
+      free(e);
+      e = n;
+    }
+  }
+  free(r->table);
+  r->table = NULL;
+}
+
+static unsigned int rnd_state = 4711;
+
+static unsigned int rnd(void)
+{
+  rnd_state = rnd_state * 1103515245 + 12345;
+  return (rnd_state >> 8) & 0xffffff;
+}
+
+static size_t mkkey(char *buf, size_t len, unsigned int n)
+{
+  msnprintf(buf, len, "host%u.example.com:443", n);
+  return strlen(buf) + 1;
+}
+
+static int is_odd(void *user, void *p)
+{
+  (void)user;
+  return (int)(((char *)p - elems) & 1);
+}
+
+static void bench(void)
+{
+  struct Curl_hash h;
+  struct ref_hash r;
+  struct curltime t0;
+  timediff_t us_hash, us_ref;
+  char key[64];
+  unsigned int i, j;
+  size_t found = 0;
+
+  Curl_hash_init(&h, 63, Curl_hash_str, Curl_str_key_compare, mydtor);
+  if(ref_init(&r, 63))
+    return;
+
+  t0 = Curl_now();
+  for(i = 0; i < BENCH_KEYS; i++) {
+    size_t klen = mkkey(key, sizeof(key), i);
+    Curl_hash_add(&h, key, klen, key);
+  }
+  for(j = 0; j < 10; j++) {
+    for(i = 0; i < BENCH_KEYS; i++) {
+      size_t klen = mkkey(key, sizeof(key), i * 2);
+      if(Curl_hash_pick(&h, key, klen))
+        found++;
+    }
+  }
+  for(i = 0; i < BENCH_KEYS; i++) {
+    size_t klen = mkkey(key, sizeof(key), i);
+    Curl_hash_delete(&h, key, klen);
+  }
+  us_hash = Curl_timediff_us(Curl_now(), t0);
+
+  t0 = Curl_now();
+  for(i = 0; i < BENCH_KEYS; i++) {
+    size_t klen = mkkey(key, sizeof(key), i);
+    ref_add(&r, key, klen, key);
+  }
+  for(j = 0; j < 10; j++) {
+    for(i = 0; i < BENCH_KEYS; i++) {
+      size_t klen = mkkey(key, sizeof(key), i * 2);
+      if(ref_pick(&r, key, klen))
+        found++;
+    }
+  }
+  for(i = 0; i < BENCH_KEYS; i++) {
+    size_t klen = mkkey(key, sizeof(key), i);
+    ref_delete(&r, key, klen);
+  }
+  us_ref = Curl_timediff_us(Curl_now(), t0);
+
+  fprintf(stderr, "%u adds, %u lookups (%zu hits each), %u deletes: "
+          "open addressing %" FMT_TIMEDIFF_T " us, "
+          "chained %" FMT_TIMEDIFF_T " us\n",
+          BENCH_KEYS, BENCH_KEYS * 10, found / 2, BENCH_KEYS,
+          us_hash, us_ref);
+
+  Curl_hash_destroy(&h);
+  ref_destroy(&r);
+}
+
+UNITTEST_START
+{
+  struct ref_hash ref;
+  struct Curl_hash_iterator iter;
+  struct Curl_hash_element *he;
+  char key[64];
+  size_t klen;
+  size_t n, total;
+  unsigned int i;
+
+  abort_unless(!ref_init(&ref, 7), "out of memory");
+
+  for(i = 0; i < NUM_OPS; i++) {
+    unsigned int r = rnd();
+    unsigned int k = r % NUM_KEYS;
+    void *p = &elems[k];
+    klen = mkkey(key, sizeof(key), k);
+
+    switch((r >> 16) % 4) {
+    case 0:
+    case 1:
+      abort_unless(Curl_hash_add(&hash_static, key, klen, p) == p,
+                   "add failed");
+      abort_unless(!ref_add(&ref, key, klen, p), "out of memory");
+      break;
+    case 2:
+      fail_unless(Curl_hash_delete(&hash_static, key, klen) ==
+                  ref_delete(&ref, key, klen), "delete differs");
+      break;
+    default:
+      fail_unless(Curl_hash_pick(&hash_static, key, klen) ==
+                  ref_pick(&ref, key, klen), "pick differs");
+      break;
+    }
+    if(Curl_hash_count(&hash_static) != ref.size) {
+      fail_unless(Curl_hash_count(&hash_static) == ref.size,
+                  "count differs");
+      break;
+    }
+  }
+  fail_unless(hash_static.slots * 3 >= Curl_hash_count(&hash_static) * 4,
+              "table did not grow");
+  fail_unless(!(hash_static.slots & (hash_static.slots - 1)),
+              "table size is not a power of two");
+
+  /* every element is seen once when iterating, deleting some of them as
+     they are returned does not disturb that */
+  n = 0;
+  total = ref.size;
+  Curl_hash_start_iterate(&hash_static, &iter);
+  for(he = Curl_hash_next_element(&iter); he;
+      he = Curl_hash_next_element(&iter)) {
+    fail_unless(ref_pick(&ref, he->key, he->key_len) == he->ptr,
+                "iterated element not in reference");
+    if(n & 1) {
+      klen = he->key_len;
+      memcpy(key, he->key, klen);
+      fail_unless(!Curl_hash_delete(&hash_static, key, klen),
+                  "delete while iterating failed");
+      ref_delete(&ref, key, klen);
+    }
+    n++;
+  }
+  fail_unless(n == total, "iteration missed elements");
+  fail_unless(Curl_hash_count(&hash_static) == ref.size, "count differs");
+
+  /* drop the elements with odd pointers, the even ones remain */
+  dtor_calls = 0;
+  n = Curl_hash_count(&hash_static);
+  Curl_hash_clean_with_criterium(&hash_static, NULL, is_odd);
+  fail_unless(dtor_calls + Curl_hash_count(&hash_static) == n,
+              "clean lost elements");
+  for(i = 0; i < NUM_KEYS; i++) {
+    void *p;
+    klen = mkkey(key, sizeof(key), i);
+    p = Curl_hash_pick(&hash_static, key, klen);
+    if(p)
+      fail_unless(!is_odd(NULL, p), "odd element left");
+  }
+
+  Curl_hash_clean(&hash_static);
+  fail_unless(!Curl_hash_count(&hash_static), "hash not empty");
+  fail_unless(!hash_static.used, "slots still in use");
+  klen = mkkey(key, sizeof(key), 1);
+  fail_unless(!Curl_hash_pick(&hash_static, key, klen), "found in empty");
+
+  ref_destroy(&ref);
+
+  if(getenv("CURL_HASH_BENCH"))
+    bench();
+}
+UNITTEST_STOP
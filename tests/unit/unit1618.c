@@ -0,0 +1,252 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "splay.h"
+#include "timewheel.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Runs the same timers through a timer wheel and a splay tree, checking
+ * that both agree on the earliest expire time and on what has expired.
+ *
+ * Set CURL_TIMER_BENCH in the environment to also have the time both take
+ * for the same work shown.
+ */
+
+#define NUM_TIMERS 2000
+#define NUM_ROUNDS 3000
+#define BENCH_TIMERS 50000
+#define BENCH_ROUNDS 20
+
+struct timer {
+  struct Curl_wheel_node wnode;
+  struct Curl_tree snode;
+  bool in_wheel;
+  bool in_tree;
+};
+
+static struct timer *timers;
+
+static CURLcode unit_setup(void)
+{
+  timers = calloc(BENCH_TIMERS, sizeof(*timers));
+  return timers ? CURLE_OK : CURLE_OUT_OF_MEMORY;
+}
+
+static void unit_stop(void)
+{
+  free(timers);
+}
+
+static unsigned int rnd_state = 4711;
+
+static unsigned int rnd(void)
+{
+  rnd_state = rnd_state * 1103515245 + 12345;
+  return (rnd_state >> 8) & 0xffffff;
+}
+
+/* `t` moved ahead by `us` microseconds */
+static struct curltime later(struct curltime t, curl_uint64_t us)
+{
+  t.tv_sec += (time_t)(us / 1000000);
+  t.tv_usec += (int)(us % 1000000);
+  if(t.tv_usec >= 1000000) {
+    t.tv_sec++;
+    t.tv_usec -= 1000000;
+  }
+  return t;
+}
+
+/* a random delay, mostly short but a few very far away */
+static curl_uint64_t rnd_delay(void)
+{
+  unsigned int r = rnd();
+  switch(r % 8) {
+  case 0:
+    return r % 1000;                         /* below a millisecond */
+  case 1:
+  case 2:
+  case 3:
+    return (curl_uint64_t)(r % 200) * 1000;  /* 200 ms */
+  case 4:
+  case 5:
+    return (curl_uint64_t)(r % 60000) * 1000; /* a minute */
+  case 6:
+    return (curl_uint64_t)r * 1000;          /* hours */
+  default:
+    /* beyond the last level of the wheel */
+    return (curl_uint64_t)r * 1000000 * 1000;
+  }
+}
+
+static void bench(struct curltime start)
+{
+  struct Curl_wheel wheel;
+  struct Curl_tree *root = NULL;
+  struct curltime now = start;
+  struct curltime t0;
+  timediff_t us_wheel, us_splay;
+  curl_uint64_t *delays;
+  size_t i, r;
+
+  delays = malloc(BENCH_TIMERS * BENCH_ROUNDS * sizeof(*delays));
+  if(!delays)
+    return;
+  for(i = 0; i < BENCH_TIMERS * BENCH_ROUNDS; i++)
+    delays[i] = (rnd() % 10000) * 1000;
+  memset(timers, 0, BENCH_TIMERS * sizeof(*timers));
+
+  /* every round, all timers are set again, then a second passes */
+  t0 = Curl_now();
+  Curl_wheel_init(&wheel);
+  for(r = 0; r < BENCH_ROUNDS; r++) {
+    struct Curl_wheel_node *n;
+    for(i = 0; i < BENCH_TIMERS; i++) {
+      struct timer *t = &timers[i];
+      Curl_wheel_remove(&wheel, &t->wnode);
+      Curl_wheel_add(&wheel, later(now, delays[r * BENCH_TIMERS + i]),
+                     &t->wnode);
+    }
+    now = later(now, 1000000);
+    do {
+      n = Curl_wheel_getbest(&wheel, now);
+    } while(n);
+  }
+  us_wheel = Curl_timediff_us(Curl_now(), t0);
+
+  now = start;
+  t0 = Curl_now();
+  for(r = 0; r < BENCH_ROUNDS; r++) {
+    struct Curl_tree *n;
+    for(i = 0; i < BENCH_TIMERS; i++) {
+      struct timer *t = &timers[i];
+      if(t->in_tree)
+        Curl_splayremove(root, &t->snode, &root);
+      root = Curl_splayinsert(later(now, delays[r * BENCH_TIMERS + i]),
+                              root, &t->snode);
+      Curl_splayset(&t->snode, t);
+      t->in_tree = TRUE;
+    }
+    now = later(now, 1000000);
+    do {
+      root = Curl_splaygetbest(now, root, &n);
+      if(n)
+        ((struct timer *)Curl_splayget(n))->in_tree = FALSE;
+    } while(n);
+  }
+  us_splay = Curl_timediff_us(Curl_now(), t0);
+
+  fprintf(stderr, "%d timers set %d times: wheel %" FMT_TIMEDIFF_T " us, "
+          "splay %" FMT_TIMEDIFF_T " us\n",
+          BENCH_TIMERS, BENCH_ROUNDS, us_wheel, us_splay);
+  free(delays);
+}
+
+UNITTEST_START
+{
+  struct Curl_wheel wheel;
+  struct Curl_tree *root = NULL;
+  struct curltime start = { 1700000000, 0 };
+  struct curltime now = start;
+  size_t i, r;
+
+  Curl_wheel_init(&wheel);
+  for(r = 0; r < NUM_ROUNDS; r++) {
+    struct curltime wkey, skey;
+    bool have_w, have_s;
+
+    /* change a few timers: drop them and perhaps set them again */
+    for(i = 0; i < 10; i++) {
+      struct timer *t = &timers[rnd() % NUM_TIMERS];
+      int rc = Curl_wheel_remove(&wheel, &t->wnode);
+      fail_unless(rc == !t->in_wheel, "wheel remove result");
+      t->in_wheel = FALSE;
+      if(t->in_tree) {
+        Curl_splayremove(root, &t->snode, &root);
+        t->in_tree = FALSE;
+      }
+      if(rnd() % 4) {
+        struct curltime key = later(now, rnd_delay());
+        Curl_wheelset(&t->wnode, t);
+        Curl_wheel_add(&wheel, key, &t->wnode);
+        Curl_splayset(&t->snode, t);
+        root = Curl_splayinsert(key, root, &t->snode);
+        t->in_wheel = t->in_tree = TRUE;
+      }
+    }
+
+    /* both know the same earliest time */
+    have_w = Curl_wheel_first(&wheel, &wkey);
+    have_s = !!root;
+    if(root) {
+      root = Curl_splay(start, root);
+      skey = root->key;
+    }
+    fail_unless(have_w == have_s, "wheel and splay differ in being empty");
+    if(have_w && have_s)
+      fail_unless(!Curl_timediff_us(wkey, skey), "earliest time differs");
+
+    /* let time pass, sometimes up to the earliest timer */
+    if(have_w && !(rnd() % 3) && (Curl_timediff_us(wkey, now) > 0))
+      now = wkey;
+    else
+      now = later(now, rnd_delay() / 64);
+
+    /* both expire the same timers */
+    for(;;) {
+      struct Curl_wheel_node *wn = Curl_wheel_getbest(&wheel, now);
+      struct timer *t;
+      if(!wn)
+        break;
+      t = Curl_wheelget(wn);
+      fail_unless(Curl_timediff_us(wn->key, now) <= 0, "expired too early");
+      fail_unless(t->in_wheel, "expired twice");
+      t->in_wheel = FALSE;
+    }
+    for(;;) {
+      struct Curl_tree *sn;
+      struct timer *t;
+      root = Curl_splaygetbest(now, root, &sn);
+      if(!sn)
+        break;
+      t = Curl_splayget(sn);
+      fail_unless(!t->in_wheel, "splay expired what the wheel did not");
+      t->in_tree = FALSE;
+    }
+    for(i = 0; i < NUM_TIMERS; i++) {
+      if(timers[i].in_wheel != timers[i].in_tree) {
+        fail_unless(timers[i].in_wheel == timers[i].in_tree,
+                    "wheel did not expire what splay did");
+        break;
+      }
+    }
+  }
+
+  if(getenv("CURL_TIMER_BENCH"))
+    bench(start);
+}
+UNITTEST_STOP
@@ -0,0 +1,226 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "urldata.h"
+#include "http.h"
+#include "strcase.h"
+#include "timeval.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Checks that http_header_id() finds the response header fields
+ * Curl_http_header() acts on, and nothing else, the same as comparing the
+ * header with the names starting with the same letter in turn does.
+ *
+ * Set CURL_HEADER_BENCH in the environment to also have the time both take
+ * for a set of typical response headers shown.
+ */
+
+static CURLcode unit_setup(void)
+{
+  return CURLE_OK;
+}
+
+static void unit_stop(void)
+{
+}
+
+#ifndef CURL_DISABLE_HTTP
+
+#define BENCH_ROUNDS 200000
+
+static const struct {
+  const char *name;
+  enum http_hd id;
+} known[] = {
+  { "Alt-Svc", HTTP_HD_ALT_SVC },
+  { "Connection", HTTP_HD_CONNECTION },
+  { "Content-Encoding", HTTP_HD_CONTENT_ENCODING },
+  { "Content-Length", HTTP_HD_CONTENT_LENGTH },
+  { "Content-Range", HTTP_HD_CONTENT_RANGE },
+  { "Content-Type", HTTP_HD_CONTENT_TYPE },
+  { "Last-Modified", HTTP_HD_LAST_MODIFIED },
+  { "Location", HTTP_HD_LOCATION },
+  { "Persistent-Auth", HTTP_HD_PERSISTENT_AUTH },
+  { "Proxy-authenticate", HTTP_HD_PROXY_AUTHENTICATE },
+  { "Proxy-Connection", HTTP_HD_PROXY_CONNECTION },
+  { "Retry-After", HTTP_HD_RETRY_AFTER },
+  { "Set-Cookie", HTTP_HD_SET_COOKIE },
+  { "Strict-Transport-Security", HTTP_HD_STRICT_TRANSPORT_SECURITY },
+  { "Trailer", HTTP_HD_TRAILER },
+  { "Transfer-Encoding", HTTP_HD_TRANSFER_ENCODING },
+  { "WWW-Authenticate", HTTP_HD_WWW_AUTHENTICATE },
+};
+
+/* the headers of a typical response, to an API request */
+static const char *response[] = {
+  "Date: Wed, 16 Oct 2024 10:12:01 GMT\r\n",
+  "Content-Type: application/json; charset=utf-8\r\n",
+  "Content-Length: 1432\r\n",
+  "Connection: keep-alive\r\n",
+  "Server: nginx\r\n",
+  "Cache-Control: no-cache, no-store, must-revalidate\r\n",
+  "Pragma: no-cache\r\n",
+  "Expires: 0\r\n",
+  "ETag: W/\"598-Zz4YpGxtTMXKx8E7r3Bq1Yt0J2c\"\r\n",
+  "Vary: Accept-Encoding, Origin\r\n",
+  "Access-Control-Allow-Origin: *\r\n",
+  "Access-Control-Allow-Credentials: true\r\n",
+  "X-Request-Id: 2d6f0b6c-1c1e-4f4e-9bbd-3b0b0f6a1c55\r\n",
+  "X-RateLimit-Limit: 5000\r\n",
+  "X-RateLimit-Remaining: 4987\r\n",
+  "X-RateLimit-Reset: 1729073521\r\n",
+  "X-Content-Type-Options: nosniff\r\n",
+  "X-Frame-Options: DENY\r\n",
+  "Referrer-Policy: strict-origin-when-cross-origin\r\n",
+  "Strict-Transport-Security: max-age=31536000; includeSubDomains\r\n",
+  "Set-Cookie: session=38afes7a8; Path=/; Secure; HttpOnly\r\n",
+  "Content-Security-Policy: default-src 'none'\r\n",
+  "Alt-Svc: h3=\":443\"; ma=86400\r\n",
+  "Via: 1.1 varnish\r\n",
+  "Age: 0\r\n",
+  "Last-Modified: Tue, 15 Oct 2024 08:00:00 GMT\r\n",
+  "Accept-Ranges: bytes\r\n",
+  "Transfer-Encoding: chunked\r\n",
+  "\r\n",
+};
+
+/* the header as found by comparing it with each of the names starting
+   with the same letter, one by one */
+static enum http_hd ref_id(const char *hd, size_t hdlen)
+{
+  size_t i;
+  for(i = 0; i < sizeof(known)/sizeof(known[0]); i++) {
+    const char *name = known[i].name;
+    size_t len;
+    if(Curl_raw_tolower(name[0]) != Curl_raw_tolower(hd[0]))
+      continue;
+    len = strlen(name);
+    if((hdlen > len) && strncasecompare(name, hd, len) && (hd[len] == ':'))
+      return known[i].id;
+  }
+  return HTTP_HD_OTHER;
+}
+
+static void check(const char *hd, enum http_hd expect)
+{
+  size_t namelen = 0;
+  enum http_hd id = http_header_id(hd, strlen(hd), &namelen);
+  if(id != expect) {
+    fprintf(stderr, "%s: got %d, expected %d\n", hd, (int)id, (int)expect);
+    fail("wrong header id");
+  }
+  else if((id != HTTP_HD_OTHER) && (hd[namelen] != ':'))
+    fail("wrong name length");
+}
+
+static void bench(void)
+{
+  size_t n = sizeof(response)/sizeof(response[0]);
+  size_t lens[sizeof(response)/sizeof(response[0])];
+  struct curltime t0;
+  timediff_t us_hash, us_ref;
+  size_t i, r, found = 0;
+
+  for(i = 0; i < n; i++)
+    lens[i] = strlen(response[i]);
+
+  t0 = Curl_now();
+  for(r = 0; r < BENCH_ROUNDS; r++) {
+    for(i = 0; i < n; i++) {
+      size_t namelen;
+      found += http_header_id(response[i], lens[i], &namelen);
+    }
+  }
+  us_hash = Curl_timediff_us(Curl_now(), t0);
+
+  t0 = Curl_now();
+  for(r = 0; r < BENCH_ROUNDS; r++) {
+    for(i = 0; i < n; i++)
+      found += ref_id(response[i], lens[i]);
+  }
+  us_ref = Curl_timediff_us(Curl_now(), t0);
+
+  fprintf(stderr, "%d x %zu headers (%zu): lookup %" FMT_TIMEDIFF_T " us, "
+          "compare %" FMT_TIMEDIFF_T " us\n",
+          BENCH_ROUNDS, n, found, us_hash, us_ref);
+}
+
+UNITTEST_START
+{
+  char buf[128];
+  size_t i;
+
+  for(i = 0; i < sizeof(known)/sizeof(known[0]); i++) {
+    const char *name = known[i].name;
+    size_t len = strlen(name);
+    size_t j;
+
+    msnprintf(buf, sizeof(buf), "%s: value\r\n", name);
+    check(buf, known[i].id);
+
+    /* any case */
+    for(j = 0; j < len; j++)
+      buf[j] = Curl_raw_toupper(name[j]);
+    check(buf, known[i].id);
+    for(j = 0; j < len; j++)
+      buf[j] = Curl_raw_tolower(name[j]);
+    check(buf, known[i].id);
+
+    /* no colon right after the name */
+    msnprintf(buf, sizeof(buf), "%s : value\r\n", name);
+    check(buf, HTTP_HD_OTHER);
+    msnprintf(buf, sizeof(buf), "%s\r\n", name);
+    check(buf, HTTP_HD_OTHER);
+
+    /* longer and shorter names */
+    msnprintf(buf, sizeof(buf), "%sx: value\r\n", name);
+    check(buf, HTTP_HD_OTHER);
+    msnprintf(buf, sizeof(buf), "%.*s: value\r\n", (int)len - 1, name);
+    check(buf, HTTP_HD_OTHER);
+    msnprintf(buf, sizeof(buf), "X-%s: value\r\n", name);
+    check(buf, HTTP_HD_OTHER);
+  }
+
+  check(":\r\n", HTTP_HD_OTHER);
+  check("\r\n", HTTP_HD_OTHER);
+  check("Trailer:", HTTP_HD_TRAILER);
+
+  /* the same answers as comparing names one by one */
+  for(i = 0; i < sizeof(response)/sizeof(response[0]); i++)
+    check(response[i], ref_id(response[i], strlen(response[i])));
+
+  if(getenv("CURL_HEADER_BENCH"))
+    bench();
+}
+UNITTEST_STOP
+
+#else
+
+UNITTEST_START
+UNITTEST_STOP
+
+#endif
@@ -103,6 +103,23 @@ UNITTEST_START
   fail_if(result, "Curl_altsvc_parse(6) failed!");
   fail_unless(Curl_llist_count(&asi->list) == 10, "wrong number of entries");
 
+  /* the entries of an origin are found by hostname, any case and with a
+     trailing dot, in the order they were added */
+  {
+    struct altsvc *as;
+    fail_unless(Curl_altsvc_lookup(asi, ALPN_h1, "3.EXAMPLE.org.", 8080, &as,
+                                   CURLALTSVC_H2 | CURLALTSVC_H3) &&
+                !strcmp(as->dst.host, "example.com"), "lookup failed");
+    fail_unless(Curl_altsvc_lookup(asi, ALPN_h1, "3.example.org", 8080, &as,
+                                   CURLALTSVC_H3) &&
+                !strcmp(as->dst.host, "yesyes.com"), "lookup(2) failed");
+    fail_if(Curl_altsvc_lookup(asi, ALPN_h1, "3.example.org", 80, &as,
+                               CURLALTSVC_H3), "lookup(3) matched port");
+    fail_if(Curl_altsvc_lookup(asi, ALPN_h1, "curl.se", 80, &as,
+                               CURLALTSVC_H2 | CURLALTSVC_H3),
+            "lookup(4) matched a cleared origin");
+  }
+
   Curl_altsvc_save(curl, asi, outname);
 
   curl_easy_cleanup(curl);
@@ -250,6 +250,70 @@ static void check_bufq(size_t pool_spares,
     Curl_bufcp_free(&pool);
 }
 
+/* two pools share their spares, which are trimmed to half of the max when
+   more are given back */
+static void check_bufc_share(void)
+{
+  struct bufc_share share;
+  struct bufc_pool pool1, pool2, pool3;
+  struct bufq q1, q2, q3;
+  unsigned char buf[1024];
+  CURLcode result;
+  ssize_t n;
+
+  Curl_bufcs_init(&share, 4 * 1024);
+  Curl_bufcp_init(&pool1, 1024, 8);
+  Curl_bufcp_init(&pool2, 1024, 8);
+  Curl_bufcp_init(&pool3, 512, 8);
+  Curl_bufcp_use_share(&pool1, &share);
+  Curl_bufcp_use_share(&pool2, &share);
+  Curl_bufcp_use_share(&pool3, &share);
+  Curl_bufq_initp(&q1, &pool1, 8, BUFQ_OPT_NONE);
+  Curl_bufq_initp(&q2, &pool2, 8, BUFQ_OPT_NONE);
+  Curl_bufq_initp(&q3, &pool3, 8, BUFQ_OPT_NONE);
+
+  /* chunks read empty on q1 are given to q2 */
+  n = Curl_bufq_write(&q1, test_data, 3 * 1024, &result);
+  fail_unless(n == 3 * 1024, "share: write q1 failed");
+  fail_unless(share.misses == 3, "share: q1 chunks not allocated");
+  while(!Curl_bufq_is_empty(&q1))
+    (void)Curl_bufq_read(&q1, buf, sizeof(buf), &result);
+  fail_unless(share.spare_bytes == 3 * 1024, "share: q1 chunks not kept");
+  fail_unless(!pool1.spare, "share: pool kept spares of its own");
+  n = Curl_bufq_write(&q2, test_data, 2 * 1024, &result);
+  fail_unless(n == 2 * 1024, "share: write q2 failed");
+  fail_unless(share.hits == 2, "share: q2 did not reuse q1 chunks");
+  fail_unless(share.spare_bytes == 1024, "share: spare bytes wrong");
+
+  /* a pool of another chunk size does not get them */
+  n = Curl_bufq_write(&q3, test_data, 512, &result);
+  fail_unless(n == 512, "share: write q3 failed");
+  fail_unless(share.hits == 2, "share: q3 took a chunk of another size");
+  fail_unless(share.misses == 4, "share: q3 chunk not allocated");
+
+  /* going over the max trims down to half of it */
+  n = Curl_bufq_write(&q1, test_data, 4 * 1024, &result);
+  fail_unless(n == 4 * 1024, "share: write q1 again failed");
+  while(!Curl_bufq_is_empty(&q2))
+    (void)Curl_bufq_read(&q2, buf, sizeof(buf), &result);
+  while(!Curl_bufq_is_empty(&q1))
+    (void)Curl_bufq_read(&q1, buf, sizeof(buf), &result);
+  fail_unless(share.trimmed, "share: nothing trimmed");
+  fail_unless(share.spare_bytes <= 4 * 1024, "share: kept over the max");
+
+  Curl_bufcs_set_max(&share, 1024);
+  fail_unless(share.spare_bytes <= 512, "share: new max not applied");
+
+  Curl_bufq_free(&q1);
+  Curl_bufq_free(&q2);
+  Curl_bufq_free(&q3);
+  Curl_bufcp_free(&pool1);
+  Curl_bufcp_free(&pool2);
+  Curl_bufcp_free(&pool3);
+  Curl_bufcs_free(&share);
+  fail_unless(!share.spare_bytes, "share: spares left after free");
+}
+
 UNITTEST_START
   struct bufq q;
   ssize_t n;
@@ -278,4 +342,6 @@ UNITTEST_START
   check_bufq(8, 8000, 10, 1234, 1234, BUFQ_OPT_NONE);
   check_bufq(8, 1024, 4, 129, 127, BUFQ_OPT_NO_SPARES);
 
+  check_bufc_share();
+
 UNITTEST_STOP
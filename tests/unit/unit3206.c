@@ -0,0 +1,148 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "urldata.h"
+#include "conncache.h"
+#include "multihandle.h"
+
+#include "memdebug.h" /* LAST include file */
+
+extern struct connectdata *cpool_get_oldest_idle(struct cpool *cpool,
+                                                 struct cpool_shard *locked,
+                                                 struct cpool_shard **pshard);
+extern void cpool_remove_conn(struct cpool *cpool,
+                              struct connectdata *conn);
+
+/* connections in the pool and the number of destinations they spread on */
+#define NUM_CONNS 100000
+#define NUM_DESTS 1000
+
+static CURL *easy;
+static CURLM *multi;
+static struct connectdata **conns;
+
+static CURLcode unit_setup(void)
+{
+  CURLcode res = CURLE_OK;
+
+  global_init(CURL_GLOBAL_ALL);
+  multi = curl_multi_init();
+  easy = curl_easy_init();
+  conns = calloc(NUM_CONNS, sizeof(*conns));
+  if(!multi || !easy || !conns) {
+    curl_easy_cleanup(easy);
+    curl_multi_cleanup(multi);
+    free(conns);
+    curl_global_cleanup();
+    return CURLE_OUT_OF_MEMORY;
+  }
+  /* no automatic eviction, the test drives it */
+  curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)NUM_CONNS * 2);
+  curl_multi_add_handle(multi, easy);
+  return res;
+}
+
+static void unit_stop(void)
+{
+  size_t i;
+  for(i = 0; i < NUM_CONNS; i++) {
+    if(conns[i]) {
+      free(conns[i]->destination);
+      free(conns[i]);
+    }
+  }
+  free(conns);
+  curl_multi_remove_handle(multi, easy);
+  curl_easy_cleanup(easy);
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+}
+
+static struct connectdata *fake_conn(size_t dest)
+{
+  struct connectdata *conn = calloc(1, sizeof(*conn));
+  if(conn) {
+    conn->destination = aprintf("host%zu.example:443", dest);
+    if(!conn->destination) {
+      free(conn);
+      return NULL;
+    }
+    conn->destination_len = strlen(conn->destination) + 1;
+    Curl_llist_init(&conn->easyq, NULL);
+  }
+  return conn;
+}
+
+/* Evict all connections in LRU order, expecting 'first' to be the oldest,
+   wrapping around at NUM_CONNS. */
+static void evict_all(struct Curl_easy *data, size_t first)
+{
+  struct cpool *cpool = &data->multi->cpool;
+  struct cpool_shard *shard = NULL;
+  size_t i;
+
+  for(i = 0; i < NUM_CONNS; i++) {
+    struct connectdata *expected = conns[(first + i) % NUM_CONNS];
+    struct connectdata *conn = cpool_get_oldest_idle(cpool, NULL, &shard);
+    if(conn != expected) {
+      fail_unless(conn == expected, "idle connection not in LRU order");
+      break;
+    }
+    fail_unless(shard, "no shard returned");
+    cpool_remove_conn(cpool, conn);
+  }
+  fail_unless(!cpool->num_conn, "pool not empty after evicting all");
+  fail_unless(!cpool_get_oldest_idle(cpool, NULL, &shard),
+              "idle connection found in empty pool");
+}
+
+UNITTEST_START
+{
+  struct Curl_easy *data = easy;
+  size_t i;
+
+  /* spread the connections round-robin on the destinations, so that the
+     per-destination order differs from the global idle order */
+  for(i = 0; i < NUM_CONNS; i++) {
+    conns[i] = fake_conn(i % NUM_DESTS);
+    abort_unless(conns[i], "out of memory");
+    abort_unless(!Curl_cpool_add_conn(data, conns[i]), "add failed");
+  }
+  abort_unless(data->multi->cpool.num_conn == NUM_CONNS, "wrong count");
+
+  for(i = 0; i < NUM_CONNS; i++)
+    fail_unless(Curl_cpool_conn_now_idle(data, conns[i]), "not kept");
+  evict_all(data, 0);
+
+  /* refill, then use the first half again: they become the youngest */
+  for(i = 0; i < NUM_CONNS; i++) {
+    abort_unless(!Curl_cpool_add_conn(data, conns[i]), "add failed");
+    fail_unless(Curl_cpool_conn_now_idle(data, conns[i]), "not kept");
+  }
+  for(i = 0; i < NUM_CONNS / 2; i++)
+    fail_unless(Curl_cpool_conn_now_idle(data, conns[i]), "not kept");
+  evict_all(data, NUM_CONNS / 2);
+}
+UNITTEST_STOP
@@ -0,0 +1,184 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "urldata.h"
+#include "http_chunks.h"
+#include "timeval.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Runs chunked bodies through the chunk parser, all at once and split in
+ * pieces of every size, checking that it ends up the same way.
+ *
+ * Set CURL_CHUNK_BENCH in the environment to also have the time it takes
+ * to parse a body of many small chunks shown.
+ */
+
+static struct Curl_easy *easy;
+
+static CURLcode unit_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  easy = curl_easy_init();
+  if(!easy) {
+    curl_global_cleanup();
+    return CURLE_OUT_OF_MEMORY;
+  }
+  /* neither body nor trailers are passed on */
+  easy->set.http_te_skip = TRUE;
+  return res;
+}
+
+static void unit_stop(void)
+{
+  curl_easy_cleanup(easy);
+  curl_global_cleanup();
+}
+
+#ifndef CURL_DISABLE_HTTP
+
+#define BENCH_CHUNKS 100000
+#define BENCH_ROUNDS 20
+
+/* Parse `body` in pieces of `step` bytes, 0 for all at once. Returns the
+   parser's last code and sets `*pleft` to the bytes left after the body. */
+static CHUNKcode parse(const char *body, size_t step, size_t *pleft)
+{
+  struct Curl_chunker ch;
+  size_t len = strlen(body);
+  size_t offset = 0;
+  CHUNKcode code = CHUNKE_OK;
+
+  *pleft = 0;
+  Curl_httpchunk_init(easy, &ch, TRUE);
+  while(offset < len) {
+    size_t blen = (step && (len - offset > step)) ? step : len - offset;
+    size_t consumed = 0;
+    CURLcode result = Curl_httpchunk_read(easy, &ch, (char *)body + offset,
+                                          blen, &consumed);
+    if(result) {
+      code = ch.last_code;
+      break;
+    }
+    fail_unless(consumed <= blen, "consumed more than given");
+    offset += consumed;
+    if(Curl_httpchunk_is_done(easy, &ch)) {
+      fail_unless((size_t)ch.datasize == blen - consumed,
+                  "wrong amount left after the body");
+      *pleft = len - offset;
+      break;
+    }
+    fail_unless(consumed == blen, "not all consumed before the end");
+  }
+  if(!code && !Curl_httpchunk_is_done(easy, &ch))
+    code = CHUNKE_BAD_CHUNK;
+  Curl_httpchunk_free(easy, &ch);
+  return code;
+}
+
+static void check(const char *body, CHUNKcode expect, size_t left)
+{
+  size_t len = strlen(body);
+  size_t step;
+
+  for(step = 0; step <= len; step++) {
+    size_t got_left;
+    CHUNKcode code = parse(body, step, &got_left);
+    if(code != expect) {
+      fprintf(stderr, "in pieces of %zu: got %d, expected %d\n",
+              step, (int)code, (int)expect);
+      fail("wrong result");
+      break;
+    }
+    if(!code && (got_left != left)) {
+      fprintf(stderr, "in pieces of %zu: %zu left, expected %zu\n",
+              step, got_left, left);
+      fail("wrong amount left");
+      break;
+    }
+  }
+}
+
+static void bench(void)
+{
+  char *body;
+  const char *chunk = "10\r\n0123456789abcdef\r\n";
+  size_t clen = strlen(chunk);
+  size_t len = BENCH_CHUNKS * clen + 5;
+  struct curltime t0;
+  timediff_t us;
+  size_t i;
+
+  body = malloc(len + 1);
+  if(!body)
+    return;
+  for(i = 0; i < BENCH_CHUNKS; i++)
+    memcpy(body + i * clen, chunk, clen);
+  strcpy(body + BENCH_CHUNKS * clen, "0\r\n\r\n");
+
+  t0 = Curl_now();
+  for(i = 0; i < BENCH_ROUNDS; i++) {
+    struct Curl_chunker ch;
+    size_t consumed;
+    Curl_httpchunk_init(easy, &ch, TRUE);
+    (void)Curl_httpchunk_read(easy, &ch, body, len, &consumed);
+    fail_unless(Curl_httpchunk_is_done(easy, &ch), "bench body not done");
+    Curl_httpchunk_free(easy, &ch);
+  }
+  us = Curl_timediff_us(Curl_now(), t0);
+
+  fprintf(stderr, "%d x %d chunks of 16 bytes: %" FMT_TIMEDIFF_T " us\n",
+          BENCH_ROUNDS, BENCH_CHUNKS, us);
+  free(body);
+}
+
+UNITTEST_START
+{
+  check("0\r\n\r\n", CHUNKE_OK, 0);
+  check("5\r\nhello\r\n7\r\n, world\r\n0\r\n\r\n", CHUNKE_OK, 0);
+  /* extensions, trailers and data after the body */
+  check("5;name=value\r\nhello\r\n0;last\r\n"
+        "X-Trailer: yes\r\nY: z\r\n\r\nextra", CHUNKE_OK, 5);
+  /* LF only */
+  check("5\nhello\n0\n\n", CHUNKE_OK, 0);
+  /* as long a size as is supported, and one digit more */
+  check("0000000000000005\r\nhello\r\n0\r\n\r\n", CHUNKE_OK, 0);
+  check("00000000000000005\r\nhello\r\n0\r\n\r\n", CHUNKE_TOO_LONG_HEX, 0);
+  check("x\r\n", CHUNKE_ILLEGAL_HEX, 0);
+  check("5\r\nhelloX\r\n", CHUNKE_BAD_CHUNK, 0);
+
+  if(getenv("CURL_CHUNK_BENCH"))
+    bench();
+}
+UNITTEST_STOP
+
+#else
+
+UNITTEST_START
+UNITTEST_STOP
+
+#endif
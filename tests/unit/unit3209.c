@@ -0,0 +1,287 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "urldata.h"
+#include "headers.h"
+#include "strcase.h"
+#include "timeval.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Stores random headers, some of them folded, over a few requests and
+ * checks that curl_easy_header() and curl_easy_nextheader() find what a
+ * plain search through them finds.
+ *
+ * Set CURL_HEADERS_BENCH in the environment to also have the time it takes
+ * to store and look up the headers of many responses shown.
+ */
+
+static struct Curl_easy *easy;
+
+static CURLcode unit_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  easy = curl_easy_init();
+  if(!easy) {
+    curl_global_cleanup();
+    return CURLE_OUT_OF_MEMORY;
+  }
+  return res;
+}
+
+static void unit_stop(void)
+{
+  curl_easy_cleanup(easy);
+  curl_global_cleanup();
+}
+
+#if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_HEADERS_API)
+
+#define NUM_HEADERS 600
+#define NUM_REQUESTS 3
+#define BENCH_RESPONSES 20000
+
+static const char *names[] = {
+  "Content-Type", "Set-Cookie", "Date", "Via", "X-Custom-Header",
+  "Cache-Control", "Link", "Server", ":status"
+};
+#define NUM_NAMES (sizeof(names) / sizeof(names[0]))
+#define PSEUDO_NAME (NUM_NAMES - 1)
+
+struct ref_header {
+  size_t name;
+  unsigned int type;
+  int request;
+  char value[64];
+};
+
+static struct ref_header refs[NUM_HEADERS];
+
+static unsigned int rnd_state = 4711;
+
+static unsigned int rnd(void)
+{
+  rnd_state = rnd_state * 1103515245 + 12345;
+  return (rnd_state >> 8) & 0xffffff;
+}
+
+/* the name with every other letter in the other case */
+static void othercase(char *buf, const char *name)
+{
+  size_t i;
+  for(i = 0; name[i]; i++)
+    buf[i] = (char)((i & 1) ? Curl_raw_toupper(name[i]) :
+                    Curl_raw_tolower(name[i]));
+  buf[i] = 0;
+}
+
+static size_t ref_amount(size_t name, unsigned int type, int request,
+                         size_t count)
+{
+  size_t i, amount = 0;
+  for(i = 0; i < count; i++) {
+    if((refs[i].name == name) && (refs[i].type & type) &&
+       (refs[i].request == request))
+      amount++;
+  }
+  return amount;
+}
+
+static void check_lookups(size_t count)
+{
+  int request;
+  unsigned int type;
+
+  for(request = 0; request < NUM_REQUESTS; request++) {
+    for(type = 1; type <= 0x1f; type++) {
+      size_t n;
+      size_t i;
+      struct curl_header *prev = NULL;
+      struct curl_header *h;
+
+      for(n = 0; n < NUM_NAMES; n++) {
+        char name[32];
+        size_t amount = ref_amount(n, type, request, count);
+        size_t index = 0;
+        othercase(name, names[n]);
+        for(i = 0; i < count; i++) {
+          CURLHcode hc;
+          if((refs[i].name != n) || !(refs[i].type & type) ||
+             (refs[i].request != request))
+            continue;
+          hc = curl_easy_header(easy, name, index, type, request, &h);
+          fail_unless(hc == CURLHE_OK, "header not found");
+          if(hc)
+            return;
+          fail_unless(h->amount == amount, "wrong amount");
+          fail_unless(h->index == index, "wrong index");
+          fail_unless(!strcmp(h->value, refs[i].value), "wrong value");
+          fail_unless((h->origin & 0x1f) == refs[i].type, "wrong origin");
+          index++;
+        }
+        fail_unless(curl_easy_header(easy, name, index, type, request, &h) ==
+                    (amount ? CURLHE_BADINDEX : CURLHE_MISSING),
+                    "found too many");
+      }
+
+      /* the headers of the request and mask in the order they arrived */
+      for(i = 0; i < count; i++) {
+        if(!(refs[i].type & type) || (refs[i].request != request))
+          continue;
+        h = curl_easy_nextheader(easy, type, request, prev);
+        fail_unless(h, "nextheader ended early");
+        if(!h)
+          return;
+        fail_unless(!strcmp(h->value, refs[i].value), "wrong next value");
+        fail_unless(h->amount == ref_amount(refs[i].name, type, request,
+                                            count), "wrong next amount");
+        prev = h;
+      }
+      fail_unless(!curl_easy_nextheader(easy, type, request, prev),
+                  "nextheader went on");
+    }
+  }
+}
+
+static void bench(void)
+{
+  static const char *response[] = {
+    "Date: Tue, 09 Nov 2010 14:49:00 GMT\r\n",
+    "Server: test-server/fake\r\n",
+    "Content-Type: text/html; charset=utf-8\r\n",
+    "Content-Length: 1234\r\n",
+    "Cache-Control: max-age=3600\r\n",
+    "Set-Cookie: a=1; Path=/\r\n",
+    "Set-Cookie: b=2; Path=/\r\n",
+    "Set-Cookie: c=3; Path=/\r\n",
+    "Vary: Accept-Encoding\r\n",
+    "ETag: \"21025-dc7-39462498\"\r\n",
+    "Last-Modified: Tue, 13 Jun 2000 12:10:00 GMT\r\n",
+    "Accept-Ranges: bytes\r\n",
+    "Connection: keep-alive\r\n",
+    "Strict-Transport-Security: max-age=31536000\r\n",
+    "X-Frame-Options: DENY\r\n",
+    "X-Content-Type-Options: nosniff\r\n",
+  };
+  size_t nheaders = sizeof(response) / sizeof(response[0]);
+  struct curltime t0 = Curl_now();
+  size_t found = 0;
+  int i;
+
+  easy->state.requests = 0;
+  for(i = 0; i < BENCH_RESPONSES; i++) {
+    struct curl_header *h;
+    size_t j;
+    for(j = 0; j < nheaders; j++)
+      Curl_headers_push(easy, response[j], CURLH_HEADER);
+    for(j = 0; j < nheaders; j++) {
+      char name[64];
+      size_t len = strcspn(response[j], ":");
+      memcpy(name, response[j], len);
+      name[len] = 0;
+      if(!curl_easy_header(easy, name, 0, CURLH_HEADER, -1, &h))
+        found++;
+    }
+    for(h = curl_easy_nextheader(easy, CURLH_HEADER, -1, NULL); h;
+        h = curl_easy_nextheader(easy, CURLH_HEADER, -1, h))
+      found++;
+    Curl_headers_cleanup(easy);
+  }
+  fprintf(stderr, "%d responses of %zu headers stored, looked up and "
+          "iterated (%zu found): %" FMT_TIMEDIFF_T " us\n",
+          BENCH_RESPONSES, nheaders, found,
+          Curl_timediff_us(Curl_now(), t0));
+}
+
+UNITTEST_START
+{
+  size_t count = 0;
+  int request = 0;
+  char line[128];
+  struct curl_header *h;
+
+  fail_unless(curl_easy_header(easy, "Date", 0, CURLH_HEADER, -1, &h) ==
+              CURLHE_NOHEADERS, "headers in a new handle");
+
+  while(count < NUM_HEADERS) {
+    unsigned int r = rnd();
+    struct ref_header *ref = &refs[count];
+
+    if(count && !(r % 7)) {
+      /* a folded line, added to the previous header's value */
+      struct ref_header *last = &refs[count - 1];
+      size_t vlen = strlen(last->value);
+      if(vlen < sizeof(last->value) - 16) {
+        msnprintf(line, sizeof(line), "   fold%u  \r\n", r % 100);
+        msnprintf(&last->value[vlen], sizeof(last->value) - vlen,
+                  " fold%u", r % 100);
+        abort_unless(!Curl_headers_push(easy, line, CURLH_HEADER),
+                     "folded push failed");
+      }
+      continue;
+    }
+    if(!(r % 97) && (request < NUM_REQUESTS - 1)) {
+      easy->state.requests = ++request;
+      continue;
+    }
+
+    ref->name = (r >> 4) % NUM_NAMES;
+    ref->type = ref->name == PSEUDO_NAME ? CURLH_PSEUDO :
+      (unsigned int)(1 << ((r >> 12) % 4));
+    ref->request = request;
+    msnprintf(ref->value, sizeof(ref->value), "v%zu", count);
+    msnprintf(line, sizeof(line), "%s: %s \r\n", names[ref->name],
+              ref->value);
+    abort_unless(!Curl_headers_push(easy, line, (unsigned char)ref->type),
+                 "push failed");
+    count++;
+  }
+  fail_unless(request == NUM_REQUESTS - 1, "not all requests used");
+
+  check_lookups(count);
+
+  fail_unless(curl_easy_header(easy, "Date", 0, CURLH_HEADER,
+                               NUM_REQUESTS, &h) == CURLHE_NOREQUEST,
+              "found a request that was not made");
+  fail_unless(curl_easy_header(easy, "Nope", 0, CURLH_HEADER, 0, &h) ==
+              CURLHE_MISSING, "found a header that was not stored");
+
+  Curl_headers_cleanup(easy);
+  fail_unless(curl_easy_header(easy, "Date", 0, CURLH_HEADER, -1, &h) ==
+              CURLHE_NOHEADERS, "headers left after cleanup");
+
+  if(getenv("CURL_HEADERS_BENCH"))
+    bench();
+}
+UNITTEST_STOP
+
+#else
+
+UNITTEST_START
+UNITTEST_STOP
+
+#endif
@@ -0,0 +1,127 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "urldata.h"
+#include "multihandle.h"
+#include "slab.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Takes objects from and gives them back to the slab of a multi handle,
+ * checking which ones are reused and that they always come zeroed.
+ */
+
+static struct Curl_easy *easy;
+static struct Curl_multi *multi;
+
+static CURLcode unit_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  easy = curl_easy_init();
+  multi = curl_multi_init();
+  if(!easy || !multi) {
+    curl_easy_cleanup(easy);
+    curl_multi_cleanup(multi);
+    curl_global_cleanup();
+    return CURLE_OUT_OF_MEMORY;
+  }
+  easy->multi = multi;
+  return res;
+}
+
+static void unit_stop(void)
+{
+  easy->multi = NULL;
+  curl_easy_cleanup(easy);
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+}
+
+static bool is_zero(const unsigned char *p, size_t len)
+{
+  size_t i;
+  for(i = 0; i < len; i++) {
+    if(p[i])
+      return FALSE;
+  }
+  return TRUE;
+}
+
+UNITTEST_START
+{
+  struct Curl_slab *slab = &multi->slab;
+  unsigned char *p, *q, *big;
+  void *objs[200];
+  size_t i, kept;
+
+  /* a freed object comes back zeroed for any size of its class */
+  p = Curl_slab_alloc(easy, 100);
+  abort_unless(p, "out of memory");
+  fail_unless(is_zero(p, 100), "new object not zeroed");
+  memset(p, 0xaa, 100);
+  Curl_slab_free(easy, p, 100);
+  fail_unless(slab->kept == 128, "freed object not kept");
+  q = Curl_slab_alloc(easy, 120);
+  fail_unless(q == p, "kept object not reused");
+  fail_unless(is_zero(q, 120), "reused object not zeroed");
+  fail_unless(!slab->kept, "reused object still kept");
+  fail_unless(slab->reused == 1, "reuse not counted");
+
+  /* an object of another class is not handed out for it */
+  Curl_slab_free(easy, q, 120);
+  p = Curl_slab_alloc(easy, 129);
+  abort_unless(p, "out of memory");
+  fail_unless(p != q, "object of a smaller class reused");
+  Curl_slab_free(easy, p, 129);
+
+  /* larger objects are not kept */
+  big = Curl_slab_alloc(easy, CURL_SLAB_MAX + 1);
+  abort_unless(big, "out of memory");
+  kept = slab->kept;
+  Curl_slab_free(easy, big, CURL_SLAB_MAX + 1);
+  fail_unless(slab->kept == kept, "large object kept");
+
+  /* no more than CURL_SLAB_KEEP bytes are kept */
+  for(i = 0; i < sizeof(objs) / sizeof(objs[0]); i++) {
+    objs[i] = Curl_slab_alloc(easy, CURL_SLAB_MAX);
+    abort_unless(objs[i], "out of memory");
+  }
+  for(i = 0; i < sizeof(objs) / sizeof(objs[0]); i++)
+    Curl_slab_free(easy, objs[i], CURL_SLAB_MAX);
+  fail_unless(slab->kept <= CURL_SLAB_KEEP, "kept too much");
+  fail_unless(slab->dropped, "nothing dropped");
+
+  /* without a multi handle, objects are just allocated and freed */
+  easy->multi = NULL;
+  kept = slab->kept;
+  p = Curl_slab_alloc(easy, 64);
+  abort_unless(p, "out of memory");
+  Curl_slab_free(easy, p, 64);
+  fail_unless(slab->kept == kept, "kept without a multi handle");
+  easy->multi = multi;
+}
+UNITTEST_STOP
@@ -0,0 +1,278 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "urldata.h"
+#include "cookie.h"
+#include "timeval.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Adds cookies to a jar and checks which of them are sent to a host, and in
+ * which order, when they are looked up in the index of their domains.
+ *
+ * Set CURL_COOKIE_BENCH in the environment to also have the time it takes
+ * to load a jar as a crawler might have it and to look up cookies in it
+ * shown.
+ */
+
+static struct Curl_easy *easy;
+
+static CURLcode unit_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  easy = curl_easy_init();
+  if(!easy) {
+    curl_global_cleanup();
+    return CURLE_OUT_OF_MEMORY;
+  }
+  return res;
+}
+
+static void unit_stop(void)
+{
+  curl_easy_cleanup(easy);
+  curl_global_cleanup();
+}
+
+#if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_COOKIES)
+
+#define BENCH_SITES 5000
+#define BENCH_LOOKUPS 100000
+
+/* Add a cookie in the netscape cookie file format */
+static void add(struct CookieInfo *c, const char *domain, bool tailmatch,
+                const char *path, curl_off_t expires, const char *name,
+                bool noexpire)
+{
+  char line[512];
+  msnprintf(line, sizeof(line), "%s\t%s\t%s\tFALSE\t%" FMT_OFF_T "\t%s\tv",
+            domain, tailmatch ? "TRUE" : "FALSE", path, expires, name);
+  fail_unless(Curl_cookie_add(easy, c, FALSE, noexpire, line, NULL, NULL,
+                              TRUE), "cookie not added");
+}
+
+/* Check the names of the cookies sent to the host, in order, separated by
+   spaces */
+static void sent(struct CookieInfo *c, const char *host, const char *path,
+                 const char *expect)
+{
+  struct Curl_cookie_iter iter;
+  struct Cookie *co;
+  char names[512] = "";
+  size_t len = 0;
+
+  for(co = Curl_cookie_first(easy, c, &iter, host, path, FALSE); co;
+      co = Curl_cookie_next(&iter)) {
+    len += msnprintf(names + len, sizeof(names) - len, "%s%s",
+                     len ? " " : "", co->name);
+  }
+  Curl_cookie_done(&iter);
+  if(strcmp(names, expect)) {
+    fprintf(stderr, "%s%s: got '%s', expected '%s'\n", host, path, names,
+            expect);
+    fail("wrong cookies sent");
+  }
+}
+
+static void bench(void)
+{
+  static const char * const tlds[] = {
+    "com", "org", "net", "co.uk", "de", "io"
+  };
+  size_t ntlds = sizeof(tlds)/sizeof(tlds[0]);
+  curl_off_t now = (curl_off_t)time(NULL);
+  struct CookieInfo *c = Curl_cookie_init(easy, NULL, NULL, FALSE);
+  unsigned int rnd = 1;
+  struct curltime t0;
+  timediff_t us_load, us_lookup;
+  size_t i, found = 0;
+
+  if(!c)
+    return;
+
+  /* ten cookies per site: some for the site and all its hosts, some for
+     its www host only. One in five are session cookies, two in five expire
+     within minutes. */
+  c->running = FALSE;
+  t0 = Curl_now();
+  for(i = 0; i < BENCH_SITES * 10; i++) {
+    char domain[64];
+    char name[16];
+    curl_off_t expires;
+    size_t site = i / 10;
+    size_t n = i % 10;
+
+    rnd = rnd * 1103515245 + 12345;
+    switch((rnd >> 16) % 5) {
+    case 0:
+      expires = 0;
+      break;
+    case 1:
+    case 2:
+      expires = now + 5 + (rnd >> 8) % 120;
+      break;
+    default:
+      expires = now + 365 * 24 * 3600;
+      break;
+    }
+    msnprintf(domain, sizeof(domain), "%ssite%zu.%s", (n < 6) ? "" : "www.",
+              site, tlds[site % ntlds]);
+    msnprintf(name, sizeof(name), "c%zu", n);
+    add(c, domain, n < 6, (n % 3) ? "/" : "/account", expires, name, TRUE);
+  }
+  us_load = Curl_timediff_us(Curl_now(), t0);
+  c->running = TRUE;
+
+  t0 = Curl_now();
+  for(i = 0; i < BENCH_LOOKUPS; i++) {
+    struct Curl_cookie_iter iter;
+    struct Cookie *co;
+    char host[64];
+    size_t site;
+
+    rnd = rnd * 1103515245 + 12345;
+    site = (rnd >> 8) % BENCH_SITES;
+    msnprintf(host, sizeof(host), "www.site%zu.%s", site,
+              tlds[site % ntlds]);
+    for(co = Curl_cookie_first(easy, c, &iter, host, "/account/login", FALSE);
+        co; co = Curl_cookie_next(&iter))
+      found++;
+    Curl_cookie_done(&iter);
+  }
+  us_lookup = Curl_timediff_us(Curl_now(), t0);
+
+  fprintf(stderr, "%d cookies: load %" FMT_TIMEDIFF_T " us, %d lookups "
+          "(%zu cookies): %" FMT_TIMEDIFF_T " us\n", c->numcookies, us_load,
+          BENCH_LOOKUPS, found, us_lookup);
+  Curl_cookie_cleanup(c);
+}
+
+UNITTEST_START
+{
+  curl_off_t now = (curl_off_t)time(NULL);
+  struct CookieInfo *c = Curl_cookie_init(easy, NULL, NULL, FALSE);
+  size_t ndomains;
+  int i;
+
+  abort_unless(c, "no cookie jar");
+
+  /* a cookie for a parent domain is sent to all hosts in it, a cookie for a
+     host only to that host */
+  add(c, "example.com", TRUE, "/", 0, "parent", FALSE);
+  add(c, "example.com", FALSE, "/", 0, "host", FALSE);
+  add(c, "b.example.com", TRUE, "/", 0, "middle", FALSE);
+  sent(c, "a.b.example.com", "/", "middle parent");
+  sent(c, "example.com", "/", "parent host");
+  sent(c, "notexample.com", "/", "");
+
+  /* domains are case insensitive */
+  add(c, "MiXeD.Example.ORG", TRUE, "/", 0, "mixed", FALSE);
+  sent(c, "www.mixed.example.org", "/", "mixed");
+  sent(c, "MIXED.EXAMPLE.ORG", "/", "mixed");
+
+  /* an IP address only gets the cookies set for it, not those of what
+     would be its parent domains */
+  add(c, "192.168.0.1", FALSE, "/", 0, "ip", FALSE);
+  add(c, "168.0.1", TRUE, "/", 0, "notip", FALSE);
+  add(c, "0.1", TRUE, "/", 0, "notip2", FALSE);
+  sent(c, "192.168.0.1", "/", "ip");
+
+  /* longer paths first, then longer domains, then longer names, then the
+     newest, across the domains of the host */
+  add(c, "order.test", TRUE, "/", 0, "one", FALSE);
+  add(c, "www.order.test", FALSE, "/a", 0, "two", FALSE);
+  add(c, "order.test", TRUE, "/a/b", 0, "three", FALSE);
+  add(c, "www.order.test", FALSE, "/a/b", 0, "four", FALSE);
+  add(c, "www.order.test", FALSE, "/a/b", 0, "five5", FALSE);
+  sent(c, "www.order.test", "/a/b/c", "five5 four three two one");
+  /* replacing a cookie with a longer path of the same meaning moves it */
+  add(c, "www.order.test", FALSE, "\"/a/\"", 0, "two", FALSE);
+  sent(c, "www.order.test", "/a/b/c", "two five5 four three one");
+
+  /* when there are too many, the oldest are sent */
+  for(i = 0; i < MAX_COOKIE_SEND_AMOUNT + 50; i++) {
+    char name[16];
+    msnprintf(name, sizeof(name), "c%03d", i);
+    add(c, (i % 2) ? "many.test" : "www.many.test", i % 2, "/", 0, name,
+        FALSE);
+  }
+  {
+    struct Curl_cookie_iter iter;
+    struct Cookie *co;
+    int n = 0;
+
+    /* same path and name lengths: those of the longer domain first, the
+       newest of each first */
+    for(co = Curl_cookie_first(easy, c, &iter, "www.many.test", "/", FALSE);
+        co; co = Curl_cookie_next(&iter)) {
+      int half = MAX_COOKIE_SEND_AMOUNT / 2;
+      int expect = (n < half) ? MAX_COOKIE_SEND_AMOUNT - 2 - n * 2 :
+        MAX_COOKIE_SEND_AMOUNT - 1 - (n - half) * 2;
+      if(atoi(&co->name[1]) != expect) {
+        fprintf(stderr, "cookie %d: got %s, expected c%03d\n", n, co->name,
+                expect);
+        fail("wrong cookie sent");
+        break;
+      }
+      n++;
+    }
+    Curl_cookie_done(&iter);
+    fail_unless(n == MAX_COOKIE_SEND_AMOUNT, "wrong number of cookies sent");
+  }
+
+  /* adding a cookie only expires those of its own domain, and a domain that
+     is left without cookies is removed from the index */
+  add(c, "gone.test", FALSE, "/", now - 10, "expired", TRUE);
+  add(c, "other.test", FALSE, "/", now - 10, "expired", TRUE);
+  ndomains = Curl_hash_count(&c->domains);
+  i = c->numcookies;
+  add(c, "gone.test", FALSE, "/", 0, "new", FALSE);
+  fail_unless(c->numcookies == i, "the expired cookie was kept");
+  fail_unless(Curl_hash_count(&c->domains) == ndomains, "wrong domains");
+  add(c, "www.other.test", FALSE, "/", 0, "new", FALSE);
+  fail_unless(c->numcookies == i + 1, "expired cookie of other domain gone");
+  fail_unless(Curl_hash_count(&c->domains) == ndomains + 1, "no new domain");
+  sent(c, "other.test", "/", "");
+  sent(c, "gone.test", "/", "new");
+
+  Curl_cookie_clearsess(c);
+  fail_unless(Curl_hash_count(&c->domains) == 1, "empty domains are kept");
+  fail_unless(c->numcookies == 1, "session cookies are kept");
+
+  Curl_cookie_cleanup(c);
+
+  if(getenv("CURL_COOKIE_BENCH"))
+    bench();
+}
+UNITTEST_STOP
+
+#else
+
+UNITTEST_START
+UNITTEST_STOP
+
+#endif
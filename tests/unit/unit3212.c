@@ -0,0 +1,246 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "urldata.h"
+#include "http.h"
+#include "dynhds.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Compares the HTTP/2 header fields of a request with those of others, the
+ * way the HTTP/2 filter decides if it can send the fields of the last
+ * request on a connection again.
+ */
+
+static struct Curl_easy *easy;
+
+static CURLcode unit_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  easy = curl_easy_init();
+  if(!easy) {
+    curl_global_cleanup();
+    return CURLE_OUT_OF_MEMORY;
+  }
+  return res;
+}
+
+static void unit_stop(void)
+{
+  curl_easy_cleanup(easy);
+  curl_global_cleanup();
+}
+
+#ifndef CURL_DISABLE_HTTP
+
+struct tcase {
+  const char *name;
+  const char *method;
+  const char *authority;
+  const char *path;
+  const char *headers[12]; /* name and value pairs */
+  bool fields_same; /* the fields are those of the first request */
+  bool h2_same; /* all HTTP/2 headers are those of the first request */
+};
+
+static const struct tcase first = {
+  "first", "GET", "example.com", "/api/1",
+  { "Host", "example.com", "User-Agent", "curl/8",
+    "Accept", "*/*", "X-Token", "abc" },
+  TRUE, TRUE
+};
+
+static const struct tcase cases[] = {
+  { "identical", "GET", "example.com", "/api/1",
+    { "Host", "example.com", "User-Agent", "curl/8",
+      "Accept", "*/*", "X-Token", "abc" }, TRUE, TRUE },
+  { "name case", "GET", "example.com", "/api/1",
+    { "Host", "example.com", "user-agent", "curl/8",
+      "ACCEPT", "*/*", "x-token", "abc" }, TRUE, TRUE },
+  { "non fields", "GET", "example.com", "/api/1",
+    { "Host", "example.com", "User-Agent", "curl/8", "Connection", "close",
+      "Accept", "*/*", "X-Token", "abc" }, TRUE, TRUE },
+  { "value", "GET", "example.com", "/api/1",
+    { "Host", "example.com", "User-Agent", "curl/8",
+      "Accept", "*/*", "X-Token", "abd" }, FALSE, FALSE },
+  { "value length", "GET", "example.com", "/api/1",
+    { "Host", "example.com", "User-Agent", "curl/8",
+      "Accept", "*/*", "X-Token", "abcd" }, FALSE, FALSE },
+  { "added", "GET", "example.com", "/api/1",
+    { "Host", "example.com", "User-Agent", "curl/8",
+      "Accept", "*/*", "X-Token", "abc", "X-More", "1" }, FALSE, FALSE },
+  { "removed", "GET", "example.com", "/api/1",
+    { "Host", "example.com", "User-Agent", "curl/8",
+      "Accept", "*/*" }, FALSE, FALSE },
+  { "order", "GET", "example.com", "/api/1",
+    { "Host", "example.com", "Accept", "*/*",
+      "User-Agent", "curl/8", "X-Token", "abc" }, FALSE, FALSE },
+  /* the pseudo headers are made for each request and are not part of the
+     fields, but the request still goes out with its own */
+  { "method", "POST", "example.com", "/api/1",
+    { "Host", "example.com", "User-Agent", "curl/8",
+      "Accept", "*/*", "X-Token", "abc" }, TRUE, FALSE },
+  { "path", "GET", "example.com", "/api/2",
+    { "Host", "example.com", "User-Agent", "curl/8",
+      "Accept", "*/*", "X-Token", "abc" }, TRUE, FALSE },
+  { "authority", "GET", "example.org", "/api/1",
+    { "Host", "example.org", "User-Agent", "curl/8",
+      "Accept", "*/*", "X-Token", "abc" }, TRUE, FALSE },
+};
+
+static struct httpreq *make(const struct tcase *t)
+{
+  struct httpreq *req;
+  size_t i;
+
+  if(Curl_http_req_make(&req, t->method, strlen(t->method),
+                        STRCONST("https"),
+                        t->authority, strlen(t->authority),
+                        t->path, strlen(t->path)))
+    return NULL;
+  for(i = 0; (i < sizeof(t->headers)/sizeof(t->headers[0])) &&
+        t->headers[i]; i += 2) {
+    if(Curl_dynhds_add(&req->headers, t->headers[i], strlen(t->headers[i]),
+                       t->headers[i + 1], strlen(t->headers[i + 1]))) {
+      Curl_http_req_free(req);
+      return NULL;
+    }
+  }
+  return req;
+}
+
+/* the HTTP/2 headers a request is sent with, when the fields of an
+   earlier one are sent again if they are the same */
+static CURLcode h2_headers(struct dynhds *h2, struct dynhds *fields,
+                           struct httpreq *req)
+{
+  CURLcode result = Curl_http_req_to_h2_pseudo(h2, req, easy);
+  size_t i;
+
+  if(!result && !Curl_http_req_h2_fields_same(fields, req)) {
+    Curl_dynhds_reset(fields);
+    result = Curl_http_req_to_h2_fields(fields, req);
+  }
+  for(i = 0; !result && (i < Curl_dynhds_count(fields)); i++) {
+    struct dynhds_entry *e = Curl_dynhds_getn(fields, i);
+    result = Curl_dynhds_add(h2, e->name, e->namelen, e->value, e->valuelen);
+  }
+  return result;
+}
+
+static bool h2_same(struct dynhds *a, struct dynhds *b)
+{
+  size_t i;
+
+  if(Curl_dynhds_count(a) != Curl_dynhds_count(b))
+    return FALSE;
+  for(i = 0; i < Curl_dynhds_count(a); i++) {
+    struct dynhds_entry *ea = Curl_dynhds_getn(a, i);
+    struct dynhds_entry *eb = Curl_dynhds_getn(b, i);
+    if((ea->namelen != eb->namelen) || (ea->valuelen != eb->valuelen) ||
+       memcmp(ea->name, eb->name, ea->namelen) ||
+       memcmp(ea->value, eb->value, ea->valuelen))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+UNITTEST_START
+{
+  struct dynhds fields, h2_first, h2;
+  struct httpreq *req;
+  size_t i;
+
+  Curl_dynhds_init(&fields, 0, DYN_HTTP_REQUEST);
+  Curl_dynhds_init(&h2_first, 0, DYN_HTTP_REQUEST);
+  Curl_dynhds_init(&h2, 0, DYN_HTTP_REQUEST);
+
+  req = make(&first);
+  if(!req || h2_headers(&h2_first, &fields, req)) {
+    Curl_http_req_free(req);
+    fail("h2 headers failed");
+    goto out;
+  }
+  Curl_http_req_free(req);
+  /* no Host, the fields in lowercase after 4 pseudo headers */
+  fail_unless(Curl_dynhds_count(&fields) == 3, "wrong number of fields");
+  fail_unless(Curl_dynhds_count(&h2_first) == 7, "wrong number of headers");
+  fail_unless(Curl_dynhds_get(&fields, STRCONST("user-agent")) &&
+              !Curl_dynhds_get(&fields, STRCONST("host")), "wrong fields");
+
+  for(i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+    const struct tcase *t = &cases[i];
+
+    req = make(t);
+    if(!req) {
+      fail("out of memory");
+      break;
+    }
+    if(Curl_http_req_h2_fields_same(&fields, req) != t->fields_same) {
+      fprintf(stderr, "%s: fields %s\n", t->name,
+              t->fields_same ? "differ" : "are the same");
+      fail("wrong field comparison");
+    }
+
+    /* what goes out, starting from the fields of the first request */
+    Curl_dynhds_reset(&h2);
+    if(h2_headers(&h2, &fields, req))
+      fail("h2 headers failed");
+    else if(h2_same(&h2, &h2_first) != t->h2_same) {
+      fprintf(stderr, "%s: HTTP/2 headers %s\n", t->name,
+              t->h2_same ? "differ" : "are the same");
+      fail("wrong HTTP/2 headers");
+    }
+    else if(!Curl_http_req_h2_fields_same(&fields, req))
+      fail("fields not kept for the request");
+    Curl_http_req_free(req);
+
+    /* back to the fields of the first request */
+    req = make(&first);
+    if(!req) {
+      fail("out of memory");
+      break;
+    }
+    Curl_dynhds_reset(&h2);
+    if(h2_headers(&h2, &fields, req) || !h2_same(&h2, &h2_first))
+      fail("first request headers changed");
+    Curl_http_req_free(req);
+  }
+
+out:
+  Curl_dynhds_free(&fields);
+  Curl_dynhds_free(&h2_first);
+  Curl_dynhds_free(&h2);
+}
+UNITTEST_STOP
+
+#else
+
+UNITTEST_START
+UNITTEST_STOP
+
+#endif
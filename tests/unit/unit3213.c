@@ -0,0 +1,97 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curlcheck.h"
+
+#include "urldata.h"
+#include "multihandle.h"
+#include "multiif.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Sets CURLMOPT_MAX_STREAM_WINDOW and checks the window HTTP/2 streams may
+ * grow to. Values outside of what HTTP/2 allows for a window set it back to
+ * the default.
+ */
+
+static struct Curl_multi *multi;
+
+static CURLcode unit_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  multi = curl_multi_init();
+  if(!multi) {
+    curl_global_cleanup();
+    return CURLE_OUT_OF_MEMORY;
+  }
+  return res;
+}
+
+static void unit_stop(void)
+{
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+}
+
+static void check(long value, unsigned int expect)
+{
+  CURLMcode mc = curl_multi_setopt(multi, CURLMOPT_MAX_STREAM_WINDOW, value);
+  unsigned int window = Curl_multi_max_stream_window(multi);
+
+  fail_unless(mc == CURLM_OK, "setopt failed");
+  if(window != expect) {
+    fprintf(stderr, "%ld: window %u, expected %u\n", value, window, expect);
+    fail("wrong stream window");
+  }
+}
+
+UNITTEST_START
+{
+  fail_unless(Curl_multi_max_stream_window(multi) == CURL_STREAM_WINDOW_MAX,
+              "wrong default");
+
+  check(1024 * 1024, 1024 * 1024);
+  check(65535, 65535);
+  check(INT_MAX, INT_MAX);
+
+  /* smaller than the default window of HTTP/2 */
+  check(1024 * 1024, 1024 * 1024);
+  check(65534, CURL_STREAM_WINDOW_MAX);
+  check(1024 * 1024, 1024 * 1024);
+  check(0, CURL_STREAM_WINDOW_MAX);
+  check(1024 * 1024, 1024 * 1024);
+  check(-1, CURL_STREAM_WINDOW_MAX);
+  check(1024 * 1024, 1024 * 1024);
+  check(LONG_MIN, CURL_STREAM_WINDOW_MAX);
+
+#if LONG_MAX > INT_MAX
+  /* larger than HTTP/2 allows */
+  check(1024 * 1024, 1024 * 1024);
+  check((long)INT_MAX + 1, CURL_STREAM_WINDOW_MAX);
+  check(1024 * 1024, 1024 * 1024);
+  check(LONG_MAX, CURL_STREAM_WINDOW_MAX);
+#endif
+}
+UNITTEST_STOP